@@ -2,28 +2,71 @@
 #define APPWEBSERVER_H
 
 #include <WiFi.h>
-#include <WebServer.h>        // Thư viện WebServer chuẩn
+#include <ESPAsyncWebServer.h> // Web server hướng sự kiện (AsyncTCP), nhiều kết nối song song
 #include "FMRadio.h"          // Cần để điều khiển FM
 #include "PowerManager.h"     // Cần để điều khiển nguồn
 #include "FileManager.h"      // Cần để phục vụ file tĩnh và lưu config
+#include "SettingsStore.h"    // Cài đặt trong NVS
 #include "Constants.h"        // Nơi chứa các hằng số
 #include "BluetoothManager.h" // Nơi thao tác với bluetooth
 #include "ConnectivityManager.h"
+#include "TaskManager.h"      // Lệnh phần cứng chạy trong task control
+#include "StatusBroadcaster.h" // Đẩy trạng thái qua SSE
+#include "BandScanner.h"      // Quét cả băng FM
+#include "StationSeeker.h"    // Seek chạy nền, hủy được
+#include "SourceManager.h"    // Chuyển nguồn FM/Bluetooth
+#include "BootProfiler.h"     // Thời gian các pha khởi động
+#include "Trace.h"            // Ring trace sự kiện
+#include "Metrics.h"          // Histogram cho /api/metrics
+#include "AssetCache.h"       // File UI trong PSRAM
+#include "RouteTable.h"       // Tra route bằng tìm kiếm nhị phân
+#include "ResponseWriter.h"   // Response JSON từ buffer cấp sẵn
+
+// Số dòng của AppWebServer::ROUTES (kiểm tra bằng static_assert)
+#define API_ROUTE_COUNT 37
+// Buffer PSRAM cho một lần trả /api/metrics
+#define METRICS_BUFFER_SIZE (48 * 1024)
 
 class AppWebServer
 {
 public:
     // Constructor nhận con trỏ của các module khác
-    AppWebServer(FMRadio *radio, PowerManager *power, FileManager *fileMgr, BluetoothManager *bluetooth, ConnectivityManager *connectivity);
+    AppWebServer(FMRadio *radio, PowerManager *power, FileManager *fileMgr, BluetoothManager *bluetooth, ConnectivityManager *connectivity, SettingsStore *settingsStore, TaskManager *tasks, StatusBroadcaster *broadcaster, BandScanner *scanner, StationSeeker *seeker, SourceManager *sources, BootProfiler *boot);
 
     bool begin();
 
-    // QUAN TRỌNG: Hàm này PHẢI được gọi liên tục trong loop()
-    void handleClient();
-
 private:
-    // Khai báo đối tượng WebServer
-    WebServer server;
+    // Một dòng của bảng route (bảng nằm trong AppWebServer.cpp)
+    struct Route
+    {
+        const char *path;
+        WebRequestMethod method;
+        void (AppWebServer::*handler)(AsyncWebServerRequest *request);
+        uint16_t maxBody; // Body JSON tối đa (byte), lớn hơn trả 413. 0: không nhận body
+    };
+    static const Route ROUTES[API_ROUTE_COUNT];
+
+    // Một handler duy nhất cho mọi route trong bảng (thay cho một handler mỗi server.on)
+    class ApiHandler : public AsyncWebHandler
+    {
+    public:
+        explicit ApiHandler(AppWebServer *owner) : owner(owner) {}
+        bool canHandle(AsyncWebServerRequest *request) const override;
+        void handleRequest(AsyncWebServerRequest *request) override;
+        void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override;
+        bool isRequestHandlerTrivial() const override { return false; }
+
+    private:
+        AppWebServer *owner;
+    };
+
+    // Khai báo đối tượng WebServer (chạy trong task async_tcp, không cần gọi từ loop())
+    AsyncWebServer server;
+    ApiHandler apiHandler;
+    // Buffer cho response JSON, đếm cấp phát theo request
+    ResponseWriter responses;
+    // File UI: đọc từ SD một lần rồi trả từ PSRAM (ETag/304, gzip)
+    AssetCache assetCache;
 
     // Con trỏ tới các module khác
     ConnectivityManager *connectivity;
@@ -31,40 +74,82 @@ private:
     PowerManager *powerManager;
     FileManager *fileManager;
     BluetoothManager *btManager;
+    SettingsStore *settings;
+    TaskManager *taskManager;
+    StatusBroadcaster *statusBroadcaster;
+    BandScanner *bandScanner;
+    StationSeeker *stationSeeker;
+    SourceManager *sourceManager;
+    BootProfiler *bootProfiler;
+
+    // Thống kê dispatch (chỉ task async_tcp ghi)
+    uint32_t routeHits[API_ROUTE_COUNT] = {};
+    uint32_t routeMaxAllocs[API_ROUTE_COUNT] = {};
+    Histogram routeLatency[API_ROUTE_COUNT]; // Thời gian chạy handler (chưa gồm gửi response)
+    uint32_t methodNotAllowed = 0;
+    uint32_t preflights = 0;
+    uint32_t bodiesRejected = 0;
+    size_t largestBody = 0;
 
     // Hàm đăng ký tất cả các API endpoints
     void registerAPIs();
 
+    // Gom body của request POST (JSON) vào request->_tempObject
+    void collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total);
+    const char *getBody(AsyncWebServerRequest *request);
+    bool parseBody(AsyncWebServerRequest *request, JsonDocument &doc, const char *filter);
+
+    // Gửi lệnh cho task control; trả 503 nếu hàng đợi đầy
+    bool postCommand(AsyncWebServerRequest *request, ControlCommand cmd, int32_t value = 0, uint32_t waitMs = 0);
+    // Gửi lệnh quét (CMD_FM_SCAN_START/CMD_FM_AUTOSTORE) với tham số dwell, trả 202 hoặc 409
+    void startScan(AsyncWebServerRequest *request, ControlCommand cmd);
+
     // Các hàm xử lý request cụ thể
-    void handleRoot();
-    void handleStaticFile();
+    void handleRoot(AsyncWebServerRequest *request);
+    void handleNotFound(AsyncWebServerRequest *request);
 
     // API FM module
-    void handleFmPower();
-    void handleFmSeek();
-    void handleFmStatus();
-    void handleFmSaveChannel();
-    void handleFmSelectChannel();
-    void handleFmLoadChannels();
-    void handleFmSetFreq();
-    void handleFmVolume();
-    void handleFmDeleteChannel();
-    // CORS helper
-    void sendCORSHeaders();
+    void handleFmPower(AsyncWebServerRequest *request);
+    void handleFmSeek(AsyncWebServerRequest *request);       // Tiến độ job seek (?direction=: bắt đầu, như POST)
+    void handleFmSeekStart(AsyncWebServerRequest *request);
+    void handleFmSeekCancel(AsyncWebServerRequest *request);
+    void handleFmStatus(AsyncWebServerRequest *request);
+    void handleFmRds(AsyncWebServerRequest *request); // PS, RadioText, PTY, giờ và bộ đếm lỗi RDS
+    void handleFmHistory(AsyncWebServerRequest *request); // Lịch sử RSSI/stereo (JSON delta hoặc nhị phân)
+    void handleFmSaveChannel(AsyncWebServerRequest *request);
+    void handleFmSelectChannel(AsyncWebServerRequest *request);
+    void handleFmLoadChannels(AsyncWebServerRequest *request);
+    void handleFmSetFreq(AsyncWebServerRequest *request);
+    void handleFmVolume(AsyncWebServerRequest *request);
+    void handleFmDeleteChannel(AsyncWebServerRequest *request);
+    void handleFmEditStation(AsyncWebServerRequest *request); // Tên, yêu thích, vị trí của một kênh đã lưu
+    void handleFmScanStart(AsyncWebServerRequest *request);  // Bắt đầu quét cả băng (chạy nền)
+    void handleFmScanResult(AsyncWebServerRequest *request); // Tiến độ và kết quả quét
+    void handleFmScanCancel(AsyncWebServerRequest *request);
+    void handleFmAutostore(AsyncWebServerRequest *request);  // Quét rồi lưu các đài mạnh nhất thành kênh
+    // MIME helper
     const char *getContentType(const String &path);
     // API Cấu hình Wi-Fi
-    void handleGetWifiStatus();    // Trạng thái (AP/STA/Operational)
-    void handleScanNetworks();     // Bắt đầu/Lấy kết quả quét
-    void handleSubmitWifiConfig(); // Kiểm tra và lưu config
-    void handleResetWifiConfig();  // Buộc về Provisioning Mode
+    void handleGetWifiStatus(AsyncWebServerRequest *request);    // Trạng thái (AP/STA/Operational)
+    void handleScanNetworks(AsyncWebServerRequest *request);     // Bắt đầu/Lấy kết quả quét
+    void handleSubmitWifiConfig(AsyncWebServerRequest *request); // Bắt đầu kiểm tra config (chạy nền)
+    void handleGetWifiConfig(AsyncWebServerRequest *request);    // Kết quả kiểm tra config
+    void handleResetWifiConfig(AsyncWebServerRequest *request);  // Buộc về Provisioning Mode
     // API Hệ thống
-    void handleSystemReset(); // Kích hoạt reset thủ công
+    void handleMetrics(AsyncWebServerRequest *request);     // Counter/gauge/histogram dạng Prometheus
+    void handleSystemBoot(AsyncWebServerRequest *request);  // Thời gian các pha khởi động
+    void handleSystemReset(AsyncWebServerRequest *request); // Kích hoạt reset thủ công
+    void handleSystemTasks(AsyncWebServerRequest *request); // Core/priority/stack/CPU của các task
+    void handleSystemTrace(AsyncWebServerRequest *request); // Tải trace (Chrome/Perfetto JSON)
+    void handleSystemStorage(AsyncWebServerRequest *request); // Thống kê ghi trễ (SD, NVS) và cache file UI
+    void handleSystemSource(AsyncWebServerRequest *request);  // Nguồn đang phát, standby và độ trễ chuyển nguồn
+    void handleRoutes(AsyncWebServerRequest *request);        // Danh sách route và số lần gọi
     // Bluetooth
-    void handleBTStatus();
-    void handleBTPower();
-    void handleBTVolume();
-    void handleBTControl();
-    void handleBTConfirmPin();
+    void handleBTStatus(AsyncWebServerRequest *request);
+    void handleBTPower(AsyncWebServerRequest *request);
+    void handleBTVolume(AsyncWebServerRequest *request);
+    void handleBTControl(AsyncWebServerRequest *request);
+    void handleBTConfirmPin(AsyncWebServerRequest *request);
 };
 
 #endif // APPWEBSERVER_H
\ No newline at end of file
@@ -0,0 +1,82 @@
+#ifndef ASSETCACHE_H
+#define ASSETCACHE_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "FileManager.h"
+
+// =========================================================
+// Cache file UI (/famio/ui) trong PSRAM
+// =========================================================
+// Lần đầu một file được yêu cầu, bản gốc và bản nén sẵn ".gz" (nếu có trên thẻ)
+// được đọc vào PSRAM, từ gói ui.pack nếu có (không cần tìm đường dẫn FAT),
+// nếu không thì từ thư mục /ui. Các lần sau trả thẳng từ RAM, không đọc SD:
+//  - client gửi "Accept-Encoding: gzip" thì nhận bản .gz
+//  - mỗi bản có ETag (FNV-1a của nội dung); If-None-Match khớp thì trả 304
+//  - file có hash trong tên (app.3f9a2c1b.js, index-a1b2c3d4.css) được đánh dấu
+//    immutable một năm, các file khác phải hỏi lại bằng ETag (no-cache)
+// Bản đã nạp không bao giờ bị giải phóng (response trỏ thẳng vào bộ nhớ này),
+// khi hết ngân sách thì file mới được đọc thẳng từ SD (seek trong gói, hoặc mở file).
+
+#ifndef ASSET_CACHE_BUDGET
+#define ASSET_CACHE_BUDGET (1024 * 1024) // Tổng PSRAM cho file UI (0: luôn đọc SD, dùng khi đo)
+#endif
+#define ASSET_MAX_FILE_SIZE (256 * 1024) // File lớn hơn luôn đọc từ SD
+#define MAX_CACHED_ASSETS 48
+
+#define ASSET_CACHE_IMMUTABLE "public, max-age=31536000, immutable"
+#define ASSET_CACHE_REVALIDATE "no-cache"
+
+class AssetCache
+{
+public:
+    AssetCache(FileManager *fileMgr);
+
+    // Trả file UI tại path (ví dụ "/index.html"). false nếu không có trên thẻ
+    bool serve(AsyncWebServerRequest *request, const String &path, const char *contentType);
+
+    // Số lần trúng cache, 304, byte đã gửi và byte tiết kiệm nhờ gzip/304
+    void getStats(JsonDocument &doc);
+
+private:
+    struct Variant
+    {
+        uint8_t *data = nullptr;
+        size_t size = 0;
+        char etag[12] = ""; // "xxxxxxxx" kèm dấu nháy
+    };
+
+    struct Asset
+    {
+        String path;
+        Variant plain;
+        Variant gzip;
+        bool immutable = false;
+    };
+
+    FileManager *fileManager;
+    Asset assets[MAX_CACHED_ASSETS];
+    uint8_t assetCount = 0;
+    size_t usedBytes = 0;
+    SemaphoreHandle_t lock;
+
+    // Thống kê
+    uint32_t hits = 0;
+    uint32_t loads = 0;
+    uint32_t sdFallbacks = 0;
+    uint32_t notModified = 0;
+    uint64_t bytesSent = 0;
+    uint64_t bytesSaved = 0;
+
+    Asset *find(const String &path);
+    Asset *load(const String &path);
+    int loadVariant(const String &path, Variant &variant);
+    bool serveFromSd(AsyncWebServerRequest *request, const String &path, const char *contentType, bool acceptGzip);
+
+    static bool isHashedName(const String &path);
+};
+
+#endif // ASSETCACHE_H
@@ -0,0 +1,104 @@
+#ifndef BANDSCANNER_H
+#define BANDSCANNER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "FMRadio.h"
+#include "StatusBroadcaster.h"
+
+// =========================================================
+// Full-band scan (87-108 MHz)
+// =========================================================
+// Walks the band at the configured RDA5807_SPACE and records RSSI and the
+// stereo flag of every channel. The scan is a job of the control task: each
+// control loop pass does at most one step (read the channel tuned on the
+// previous pass, tune the next one) and waits for the dwell time on the
+// command queue, so radio commands keep running in between. Commands that
+// retune the chip cancel the scan.
+//
+// Results live in one byte per channel (bit 7 = stereo, bits 0-6 = RSSI).
+// Partial results are pushed as SSE "scan" events every SCAN_PUSH_POINTS
+// channels; GET /api/fm/scan returns the whole array.
+//
+// Auto-store: a scan started with autostore replaces the saved stations that
+// are not favorites with the ones found in the result (see pickStations).
+
+#define SCAN_BAND_BOTTOM RDA5807_BAND_BOTTOM // 87.0 MHz, 10 kHz units
+#define SCAN_BAND_TOP RDA5807_BAND_TOP     // 108.0 MHz
+#define SCAN_DWELL_MS 30      // Settle time before reading a channel
+#define SCAN_DWELL_MIN_MS 5
+#define SCAN_DWELL_MAX_MS 500
+#define SCAN_PUSH_POINTS 16   // Channels per SSE "scan" event
+
+// RDA5807_SPACE -> channel step in 10 kHz units (0=100 kHz, 1=200 kHz, 2=50 kHz)
+#define SCAN_STEP_10K RDA5807_STEP_10K
+#define SCAN_CHANNELS ((SCAN_BAND_TOP - SCAN_BAND_BOTTOM) / SCAN_STEP_10K + 1)
+
+#define SCAN_POINT_STEREO 0x80
+#define SCAN_POINT_RSSI 0x7F
+
+// Auto-store station picking
+#define AUTOSTORE_PRESETS 10      // Stations stored per auto-store, best first
+#define AUTOSTORE_MARGIN 10       // RSSI above the noise floor (band median) to count as a station
+#define AUTOSTORE_MIN_RSSI 12     // Lower bound of that threshold
+#define AUTOSTORE_SPACING_10K 20  // Peaks closer than this are one station, the strongest is kept
+#define AUTOSTORE_STEREO_BONUS 8  // Stereo lock counts as this much RSSI when ranking
+
+enum ScanState : uint8_t
+{
+    SCAN_IDLE,
+    SCAN_RUNNING,
+    SCAN_DONE,
+    SCAN_CANCELLED,
+};
+
+class BandScanner
+{
+public:
+    BandScanner(FMRadio *radio, StatusBroadcaster *broadcaster);
+
+    // Control task only
+    void start(uint32_t dwellMs, bool autostore = false);
+    void cancel();
+    // Does one step if the dwell time of the tuned channel has passed
+    void step();
+    // Time until the next step is due (for the control queue timeout)
+    uint32_t msUntilStep() const;
+
+    bool isRunning() const { return state == SCAN_RUNNING; }
+
+    // Snapshot of the job and all recorded points (any task)
+    void getResult(JsonDocument &doc);
+
+    // Stations in a scan result: local RSSI maxima above the noise floor,
+    // adjacent peaks merged, ranked by RSSI and stereo lock. Writes up to max
+    // channel indices (best first) and returns how many
+    static uint8_t pickStations(const uint8_t *points, uint16_t count, uint16_t *channels, uint8_t max);
+    static uint16_t channelFrequency(uint16_t index) { return SCAN_BAND_BOTTOM + index * SCAN_STEP_10K; }
+
+private:
+    FMRadio *fmRadio;
+    StatusBroadcaster *statusBroadcaster;
+
+    uint8_t points[SCAN_CHANNELS];
+    volatile ScanState state = SCAN_IDLE;
+    volatile uint16_t done = 0;  // Channels recorded so far
+    uint16_t pushed = 0;         // Channels already sent over SSE
+    uint32_t dwellMs = SCAN_DWELL_MS;
+    uint32_t startedAt = 0;
+    uint32_t tunedAt = 0;
+    volatile uint32_t elapsedMs = 0;
+    uint32_t scans = 0;
+    bool autostore = false;
+    uint16_t presets[AUTOSTORE_PRESETS]; // Frequencies stored by the last auto-store (10 kHz units)
+    volatile uint8_t presetCount = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    void finish(ScanState result);
+    void storePresets();
+    float stepsPerSecond() const;
+    void addHeader(JsonDocument &doc, ScanState current, uint16_t count);
+    void push();
+};
+
+#endif // BANDSCANNER_H
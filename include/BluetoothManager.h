@@ -4,7 +4,9 @@
 #include <Arduino.h>
 #include "BluetoothA2DPSink.h"
 #include "FileManager.h"
+#include "SettingsStore.h"
 #include "Constants.h"
+#include "Metrics.h"
 
 struct MusicMetadata
 {
@@ -23,15 +25,23 @@ struct MusicMetadata
 class BluetoothManager
 {
 public:
-    BluetoothManager(FileManager *fileMgr);
+    BluetoothManager(FileManager *fileMgr, SettingsStore *settingsStore);
 
     // Khởi tạo cấu hình chân I2S nhưng CHƯA bật Bluetooth
     void begin();
 
-    // Điều khiển Nguồn (Bật/Tắt Stack)
+    // Điều khiển Nguồn (Bật/Tắt Stack). Bật khi đang standby: chỉ phát tiếp, không khởi động lại stack
     void setPower(bool enable);
     bool isPowered() const { return _isPowered; }
 
+    // Standby: giữ stack A2DP và kết nối với điện thoại, tạm dừng phát (AVRC pause).
+    // setPower(true) sau đó chỉ mất một lệnh play thay vì khởi động lại cả stack
+    void standby();
+    bool isStandby() const { return _standby; }
+    // Âm lượng ra I2S khi chuyển nguồn (fade), không đổi âm lượng đã lưu
+    void setOutputLevel(uint8_t level);
+    bool isConnected() { return _isPowered && a2dp_sink.is_connected(); }
+
     // Điều khiển nhạc
     void play();
     void pause();
@@ -47,15 +57,28 @@ public:
 
     // Callbacks (Cần để nhận metadata từ điện thoại)
     static void metadataCallback(uint8_t id, const uint8_t *text);
+    // Trạng thái kết nối A2DP (task Bluetooth): trace và thời gian kết nối
+    static void connectionCallback(esp_a2d_connection_state_t state, void *obj);
+    // Thời gian từ lúc bật stack (hoặc mất kết nối) tới khi điện thoại kết nối (GET /api/metrics)
+    void writeMetrics(MetricsWriter &out);
+    // Tăng mỗi khi metadata đổi (để phát hiện thay đổi mà không so sánh chuỗi)
+    static uint32_t getMetadataVersion() { return _metaVersion; }
     void confirmPinCode(long pinCode);
 
 private:
     BluetoothA2DPSink a2dp_sink;
     FileManager *fileManager;
+    SettingsStore *settings; // Âm lượng lưu trong NVS
 
     bool _isPowered = false;
+    bool _standby = false; // Stack vẫn chạy nhưng không phải nguồn đang phát
     uint8_t _currentVolume = 64; // Mặc định 50%
     static MusicMetadata _meta;
+    static SemaphoreHandle_t _metaLock; // Bảo vệ _meta giữa task Bluetooth và Web Server
+    static volatile uint32_t _metaVersion;
+    static Histogram _connectTime;
+    static volatile uint32_t _connectStartMs; // 0: không chờ kết nối
+    static volatile uint32_t _connections;
 
     void loadConfig();
     void saveConfig();
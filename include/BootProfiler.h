@@ -0,0 +1,66 @@
+#ifndef BOOTPROFILER_H
+#define BOOTPROFILER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+
+// =========================================================
+// Thời gian khởi động theo từng pha
+// =========================================================
+// setup() chia thành các pha theo thứ tự phụ thuộc; pha không phụ thuộc nhau
+// chạy song song (kết nối Wi-Fi chạy trong task riêng trong lúc loopTask khởi
+// động thẻ SD, I2C, task control và phát lại nguồn cuối). Mỗi pha ghi mốc
+// bắt đầu/kết thúc (millis() từ lúc cấp nguồn) và core chạy nó; báo cáo được
+// in ra Serial khi setup() xong và trả qua GET /api/system/boot.
+//
+//     uint8_t sd = bootProfiler.start("sd");
+//     ...
+//     bootProfiler.finish(sd, ok);
+//     bootProfiler.waitFor(sd);           // Từ task khác: chờ pha xong
+
+#define BOOT_MAX_PHASES 12
+#define BOOT_WAIT_POLL_MS 5
+
+// Task kết nối Wi-Fi lúc khởi động (core 0 cùng stack Wi-Fi, tự xóa khi xong)
+#define BOOT_NET_TASK_NAME "boot_net"
+#define BOOT_NET_TASK_CORE 0
+#define BOOT_NET_TASK_PRIORITY 2
+#define BOOT_NET_TASK_STACK 6144
+
+class BootProfiler
+{
+public:
+    // Mọi task: mở một pha, trả về id dùng cho finish()/waitFor()
+    // (BOOT_MAX_PHASES nếu bảng đầy: pha không được ghi)
+    uint8_t start(const char *name);
+    void finish(uint8_t id, bool ok = true);
+    // Chờ một pha (của task khác) xong; trả về thời gian đã chờ (ms)
+    uint32_t waitFor(uint8_t id);
+
+    // Gọi cuối setup(): tổng thời gian và bảng các pha ra Serial
+    void complete();
+
+    // Mốc của từng pha và tổng thời gian setup() (mọi task)
+    void getReport(JsonDocument &doc);
+
+private:
+    struct Phase
+    {
+        const char *name;
+        uint32_t startMs;
+        uint32_t endMs;
+        int8_t core;
+        bool done;
+        bool ok;
+    };
+
+    Phase phases[BOOT_MAX_PHASES] = {};
+    volatile uint8_t count = 0;
+    volatile uint32_t completedMs = 0; // 0: setup() chưa xong
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    bool isDone(uint8_t id);
+};
+
+#endif // BOOTPROFILER_H
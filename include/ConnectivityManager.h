@@ -2,9 +2,9 @@
 #define CONNECTIVITYMANAGER_H
 
 #include <WiFi.h>
-#include <Preferences.h>
 #include <ArduinoJson.h>
 #include "FileManager.h"
+#include "SettingsStore.h"
 #include "Constants.h" // Cần để truy cập FileManager
 
 
@@ -16,8 +16,8 @@ public:
         int rssi;
     };
     
-    // Constructor nhận FileManager
-    ConnectivityManager(FileManager* fileManager);
+    // Constructor nhận FileManager (cấu hình AP) và SettingsStore (thông tin Wi-Fi trong NVS)
+    ConnectivityManager(FileManager* fileManager, SettingsStore* settingsStore);
 
     // Hàm chính khởi tạo và thiết lập chế độ Wi-Fi
     // Trả về TRUE nếu ở chế độ Operational (STA), FALSE nếu ở chế độ Provisioning (AP+STA)
@@ -36,9 +36,21 @@ public:
     // Trả về một JsonArray chứa danh sách mạng
     void getScanResults(JsonArray& array);
 
-    // API: Kiểm tra Credentials và lưu nếu thành công
-    // Trả về true nếu thành công và đã gọi reset, false nếu thất bại/timeout.
-    bool checkAndSaveCredentials(const String& ssid, const String& pass);
+    // Trạng thái kiểm tra Credentials chạy nền
+    enum CredentialCheckState {
+        CHECK_IDLE,
+        CHECK_PENDING,
+        CHECK_SUCCESS,
+        CHECK_FAILED
+    };
+
+    // API: Bắt đầu kiểm tra Credentials (Non-blocking), lưu nếu kết nối thành công.
+    // Trả về false nếu đang có một lần kiểm tra khác hoặc không ở Provisioning.
+    bool startCredentialCheck(const String& ssid, const String& pass);
+    CredentialCheckState getCredentialCheckState() const { return check_state; }
+
+    // Phải được gọi liên tục trong loop() để tiến hành kiểm tra Credentials
+    void loop();
 
     // API: Buộc đưa thiết bị về chế độ cấu hình (Change Network)
     // Thực hiện reset.
@@ -50,13 +62,23 @@ public:
 
 private:
     FileManager* fm;
+    SettingsStore* settings;
     bool operational_mode = false;
     int scan_state = -2; // -2: chưa quét, -1: đang quét, >=0: số mạng tìm thấy
 
-    // Hàm nội bộ: Tải Credentials từ SD Card
-    bool loadCredentials(String& ssid, String& pass, String& ap_ssid, String& ap_pass);
+    // Kiểm tra Credentials: handler HTTP chỉ ghi yêu cầu, loop() thực hiện
+    volatile CredentialCheckState check_state = CHECK_IDLE;
+    volatile bool check_requested = false;
+    String check_ssid, check_pass;
+    unsigned long check_start = 0;
+
+    // Hàm nội bộ: Tải Credentials từ NVS (lần đầu: chuyển từ wifi.json trên SD sang)
+    bool loadCredentials(String& ssid, String& pass);
+
+    // Hàm nội bộ: Tải tên/mật khẩu AP (chỉ cần ở chế độ Provisioning)
+    void loadApConfig(String& ap_ssid, String& ap_pass);
 
-    // Hàm nội bộ: Lưu Credentials vào SD Card
+    // Hàm nội bộ: Lưu Credentials vào NVS
     bool saveCredentials(const String& ssid, const String& pass);
 
     // Hàm nội bộ: Xóa Credentials
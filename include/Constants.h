@@ -20,6 +20,9 @@
 // =========================================================
 #define DEFAULT_WIFI_SSID "ESP32_Famio_AP"
 #define DEFAULT_WIFI_PASS "12345678"
+// AP cài đặt khi không có wifi.json (hoặc không có thẻ SD)
+#define DEFAULT_AP_SSID "Famio_Setup_AP"
+#define DEFAULT_AP_PASS "12345678"
 #define MDNS_HOSTNAME "famio"
 
 #define STA_SSID_CONFIG_KEY "sta_ssid"
@@ -29,6 +32,7 @@
 #define AP_PWD_CONFIG_KEY "ap_password"
 
 #define CONNECTION_TIMEOUT_S 30
+#define CONNECTION_POLL_MS 50 // Chu kỳ kiểm tra kết nối STA lúc khởi động
 
 // =========================================================
 // 4. Cấu hình I2S cho DAC PCM5102A (Đã dời chân để tránh I2C)
@@ -41,6 +45,7 @@
 #define PROJECT_ROOT_DIR "/famio"
 #define CONFIG_FILE_PATH "/config" // Đường dẫn file config Wi-Fi trên SD Card
 #define UI_PATH "/ui"
+#define UI_BUNDLE_FILE "/ui.pack" // Gói UI do tools/pack_ui.py tạo, ưu tiên hơn thư mục /ui
 #define WIFI_CONFIG_FILE "/wifi.json"
 #define COMMON_CONFIG_FILE "/common.json"
 #define BT_CONFIG_FILE "/bluetooth.json"
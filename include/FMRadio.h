@@ -6,9 +6,13 @@
 #include <ArduinoJson.h>   // JSON support
 #include <RDA5807.h>       // PU2CLR RDA5807 library
 #include "FileManager.h"
+#include "SettingsStore.h"
+#include "StationStore.h"
+#include "RdsDecoder.h"
+#include "SignalHistory.h"
+#include "Metrics.h"
 
 #define FM_CONFIG_FILE "/config/fm.json" 
-#define MAX_CHANNELS 10    // Maximum number of saved channels
 
 // RDA5807 library configuration
 // Band options: 0=FM World (87-108MHz), 1=Japan wide (76-91MHz), 2=World wide (76-108MHz), 3=Special (65-76MHz or 50-65MHz)
@@ -16,24 +20,51 @@
 // Space options: 0=100kHz, 1=200kHz, 2=50kHz, 3=25kHz
 #define RDA5807_SPACE 0      // 100 kHz channel spacing
 
+// Channel numbers (READCHAN) <-> frequency in 10 kHz units
+#define RDA5807_BAND_BOTTOM 8700 // 87.0 MHz (RDA5807_BAND 0)
+#define RDA5807_BAND_TOP 10800   // 108.0 MHz
+static_assert(RDA5807_SPACE <= 2, "25 kHz spacing is not representable in 10 kHz units");
+#define RDA5807_STEP_10K (RDA5807_SPACE == 0 ? 10 : RDA5807_SPACE == 1 ? 20 : 5)
+
+// Sequential I2C access: a read from this address starts at register 0x0A
+#define RDA5807_I2C_SEQUENTIAL 0x10
+#define RDA5807_STATUS_REGS 6        // 0x0A-0x0F: status, RSSI/errors, RDS blocks A-D
+
+// Telemetry sampler: one burst read of the status registers per period feeds
+// both the status snapshot and the RDS decoder. RDS sends a group every
+// 87.6 ms, so above ~80 ms groups are lost (the status stays correct)
+#ifndef FM_SAMPLE_MS
+#define FM_SAMPLE_MS RDS_POLL_MS
+#endif
+
+// Power-on: wait for the tune to complete (STC) instead of fixed delays
+#define FM_READY_TIMEOUT_MS 1000
+#define FM_READY_POLL_MS 5
+
+// Last sample of the status registers
+struct TunerStatus
+{
+    uint16_t freq10k = 0;   // READCHAN
+    uint8_t rssi = 0;       // 0-63
+    bool stereo = false;
+    bool station = false;   // FM_TRUE: the channel carries a station
+    uint32_t sampledAt = 0; // millis()
+};
+
 class FMRadio {
 public:
     // Constructor
-    FMRadio(FileManager* fm);
+    FMRadio(FileManager* fm, SettingsStore* settings);
 
-    // Initialize I2C and RDA5807 chip
-    void begin();
+    // Power on: full setup the first time (config from NVS/SD, every register),
+    // afterwards a warm resume from powerDown(). Returns once the chip is tuned.
+    // silent: output level 0, for the source switch to fade in
+    void begin(bool silent = false);
+    bool lastStartWasWarm() const { return lastStartWarm; }
     
     // Set frequency in MHz (e.g., 99.5 for 99.5 MHz)
     void setFrequency(float freq_mhz);
     
-    // Auto seek - returns new frequency
-    float autoSeekNext();
-
-    // Hardware seek up/down
-    void seekUp();
-    void seekDown();
-
     // Stereo/Mono control
     void setStereo(bool enable);
 
@@ -43,35 +74,95 @@ public:
     
     // Volume control (0-15)
     void setVolume(uint8_t volume);
+    // Chip volume for fades; the saved volume does not change
+    void setOutputLevel(uint8_t level);
     uint8_t getVolume() const { return currentVolume; }
 
-    // Save configuration to SD card
+    // Save the station list to SD card (volume/frequency live in SettingsStore)
     void saveConfig();
-    // Channel management
-    void saveChannel(float freq_mhz);                
-    void selectSavedChannel(uint8_t index);         
-    void getSavedChannels(JsonDocument* doc);       
-    void deleteChannel(uint8_t index);
+    // Channel management. index = position in the preset order
+    void saveChannel(float freq_mhz);
+    void selectSavedChannel(uint16_t index);
+    // One page of the station list (see StationStore::page)
+    void getSavedChannels(JsonDocument* doc, uint16_t offset = 0, uint16_t limit = STATION_PAGE_SIZE, bool byFrequency = false, bool favoritesOnly = false);
+    void deleteChannel(uint16_t index);
+    void deleteStation(uint16_t freq10k);
+    // Frequency of a saved channel, 0 if the index is invalid
+    float getSavedChannel(uint16_t index);
+    // Name/favorite/position of a saved station (see StationStore::edit)
+    bool editStation(uint16_t freq10k, const char *name, int favorite, int position);
+    // Auto-store: replace the non-favorite stations with the ones found
+    void autostoreChannels(const uint16_t *freq10k, const uint8_t *rssiLevels, uint8_t count);
 
-    // Get receiver status (for WebServer)
+    // Get receiver status (for WebServer). Reads cached values only, no I2C
     void getStatus(JsonDocument* doc);
 
+    // Telemetry (control task): when FM_SAMPLE_MS has passed (or force), reads
+    // the status registers in one burst, publishes the TunerStatus snapshot and
+    // queues/decodes the RDS group. msUntilSample() is for the control queue timeout
+    void sample(bool force = false);
+    uint32_t msUntilSample() const;
+    // Snapshot of the last sample (any task, no I2C)
+    void getTunerStatus(TunerStatus &out);
+    // Bus transactions issued to the RDA5807 (a library call or a burst read each)
+    uint32_t getI2cTransactions() const { return i2cTransactions; }
+    // Transaction count and latency, RSSI (GET /api/metrics, any task)
+    void writeMetrics(MetricsWriter &out);
+    // Decoded station data and counters (any task, no I2C)
+    void getRds(JsonDocument *doc) { rds.toJson(*doc); }
+    uint32_t getRdsVersion() const { return rds.getVersion(); }
+    // RSSI/stereo history of the samples (any task, no I2C)
+    SignalHistory *getHistory() { return &history; }
+
+    // Band scan (BandScanner) and seek (StationSeeker): tune and measure
+    // without changing the current station
+    void beginScan();                               // Mute while the band is walked
+    void tuneScan(uint16_t freq10k);
+    void readSignal(uint8_t &rssiOut, bool &stereoOut, bool &stationOut);
+    void endScan();                                 // Back to the current station, unmute
+    void endSeek(uint16_t freq10k);                 // Stay on the channel found, unmute
+
+    bool getPowerState() const { return isPowered; }
+    int getRssi();
+    bool getStereo();
+
     // Get current frequency
     float getCurrentFrequency() const { return currentFreq; }
 
 private:
     RDA5807 rx;                         // RDA5807 receiver from library
     FileManager* fileManager;           // Reference to FileManager
+    SettingsStore* settings;            // Volume and last frequency (NVS)
     float currentFreq;                  // Current frequency in MHz
     bool isPowered;                     // Power state
-    int rssi;                           // Signal strength (RSSI)
+    TunerStatus tuner;                  // Published by sample(), guarded by tunerLock
+    portMUX_TYPE tunerLock = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t lastSample;                // millis() of the last burst read
+    volatile uint32_t i2cTransactions;
+    Histogram i2cLatency;               // Per transaction, written by the control task
     uint8_t currentVolume;              // Current volume (0-15)
-    float savedChannels[MAX_CHANNELS];  // Saved channel frequencies
-    uint8_t numSavedChannels;           // Number of saved channels
+    StationStore stations;              // Saved stations (thread-safe, PSRAM)
+    RdsDecoder rds;                     // RDS of the current station
+    SignalHistory history;              // Fed by sample(), gaps while off or scanning
+
+    // Power-on path and time to audio
+    bool configLoaded = false;          // Config read from NVS/SD (RAM is the newer copy after that)
+    bool chipConfigured = false;        // Registers written since boot, kept through powerDown()
+    bool lastStartWarm = false;
+    uint32_t coldStarts = 0;
+    uint32_t warmStarts = 0;
+    uint32_t warmFallbacks = 0;         // Warm starts that timed out and did a full setup
+    uint32_t lastColdMs = 0;
+    uint32_t lastWarmMs = 0;
 
     // Helper functions
-    void loadConfig();       // Load volume and channels from SD card
-    void updateStatus();     // Update RSSI from chip
+    void loadConfig();       // Load volume/frequency from NVS and channels from SD card
+    void coldStart(bool silent);
+    bool resume(bool silent);
+    bool waitTuned();
+    bool readStatusRegisters(uint16_t regs[RDA5807_STATUS_REGS]);
+    void countI2c(uint32_t startUs, uint8_t transactions);
+    void publishTuner(const TunerStatus &status);
 };
 
 #endif // FMRADIO_H
\ No newline at end of file
@@ -4,27 +4,136 @@
 #include "FS.h"
 #include "SD.h"
 #include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include "RecordLog.h"
+#include "Metrics.h"
 
 // Định nghĩa Pin CS cho SD Card (Điều chỉnh theo mạch của bạn)
 #define SD_CS_PIN 5 
 
+// Write-behind: saveJsonFile() chỉ cập nhật bản trong RAM, file được ghi ra SD sau
+#define WRITE_BEHIND_DELAY_MS 2000    // Ghi khi file không đổi thêm trong khoảng này
+#define WRITE_BEHIND_MAX_AGE_MS 10000 // Nhưng không giữ dữ liệu chưa ghi lâu hơn
+#define MAX_CACHED_FILES 8
+// Số file cấu hình tối đa lưu dạng log ghi nối tiếp (xem RecordLog.h)
+#define MAX_RECORD_LOGS 4
+
+// Gói UI (ui.pack, xem tools/pack_ui.py): mở một lần, index nằm trong RAM
+#define UI_BUNDLE_MAGIC "FUIP"
+#define UI_BUNDLE_VERSION 1
+#define UI_BUNDLE_MAX_ENTRIES 512
+#define UI_BUNDLE_FLAG_GZIP 1
+
+// Một mục trong index của gói, đúng bố cục trên thẻ (128 byte, little endian)
+struct BundleEntry {
+    char path[80];      // Đường dẫn URL, ví dụ "/index.html"
+    char mime[32];
+    uint32_t offset;    // Vị trí dữ liệu tính từ đầu file
+    uint32_t length;
+    uint32_t hash;      // FNV-1a của dữ liệu (dùng làm ETag)
+    uint32_t flags;     // UI_BUNDLE_FLAG_GZIP: dữ liệu đã nén gzip
+};
+static_assert(sizeof(BundleEntry) == 128, "BundleEntry phải khớp với tools/pack_ui.py");
+
 class FileManager {
 public:
+    FileManager();
+
     // Hàm khởi tạo và kiểm tra SD Card
     bool begin();
+
+    // Lưu file (ví dụ "/config/fm.json") dạng log ghi nối tiếp "/config/fm.log":
+    // dành cho file đổi thường xuyên (tần số, âm lượng). Gọi trước begin().
+    // loadJsonFile/saveJsonFile dùng như cũ; file .json cũ được chuyển sang log ở lần đọc đầu.
+    void useRecordLog(const char* path);
     
     // Hàm đọc JSON, sử dụng cú pháp tối ưu mà bạn đề xuất
+    // (đọc từ cache nếu file đã được lưu qua saveJsonFile)
     bool loadJsonFile(const char* path, JsonDocument* doc);
 
     // Hàm lưu JSON (cần thiết để lưu cấu hình Wi-Fi, Preset)
+    // Ghi trễ: nhiều lần lưu liên tiếp cùng một file chỉ tạo một lần ghi SD
     bool saveJsonFile(const char* path, const JsonDocument& doc);
 
+    // Ghi ra SD các file đã hết thời gian chờ (gọi định kỳ từ task storage)
+    void flushDue();
+    // Ghi ngay mọi file đang chờ (trước khi tắt nguồn/khởi động lại)
+    void flush();
+
+    // Thống kê cache: số lần lưu, số lần ghi SD tránh được, thời gian ghi
+    // (và với từng log: số record, số lần compact, byte ghi so với ghi lại cả file)
+    void getStats(JsonDocument& doc);
+    // Độ trễ và số byte đọc/ghi thẻ SD (GET /api/metrics)
+    void writeMetrics(MetricsWriter& out);
+
     // Hàm phục vụ file tĩnh (cho Web Server)
     File openFile(const char* path);
 
+    // Gói UI: tìm file theo đường dẫn URL (tìm nhị phân trong index, không chạm SD).
+    // nullptr nếu không có gói hoặc không có file. Con trỏ dùng được mãi mãi.
+    const BundleEntry* findBundleEntry(const char* path);
+    // Đọc len byte của entry từ vị trí offset (seek trong file gói đang mở)
+    size_t readBundle(const BundleEntry* entry, size_t offset, uint8_t* buf, size_t len);
+
 private:
     // Biến lưu trữ trạng thái khởi tạo
     bool sd_initialized = false;
+
+    struct CacheEntry {
+        bool used = false;
+        bool dirty = false;
+        String path;
+        String content;           // JSON đã serialize
+        uint32_t version = 0;     // Tăng mỗi lần nội dung đổi
+        uint32_t firstDirtyMs = 0;
+        uint32_t lastSaveMs = 0;
+    };
+    CacheEntry cache[MAX_CACHED_FILES];
+    // Cache được dùng từ task control, loopTask (Wi-Fi) và task storage
+    SemaphoreHandle_t cacheLock;
+
+    struct LogEntry {
+        String path;              // Đường dẫn JSON mà các module dùng
+        RecordLog log;
+    };
+    LogEntry logs[MAX_RECORD_LOGS];
+    uint8_t logCount = 0;
+    // Log được đọc lúc bật module (task control) và ghi từ task storage
+    SemaphoreHandle_t logLock;
+
+    // Gói UI luôn mở; các lần đọc dùng chung một File nên cần khóa
+    File bundleFile;
+    BundleEntry* bundleIndex = nullptr;
+    uint16_t bundleCount = 0;
+    SemaphoreHandle_t bundleLock;
+    uint32_t bundleReads = 0;
+
+    // Thống kê
+    uint32_t saveCount = 0;
+    uint32_t writesAvoided = 0;
+    uint32_t sdWrites = 0;
+    uint32_t sdWriteErrors = 0;
+    uint32_t lastFlushUs = 0;
+    uint32_t maxFlushUs = 0;
+    uint64_t totalFlushUs = 0;
+
+    // Metric (ghi từ nhiều task, không khóa)
+    Histogram sdReadLatency;
+    Histogram sdWriteLatency;
+    std::atomic<uint32_t> sdBytesRead{0};
+    std::atomic<uint32_t> sdBytesWritten{0};
+
+    int findEntry(const char* path);
+    bool flushEntry(int index);
+    bool writeFile(const String& fullPath, const String& content);
+    bool readJsonFile(const String& fullPath, JsonDocument* doc);
+    int findLog(const char* path);
+    bool loadFromLog(int index, const char* path, JsonDocument* doc);
+    bool saveToLog(int index, const String& content);
+    bool persist(const String& path, const String& content);
+    void recordFlush(uint32_t elapsedUs, bool ok);
+    bool openBundle();
 };
 
 #endif // FILEMANAGER_H
\ No newline at end of file
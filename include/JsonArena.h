@@ -0,0 +1,107 @@
+#ifndef JSONARENA_H
+#define JSONARENA_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+// =========================================================
+// Bộ nhớ cho JsonDocument trong PSRAM
+// =========================================================
+// DRAM nội là thứ stack Bluetooth/Wi-Fi cần; JsonDocument tạm (handler HTTP,
+// đọc/ghi cấu hình) không cần nằm ở đó.
+//
+// JsonArena: vùng PSRAM cấp một lần, chia cho mỗi task một region. Cấp phát chỉ
+// là tăng con trỏ; JsonArena::Scope ghi lại vị trí lúc mở và trả cả region về đó
+// khi đóng (mỗi request / mỗi lần đọc-ghi cấu hình). Cách dùng:
+//
+//     JsonArena::Scope scope;                   // khai báo TRƯỚC document
+//     JsonDocument doc(&JsonArena::instance());
+//
+// Hàm mở Scope chỉ được làm lớn document do chính nó tạo: document của hàm gọi
+// mà lớn thêm bên trong Scope sẽ mất phần mới khi Scope đóng. Vì vậy hàm nhận
+// JsonDocument& từ nơi khác (getStatus, loadJsonFile, RecordLog) không mở Scope.
+//
+// Cấp phát ngoài Scope, khi region đầy hoặc khi hết region thì lấy từ PSRAM heap
+// (ps_malloc), chỉ khi không có PSRAM mới dùng heap nội. Document sống lâu
+// (giữ qua nhiều lần gọi) dùng PsramAllocator thay vì arena.
+
+#define JSON_ARENA_REGIONS 6                // Số task dùng arena (web, control, storage, loop, ...)
+#define JSON_ARENA_REGION_SIZE (24 * 1024)  // Mỗi task
+
+class JsonArena : public Allocator
+{
+public:
+    static JsonArena &instance();
+
+    // Cấp vùng PSRAM, gọi sớm trong setup(). Trước đó mọi cấp phát đi thẳng ps_malloc
+    bool begin();
+
+    void *allocate(size_t size) override;
+    void deallocate(void *ptr) override;
+    void *reallocate(void *ptr, size_t newSize) override;
+
+    // Mở một phạm vi cấp phát cho task hiện tại (lồng nhau được)
+    class Scope
+    {
+    public:
+        Scope();
+        ~Scope();
+        Scope(const Scope &) = delete;
+        Scope &operator=(const Scope &) = delete;
+
+    private:
+        int region;
+        size_t mark;
+    };
+
+    // Task sắp kết thúc (vTaskDelete) trả region của nó cho task khác
+    void releaseTask();
+
+    // Số lần task hiện tại phải lấy heap nội (PSRAM không có/hết) cho JSON
+    uint32_t internalAllocations();
+
+    // Đỉnh dùng của từng region, số lần tràn, heap nội còn trống
+    void getStats(JsonDocument &doc);
+
+private:
+    struct Region
+    {
+        TaskHandle_t owner = nullptr;
+        size_t top = 0;
+        size_t peak = 0;
+        size_t lastBlock = SIZE_MAX; // Block cuối (thu hồi/nới rộng tại chỗ được)
+        uint8_t depth = 0;
+        uint32_t allocations = 0;
+        uint32_t overflows = 0; // Region đầy hoặc ngoài Scope: lấy PSRAM heap
+        uint32_t internal = 0;  // Phải lấy heap nội
+        uint32_t scopes = 0;
+    };
+
+    uint8_t *memory = nullptr;
+    Region regions[JSON_ARENA_REGIONS];
+    portMUX_TYPE mux = portMUX_INITIALIZER_UNLOCKED;
+    uint32_t unownedInternal = 0;
+
+    JsonArena() {}
+    int currentRegion(bool claim);
+    int regionOf(const void *ptr);
+    void *heapAllocate(size_t size, Region *region);
+};
+
+// Document sống lâu: PSRAM heap thường (không reset theo Scope)
+class PsramAllocator : public Allocator
+{
+public:
+    static PsramAllocator &instance();
+
+    void *allocate(size_t size) override;
+    void deallocate(void *ptr) override;
+    void *reallocate(void *ptr, size_t newSize) override;
+
+private:
+    PsramAllocator() {}
+};
+
+#endif // JSONARENA_H
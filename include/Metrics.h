@@ -0,0 +1,88 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+
+// =========================================================
+// Metric dạng Prometheus (GET /api/metrics)
+// =========================================================
+// Histogram: các bucket cố định (giới hạn trên, µs), mỗi bucket một bộ đếm
+// nguyên tử. observe() chỉ là một vòng so sánh và hai fetch_add: không khóa,
+// không cấp phát, gọi được từ mọi task. Histogram phải nằm trong RAM nội
+// (biến toàn cục/thành viên của module): thao tác nguyên tử không chạy trên PSRAM.
+//
+// MetricsWriter ghi bản text exposition format (version 0.0.4) vào một buffer
+// PSRAM cấp theo request, rồi được gửi từng đoạn. Mỗi module tự ghi metric của
+// nó (writeMetrics()), giống getStats() cho các API JSON.
+
+#define HISTOGRAM_MAX_BOUNDS 13
+
+// Độ trễ chung: 50 µs .. 1 s (handler HTTP, thẻ SD, I2C)
+extern const uint32_t HISTOGRAM_LATENCY_US[];
+extern const uint8_t HISTOGRAM_LATENCY_COUNT;
+// Thời gian kết nối: 0,5 s .. 60 s (A2DP)
+extern const uint32_t HISTOGRAM_CONNECT_US[];
+extern const uint8_t HISTOGRAM_CONNECT_COUNT;
+
+class Histogram
+{
+public:
+    Histogram(const uint32_t *bounds = HISTOGRAM_LATENCY_US, uint8_t count = HISTOGRAM_LATENCY_COUNT);
+    Histogram(const Histogram &) = delete;
+    Histogram &operator=(const Histogram &) = delete;
+
+    void observe(uint32_t us);
+
+    struct Snapshot
+    {
+        uint32_t buckets[HISTOGRAM_MAX_BOUNDS + 1]; // Không cộng dồn; phần tử cuối là +Inf
+        uint32_t count;
+        uint64_t sumUs;
+    };
+    void snapshot(Snapshot &out) const;
+
+    const uint32_t *getBounds() const { return bounds; }
+    uint8_t getBoundCount() const { return boundCount; }
+
+private:
+    const uint32_t *bounds;
+    uint8_t boundCount;
+    std::atomic<uint32_t> buckets[HISTOGRAM_MAX_BOUNDS + 1];
+    // Tổng 64 bit từ hai từ 32 bit (atomic 64 bit trên ESP32 phải khóa)
+    std::atomic<uint32_t> sumUs;
+    std::atomic<uint32_t> sumWraps;
+};
+
+class MetricsWriter
+{
+public:
+    explicit MetricsWriter(size_t capacity);
+    ~MetricsWriter();
+    MetricsWriter(const MetricsWriter &) = delete;
+    MetricsWriter &operator=(const MetricsWriter &) = delete;
+
+    bool ok() const { return text != nullptr; }
+
+    // # HELP / # TYPE của một metric (type: counter, gauge, histogram)
+    void family(const char *name, const char *type, const char *help);
+    // labels: nullptr hoặc dạng key="value",key2="value2"
+    void sample(const char *name, const char *labels, double value);
+    // _bucket (cộng dồn, le theo giây), _sum, _count
+    void histogram(const char *name, const char *labels, const Histogram &histogram);
+
+    // Phần text tiếp theo, tối đa maxLen byte; 0 = hết
+    size_t fill(uint8_t *buffer, size_t maxLen);
+    bool isTruncated() const { return truncated; }
+
+private:
+    char *text = nullptr;
+    size_t capacity = 0;
+    size_t length = 0;
+    size_t sent = 0;
+    bool truncated = false;
+
+    void append(const char *format, ...) __attribute__((format(printf, 2, 3)));
+};
+
+#endif // METRICS_H
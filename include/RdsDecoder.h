@@ -0,0 +1,128 @@
+#ifndef RDSDECODER_H
+#define RDSDECODER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// =========================================================
+// RDS decoder
+// =========================================================
+// The control task reads one RDS group per poll (registers 0x0A-0x0F in one
+// I2C burst) and pushes it into a ring buffer; process() drains the ring and
+// decodes PI, PTY/TP/TA/MS, the PS name (0A/0B), RadioText (2A/2B) and the
+// clock (4A). The host bench feeds recorded captures into the same ring.
+//
+// Block errors: every block carries the chip's error level (0 = clean,
+// 1 = 1-2 bits corrected, 2 = 3-5 corrected, 3 = uncorrectable). A group
+// whose block B is not usable is dropped. Text characters from clean blocks
+// are taken as is; characters from corrected blocks only once the same
+// characters arrive twice in a row at that position.
+//
+// Decoded values are published as an RdsInfo snapshot (with a version that
+// changes with it), so the status APIs never touch I2C.
+
+#define RDS_RING_SIZE 32     // Groups (~2.8 s at 11.4 groups/s)
+#define RDS_POLL_MS 40       // A group lasts 87.6 ms: poll twice per group
+#define RDS_PS_SIZE 8
+#define RDS_RT_SIZE 64
+#define RDS_MAX_BLER 2       // Highest block error level accepted for data
+#define RDS_BLER_LOST 3      // Uncorrectable (or missing in a capture)
+
+struct RdsGroup
+{
+    uint16_t block[4]; // A, B, C, D
+    uint8_t bler[4];   // Error level per block (0-3)
+};
+
+struct RdsClock
+{
+    uint16_t year;
+    uint8_t month;
+    uint8_t day;
+    uint8_t hour;          // UTC
+    uint8_t minute;
+    int8_t offsetHalfHours; // Local time offset
+};
+
+struct RdsInfo
+{
+    uint16_t pi = 0;       // 0 = no RDS on this channel (yet)
+    uint8_t pty = 0;
+    bool tp = false;
+    bool ta = false;
+    bool music = true;
+    bool hasPs = false;
+    bool hasRt = false;
+    bool hasClock = false;
+    char ps[RDS_PS_SIZE + 1] = "";
+    char rt[RDS_RT_SIZE + 1] = "";
+    RdsClock clock = {};
+};
+
+struct RdsStats
+{
+    uint32_t groups = 0;         // Pushed into the ring
+    uint32_t overflows = 0;      // Dropped because the ring was full
+    uint32_t decoded = 0;
+    uint32_t rejected = 0;       // Block B unusable
+    uint32_t corrected[4] = {};  // Blocks A-D with corrected errors
+    uint32_t lost[4] = {};       // Blocks A-D uncorrectable
+    float groupsPerSecond = 0;   // Decode rate over the last second
+};
+
+class RdsDecoder
+{
+public:
+    RdsDecoder();
+
+    // Producer side: false (and counted) if the ring is full
+    bool push(const RdsGroup &group);
+    // Consumer side: decodes up to maxGroups queued groups, returns how many
+    uint16_t process(uint16_t maxGroups = RDS_RING_SIZE);
+
+    // New channel: drops queued groups and the decoded station data
+    void reset();
+
+    // Snapshot for the status APIs (any task)
+    void getInfo(RdsInfo &out);
+    uint32_t getVersion() const { return version; }
+    const RdsStats &getStats() const { return stats; }
+
+    // Snapshot and counters as JSON (GET /api/fm/rds)
+    void toJson(JsonDocument &doc);
+
+private:
+    RdsGroup ring[RDS_RING_SIZE];
+    volatile uint16_t head = 0; // Next slot written by push()
+    volatile uint16_t tail = 0; // Next slot read by process()
+
+    // Decoder state (consumer side only)
+    RdsInfo working;
+    char psCandidate[RDS_PS_SIZE];
+    char rtText[RDS_RT_SIZE];
+    char rtCandidate[RDS_RT_SIZE];
+    uint8_t psReceived = 0;   // Bit per 2-character segment
+    uint16_t rtReceived = 0;  // Bit per segment (4 characters for 2A, 2 for 2B)
+    int8_t rtAbFlag = -1;
+    uint8_t rtLength = RDS_RT_SIZE;
+    bool dirty = false;
+
+    RdsStats stats;
+    uint32_t windowStart = 0;
+    uint32_t windowGroups = 0;
+
+    RdsInfo published;
+    volatile uint32_t version = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    void decode(const RdsGroup &group);
+    void decodePs(const RdsGroup &group);
+    void decodeRt(const RdsGroup &group, bool versionB);
+    void decodeClock(const RdsGroup &group);
+    static bool acceptChars(char *text, char *candidate, uint8_t pos, const uint8_t *chars, uint8_t count, uint8_t bler, bool &changed);
+    void clearStation();
+    void publish();
+    static char toAscii(uint8_t c);
+};
+
+#endif // RDSDECODER_H
@@ -0,0 +1,77 @@
+#ifndef RECORDLOG_H
+#define RECORDLOG_H
+
+#include "FS.h"
+#include "SD.h"
+#include <ArduinoJson.h>
+#include "JsonArena.h"
+
+// =========================================================
+// Log ghi nối tiếp (append-only) cho file cấu hình JSON
+// =========================================================
+// Thay vì xóa và ghi lại cả file, mỗi lần lưu chỉ nối thêm một record chứa các
+// khóa cấp 1 đã đổi, ví dụ {"volume":7}. Khi khởi động, các record được áp dụng
+// lần lượt để dựng lại trạng thái mới nhất.
+//
+// Định dạng file:  magic (4 byte) | record | record | ...
+// Record:          độ dài payload (2 byte) | CRC32 payload (4 byte) | payload JSON
+// Khóa có giá trị null trong payload nghĩa là khóa đó đã bị xóa.
+//
+// Mất điện giữa lúc ghi chỉ làm hỏng record cuối: khi đọc lại, việc áp dụng dừng
+// ở record đầu tiên sai CRC và log được ghi gọn lại (compact) ngay.
+// Compact ghi toàn bộ trạng thái thành một record vào file .tmp rồi đổi tên, nên
+// luôn còn một bản hợp lệ trên thẻ.
+
+#define RECORD_LOG_MAGIC 0x474F4C46UL  // "FLOG"
+#define RECORD_LOG_COMPACT_BYTES 4096 // Compact khi log lớn hơn (và lớn hơn 2 lần trạng thái, xem compactLimit)
+#define RECORD_MAX_PAYLOAD 1024
+
+struct RecordLogStats
+{
+    uint32_t appends = 0;
+    uint32_t compactions = 0;
+    uint32_t corruptLoads = 0;  // Số lần đọc gặp record hỏng (đã tự sửa)
+    uint64_t bytesWritten = 0;  // Byte thực sự ghi xuống SD (record + compact)
+    uint64_t logicalBytes = 0;  // Byte mà cách ghi lại cả file sẽ phải ghi
+    uint32_t lastWriteUs = 0;
+    uint32_t maxWriteUs = 0;
+    uint64_t totalWriteUs = 0;
+    uint32_t writes = 0;
+};
+
+class RecordLog
+{
+public:
+    // logPath: đường dẫn đầy đủ trên SD, ví dụ /famio/config/fm.log
+    void begin(const String &logPath);
+    const String &getPath() const { return path; }
+
+    // Dựng lại trạng thái mới nhất. false nếu chưa có log hợp lệ
+    bool load(JsonDocument &doc);
+
+    // Lưu trạng thái mới: chỉ nối thêm các khóa đã đổi so với lần lưu trước
+    bool save(const JsonDocument &state);
+
+    // Ghi toàn bộ trạng thái thành log mới (tmp + rename)
+    bool compact(const JsonDocument &state);
+
+    const RecordLogStats &getStats() const { return stats; }
+
+private:
+    String path;
+    String tmpPath;
+    JsonDocument current{&PsramAllocator::instance()}; // Trạng thái đã nằm trên thẻ
+    size_t logSize = 0;
+    size_t stateBytes = 0; // Cỡ JSON của trạng thái (bản compact)
+    bool loaded = false;
+    RecordLogStats stats;
+
+    bool replay(const char *file, JsonDocument &doc, size_t &validSize, bool &corrupt);
+    bool writeRecord(File &file, const uint8_t *payload, size_t len);
+    bool writeCompacted(const JsonDocument &state, size_t logicalBytes);
+    void recordWrite(uint32_t startUs, size_t bytes, size_t logicalBytes);
+    size_t compactLimit() const;
+    static void applyRecord(JsonDocument &doc, JsonObjectConst record);
+};
+
+#endif // RECORDLOG_H
@@ -0,0 +1,74 @@
+#ifndef RESPONSEWRITER_H
+#define RESPONSEWRITER_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+#include <ArduinoJson.h>
+#include "JsonArena.h"
+
+// =========================================================
+// Trả response JSON không cấp phát heap
+// =========================================================
+// Thay cho "serializeJson vào String rồi request->send()" và nối chuỗi String:
+// response được ghi thẳng vào một buffer cấp sẵn lúc khởi động (pool), rồi gửi
+// bằng response trỏ vào buffer đó (không copy). Buffer được trả về pool khi kết
+// nối đóng (request->onDisconnect), nên handler dùng sendJson()/sendf() không
+// được tự gọi onDisconnect nữa.
+//
+// JsonDocument của handler tạo bằng allocator() (JsonArena, trong Scope mà
+// AppWebServer mở quanh mỗi handler). Mọi cấp phát heap nội trên đường trả
+// response (JSON tràn sang heap nội, pool hết, response quá lớn) đều được đếm:
+// AppWebServer ghi lại số lần cấp phát của từng request.
+
+#define RESPONSE_POOL_SLOTS 4
+#define RESPONSE_BUFFER_SIZE 4096 // Response lớn hơn được stream (có cấp phát)
+#define RESPONSE_LINE_SIZE 256    // Giới hạn của sendf()
+
+class ResponseWriter
+{
+public:
+    // Cấp phát pool (PSRAM nếu có), gọi một lần trong AppWebServer::begin()
+    bool begin();
+
+    // Allocator cho JsonDocument của handler
+    Allocator *allocator() { return &JsonArena::instance(); }
+
+    // Serialize doc vào buffer của pool
+    void sendJson(AsyncWebServerRequest *request, int code, const JsonDocument &doc);
+    // Response ngắn theo format printf (thay cho nối String)
+    void sendf(AsyncWebServerRequest *request, int code, const char *format, ...) __attribute__((format(printf, 4, 5)));
+    // Chuỗi hằng (literal): gửi thẳng, không copy
+    void sendStatic(AsyncWebServerRequest *request, int code, const char *content, const char *contentType = "application/json");
+    // Handler tự ghi response vào buffer của pool (tối đa RESPONSE_BUFFER_SIZE):
+    // acquireBuffer() trả nullptr nếu pool hết; buffer đã lấy phải được gửi bằng sendBuffer()
+    uint8_t *acquireBuffer(int &slot);
+    void sendBuffer(AsyncWebServerRequest *request, int code, int slot, size_t len, const char *contentType = "application/json");
+
+    // Bao quanh một lần gọi handler; endRequest() trả số lần cấp phát của request
+    void beginRequest();
+    uint32_t endRequest();
+
+    void getStats(JsonDocument &doc);
+
+private:
+    char *pool = nullptr;
+    uint32_t freeSlots = 0; // Bit i = slot i đang rảnh
+    portMUX_TYPE poolMux = portMUX_INITIALIZER_UNLOCKED;
+
+    // Thống kê
+    uint32_t requestStart = 0;
+    uint32_t fallbacks = 0; // Lần gửi phải cấp phát (pool hết/response quá lớn)
+    uint32_t requests = 0;
+    uint32_t requestAllocs = 0;
+    uint32_t zeroAllocRequests = 0;
+    uint32_t maxAllocs = 0;
+    uint32_t pooledSends = 0;
+    uint32_t staticSends = 0;
+    size_t largestResponse = 0;
+
+    int acquire();
+    void release(int slot);
+    void sendSlot(AsyncWebServerRequest *request, int code, int slot, size_t len, const char *contentType = "application/json");
+};
+
+#endif // RESPONSEWRITER_H
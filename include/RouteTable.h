@@ -0,0 +1,97 @@
+#ifndef ROUTETABLE_H
+#define ROUTETABLE_H
+
+#include <Arduino.h>
+#include <ESPAsyncWebServer.h>
+
+// =========================================================
+// Bảng route tĩnh (dùng cho AppWebServer)
+// =========================================================
+// Bảng là một mảng constexpr sắp xếp theo (path, method), nằm trong flash:
+// không có std::function hay cấp phát heap cho từng route như server.on().
+// Tra bằng tìm kiếm nhị phân nên chi phí chỉ tăng theo log2(số route).
+// Kiểu Route bất kỳ có hai trường path (const char*) và method (WebRequestMethod).
+
+namespace RouteTable
+{
+    constexpr int compare(const char *a, const char *b)
+    {
+        while (*a && *a == *b)
+        {
+            a++;
+            b++;
+        }
+        return (unsigned char)*a - (unsigned char)*b;
+    }
+
+    // Dùng trong static_assert: tăng dần, không trùng (path, method)
+    template <typename Route, size_t N>
+    constexpr bool isSorted(const Route (&routes)[N])
+    {
+        for (size_t i = 1; i < N; i++)
+        {
+            int order = compare(routes[i - 1].path, routes[i].path);
+            if (order > 0 || (order == 0 && routes[i - 1].method >= routes[i].method))
+                return false;
+        }
+        return true;
+    }
+
+    // Vị trí route đầu tiên của path (các method của một path nằm liền nhau), -1 nếu không có
+    template <typename Route>
+    int findPath(const Route *routes, size_t count, const char *path)
+    {
+        size_t low = 0, high = count;
+        while (low < high)
+        {
+            size_t mid = (low + high) / 2;
+            if (compare(routes[mid].path, path) < 0)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+        return (low < count && compare(routes[low].path, path) == 0) ? (int)low : -1;
+    }
+
+    // Route khớp cả path và method, -1 nếu không có.
+    // allowed nhận các method đăng ký cho path (cho 405 và preflight OPTIONS).
+    template <typename Route>
+    int find(const Route *routes, size_t count, const char *path, WebRequestMethodComposite method, WebRequestMethodComposite &allowed)
+    {
+        allowed = 0;
+        int first = findPath(routes, count, path);
+        if (first < 0)
+            return -1;
+
+        int match = -1;
+        for (size_t i = first; i < count && compare(routes[i].path, path) == 0; i++)
+        {
+            allowed |= routes[i].method;
+            if (match < 0 && (routes[i].method & method))
+                match = (int)i;
+        }
+        return match;
+    }
+
+    // "GET, POST, OPTIONS" cho header Allow / Access-Control-Allow-Methods
+    inline void methodList(WebRequestMethodComposite methods, char *out, size_t size, bool withOptions = true)
+    {
+        static const struct
+        {
+            WebRequestMethod method;
+            const char *name;
+        } NAMES[] = {{HTTP_GET, "GET"}, {HTTP_POST, "POST"}, {HTTP_PUT, "PUT"}, {HTTP_PATCH, "PATCH"}, {HTTP_DELETE, "DELETE"}};
+
+        size_t used = 0;
+        out[0] = '\0';
+        for (const auto &entry : NAMES)
+        {
+            if ((methods & entry.method) && used < size)
+                used += snprintf(out + used, size - used, "%s%s", used ? ", " : "", entry.name);
+        }
+        if (withOptions && used < size)
+            snprintf(out + used, size - used, "%sOPTIONS", used ? ", " : "");
+    }
+}
+
+#endif // ROUTETABLE_H
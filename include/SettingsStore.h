@@ -0,0 +1,108 @@
+#ifndef SETTINGSSTORE_H
+#define SETTINGSSTORE_H
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <ArduinoJson.h>
+
+// =========================================================
+// Cài đặt "nóng" trong NVS (flash nội), SD chỉ giữ dữ liệu lớn
+// =========================================================
+// Âm lượng, tần số cuối, chế độ cuối (FM/BT) và thông tin Wi-Fi nằm trong NVS:
+// đọc lúc khởi động không cần mount FAT hay giải mã JSON, và vẫn có khi không có thẻ SD.
+// Danh sách kênh, file UI và log vẫn ở trên SD.
+//
+// Các setter chỉ đổi giá trị trong RAM; task storage ghi xuống NVS sau khi giá trị
+// không đổi thêm trong SETTINGS_COMMIT_DELAY_MS (kéo thanh âm lượng chỉ tạo một lần ghi).
+// Thông tin Wi-Fi được ghi ngay vì thường đi kèm khởi động lại.
+
+#define SETTINGS_NAMESPACE "famio"
+#define SETTINGS_COMMIT_DELAY_MS 1500
+#define SETTINGS_MAX_AGE_MS 10000
+
+// Khóa NVS (tối đa 15 ký tự)
+#define NVS_KEY_FM_VOLUME "fm_vol"
+#define NVS_KEY_FM_FREQ "fm_freq" // Đơn vị 10 kHz, ví dụ 9950 = 99.5 MHz
+#define NVS_KEY_BT_VOLUME "bt_vol"
+#define NVS_KEY_MODE "mode"
+#define NVS_KEY_STA_SSID "sta_ssid"
+#define NVS_KEY_STA_PASS "sta_pass"
+
+enum AudioMode : uint8_t
+{
+    MODE_OFF = 0,
+    MODE_FM = 1,
+    MODE_BT = 2,
+};
+
+class SettingsStore
+{
+public:
+    // Mở NVS và đọc mọi khóa vào RAM (gọi đầu tiên trong setup(), trước SD)
+    bool begin();
+
+    // has*(): NVS đã có giá trị chưa (chưa có thì module đọc bản cũ trên SD rồi chuyển sang)
+    bool hasFmState();
+    uint8_t getFmVolume();
+    float getFmFrequency();
+    void setFmVolume(uint8_t volume);
+    void setFmFrequency(float freqMhz);
+
+    bool hasBtVolume();
+    uint8_t getBtVolume();
+    void setBtVolume(uint8_t volume);
+
+    AudioMode getMode();
+    void setMode(AudioMode mode);
+
+    // false nếu NVS chưa từng lưu thông tin Wi-Fi. ssid rỗng = đã xóa (về Provisioning)
+    bool getWifiCredentials(String &ssid, String &pass);
+    bool setWifiCredentials(const String &ssid, const String &pass);
+
+    // Ghi xuống NVS các giá trị đã hết thời gian chờ (task storage gọi định kỳ)
+    void flushDue();
+    // Ghi ngay mọi giá trị đang chờ (trước khi khởi động lại)
+    void flush();
+
+    // Số lần ghi NVS, số thay đổi được gộp, thời gian ghi
+    void getStats(JsonDocument &doc);
+
+private:
+    enum : uint8_t
+    {
+        KEY_FM_VOLUME = 1 << 0,
+        KEY_FM_FREQ = 1 << 1,
+        KEY_BT_VOLUME = 1 << 2,
+        KEY_MODE = 1 << 3,
+    };
+
+    Preferences prefs;
+    bool ready = false;
+
+    // Giá trị hiện tại (RAM)
+    uint8_t fmVolume = 10;
+    uint16_t fmFreq = 9950;
+    uint8_t btVolume = 64;
+    uint8_t mode = MODE_OFF;
+
+    uint8_t present = 0; // Khóa đã có trong NVS
+    uint8_t dirty = 0;   // Khóa đổi nhưng chưa ghi
+    uint32_t firstDirtyMs = 0;
+    uint32_t lastChangeMs = 0;
+    // Setter chạy trong task control, flush trong task storage / loopTask
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+    // Preferences không an toàn khi dùng từ nhiều task cùng lúc
+    SemaphoreHandle_t prefsLock = nullptr;
+
+    // Thống kê
+    uint32_t changes = 0;
+    uint32_t commits = 0;
+    uint32_t lastCommitUs = 0;
+    uint32_t maxCommitUs = 0;
+    uint32_t bootLoadUs = 0;
+
+    void markDirty(uint8_t key);
+    bool commit();
+};
+
+#endif // SETTINGSSTORE_H
@@ -0,0 +1,89 @@
+#ifndef SIGNALHISTORY_H
+#define SIGNALHISTORY_H
+
+#include <Arduino.h>
+
+// =========================================================
+// Reception history (RSSI and stereo over time)
+// =========================================================
+// Two fixed rings of one byte per point: 1 s points for the last 10 minutes
+// (antenna positioning) and 1 min points for the last 24 hours. The telemetry
+// sampler adds every reading; a second closes into a 1 s point (mean RSSI,
+// stereo if most samples were), 60 of those into a 1 min point. Seconds
+// without samples (FM off, band scan) become gap points, so both rings stay
+// aligned with uptime. No allocation after construction; adding a sample is
+// a few additions.
+//
+// Point byte: bit 7 = stereo, bits 6-0 = RSSI (0-126, as the chip reports
+// it); 0xFF is a gap.
+//
+// Binary form (little endian), one header then the points oldest first:
+//   'F' 'H' version(1) level | step_s (2) | count (2) | end_s (4)
+// end_s is the uptime second the newest point ends at.
+//
+// JSON form: {"level":0,"step_s":1,"end_s":..,"count":..,"rssi":[..],"stereo":[..]}
+// "rssi" holds the first value, then the change from the previous point;
+// null is a gap and the value after a gap is absolute again. "stereo" holds
+// run lengths, alternately mono and stereo, starting with mono.
+
+#define HISTORY_SECONDS 600   // 1 s points: 10 minutes
+#define HISTORY_MINUTES 1440  // 1 min points: 24 hours
+#define HISTORY_LEVELS 2
+
+#define HISTORY_POINT_GAP 0xFF
+#define HISTORY_POINT_STEREO 0x80
+#define HISTORY_POINT_RSSI 0x7F
+
+#define HISTORY_BINARY_VERSION 1
+#define HISTORY_HEADER_SIZE 12
+
+class SignalHistory
+{
+public:
+    // Control task: one telemetry reading
+    void add(uint32_t nowMs, uint8_t rssi, bool stereo);
+    // Control task: closes the seconds that have passed (gaps if no samples)
+    void advance(uint32_t nowMs);
+
+    // Newest `points` points of a level (0 = seconds, 1 = minutes; 0 points =
+    // everything), written into buf. Return the length, 0 if it does not fit
+    size_t writeBinary(uint8_t level, uint16_t points, uint8_t *buf, size_t size);
+    size_t writeJson(uint8_t level, uint16_t points, char *buf, size_t size);
+
+private:
+    struct Ring
+    {
+        uint8_t *points;
+        uint16_t capacity;
+        uint16_t head;  // Next slot
+        uint16_t count;
+    };
+
+    uint8_t seconds[HISTORY_SECONDS];
+    uint8_t minutes[HISTORY_MINUTES];
+    Ring rings[HISTORY_LEVELS] = {{seconds, HISTORY_SECONDS, 0, 0}, {minutes, HISTORY_MINUTES, 0, 0}};
+    uint32_t endSecond[HISTORY_LEVELS] = {}; // Uptime second the newest point of each level ends at
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    // Current second
+    bool started = false;
+    uint32_t clockMs = 0;  // millis() at the last advance
+    uint64_t uptimeMs = 0; // Does not wrap with millis()
+    uint32_t second = 0;
+    uint16_t sampleCount = 0;
+    uint16_t stereoCount = 0;
+    uint32_t rssiSum = 0;
+
+    // Current minute (from closed seconds)
+    uint8_t minuteSeconds = 0;
+    uint8_t minuteValid = 0;
+    uint8_t minuteStereo = 0;
+    uint16_t minuteRssiSum = 0;
+
+    void closeSecond();
+    void push(uint8_t level, uint8_t point);
+    uint16_t snapshot(uint8_t level, uint16_t points, uint8_t *out, uint32_t &end);
+    static uint8_t makePoint(uint16_t valid, uint16_t stereo, uint32_t rssiSum);
+};
+
+#endif // SIGNALHISTORY_H
@@ -0,0 +1,78 @@
+#ifndef SOURCEMANAGER_H
+#define SOURCEMANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "FMRadio.h"
+#include "BluetoothManager.h"
+#include "SettingsStore.h"
+
+// =========================================================
+// Chuyển nguồn âm thanh FM <-> Bluetooth
+// =========================================================
+// Trước đây mỗi lần đổi nguồn là tắt hẳn nguồn cũ (a2dp_sink.end(), mất kết
+// nối điện thoại) rồi khởi động lại nguồn mới từ đầu (stack A2DP, I2S), mất
+// vài giây. SourceManager (chạy trong task control) giữ nguồn không dùng ở
+// standby:
+//   - FM: chip powerDown, bật lại bằng warm resume (FMRadio::begin()).
+//   - Bluetooth: stack và kết nối vẫn giữ, chỉ pause; nếu heap nội còn dưới
+//     SOURCE_STANDBY_MIN_HEAP hoặc standby quá SOURCE_STANDBY_MS thì tắt hẳn.
+// Nguồn mới được bật ở mức 0 rồi crossfade với nguồn cũ trong SOURCE_FADE_MS.
+// Bluetooth bật nguội (stack mới) thì không fade: chưa có âm thanh cho tới khi
+// điện thoại kết nối lại.
+//
+// Độ trễ được đo từ lúc Web Server gửi lệnh (gồm thời gian chờ trong hàng đợi)
+// tới khi nguồn mới phát đủ âm lượng, theo từng loại chuyển (nguồn đích, nóng/nguội).
+
+#define SOURCE_FADE_MS 160
+#define SOURCE_FADE_STEPS 8
+#define SOURCE_STANDBY_MIN_HEAP (64 * 1024) // Heap nội tối thiểu để giữ stack Bluetooth khi nghe FM
+#define SOURCE_STANDBY_MS (15 * 60 * 1000UL) // Bluetooth standby lâu hơn thì tắt hẳn
+
+class SourceManager
+{
+public:
+    SourceManager(FMRadio *radio, BluetoothManager *bluetooth, SettingsStore *settingsStore);
+
+    // Task control: chuyển sang nguồn target (MODE_OFF = tắt hết). requestedAt =
+    // millis() lúc lệnh được gửi vào hàng đợi
+    void select(AudioMode target, uint32_t requestedAt);
+    // Tắt một nguồn: nếu đang phát thì về MODE_OFF; Bluetooth standby thì tắt hẳn
+    void stop(AudioMode source, uint32_t requestedAt);
+    // Gọi mỗi vòng task control: hết hạn standby
+    void tick();
+
+    AudioMode getActive() const { return active; }
+
+    // Nguồn hiện tại, standby và độ trễ chuyển nguồn (mọi task)
+    void getStatus(JsonDocument &doc);
+
+private:
+    struct SwitchStats
+    {
+        uint32_t count;
+        uint32_t lastMs;
+        uint32_t maxMs;
+        uint32_t totalMs;
+    };
+
+    FMRadio *fmRadio;
+    BluetoothManager *btManager;
+    SettingsStore *settings;
+
+    volatile AudioMode active = MODE_OFF;
+    uint32_t standbySince = 0;
+    // [nguồn đích][0 = nguội, 1 = nóng]
+    SwitchStats stats[3][2] = {};
+    uint32_t lastQueueMs = 0;
+    uint32_t btTeardowns = 0; // Standby Bluetooth bị tắt hẳn (thiếu heap/hết hạn)
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    void fade(AudioMode from, AudioMode to, bool fadeIn);
+    void setLevel(AudioMode source, uint8_t level);
+    uint8_t fullLevel(AudioMode source);
+    void parkBluetooth();
+    void record(AudioMode target, bool warm, uint32_t elapsedMs, uint32_t queueMs);
+};
+
+#endif // SOURCEMANAGER_H
@@ -0,0 +1,88 @@
+#ifndef STATIONSEEKER_H
+#define STATIONSEEKER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include "FMRadio.h"
+#include "StatusBroadcaster.h"
+
+// =========================================================
+// Seek to the next station
+// =========================================================
+// Replaces the chip's own seek (rx.seek() polls until the chip stops, which
+// held the control task, and the web request waiting on it, for seconds on a
+// quiet band). The seek is a job of the control task like the band scan:
+// each control loop pass tunes one channel or reads the one tuned on the
+// previous pass, and the first channel the chip flags as a station (FM_TRUE,
+// the same test its own seek uses) ends the job. The band wraps at the edges;
+// back at the start channel the seek fails and the radio returns there.
+//
+// A job gets its id from reserveId() before the command is queued, so the web
+// request answers at once. Progress is pushed as SSE "seek" events (at most
+// every SEEK_PUSH_MS and when the job ends) and returned by GET /api/fm/seek.
+// Commands that retune the chip, or DELETE /api/fm/seek, cancel the seek.
+
+#define SEEK_DWELL_MS 20   // Settle time before reading a channel
+#define SEEK_PUSH_MS 250   // Progress events at most this often
+
+enum SeekState : uint8_t
+{
+    SEEK_IDLE,
+    SEEK_RUNNING,
+    SEEK_FOUND,
+    SEEK_FAILED,    // Whole band walked without a station
+    SEEK_CANCELLED,
+};
+
+class StationSeeker
+{
+public:
+    StationSeeker(FMRadio *radio, StatusBroadcaster *broadcaster);
+
+    // Any task: id of the job the next seek command will start
+    uint32_t reserveId();
+
+    // Control task only. A running seek is replaced by the new one
+    void start(uint32_t id, bool up);
+    void cancel();
+    // Reads or tunes one channel if the dwell time has passed
+    void step();
+    uint32_t msUntilStep() const;
+
+    bool isRunning() const { return state == SEEK_RUNNING; }
+    uint32_t getJobId() const { return jobId; }
+
+    // Progress of the last job and seek durations (any task)
+    void getStatus(JsonDocument &doc);
+
+private:
+    FMRadio *fmRadio;
+    StatusBroadcaster *statusBroadcaster;
+
+    uint32_t lastId = 0;          // Last id handed out
+    volatile uint32_t jobId = 0;  // Job started last
+    volatile SeekState state = SEEK_IDLE;
+    bool up = true;
+    uint16_t fromFreq10k = 0;     // Station listened to when the seek started
+    volatile uint16_t freq10k = 0; // Channel being measured
+    volatile uint16_t channels = 0; // Channels measured so far
+    uint32_t startedAt = 0;
+    uint32_t tunedAt = 0;
+    uint32_t pushedAt = 0;
+    volatile uint32_t elapsedMs = 0;
+
+    // Durations of finished jobs
+    uint32_t seeks = 0;
+    uint32_t found = 0;
+    uint32_t failed = 0;
+    uint32_t cancelled = 0;
+    uint32_t foundMsTotal = 0;
+    uint32_t maxMs = 0;
+    portMUX_TYPE lock = portMUX_INITIALIZER_UNLOCKED;
+
+    uint16_t nextChannel(uint16_t freq) const;
+    void finish(SeekState result);
+    void push();
+};
+
+#endif // STATIONSEEKER_H
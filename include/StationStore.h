@@ -0,0 +1,97 @@
+#ifndef STATIONSTORE_H
+#define STATIONSTORE_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+
+// =========================================================
+// Saved stations
+// =========================================================
+// Stations are kept in one array sorted by frequency (10 kHz units), so a
+// lookup is a binary search. A second array holds the frequencies in preset
+// order (what the legacy index-based APIs and the UI list use). Both live in
+// PSRAM; inserting or removing moves at most a few KB with memmove, which is
+// cheaper on the ESP32 than allocating a node per station.
+//
+// On the card every station is its own top-level key of fm.json, e.g.
+// "9950": {"o":3,"r":41,"n":"VOV1","f":true}, so the RecordLog behind fm.json
+// appends only the stations an edit touched. The old {"channels":[...]}
+// layout is read once and dropped on the next save.
+
+#define STATION_CAPACITY 500
+#define STATION_NAME_SIZE 26    // UTF-8 bytes including '\0'
+#define STATION_PAGE_SIZE 32    // Default page of GET /api/fm/channels
+#define STATION_PAGE_MAX 64
+#define STATION_FREQ_MIN 8700   // 87.0 MHz
+#define STATION_FREQ_MAX 10800  // 108.0 MHz
+
+#define STATION_FAVORITE 0x01
+
+struct Station
+{
+    uint16_t freq10k;
+    uint16_t order;   // Preset order (ascending, may have gaps after deletes)
+    uint8_t rssi;     // Last RSSI seen when saved or scanned
+    uint8_t flags;    // STATION_FAVORITE
+    char name[STATION_NAME_SIZE];
+};
+
+class StationStore
+{
+public:
+    StationStore();
+
+    // Allocates the arrays (PSRAM if present); edits fail until this succeeds
+    bool begin();
+
+    uint16_t count();
+
+    // Adds a station at the end of the preset order. An existing station only
+    // gets its RSSI refreshed. false if the frequency is invalid or the store is full
+    bool add(uint16_t freq10k, uint8_t rssi, bool *created = nullptr);
+    bool remove(uint16_t freq10k);
+    bool find(uint16_t freq10k, Station &out);
+
+    // name == nullptr: keep; favorite < 0: keep; position < 0: keep
+    bool edit(uint16_t freq10k, const char *name, int favorite, int position);
+
+    // Preset order view (position = the "index" of the channel APIs), 0 if out of range
+    uint16_t frequencyAt(uint16_t position);
+
+    // Auto-store: drops every station that is not a favorite, then adds the
+    // given ones (names and favorites of stations found again are kept)
+    void replaceUnfavorites(const uint16_t *freq10k, const uint8_t *rssi, uint8_t count);
+
+    // One page of the list in preset or frequency order; returns the total
+    // number of stations matching the filter
+    uint16_t page(JsonArray out, uint16_t offset, uint16_t limit, bool byFrequency, bool favoritesOnly);
+
+    // fm.json <-> store. toJson writes every station as its own key
+    void fromJson(const JsonDocument &doc);
+    void toJson(JsonDocument &doc);
+
+    // Held across toJson and the save so snapshots reach the file in edit order
+    void lock() { xSemaphoreTakeRecursive(mutex, portMAX_DELAY); }
+    void unlock() { xSemaphoreGiveRecursive(mutex); }
+
+private:
+    Station *stations = nullptr; // Sorted by freq10k
+    uint16_t *byOrder = nullptr; // freq10k in preset order
+    uint16_t used = 0;
+    uint16_t nextOrder = 0;
+    SemaphoreHandle_t mutex;
+
+    // Index of freq10k, or -(insertion point + 1)
+    int indexOf(uint16_t freq10k) const;
+    int positionOf(uint16_t freq10k) const;
+    bool insert(uint16_t freq10k, uint16_t order, uint8_t rssi, uint8_t flags, const char *name);
+    void erase(int index);
+    void renumber();
+    void rebuildOrder();
+    static void copyName(char *dest, const char *name);
+    static void addEntry(JsonArray out, const Station &station, uint16_t position);
+};
+
+#endif // STATIONSTORE_H
@@ -0,0 +1,74 @@
+#ifndef STATUSBROADCASTER_H
+#define STATUSBROADCASTER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <ESPAsyncWebServer.h>
+#include "FMRadio.h"
+#include "BluetoothManager.h"
+
+// =========================================================
+// Đẩy trạng thái qua Server-Sent Events (GET /api/events)
+// =========================================================
+// Thay cho việc UI hỏi liên tục /api/fm/status và /api/bt/status: chỉ khi trạng
+// thái đổi mới serialize một lần, rồi cùng một frame được gửi cho mọi client.
+// Sự kiện "fm" và "bt" có cùng nội dung JSON với hai API trạng thái tương ứng.
+
+#define EVENTS_PATH "/api/events"
+#define EVENTS_RECONNECT_MS 3000 // Trình duyệt tự kết nối lại sau khoảng này
+#define RSSI_BUCKET_SIZE 4       // RSSI (0-63) gom theo nhóm để dao động nhỏ không tạo sự kiện
+
+class StatusBroadcaster
+{
+public:
+    StatusBroadcaster(FMRadio *radio, BluetoothManager *bluetooth);
+
+    // Đăng ký endpoint SSE vào Web Server
+    void begin(AsyncWebServer &server);
+
+    // Gọi định kỳ từ task control: so sánh trạng thái và đẩy frame nếu có thay đổi
+    void update();
+
+    // Sự kiện một lần (ví dụ kết quả quét băng tần), không giữ lại cho client mới
+    void sendEvent(const char *event, JsonDocument &doc);
+
+private:
+    struct FmState
+    {
+        bool powered;
+        uint16_t freq10k;
+        uint8_t rssiBucket;
+        bool stereo;
+        uint8_t volume;
+        uint32_t rdsVersion;
+    };
+
+    struct BtState
+    {
+        bool powered;
+        bool connected;
+        uint8_t volume;
+        uint32_t metaVersion;
+    };
+
+    AsyncEventSource events;
+    FMRadio *fmRadio;
+    BluetoothManager *btManager;
+
+    FmState lastFm;
+    BtState lastBt;
+    bool hasState = false;
+    uint32_t eventId = 0;
+
+    // Frame gần nhất, gửi ngay cho client mới kết nối (onConnect chạy trong async_tcp)
+    String fmFrame;
+    String btFrame;
+    SemaphoreHandle_t frameLock;
+
+    void readFmState(FmState &state);
+    void readBtState(BtState &state);
+    void publish(const char *event, String &frame, JsonDocument &doc);
+    void handleConnect(AsyncEventSourceClient *client);
+};
+
+#endif // STATUSBROADCASTER_H
@@ -0,0 +1,161 @@
+#ifndef TASKMANAGER_H
+#define TASKMANAGER_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include "FMRadio.h"
+#include "BluetoothManager.h"
+#include "StatusBroadcaster.h"
+#include "FileManager.h"
+#include "SettingsStore.h"
+#include "BandScanner.h"
+#include "StationSeeker.h"
+#include "SourceManager.h"
+
+// =========================================================
+// Bố trí task (core / priority / stack)
+// =========================================================
+// Core 0: WiFi/lwIP, Bluetooth controller (ESP-IDF) và async_tcp (Web Server,
+//         cấu hình bằng CONFIG_ASYNC_TCP_* trong platformio.ini).
+// Core 1: task "control" (mọi thao tác I2C với RDA5807, bật/tắt A2DP),
+//         task "storage" (ghi trễ cài đặt xuống NVS và file cấu hình xuống SD)
+//         và loopTask (ConnectivityManager).
+// Web Server không gọi phần cứng trực tiếp: nó gửi lệnh vào hàng đợi của task
+// control và trả lời ngay, nên một lần seek hay ghi SD không làm nghẽn UI.
+
+#define CONTROL_TASK_NAME "control"
+#define CONTROL_TASK_CORE 1
+#define CONTROL_TASK_PRIORITY 4 // Cao hơn loopTask (1), thấp hơn task I2S của A2DP
+#define CONTROL_TASK_STACK 6144
+#define CONTROL_QUEUE_LENGTH 8
+
+// Chu kỳ kiểm tra thay đổi trạng thái để đẩy qua SSE (metadata BT đổi ngoài task control)
+#define CONTROL_TICK_MS 100
+// Thời gian tối đa Web Server chờ một lệnh cần kết quả
+#define CONTROL_WAIT_MS 5000
+
+#define STORAGE_TASK_NAME "storage"
+#define STORAGE_TASK_CORE 1
+#define STORAGE_TASK_PRIORITY 2 // Thấp hơn task control: ghi SD không làm trễ lệnh radio
+#define STORAGE_TASK_STACK 4096
+#define STORAGE_CHECK_MS 500 // Chu kỳ kiểm tra cài đặt/file cần ghi
+
+// Số task tối đa trong báo cáo CPU
+#define MAX_REPORTED_TASKS 32
+
+enum ControlCommand : uint8_t
+{
+    CMD_FM_POWER_ON,
+    CMD_FM_POWER_OFF,
+    CMD_FM_SET_FREQ, // value = tần số * 100 (đơn vị 10 kHz)
+    CMD_FM_SET_VOLUME,
+    CMD_FM_SEEK_UP,   // value = id của job seek (StationSeeker::reserveId())
+    CMD_FM_SEEK_DOWN,
+    CMD_FM_SAVE_CHANNEL,
+    CMD_FM_SELECT_CHANNEL,
+    CMD_FM_DELETE_CHANNEL, // value = vị trí trong danh sách kênh
+    CMD_FM_DELETE_STATION, // value = tần số * 100
+    CMD_BT_POWER_ON,
+    CMD_BT_POWER_OFF,
+    CMD_BT_SET_VOLUME,
+    CMD_BT_PLAY,
+    CMD_BT_PAUSE,
+    CMD_BT_NEXT,
+    CMD_BT_PREVIOUS,
+    CMD_BT_CONFIRM_PIN,
+    CMD_FM_SCAN_START, // value = thời gian dừng mỗi kênh (ms)
+    CMD_FM_SCAN_CANCEL,
+    CMD_FM_AUTOSTORE, // Quét rồi thay danh sách kênh; value = thời gian dừng mỗi kênh (ms)
+    CMD_FM_SEEK_CANCEL,
+};
+
+struct ControlMessage
+{
+    ControlCommand cmd;
+    int32_t value;
+    uint32_t seq;       // Số thứ tự, dùng khi có task chờ kết quả
+    TaskHandle_t waiter; // nullptr = không chờ
+    uint32_t postedAt;  // millis() lúc gửi (đo độ trễ đầu-cuối)
+};
+
+class TaskManager
+{
+public:
+    TaskManager(FMRadio *radio, BluetoothManager *bluetooth, FileManager *fileMgr, SettingsStore *settingsStore, StatusBroadcaster *broadcaster, BandScanner *scanner, StationSeeker *seeker, SourceManager *sources);
+
+    // Tạo hàng đợi và task control (gọi sau Wire.begin())
+    bool begin();
+
+    // Gửi lệnh cho task control. waitMs > 0: chờ tối đa waitMs cho lệnh chạy xong.
+    // Trả về false nếu hàng đợi đầy (lệnh bị bỏ)
+    bool post(ControlCommand cmd, int32_t value = 0, uint32_t waitMs = 0);
+
+    // Đánh thức task storage để ghi ngay mọi cài đặt/file đang chờ
+    void requestFlush();
+
+    // Thời gian bận của loopTask (main.cpp đo quanh phần việc của loop())
+    void addLoopTime(uint32_t us) { addBusy(loopBusyUs, us); }
+
+    // Báo cáo core/priority/stack/CPU của các task
+    void getTaskReport(JsonDocument &doc);
+
+private:
+    FMRadio *fmRadio;
+    BluetoothManager *btManager;
+    FileManager *fileManager;
+    SettingsStore *settings;
+    StatusBroadcaster *statusBroadcaster;
+    BandScanner *bandScanner;
+    StationSeeker *stationSeeker;
+    SourceManager *sourceManager;
+
+    QueueHandle_t controlQueue = nullptr;
+    TaskHandle_t controlTask = nullptr;
+    TaskHandle_t storageTask = nullptr;
+    volatile uint32_t nextSeq = 0;
+    volatile uint32_t completedSeq = 0;
+    volatile uint32_t commandCount = 0;
+    volatile uint32_t droppedCount = 0;
+
+    // Thời gian bận (µs) đo trong code của mình, dùng khi không có run-time stats.
+    // Ghi ở core này, đọc ở core kia: truy cập 64 bit không nguyên tử trên ESP32 nên đi qua busyLock
+    uint64_t controlBusyUs = 0;
+    uint64_t storageBusyUs = 0;
+    uint64_t loopBusyUs = 0;
+    portMUX_TYPE busyLock = portMUX_INITIALIZER_UNLOCKED;
+    void addBusy(uint64_t &total, uint32_t us)
+    {
+        portENTER_CRITICAL(&busyLock);
+        total += us;
+        portEXIT_CRITICAL(&busyLock);
+    }
+
+    // Mốc của lần báo cáo trước để tính %CPU theo cửa sổ
+    int64_t lastReportUs = 0;
+    uint64_t lastControlBusyUs = 0;
+    uint64_t lastStorageBusyUs = 0;
+    uint64_t lastLoopBusyUs = 0;
+    uint32_t lastI2cTransactions = 0;
+    struct RuntimeSample
+    {
+        TaskHandle_t handle;
+        uint32_t runtime;
+    };
+    RuntimeSample lastRuntime[MAX_REPORTED_TASKS];
+    uint8_t lastRuntimeCount = 0;
+    uint32_t lastTotalRuntime = 0;
+
+    static void controlTaskEntry(void *arg);
+    void controlLoop();
+    void execute(const ControlMessage &msg);
+
+    static void storageTaskEntry(void *arg);
+    void storageLoop();
+
+    void addTaskEntry(JsonArray &tasks, const char *name, TaskHandle_t handle, float cpu); // cpu < 0: không rõ
+};
+
+#endif // TASKMANAGER_H
@@ -0,0 +1,152 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <Arduino.h>
+#include <atomic>
+#include <freertos/FreeRTOS.h>
+
+// =========================================================
+// Trace sự kiện (xuất dạng Chrome/Perfetto JSON)
+// =========================================================
+// Mỗi core một ring buffer trong PSRAM. Ghi một sự kiện chỉ là lấy chỗ bằng
+// fetch_add trên đầu ring (nằm trong RAM nội) rồi điền slot: không khóa, không
+// cấp phát, gọi được từ mọi task. Ring đầy thì sự kiện cũ nhất bị ghi đè.
+// Thời gian lấy từ esp_timer (µs từ lúc khởi động).
+//
+//     void FMRadio::setFrequency(float freq_mhz)
+//     {
+//         TRACE_SCOPE(TRACE_I2C, "fm.setFrequency"); // B lúc vào, E lúc ra
+//         ...
+//     }
+//     TRACE_INSTANT(TRACE_BT, "a2dp.connection", state);
+//
+// Tên sự kiện phải là chuỗi tĩnh (chỉ con trỏ được lưu). GET /api/system/trace
+// trả toàn bộ ring dưới dạng JSON mở được bằng chrome://tracing hoặc
+// ui.perfetto.dev. Build với -DTRACE_ENABLED=0 thì các macro thành rỗng.
+
+#ifndef TRACE_ENABLED
+#define TRACE_ENABLED 1
+#endif
+
+#define TRACE_CORES 2
+#define TRACE_RING_EVENTS 2048 // Mỗi core, lũy thừa của 2
+#define TRACE_TASK_NAME_LEN 10 // Tên task được chép vào sự kiện (task có thể đã bị xóa khi xuất)
+
+enum TraceCategory : uint8_t
+{
+    TRACE_HTTP,    // Handler API và file UI
+    TRACE_SD,      // Đọc/ghi thẻ SD
+    TRACE_I2C,     // Giao dịch I2C với RDA5807
+    TRACE_BT,      // Callback và lệnh A2DP/AVRC
+    TRACE_CONTROL, // Lệnh và job của task control
+    TRACE_CATEGORY_COUNT,
+};
+
+struct TraceEvent
+{
+    uint32_t seq;  // Số thứ tự + 1 của lần ghi slot; 0 = đang ghi/trống
+    uint32_t tsUs; // 32 bit thấp của esp_timer_get_time()
+    const char *name;
+    int32_t arg;
+    char phase; // 'B', 'E', 'i'
+    uint8_t category;
+    char task[TRACE_TASK_NAME_LEN];
+};
+
+class Trace
+{
+public:
+    // Cấp ring trong PSRAM, gọi sớm trong setup(). Trước đó sự kiện bị bỏ
+    static bool begin();
+
+    static void record(TraceCategory category, const char *name, char phase, int32_t arg = 0);
+
+    // Bản chụp các ring, sinh JSON theo từng đoạn (dùng cho chunked response)
+    class Export
+    {
+    public:
+        Export();
+        ~Export();
+        Export(const Export &) = delete;
+        Export &operator=(const Export &) = delete;
+
+        bool ok() const { return events != nullptr; }
+        // Ghi tối đa maxLen byte JSON tiếp theo; 0 = hết
+        size_t fill(uint8_t *buffer, size_t maxLen);
+
+    private:
+        enum Stage : uint8_t
+        {
+            STAGE_HEADER,
+            STAGE_CORES,
+            STAGE_TASKS,
+            STAGE_EVENTS,
+            STAGE_FOOTER,
+            STAGE_DONE,
+        };
+
+        TraceEvent *events = nullptr;
+        size_t count = 0;
+        uint32_t recorded = 0;
+        int64_t nowUs = 0;
+        size_t coreEnd[TRACE_CORES] = {}; // events xếp theo core: core i kết thúc ở coreEnd[i]
+
+        // Tên task khác nhau trong bản chụp (tid = vị trí + 1)
+        static const uint8_t MAX_TASKS = 24;
+        const char *tasks[MAX_TASKS] = {};
+        uint8_t taskCores[MAX_TASKS] = {}; // Bit i: task có sự kiện trên core i
+        uint8_t taskCount = 0;
+
+        Stage stage = STAGE_HEADER;
+        size_t cursor = 0;
+        char line[192];
+        size_t lineLen = 0;
+        size_t lineOffset = 0;
+
+        uint8_t taskId(const char *name);
+        bool nextLine();
+        void append(const char *format, ...);
+    };
+
+private:
+    static TraceEvent *rings;
+    static std::atomic<uint32_t> heads[TRACE_CORES];
+};
+
+#if TRACE_ENABLED
+
+// Ghi 'B' khi tạo, 'E' khi ra khỏi phạm vi
+class TraceScope
+{
+public:
+    TraceScope(TraceCategory category, const char *name) : category(category), name(name)
+    {
+        Trace::record(category, name, 'B');
+    }
+    ~TraceScope() { Trace::record(category, name, 'E', arg); }
+    // Giá trị kèm theo sự kiện 'E' (số byte, mã trạng thái...)
+    void setArg(int32_t value) { arg = value; }
+
+private:
+    TraceCategory category;
+    const char *name;
+    int32_t arg = 0;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+#define TRACE_SCOPE(category, name) TraceScope TRACE_CONCAT(traceScope, __LINE__)(category, name)
+#define TRACE_SCOPE_NAMED(var, category, name) TraceScope var(category, name)
+#define TRACE_SET_ARG(var, value) (var).setArg(value)
+#define TRACE_INSTANT(category, name, arg) Trace::record(category, name, 'i', arg)
+
+#else
+
+#define TRACE_SCOPE(category, name) ((void)0)
+#define TRACE_SCOPE_NAMED(var, category, name) ((void)0)
+#define TRACE_SET_ARG(var, value) ((void)0)
+#define TRACE_INSTANT(category, name, arg) ((void)0)
+
+#endif // TRACE_ENABLED
+
+#endif // TRACE_H
@@ -0,0 +1,357 @@
+#ifndef SIM_ARDUINO_H
+#define SIM_ARDUINO_H
+
+// =========================================================
+// Host stand-in for the Arduino-ESP32 core (env:native)
+// =========================================================
+// Only the subset of the core API that the firmware uses is provided.
+// String/Print/Stream keep the Arduino semantics so ArduinoJson can use
+// them through ARDUINOJSON_ENABLE_ARDUINO_* exactly like on the board.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#include <cstdlib>
+#include <cstdarg>
+#include <cmath>
+#include <string>
+#include <algorithm>
+
+// The ESP32 core pulls FreeRTOS in through Arduino.h
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+class String
+{
+public:
+    String() {}
+    String(const char *s) : s_(s ? s : "") {}
+    String(const char *s, size_t len) : s_(s ? std::string(s, len) : std::string()) {}
+    String(const std::string &s) : s_(s) {}
+    String(const String &other) = default;
+    String(String &&other) = default;
+    explicit String(char c) : s_(1, c) {}
+    explicit String(unsigned char value, unsigned char base = 10) { fromUnsigned(value, base); }
+    explicit String(int value, unsigned char base = 10) { fromSigned(value, base); }
+    explicit String(unsigned int value, unsigned char base = 10) { fromUnsigned(value, base); }
+    explicit String(long value, unsigned char base = 10) { fromSigned(value, base); }
+    explicit String(unsigned long value, unsigned char base = 10) { fromUnsigned(value, base); }
+    explicit String(long long value, unsigned char base = 10) { fromSigned(value, base); }
+    explicit String(unsigned long long value, unsigned char base = 10) { fromUnsigned(value, base); }
+    explicit String(float value, unsigned int decimals = 2) { fromDouble(value, decimals); }
+    explicit String(double value, unsigned int decimals = 2) { fromDouble(value, decimals); }
+
+    String &operator=(const String &other) = default;
+    String &operator=(String &&other) = default;
+    String &operator=(const char *s)
+    {
+        s_ = s ? s : "";
+        return *this;
+    }
+
+    const char *c_str() const { return s_.c_str(); }
+    unsigned int length() const { return (unsigned int)s_.size(); }
+    bool isEmpty() const { return s_.empty(); }
+    bool reserve(unsigned int size)
+    {
+        s_.reserve(size);
+        return true;
+    }
+
+    bool concat(const String &other)
+    {
+        s_ += other.s_;
+        return true;
+    }
+    bool concat(const char *s)
+    {
+        if (s)
+            s_ += s;
+        return true;
+    }
+    bool concat(const char *s, unsigned int len)
+    {
+        if (s)
+            s_.append(s, len);
+        return true;
+    }
+    bool concat(char c)
+    {
+        s_ += c;
+        return true;
+    }
+    template <typename T>
+    bool concat(T value) { return concat(String(value)); }
+
+    template <typename T>
+    String &operator+=(const T &value)
+    {
+        concat(value);
+        return *this;
+    }
+
+    bool equals(const String &other) const { return s_ == other.s_; }
+    bool equals(const char *s) const { return s_ == (s ? s : ""); }
+    bool equalsIgnoreCase(const String &other) const
+    {
+        if (s_.size() != other.s_.size())
+            return false;
+        for (size_t i = 0; i < s_.size(); i++)
+            if (tolower((unsigned char)s_[i]) != tolower((unsigned char)other.s_[i]))
+                return false;
+        return true;
+    }
+    bool operator==(const String &other) const { return equals(other); }
+    bool operator==(const char *s) const { return equals(s); }
+    bool operator!=(const String &other) const { return !equals(other); }
+    bool operator!=(const char *s) const { return !equals(s); }
+    bool operator<(const String &other) const { return s_ < other.s_; }
+
+    char charAt(unsigned int index) const { return index < s_.size() ? s_[index] : 0; }
+    char operator[](unsigned int index) const { return charAt(index); }
+    char &operator[](unsigned int index) { return s_[index]; }
+
+    bool startsWith(const String &prefix) const { return s_.compare(0, prefix.s_.size(), prefix.s_) == 0; }
+    bool endsWith(const String &suffix) const
+    {
+        return s_.size() >= suffix.s_.size() &&
+               s_.compare(s_.size() - suffix.s_.size(), suffix.s_.size(), suffix.s_) == 0;
+    }
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        size_t pos = s_.find(c, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int indexOf(const String &str, unsigned int from = 0) const
+    {
+        size_t pos = s_.find(str.s_, from);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    int lastIndexOf(char c) const
+    {
+        size_t pos = s_.rfind(c);
+        return pos == std::string::npos ? -1 : (int)pos;
+    }
+    String substring(unsigned int from) const { return from < s_.size() ? String(s_.substr(from)) : String(); }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        if (from > to)
+            std::swap(from, to);
+        if (from >= s_.size())
+            return String();
+        return String(s_.substr(from, to - from));
+    }
+
+    void trim()
+    {
+        size_t b = s_.find_first_not_of(" \t\r\n");
+        size_t e = s_.find_last_not_of(" \t\r\n");
+        s_ = (b == std::string::npos) ? std::string() : s_.substr(b, e - b + 1);
+    }
+    void toLowerCase()
+    {
+        for (auto &c : s_)
+            c = (char)tolower((unsigned char)c);
+    }
+    void toUpperCase()
+    {
+        for (auto &c : s_)
+            c = (char)toupper((unsigned char)c);
+    }
+    void replace(const String &find, const String &with)
+    {
+        if (find.s_.empty())
+            return;
+        size_t pos = 0;
+        while ((pos = s_.find(find.s_, pos)) != std::string::npos)
+        {
+            s_.replace(pos, find.s_.size(), with.s_);
+            pos += with.s_.size();
+        }
+    }
+    void remove(unsigned int index) { s_.erase(std::min<size_t>(index, s_.size())); }
+    void remove(unsigned int index, unsigned int count) { s_.erase(std::min<size_t>(index, s_.size()), count); }
+
+    long toInt() const { return strtol(s_.c_str(), nullptr, 10); }
+    float toFloat() const { return strtof(s_.c_str(), nullptr); }
+    double toDouble() const { return strtod(s_.c_str(), nullptr); }
+
+    friend String operator+(const String &a, const String &b) { return String(a.s_ + b.s_); }
+    friend String operator+(const String &a, const char *b) { return String(a.s_ + (b ? b : "")); }
+    friend String operator+(const char *a, const String &b) { return String((a ? a : "") + b.s_); }
+    friend String operator+(const String &a, char c) { return String(a.s_ + c); }
+
+private:
+    std::string s_;
+
+    void fromSigned(long long value, unsigned char base)
+    {
+        if (value < 0 && base == 10)
+        {
+            fromUnsigned((unsigned long long)(-value), base);
+            s_.insert(s_.begin(), '-');
+        }
+        else
+        {
+            fromUnsigned((unsigned long long)value, base);
+        }
+    }
+    void fromUnsigned(unsigned long long value, unsigned char base)
+    {
+        char buf[66];
+        char *p = buf + sizeof(buf) - 1;
+        *p = 0;
+        do
+        {
+            unsigned digit = (unsigned)(value % base);
+            *--p = (char)(digit < 10 ? '0' + digit : 'a' + digit - 10);
+            value /= base;
+        } while (value);
+        s_ = p;
+    }
+    void fromDouble(double value, unsigned int decimals)
+    {
+        char buf[64];
+        snprintf(buf, sizeof(buf), "%.*f", (int)decimals, value);
+        s_ = buf;
+    }
+};
+
+class Print
+{
+public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t n = 0;
+        while (size--)
+        {
+            if (!write(*buffer++))
+                break;
+            n++;
+        }
+        return n;
+    }
+    size_t write(const char *str) { return str ? write((const uint8_t *)str, strlen(str)) : 0; }
+    size_t write(const char *buffer, size_t size) { return write((const uint8_t *)buffer, size); }
+    virtual void flush() {}
+
+    size_t print(const String &s) { return write(s.c_str(), s.length()); }
+    size_t print(const char *s) { return write(s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(int n) { return print(String(n)); }
+    size_t print(unsigned int n) { return print(String(n)); }
+    size_t print(long n) { return print(String(n)); }
+    size_t print(unsigned long n) { return print(String(n)); }
+    size_t print(double n, int digits = 2) { return print(String(n, digits)); }
+
+    size_t println() { return write("\r\n"); }
+    template <typename T>
+    size_t println(const T &value)
+    {
+        size_t n = print(value);
+        return n + println();
+    }
+
+    size_t printf(const char *format, ...) __attribute__((format(printf, 2, 3)))
+    {
+        char stackBuf[256];
+        va_list args;
+        va_start(args, format);
+        int len = vsnprintf(stackBuf, sizeof(stackBuf), format, args);
+        va_end(args);
+        if (len < 0)
+            return 0;
+        if ((size_t)len < sizeof(stackBuf))
+            return write((const uint8_t *)stackBuf, len);
+        std::string heapBuf(len + 1, '\0');
+        va_start(args, format);
+        vsnprintf(&heapBuf[0], heapBuf.size(), format, args);
+        va_end(args);
+        return write((const uint8_t *)heapBuf.data(), len);
+    }
+};
+
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+
+    void setTimeout(unsigned long timeout) { _timeout = timeout; }
+
+    virtual size_t readBytes(char *buffer, size_t length)
+    {
+        size_t count = 0;
+        while (count < length)
+        {
+            int c = read();
+            if (c < 0)
+                break;
+            *buffer++ = (char)c;
+            count++;
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+
+protected:
+    unsigned long _timeout = 1000;
+};
+
+class HardwareSerial : public Stream
+{
+public:
+    void begin(unsigned long baud) { (void)baud; }
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *buffer, size_t size) override;
+    using Print::write;
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    void flush() override;
+};
+
+extern HardwareSerial Serial;
+
+class EspClass
+{
+public:
+    uint32_t getHeapSize();
+    uint32_t getFreeHeap();
+    uint32_t getMinFreeHeap();
+    uint32_t getMaxAllocHeap();
+    uint32_t getPsramSize();
+    uint32_t getFreePsram();
+    uint32_t getMinFreePsram();
+    uint32_t getMaxAllocPsram();
+    void restart() __attribute__((noreturn));
+};
+
+extern EspClass ESP;
+
+unsigned long millis();
+unsigned long micros();
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+long random(long howbig);
+long random(long howsmall, long howbig);
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+
+bool psramInit();
+void *ps_malloc(size_t size);
+void *ps_realloc(void *ptr, size_t size);
+
+#define log_e(format, ...) fprintf(stderr, "[E] " format "\n", ##__VA_ARGS__)
+#define log_w(format, ...) fprintf(stderr, "[W] " format "\n", ##__VA_ARGS__)
+#define log_i(format, ...) fprintf(stderr, "[I] " format "\n", ##__VA_ARGS__)
+
+#endif // SIM_ARDUINO_H
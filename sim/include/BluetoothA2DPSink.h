@@ -0,0 +1,81 @@
+#ifndef SIM_BLUETOOTHA2DPSINK_H
+#define SIM_BLUETOOTHA2DPSINK_H
+
+// =========================================================
+// Fake A2DP sink (ESP32-A2DP stand-in)
+// =========================================================
+// After start() a simulated phone connects (FAMIO_SIM_BT_CONNECT_MS,
+// default 1500 ms) and pushes AVRC metadata from its own thread, changing
+// track every FAMIO_SIM_BT_TRACK_S seconds (default 20), the same way the
+// Bluedroid task calls back into the firmware on the board.
+
+#include <Arduino.h>
+#include <atomic>
+#include <thread>
+
+#define I2S_PIN_NO_CHANGE (-1)
+
+typedef struct
+{
+    int bck_io_num;
+    int ws_io_num;
+    int data_out_num;
+    int data_in_num;
+} i2s_pin_config_t;
+
+typedef enum
+{
+    ESP_A2D_CONNECTION_STATE_DISCONNECTED = 0,
+    ESP_A2D_CONNECTION_STATE_CONNECTING,
+    ESP_A2D_CONNECTION_STATE_CONNECTED,
+    ESP_A2D_CONNECTION_STATE_DISCONNECTING
+} esp_a2d_connection_state_t;
+
+class BluetoothA2DPSink
+{
+public:
+    ~BluetoothA2DPSink() { end(); }
+
+    void set_pin_config(i2s_pin_config_t pin_config) { (void)pin_config; }
+    void set_avrc_metadata_callback(void (*callback)(uint8_t, const uint8_t *)) { _metadataCallback = callback; }
+    void set_on_connection_state_changed(void (*callback)(esp_a2d_connection_state_t state, void *), void *obj = nullptr)
+    {
+        _connectionCallback = callback;
+        _connectionObj = obj;
+    }
+    void activate_pin_code(bool active) { (void)active; }
+    int pin_code() { return 0; }
+    void confirm_pin_code(int code) { (void)code; }
+
+    void start(const char *name, bool auto_reconnect = true);
+    void end(bool release_memory = false);
+
+    void set_volume(uint8_t volume) { _volume = volume; }
+    int get_volume() { return _volume; }
+    bool is_connected() { return _connected.load(); }
+    esp_a2d_connection_state_t get_connection_state()
+    {
+        return _connected ? ESP_A2D_CONNECTION_STATE_CONNECTED : ESP_A2D_CONNECTION_STATE_DISCONNECTED;
+    }
+
+    void play() { _playing = true; }
+    void pause() { _playing = false; }
+    void stop() { _playing = false; }
+    void next() { _skip++; }
+    void previous() { _skip++; }
+
+private:
+    void (*_metadataCallback)(uint8_t, const uint8_t *) = nullptr;
+    void (*_connectionCallback)(esp_a2d_connection_state_t, void *) = nullptr;
+    void *_connectionObj = nullptr;
+    std::atomic<bool> _running{false};
+    std::atomic<bool> _connected{false};
+    std::atomic<bool> _playing{true};
+    std::atomic<int> _skip{0};
+    uint8_t _volume = 64;
+    std::thread _peer;
+
+    void peerLoop();
+};
+
+#endif // SIM_BLUETOOTHA2DPSINK_H
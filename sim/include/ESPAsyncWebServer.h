@@ -0,0 +1,443 @@
+#ifndef SIM_ESPASYNCWEBSERVER_H
+#define SIM_ESPASYNCWEBSERVER_H
+
+// =========================================================
+// Host stand-in for ESPAsyncWebServer (+ AsyncTCP)
+// =========================================================
+// One event thread multiplexes every connection with poll(), the same
+// model as the async_tcp task on the board: handlers run on that thread,
+// request bodies arrive in chunks through handleBody(), and the
+// connection is closed once the response has been written.
+
+#include <Arduino.h>
+#include <FS.h>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+typedef enum
+{
+    HTTP_GET = 0b00000001,
+    HTTP_POST = 0b00000010,
+    HTTP_DELETE = 0b00000100,
+    HTTP_PUT = 0b00001000,
+    HTTP_PATCH = 0b00010000,
+    HTTP_HEAD = 0b00100000,
+    HTTP_OPTIONS = 0b01000000,
+    HTTP_ANY = 0b01111111,
+} WebRequestMethod;
+
+typedef uint8_t WebRequestMethodComposite;
+
+class AsyncWebServer;
+class AsyncWebServerRequest;
+class AsyncWebServerResponse;
+class AsyncEventSource;
+
+typedef std::function<void(AsyncWebServerRequest *request)> ArRequestHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, const String &filename, size_t index,
+                           uint8_t *data, size_t len, bool final)>
+    ArUploadHandlerFunction;
+typedef std::function<void(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)>
+    ArBodyHandlerFunction;
+typedef std::function<void(void)> ArDisconnectHandler;
+typedef std::function<size_t(uint8_t *buffer, size_t maxLen, size_t index)> AwsResponseFiller;
+
+class AsyncWebHeader
+{
+public:
+    AsyncWebHeader(const String &name, const String &value) : _name(name), _value(value) {}
+    const String &name() const { return _name; }
+    const String &value() const { return _value; }
+
+private:
+    String _name;
+    String _value;
+};
+
+class AsyncWebParameter
+{
+public:
+    AsyncWebParameter(const String &name, const String &value, bool form = false)
+        : _name(name), _value(value), _isForm(form) {}
+    const String &name() const { return _name; }
+    const String &value() const { return _value; }
+    bool isPost() const { return _isForm; }
+    bool isFile() const { return false; }
+
+private:
+    String _name;
+    String _value;
+    bool _isForm;
+};
+
+// =========================================================
+// Responses
+// =========================================================
+
+class AsyncWebServerResponse
+{
+public:
+    virtual ~AsyncWebServerResponse() {}
+    void setCode(int code) { _code = code; }
+    int code() const { return _code; }
+    void setContentType(const char *type) { _contentType = type; }
+    bool addHeader(const char *name, const char *value, bool replaceExisting = true);
+    bool addHeader(const String &name, const String &value, bool replaceExisting = true)
+    {
+        return addHeader(name.c_str(), value.c_str(), replaceExisting);
+    }
+
+    // Serialises status line, headers and body (sim only)
+    std::string assemble(bool headOnly);
+
+    // Non-null when the connection turns into an event stream (sim only)
+    virtual AsyncEventSource *eventSource() { return nullptr; }
+
+protected:
+    int _code = 200;
+    String _contentType;
+    std::vector<AsyncWebHeader> _headers;
+    bool _chunked = false;
+    bool _keepOpen = false;
+
+    virtual void body(std::string &out) = 0;
+};
+
+class AsyncBasicResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncBasicResponse(int code, const String &contentType, const String &content);
+
+protected:
+    void body(std::string &out) override;
+
+private:
+    String _content;
+};
+
+// Serves a caller-owned buffer without copying it (AsyncProgmemResponse)
+class AsyncProgmemResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncProgmemResponse(int code, const String &contentType, const uint8_t *content, size_t len);
+
+protected:
+    void body(std::string &out) override;
+
+private:
+    const uint8_t *_content;
+    size_t _len;
+};
+
+class AsyncFileResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncFileResponse(File content, const String &path, const String &contentType, bool download);
+
+protected:
+    void body(std::string &out) override;
+
+private:
+    File _content;
+};
+
+class AsyncChunkedResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncChunkedResponse(const String &contentType, AwsResponseFiller callback);
+
+protected:
+    void body(std::string &out) override;
+
+private:
+    AwsResponseFiller _filler;
+};
+
+// Known length, body produced by the callback (AsyncCallbackResponse)
+class AsyncCallbackResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncCallbackResponse(const String &contentType, size_t len, AwsResponseFiller callback);
+
+protected:
+    void body(std::string &out) override;
+
+private:
+    size_t _len;
+    AwsResponseFiller _filler;
+};
+
+class AsyncResponseStream : public AsyncWebServerResponse, public Print
+{
+public:
+    AsyncResponseStream(const String &contentType, size_t bufferSize);
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t *data, size_t len) override;
+    using Print::write;
+
+protected:
+    void body(std::string &out) override;
+
+private:
+    std::string _buffer;
+};
+
+// =========================================================
+// Request
+// =========================================================
+
+class AsyncWebServerRequest
+{
+    friend class AsyncWebServer;
+
+public:
+    AsyncWebServerRequest(AsyncWebServer *server, int fd);
+    ~AsyncWebServerRequest();
+
+    void *_tempObject = nullptr;
+
+    WebRequestMethodComposite method() const { return _method; }
+    const char *methodToString() const;
+    const String &url() const { return _url; }
+    const String &contentType() const { return _contentType; }
+    size_t contentLength() const { return _contentLength; }
+
+    size_t params() const { return _params.size(); }
+    bool hasParam(const char *name, bool post = false, bool file = false) const;
+    bool hasParam(const String &name, bool post = false, bool file = false) const { return hasParam(name.c_str(), post, file); }
+    const AsyncWebParameter *getParam(const char *name, bool post = false, bool file = false) const;
+    const AsyncWebParameter *getParam(const String &name, bool post = false, bool file = false) const { return getParam(name.c_str(), post, file); }
+    const AsyncWebParameter *getParam(size_t num) const { return num < _params.size() ? &_params[num] : nullptr; }
+
+    bool hasArg(const char *name) const;
+    const String &arg(const char *name) const;
+
+    bool hasHeader(const char *name) const;
+    const AsyncWebHeader *getHeader(const char *name) const;
+    const String &header(const char *name) const;
+
+    void onDisconnect(ArDisconnectHandler fn) { _onDisconnect = fn; }
+
+    void send(AsyncWebServerResponse *response);
+    void send(int code, const char *contentType = "", const char *content = "")
+    {
+        send(beginResponse(code, String(contentType), String(content)));
+    }
+    void send(int code, const String &contentType, const String &content = String())
+    {
+        send(beginResponse(code, contentType, content));
+    }
+    void send(int code, const char *contentType, const uint8_t *content, size_t len)
+    {
+        send(beginResponse(code, contentType, content, len));
+    }
+    void send(File content, const String &path, const char *contentType = "", bool download = false)
+    {
+        send(beginResponse(content, path, contentType, download));
+    }
+
+    AsyncWebServerResponse *beginResponse(int code, const String &contentType = String(), const String &content = String());
+    AsyncWebServerResponse *beginResponse(int code, const char *contentType, const uint8_t *content, size_t len);
+    AsyncWebServerResponse *beginResponse(File content, const String &path, const String &contentType = String(), bool download = false);
+    AsyncWebServerResponse *beginResponse(const String &contentType, size_t len, AwsResponseFiller callback);
+    AsyncWebServerResponse *beginChunkedResponse(const String &contentType, AwsResponseFiller callback);
+    AsyncResponseStream *beginResponseStream(const String &contentType, size_t bufferSize = 1460);
+
+private:
+    AsyncWebServer *_server;
+    int _fd;
+    WebRequestMethodComposite _method = HTTP_GET;
+    String _url;
+    String _contentType;
+    size_t _contentLength = 0;
+    size_t _bodyReceived = 0;
+    std::vector<AsyncWebHeader> _headers;
+    std::vector<AsyncWebParameter> _params;
+    std::string _formBody;
+    bool _isForm = false;
+    ArDisconnectHandler _onDisconnect;
+    class AsyncWebHandler *_handler = nullptr;
+    AsyncWebServerResponse *_response = nullptr;
+    bool _responseSent = false;
+
+    void addQueryParams(const String &query, bool form);
+};
+
+// =========================================================
+// Handlers & server
+// =========================================================
+
+class AsyncWebHandler
+{
+public:
+    virtual ~AsyncWebHandler() {}
+    virtual bool canHandle(AsyncWebServerRequest *request) const
+    {
+        (void)request;
+        return false;
+    }
+    virtual void handleRequest(AsyncWebServerRequest *request) { (void)request; }
+    virtual void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+    {
+        (void)request;
+        (void)data;
+        (void)len;
+        (void)index;
+        (void)total;
+    }
+    virtual bool isRequestHandlerTrivial() const { return true; }
+};
+
+class AsyncCallbackWebHandler : public AsyncWebHandler
+{
+public:
+    void setUri(const String &uri) { _uri = uri; }
+    void setMethod(WebRequestMethodComposite method) { _method = method; }
+    void onRequest(ArRequestHandlerFunction fn) { _onRequest = fn; }
+    void onUpload(ArUploadHandlerFunction fn) { _onUpload = fn; }
+    void onBody(ArBodyHandlerFunction fn) { _onBody = fn; }
+
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+    void handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total) override;
+    bool isRequestHandlerTrivial() const override { return !_onRequest; }
+
+private:
+    String _uri;
+    WebRequestMethodComposite _method = HTTP_ANY;
+    ArRequestHandlerFunction _onRequest;
+    ArUploadHandlerFunction _onUpload;
+    ArBodyHandlerFunction _onBody;
+};
+
+// =========================================================
+// Server-Sent Events
+// =========================================================
+
+// Outgoing bytes of one event-stream connection. Any thread may queue data;
+// the event thread moves it to the socket (sim only).
+struct AsyncEventSourceStream
+{
+    std::mutex lock;
+    std::string pending;
+    bool closed = false;
+};
+
+class AsyncEventSourceClient
+{
+public:
+    AsyncEventSourceClient(AsyncEventSource *server, std::shared_ptr<AsyncEventSourceStream> stream)
+        : _server(server), _stream(stream) {}
+
+    bool send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0);
+    bool send(const String &message, const String &event, uint32_t id = 0, uint32_t reconnect = 0)
+    {
+        return send(message.c_str(), event.c_str(), id, reconnect);
+    }
+    void close();
+    bool connected() const;
+    uint32_t lastId() const { return _lastId; }
+    AsyncEventSource *server() { return _server; }
+
+    // Queues an already formatted frame (sim only)
+    bool write(const std::string &frame);
+
+private:
+    AsyncEventSource *_server;
+    std::shared_ptr<AsyncEventSourceStream> _stream;
+    uint32_t _lastId = 0;
+};
+
+typedef std::function<void(AsyncEventSourceClient *client)> ArEventHandlerFunction;
+
+class AsyncEventSource : public AsyncWebHandler
+{
+public:
+    AsyncEventSource(const String &url) : _url(url) {}
+    ~AsyncEventSource();
+
+    const char *url() const { return _url.c_str(); }
+    void onConnect(ArEventHandlerFunction cb) { _connectcb = cb; }
+    void onDisconnect(ArEventHandlerFunction cb) { _disconnectcb = cb; }
+    void close();
+
+    // The frame is formatted once and queued to every client
+    void send(const char *message, const char *event = nullptr, uint32_t id = 0, uint32_t reconnect = 0);
+    void send(const String &message, const String &event, uint32_t id = 0, uint32_t reconnect = 0)
+    {
+        send(message.c_str(), event.c_str(), id, reconnect);
+    }
+    size_t count() const;
+
+    bool canHandle(AsyncWebServerRequest *request) const override;
+    void handleRequest(AsyncWebServerRequest *request) override;
+
+    // sim: called by the event thread
+    void _addClient(AsyncEventSourceClient *client);
+    void _handleDisconnect(AsyncEventSourceClient *client);
+
+    static std::string formatFrame(const char *message, const char *event, uint32_t id, uint32_t reconnect);
+
+private:
+    String _url;
+    std::vector<AsyncEventSourceClient *> _clients;
+    mutable std::recursive_mutex _lock;
+    ArEventHandlerFunction _connectcb;
+    ArEventHandlerFunction _disconnectcb;
+};
+
+class AsyncEventSourceResponse : public AsyncWebServerResponse
+{
+public:
+    AsyncEventSourceResponse(AsyncEventSource *server);
+    AsyncEventSource *eventSource() override { return _server; }
+
+protected:
+    void body(std::string &out) override { (void)out; }
+
+private:
+    AsyncEventSource *_server;
+};
+
+class DefaultHeaders
+{
+public:
+    static DefaultHeaders &Instance();
+    void addHeader(const String &name, const String &value) { _headers.emplace_back(name, value); }
+    const std::vector<AsyncWebHeader> &headers() const { return _headers; }
+
+private:
+    std::vector<AsyncWebHeader> _headers;
+};
+
+class AsyncWebServer
+{
+public:
+    AsyncWebServer(uint16_t port);
+    ~AsyncWebServer();
+
+    void begin();
+    void end();
+
+    AsyncWebHandler &addHandler(AsyncWebHandler *handler);
+    bool removeHandler(AsyncWebHandler *handler);
+
+    AsyncCallbackWebHandler &on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                ArUploadHandlerFunction onUpload = nullptr, ArBodyHandlerFunction onBody = nullptr);
+    void onNotFound(ArRequestHandlerFunction fn);
+    void onRequestBody(ArBodyHandlerFunction fn);
+
+    // sim: attaches the matching handler, or the catch-all one
+    void _attachHandler(AsyncWebServerRequest *request);
+
+private:
+    struct Impl;
+    uint16_t _port;
+    std::vector<AsyncWebHandler *> _handlers;
+    AsyncCallbackWebHandler *_catchAllHandler;
+    std::unique_ptr<Impl> _impl;
+};
+
+#endif // SIM_ESPASYNCWEBSERVER_H
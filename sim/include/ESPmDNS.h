@@ -0,0 +1,26 @@
+#ifndef SIM_ESPMDNS_H
+#define SIM_ESPMDNS_H
+
+#include <Arduino.h>
+
+class MDNSResponder
+{
+public:
+    bool begin(const char *hostName)
+    {
+        (void)hostName;
+        return true;
+    }
+    void end() {}
+    bool addService(const char *service, const char *proto, uint16_t port)
+    {
+        (void)service;
+        (void)proto;
+        (void)port;
+        return true;
+    }
+};
+
+extern MDNSResponder MDNS;
+
+#endif // SIM_ESPMDNS_H
@@ -0,0 +1,95 @@
+#ifndef SIM_FS_H
+#define SIM_FS_H
+
+// =========================================================
+// Host stand-in for the Arduino-ESP32 FS layer
+// =========================================================
+// Files are plain host files under a root directory, so a "SD card" is
+// just a folder (see SimRuntime::sdRoot()).
+
+#include <Arduino.h>
+#include <memory>
+
+#define FILE_READ "r"
+#define FILE_WRITE "w"
+#define FILE_APPEND "a"
+
+namespace fs
+{
+    enum SeekMode
+    {
+        SeekSet = 0,
+        SeekCur = 1,
+        SeekEnd = 2
+    };
+
+    struct FileHandle;
+
+    class File : public Stream
+    {
+    public:
+        File() {}
+        explicit File(std::shared_ptr<FileHandle> handle) : _h(std::move(handle)) {}
+
+        size_t write(uint8_t c) override;
+        size_t write(const uint8_t *buf, size_t size) override;
+        using Print::write;
+        int available() override;
+        int read() override;
+        int peek() override;
+        size_t read(uint8_t *buf, size_t size);
+        size_t readBytes(char *buffer, size_t length) override { return read((uint8_t *)buffer, length); }
+        void flush() override;
+        bool seek(uint32_t pos, SeekMode mode);
+        bool seek(uint32_t pos) { return seek(pos, SeekSet); }
+        size_t position() const;
+        size_t size() const;
+        void close();
+        operator bool() const;
+        const char *path() const;
+        const char *name() const;
+        bool isDirectory() const;
+        File openNextFile(const char *mode = FILE_READ);
+
+    private:
+        std::shared_ptr<FileHandle> _h;
+    };
+
+    class FS
+    {
+    public:
+        explicit FS(const char *mountpoint = "") : _mountpoint(mountpoint) {}
+        virtual ~FS() {}
+
+        File open(const char *path, const char *mode = FILE_READ, const bool create = false);
+        File open(const String &path, const char *mode = FILE_READ, const bool create = false)
+        {
+            return open(path.c_str(), mode, create);
+        }
+        bool exists(const char *path);
+        bool exists(const String &path) { return exists(path.c_str()); }
+        bool remove(const char *path);
+        bool remove(const String &path) { return remove(path.c_str()); }
+        bool rename(const char *pathFrom, const char *pathTo);
+        bool rename(const String &pathFrom, const String &pathTo) { return rename(pathFrom.c_str(), pathTo.c_str()); }
+        bool mkdir(const char *path);
+        bool mkdir(const String &path) { return mkdir(path.c_str()); }
+        bool rmdir(const char *path);
+
+    protected:
+        std::string hostPath(const char *path) const;
+        bool _mounted = false;
+        std::string _mountpoint;
+    };
+}
+
+#ifndef FS_NO_GLOBALS
+using fs::File;
+using fs::FS;
+using fs::SeekCur;
+using fs::SeekEnd;
+using fs::SeekMode;
+using fs::SeekSet;
+#endif
+
+#endif // SIM_FS_H
@@ -0,0 +1,40 @@
+#ifndef SIM_PREFERENCES_H
+#define SIM_PREFERENCES_H
+
+#include <Arduino.h>
+#include <map>
+#include <string>
+
+// NVS stand-in: each namespace is a text file under the NVS directory
+// (--nvs-dir / FAMIO_NVS_DIR), rewritten on every put like an NVS commit.
+// Only the subset of the Preferences API that the firmware uses is provided.
+class Preferences
+{
+public:
+    bool begin(const char *name, bool readOnly = false);
+    void end();
+
+    bool isKey(const char *key);
+    bool remove(const char *key);
+    bool clear();
+
+    size_t putUChar(const char *key, uint8_t value);
+    size_t putUShort(const char *key, uint16_t value);
+    size_t putString(const char *key, const char *value);
+    size_t putString(const char *key, const String &value) { return putString(key, value.c_str()); }
+
+    uint8_t getUChar(const char *key, uint8_t defaultValue = 0);
+    uint16_t getUShort(const char *key, uint16_t defaultValue = 0);
+    String getString(const char *key, const String &defaultValue = String());
+
+private:
+    std::string _path;
+    bool _open = false;
+    bool _readOnly = false;
+    std::map<std::string, std::string> _values;
+
+    size_t put(const char *key, const std::string &value, size_t size);
+    bool save();
+};
+
+#endif // SIM_PREFERENCES_H
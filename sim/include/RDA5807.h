@@ -0,0 +1,43 @@
+#ifndef SIM_RDA5807_H
+#define SIM_RDA5807_H
+
+// Host stand-in for the PU2CLR RDA5807 library, driven by SimTuner.
+
+#include <Arduino.h>
+
+#define OSCILLATOR_32KHZ 0
+#define OSCILLATOR_TYPE_PASSIVE 0
+
+#define RDA_SEEK_WRAP 0
+#define RDA_SEEK_STOP 1
+#define RDA_SEEK_DOWN 0
+#define RDA_SEEK_UP 1
+
+class RDA5807
+{
+public:
+    void setup(uint8_t clock_frequency = OSCILLATOR_32KHZ, uint8_t oscillator_type = OSCILLATOR_TYPE_PASSIVE);
+    void powerUp();
+    void powerDown();
+    void softReset();
+
+    void setBand(uint8_t band);
+    void setSpace(uint8_t space);
+    void setGpio(uint8_t gpioPin, uint8_t gpioSetup);
+    void setFrequency(uint16_t frequency);
+    uint16_t getFrequency();
+    uint16_t getRealFrequency();
+    void seek(uint8_t seek_mode, uint8_t direction);
+    void setSeekThreshold(uint8_t value);
+
+    void setVolume(uint8_t value);
+    uint8_t getVolume();
+    void setMute(bool value);
+    void setMono(bool value);
+    void setRDS(bool value);
+
+    int getRssi();
+    bool isStereo();
+};
+
+#endif // SIM_RDA5807_H
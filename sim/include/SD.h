@@ -0,0 +1,38 @@
+#ifndef SIM_SD_H
+#define SIM_SD_H
+
+#include "FS.h"
+#include "SPI.h"
+
+typedef enum
+{
+    CARD_NONE,
+    CARD_MMC,
+    CARD_SD,
+    CARD_SDHC,
+    CARD_UNKNOWN
+} sdcard_type_t;
+
+namespace fs
+{
+    // SD card backed by a host directory. The card is "missing" when the
+    // directory does not exist, which lets us exercise the no-SD paths.
+    class SDFS : public FS
+    {
+    public:
+        SDFS() : FS("/sd") {}
+        bool begin(uint8_t ssPin = 5, SPIClass &spi = SPI, uint32_t frequency = 4000000,
+                   const char *mountpoint = "/sd", uint8_t max_files = 5, bool format_if_empty = false);
+        void end() { _mounted = false; }
+        sdcard_type_t cardType() { return _mounted ? CARD_SDHC : CARD_NONE; }
+        uint64_t cardSize();
+        uint64_t totalBytes() { return cardSize(); }
+        uint64_t usedBytes();
+    };
+}
+
+extern fs::SDFS SD;
+
+using namespace fs;
+
+#endif // SIM_SD_H
@@ -0,0 +1,33 @@
+#ifndef SIM_RUNTIME_H
+#define SIM_RUNTIME_H
+
+// =========================================================
+// Host simulator runtime configuration
+// =========================================================
+// Every knob can be set from the command line or from the environment:
+//   --sd-root DIR     FAMIO_SD_ROOT      directory that stands in for the SD card
+//   --port N          FAMIO_HTTP_PORT    host port the web server binds instead of 80
+//   --no-sd           FAMIO_NO_SD=1      boot as if the card was missing
+//   --nvs-dir DIR     FAMIO_NVS_DIR      directory that stands in for the NVS partition
+//   --bench-storage N                    run the config storage benchmark and exit
+//   --bench-routes N                     run the route dispatch benchmark and exit
+//   --bench-autostore N                  run the preset auto-store benchmark and exit
+//   --bench-rds N                        decode N RDS groups and exit
+
+#include <string>
+
+namespace SimRuntime
+{
+    void init(int argc, char **argv);
+
+    const std::string &sdRoot();
+    bool sdPresent();
+    const std::string &nvsDir();
+    int mapPort(int firmwarePort);
+    int benchStorageSaves(); // 0 = boot the firmware
+    int benchRouteRounds();  // 0 = boot the firmware
+    int benchAutostoreRounds(); // 0 = boot the firmware
+    int benchRdsGroups();       // 0 = boot the firmware
+}
+
+#endif // SIM_RUNTIME_H
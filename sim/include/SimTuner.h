@@ -0,0 +1,66 @@
+#ifndef SIM_TUNER_H
+#define SIM_TUNER_H
+
+// =========================================================
+// Simulated RDA5807 chip model
+// =========================================================
+// Shared by the RDA5807 library stand-in and the Wire stand-in so both
+// views of the chip (library calls and raw I2C reads) stay consistent.
+// The band is populated from FAMIO_SIM_STATIONS ("88.1:48,97.7:58,...",
+// frequency in MHz and peak RSSI) or a built-in list.
+//
+// RDS: a station tuned exactly sends a group every 87.6 ms, generated from
+// its frequency (PS "FM 99.5", RadioText, PTY, clock) or replayed from the
+// capture in FAMIO_SIM_RDS. FAMIO_SIM_RDS_BLER (percent) corrupts blocks.
+
+#include <Arduino.h>
+#include <vector>
+
+struct SimRdsGroup
+{
+    uint16_t block[4];
+    uint8_t bler[4]; // 0 = clean .. 3 = lost
+};
+
+namespace SimTuner
+{
+    // Cost of one I2C transaction at 100 kHz (FAMIO_SIM_I2C_US)
+    uint32_t i2cCostUs();
+    // Counts one bus transaction and burns its simulated bus time
+    void i2cTransaction();
+    uint32_t i2cTransactionCount();
+
+    void powerUp();
+    void powerDown();
+    bool isPowered();
+
+    void tune(uint16_t freq10k);
+    uint16_t frequency();
+    // Hardware seek: walks the band until a channel beats the threshold
+    void seek(bool up, bool wrap);
+    void setSeekThreshold(uint8_t value);
+
+    uint8_t rssiAt(uint16_t freq10k);
+    // Reads ramp up over the settle time after a tune, like the real chip's
+    uint8_t rssi();
+    // Stations on the simulated band (ground truth for benchmarks)
+    size_t stations(uint16_t *freq10k, uint8_t *peakRssi, size_t max);
+    bool isStereo();
+    void setMono(bool mono);
+    void setVolume(uint8_t volume);
+    uint8_t volume();
+    void setMute(bool mute);
+
+    void setRds(bool enabled);
+    // Capture in redsea's hex format: one group per line, "AAAA BBBB CCCC DDDD",
+    // "----" for a block that was not received. Other lines are skipped
+    bool loadRdsCapture(const char *path, std::vector<SimRdsGroup> &groups);
+    // Group n sent by the station on freq10k (capture or generated stream,
+    // FAMIO_SIM_RDS_BLER errors applied)
+    SimRdsGroup rdsGroup(uint16_t freq10k, uint32_t n);
+
+    // Status registers 0x0A..0x0F, as returned by a sequential read
+    void readStatusRegisters(uint16_t regs[6]);
+}
+
+#endif // SIM_TUNER_H
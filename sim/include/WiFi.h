@@ -0,0 +1,63 @@
+#ifndef SIM_WIFI_H
+#define SIM_WIFI_H
+
+// WiFi stand-in: the host network is always "up". Station mode connects
+// to any non-empty SSID after FAMIO_SIM_WIFI_CONNECT_MS (default 800 ms).
+
+#include <Arduino.h>
+#include "IPAddress.h"
+
+typedef enum
+{
+    WL_IDLE_STATUS = 0,
+    WL_NO_SSID_AVAIL = 1,
+    WL_SCAN_COMPLETED = 2,
+    WL_CONNECTED = 3,
+    WL_CONNECT_FAILED = 4,
+    WL_CONNECTION_LOST = 5,
+    WL_DISCONNECTED = 6
+} wl_status_t;
+
+typedef enum
+{
+    WIFI_OFF = 0,
+    WIFI_STA = 1,
+    WIFI_AP = 2,
+    WIFI_AP_STA = 3
+} wifi_mode_t;
+
+#define WIFI_SCAN_RUNNING (-1)
+#define WIFI_SCAN_FAILED (-2)
+
+class WiFiClass
+{
+public:
+    bool mode(wifi_mode_t mode);
+    wifi_mode_t getMode() { return _mode; }
+    wl_status_t begin(const char *ssid, const char *passphrase = nullptr);
+    wl_status_t status();
+    bool disconnect(bool wifioff = false);
+    IPAddress localIP();
+    IPAddress softAPIP();
+    bool softAP(const String &ssid, const String &passphrase);
+    int8_t RSSI();
+
+    int16_t scanNetworks(bool async = false, bool show_hidden = false);
+    int16_t scanComplete();
+    void scanDelete();
+    String SSID(uint8_t i);
+    String BSSIDstr(uint8_t i);
+    int32_t RSSI(uint8_t i);
+    int32_t channel(uint8_t i);
+
+private:
+    wifi_mode_t _mode = WIFI_OFF;
+    bool _connecting = false;
+    unsigned long _connectStart = 0;
+    unsigned long _scanStart = 0;
+    int16_t _scanState = WIFI_SCAN_FAILED;
+};
+
+extern WiFiClass WiFi;
+
+#endif // SIM_WIFI_H
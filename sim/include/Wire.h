@@ -0,0 +1,34 @@
+#ifndef SIM_WIRE_H
+#define SIM_WIRE_H
+
+#include <Arduino.h>
+
+// I2C bus stand-in. The RDA5807 answers on 0x10 (sequential access,
+// reads start at register 0x0A) and 0x11 (random access).
+class TwoWire : public Stream
+{
+public:
+    bool begin(int sda = -1, int scl = -1, uint32_t frequency = 0);
+    void setClock(uint32_t frequency) { (void)frequency; }
+
+    void beginTransmission(uint8_t address);
+    uint8_t endTransmission(bool sendStop = true);
+    uint8_t requestFrom(uint8_t address, uint8_t quantity, bool sendStop = true);
+
+    size_t write(uint8_t data) override;
+    size_t write(const uint8_t *data, size_t quantity) override;
+    using Print::write;
+    int available() override;
+    int read() override;
+    int peek() override;
+
+private:
+    uint8_t _txAddress = 0;
+    uint8_t _rxBuffer[32];
+    uint8_t _rxLength = 0;
+    uint8_t _rxIndex = 0;
+};
+
+extern TwoWire Wire;
+
+#endif // SIM_WIRE_H
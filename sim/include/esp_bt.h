@@ -0,0 +1,20 @@
+#ifndef SIM_ESP_BT_H
+#define SIM_ESP_BT_H
+
+#include "esp_err.h"
+
+typedef enum
+{
+    ESP_BT_MODE_IDLE = 0x00,
+    ESP_BT_MODE_BLE = 0x01,
+    ESP_BT_MODE_CLASSIC_BT = 0x02,
+    ESP_BT_MODE_BTDM = 0x03
+} esp_bt_mode_t;
+
+inline esp_err_t esp_bt_controller_mem_release(esp_bt_mode_t mode)
+{
+    (void)mode;
+    return ESP_OK;
+}
+
+#endif // SIM_ESP_BT_H
@@ -0,0 +1,26 @@
+#ifndef SIM_ESP_GAP_BT_API_H
+#define SIM_ESP_GAP_BT_API_H
+
+#include <cstdint>
+#include "esp_err.h"
+
+typedef uint8_t esp_bt_io_cap_t;
+typedef enum
+{
+    ESP_BT_SP_IOCAP_MODE = 0
+} esp_bt_sp_param_t;
+
+#define ESP_BT_IO_CAP_OUT 0
+#define ESP_BT_IO_CAP_IO 1
+#define ESP_BT_IO_CAP_IN 2
+#define ESP_BT_IO_CAP_NONE 3
+
+inline esp_err_t esp_bt_gap_set_security_param(esp_bt_sp_param_t param_type, void *value, uint8_t len)
+{
+    (void)param_type;
+    (void)value;
+    (void)len;
+    return ESP_OK;
+}
+
+#endif // SIM_ESP_GAP_BT_API_H
@@ -0,0 +1,9 @@
+#ifndef SIM_ESP_TIMER_H
+#define SIM_ESP_TIMER_H
+
+#include <cstdint>
+
+// Microseconds since boot
+int64_t esp_timer_get_time();
+
+#endif // SIM_ESP_TIMER_H
@@ -0,0 +1,47 @@
+#ifndef SIM_FREERTOS_H
+#define SIM_FREERTOS_H
+
+// =========================================================
+// FreeRTOS stand-in on top of std::thread
+// =========================================================
+// One tick is one millisecond. Core affinity and priorities are recorded
+// but the host scheduler decides where threads run.
+
+#include <cstdint>
+#include <cstddef>
+
+typedef int BaseType_t;
+typedef unsigned int UBaseType_t;
+typedef uint32_t TickType_t;
+typedef uint32_t StackType_t;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define pdPASS 1
+#define pdFAIL 0
+#define portMAX_DELAY 0xFFFFFFFFu
+#define configTICK_RATE_HZ 1000
+#define portTICK_PERIOD_MS 1
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+#define tskNO_AFFINITY 0x7FFFFFFF
+#define configMAX_PRIORITIES 25
+#define configGENERATE_RUN_TIME_STATS 0
+#define PRO_CPU_NUM 0
+#define APP_CPU_NUM 1
+
+struct SimMux;
+typedef struct
+{
+    SimMux *impl;
+} portMUX_TYPE;
+
+#define portMUX_INITIALIZER_UNLOCKED {nullptr}
+
+void simEnterCritical(portMUX_TYPE *mux);
+void simExitCritical(portMUX_TYPE *mux);
+#define portENTER_CRITICAL(mux) simEnterCritical(mux)
+#define portEXIT_CRITICAL(mux) simExitCritical(mux)
+
+BaseType_t xPortGetCoreID();
+
+#endif // SIM_FREERTOS_H
@@ -0,0 +1,115 @@
+#include <Arduino.h>
+#include <chrono>
+#include <thread>
+#include <random>
+#include <unistd.h>
+
+// =========================================================
+// Core runtime stand-ins (timing, Serial, ESP)
+// =========================================================
+
+HardwareSerial Serial;
+EspClass ESP;
+
+namespace
+{
+    const auto bootTime = std::chrono::steady_clock::now();
+    std::mt19937 &rng()
+    {
+        static std::mt19937 gen(12345);
+        return gen;
+    }
+
+    // Fixed figures that look like an ESP32-WROVER right after boot
+    const uint32_t SIM_HEAP_SIZE = 320 * 1024;
+    const uint32_t SIM_PSRAM_SIZE = 4 * 1024 * 1024;
+}
+
+size_t HardwareSerial::write(uint8_t c)
+{
+    return fwrite(&c, 1, 1, stdout);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+    return fwrite(buffer, 1, size, stdout);
+}
+
+void HardwareSerial::flush()
+{
+    fflush(stdout);
+}
+
+unsigned long millis()
+{
+    return (unsigned long)std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now() - bootTime)
+        .count();
+}
+
+unsigned long micros()
+{
+    return (unsigned long)std::chrono::duration_cast<std::chrono::microseconds>(
+               std::chrono::steady_clock::now() - bootTime)
+        .count();
+}
+
+void delay(uint32_t ms)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+void delayMicroseconds(uint32_t us)
+{
+    std::this_thread::sleep_for(std::chrono::microseconds(us));
+}
+
+void yield()
+{
+    std::this_thread::yield();
+}
+
+long random(long howbig)
+{
+    if (howbig <= 0)
+        return 0;
+    return std::uniform_int_distribution<long>(0, howbig - 1)(rng());
+}
+
+long random(long howsmall, long howbig)
+{
+    if (howsmall >= howbig)
+        return howsmall;
+    return howsmall + random(howbig - howsmall);
+}
+
+bool psramInit()
+{
+    return true;
+}
+
+void *ps_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void *ps_realloc(void *ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+uint32_t EspClass::getHeapSize() { return SIM_HEAP_SIZE; }
+uint32_t EspClass::getFreeHeap() { return SIM_HEAP_SIZE / 2; }
+uint32_t EspClass::getMinFreeHeap() { return SIM_HEAP_SIZE / 2; }
+uint32_t EspClass::getMaxAllocHeap() { return SIM_HEAP_SIZE / 4; }
+uint32_t EspClass::getPsramSize() { return SIM_PSRAM_SIZE; }
+uint32_t EspClass::getFreePsram() { return SIM_PSRAM_SIZE - 64 * 1024; }
+uint32_t EspClass::getMinFreePsram() { return SIM_PSRAM_SIZE - 64 * 1024; }
+uint32_t EspClass::getMaxAllocPsram() { return SIM_PSRAM_SIZE / 2; }
+
+void EspClass::restart()
+{
+    Serial.println("[sim] ESP.restart() -> exiting process");
+    Serial.flush();
+    _exit(0);
+}
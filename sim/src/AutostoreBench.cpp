@@ -0,0 +1,178 @@
+#include <Arduino.h>
+#include <RDA5807.h>
+#include <chrono>
+#include "BandScanner.h"
+#include "SimTuner.h"
+
+// =========================================================
+// --bench-autostore N: presets from a band scan vs. a run of seeks
+// =========================================================
+// Fills AUTOSTORE_PRESETS presets from the simulated band N times each way:
+//  - scan: tune every channel, wait the dwell time, read RSSI/stereo, then
+//    BandScanner::pickStations (what POST /api/fm/autostore does), at a few
+//    dwell times to show the settle-time/accuracy trade-off;
+//  - seek: hardware seek up from the bottom of the band until it stops
+//    moving, reading RSSI/stereo at every stop and ranking the same way
+//    (the manual /api/fm/seek + /api/fm/save routine).
+// Found presets are compared with the band's real stations: "exact" are on
+// a station's channel, "off" are not, "top" counts presets that belong to
+// the AUTOSTORE_PRESETS strongest stations. Set FAMIO_SIM_I2C_US for bus cost.
+
+namespace
+{
+    const uint32_t DWELLS_MS[] = {5, 10, 20, 30};
+    const size_t MAX_STATIONS = 64;
+
+    struct Truth
+    {
+        uint16_t freq10k[MAX_STATIONS];
+        uint8_t peak[MAX_STATIONS];
+        size_t count;
+    };
+
+    struct Outcome
+    {
+        uint16_t presets[AUTOSTORE_PRESETS];
+        uint8_t count;
+    };
+
+    RDA5807 rx;
+
+    uint8_t readPoint()
+    {
+        uint8_t rssi = rx.getRssi();
+        bool stereo = rx.isStereo();
+        return (rssi & SCAN_POINT_RSSI) | (stereo ? SCAN_POINT_STEREO : 0);
+    }
+
+    void runScan(uint32_t dwellMs, Outcome &out)
+    {
+        uint8_t points[SCAN_CHANNELS];
+        for (uint16_t i = 0; i < SCAN_CHANNELS; i++)
+        {
+            rx.setFrequency(BandScanner::channelFrequency(i));
+            delay(dwellMs);
+            points[i] = readPoint();
+        }
+        uint16_t channels[AUTOSTORE_PRESETS];
+        out.count = BandScanner::pickStations(points, SCAN_CHANNELS, channels, AUTOSTORE_PRESETS);
+        for (uint8_t i = 0; i < out.count; i++)
+            out.presets[i] = BandScanner::channelFrequency(channels[i]);
+    }
+
+    void runSeek(Outcome &out)
+    {
+        uint16_t stops[SCAN_CHANNELS];
+        uint8_t points[SCAN_CHANNELS];
+        uint16_t count = 0;
+        uint16_t freq = SCAN_BAND_BOTTOM;
+        rx.setFrequency(freq);
+        while (count < SCAN_CHANNELS)
+        {
+            rx.seek(RDA_SEEK_STOP, RDA_SEEK_UP);
+            uint16_t next = rx.getRealFrequency();
+            if (next <= freq)
+                break;
+            freq = next;
+            uint8_t point = readPoint();
+            if (freq == SCAN_BAND_TOP && (point & SCAN_POINT_RSSI) < 25)
+                break; // Seek hit the band edge without a station
+            stops[count] = freq;
+            points[count] = point;
+            count++;
+        }
+
+        // Rank the stops like pickStations does, without the peak/spacing logic
+        // (a seek stops at the first channel above its threshold)
+        out.count = 0;
+        bool used[SCAN_CHANNELS] = {};
+        while (out.count < AUTOSTORE_PRESETS)
+        {
+            int best = -1;
+            for (uint16_t i = 0; i < count; i++)
+            {
+                if (used[i])
+                    continue;
+                uint8_t score = (points[i] & SCAN_POINT_RSSI) + ((points[i] & SCAN_POINT_STEREO) ? AUTOSTORE_STEREO_BONUS : 0);
+                uint8_t bestScore = best < 0 ? 0 : (points[best] & SCAN_POINT_RSSI) + ((points[best] & SCAN_POINT_STEREO) ? AUTOSTORE_STEREO_BONUS : 0);
+                if (best < 0 || score > bestScore)
+                    best = i;
+            }
+            if (best < 0)
+                break;
+            used[best] = true;
+            out.presets[out.count++] = stops[best];
+        }
+    }
+
+    bool isStation(const Truth &truth, uint16_t freq10k)
+    {
+        for (size_t i = 0; i < truth.count; i++)
+            if (truth.freq10k[i] == freq10k)
+                return true;
+        return false;
+    }
+
+    bool isTopStation(const Truth &truth, uint16_t freq10k)
+    {
+        for (size_t i = 0; i < truth.count; i++)
+        {
+            if (truth.freq10k[i] != freq10k)
+                continue;
+            size_t stronger = 0;
+            for (size_t j = 0; j < truth.count; j++)
+                if (truth.peak[j] > truth.peak[i])
+                    stronger++;
+            return stronger < AUTOSTORE_PRESETS;
+        }
+        return false;
+    }
+
+    void report(const char *method, uint32_t dwellMs, int rounds, double ms, uint32_t i2c, const Outcome &out, const Truth &truth)
+    {
+        int exact = 0;
+        int top = 0;
+        for (uint8_t i = 0; i < out.count; i++)
+        {
+            exact += isStation(truth, out.presets[i]);
+            top += isTopStation(truth, out.presets[i]);
+        }
+        char dwell[16];
+        if (dwellMs)
+            snprintf(dwell, sizeof(dwell), "%u", (unsigned)dwellMs);
+        else
+            snprintf(dwell, sizeof(dwell), "-");
+        printf("%-6s %8s %10.0f %8u %8u %8d %8d %8d\n", method, dwell, ms / rounds, (unsigned)(i2c / rounds),
+               out.count, exact, out.count - exact, top);
+    }
+}
+
+int runAutostoreBench(int rounds)
+{
+    Truth truth;
+    truth.count = SimTuner::stations(truth.freq10k, truth.peak, MAX_STATIONS);
+    rx.setup();
+    rx.setMute(true);
+
+    printf("rounds: %d, stations on the band: %u, presets: %d\n", rounds, (unsigned)truth.count, AUTOSTORE_PRESETS);
+    printf("%-6s %8s %10s %8s %8s %8s %8s %8s\n", "method", "dwell_ms", "ms", "i2c", "presets", "exact", "off", "top");
+
+    Outcome out;
+    for (uint32_t dwell : DWELLS_MS)
+    {
+        uint32_t i2c = SimTuner::i2cTransactionCount();
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+            runScan(dwell, out);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        report("scan", dwell, rounds, ms, SimTuner::i2cTransactionCount() - i2c, out, truth);
+    }
+
+    uint32_t i2c = SimTuner::i2cTransactionCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++)
+        runSeek(out);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    report("seek", 0, rounds, ms, SimTuner::i2cTransactionCount() - i2c, out, truth);
+    return 0;
+}
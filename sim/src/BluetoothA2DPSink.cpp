@@ -0,0 +1,92 @@
+#include <BluetoothA2DPSink.h>
+
+namespace
+{
+    // Rough cost of bringing the Bluedroid stack up/down on the board
+    const uint32_t STACK_START_MS = 400;
+    const uint32_t STACK_STOP_MS = 150;
+
+    struct Track
+    {
+        const char *title;
+        const char *artist;
+        const char *album;
+    };
+
+    const Track TRACKS[] = {
+        {"Song of the Road", "The Simulators", "Host Build"},
+        {"Loopback", "Localhost Trio", "127.0.0.1"},
+        {"Keep-Alive", "Socket Club", "HTTP/1.1"},
+    };
+
+    unsigned long envMs(const char *name, unsigned long fallback)
+    {
+        const char *value = getenv(name);
+        return (value && *value) ? strtoul(value, nullptr, 10) : fallback;
+    }
+}
+
+void BluetoothA2DPSink::start(const char *name, bool auto_reconnect)
+{
+    (void)name;
+    (void)auto_reconnect;
+    if (_running)
+        return;
+    delay(STACK_START_MS);
+    _running = true;
+    _peer = std::thread(&BluetoothA2DPSink::peerLoop, this);
+}
+
+void BluetoothA2DPSink::end(bool release_memory)
+{
+    (void)release_memory;
+    if (!_running)
+        return;
+    _running = false;
+    if (_peer.joinable())
+        _peer.join();
+    delay(STACK_STOP_MS);
+}
+
+void BluetoothA2DPSink::peerLoop()
+{
+    const unsigned long connectMs = envMs("FAMIO_SIM_BT_CONNECT_MS", 1500);
+    const unsigned long trackMs = envMs("FAMIO_SIM_BT_TRACK_S", 20) * 1000;
+    const unsigned long started = millis();
+
+    while (_running && millis() - started < connectMs)
+        delay(20);
+    if (!_running)
+        return;
+
+    _connected = true;
+    if (_connectionCallback)
+        _connectionCallback(ESP_A2D_CONNECTION_STATE_CONNECTED, _connectionObj);
+
+    size_t track = 0;
+    int seenSkip = _skip;
+    unsigned long trackStart = 0;
+    bool announce = true;
+    while (_running)
+    {
+        if (_skip != seenSkip || millis() - trackStart >= trackMs)
+        {
+            if (!announce)
+                track = (track + 1) % (sizeof(TRACKS) / sizeof(TRACKS[0]));
+            seenSkip = _skip;
+            trackStart = millis();
+            announce = false;
+            if (_metadataCallback)
+            {
+                _metadataCallback(0x1, (const uint8_t *)TRACKS[track].title);
+                _metadataCallback(0x2, (const uint8_t *)TRACKS[track].artist);
+                _metadataCallback(0x4, (const uint8_t *)TRACKS[track].album);
+            }
+        }
+        delay(20);
+    }
+
+    _connected = false;
+    if (_connectionCallback)
+        _connectionCallback(ESP_A2D_CONNECTION_STATE_DISCONNECTED, _connectionObj);
+}
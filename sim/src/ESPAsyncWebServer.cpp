@@ -0,0 +1,912 @@
+#include <ESPAsyncWebServer.h>
+#include "SimRuntime.h"
+#include <arpa/inet.h>
+#include <atomic>
+#include <fcntl.h>
+#include <map>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+
+namespace
+{
+    const size_t MAX_HEADER_BYTES = 8 * 1024;
+    const String EMPTY_STRING;
+
+    String urlDecode(const String &in)
+    {
+        String out;
+        for (unsigned int i = 0; i < in.length(); i++)
+        {
+            char c = in[i];
+            if (c == '+')
+                out += ' ';
+            else if (c == '%' && i + 2 < in.length())
+            {
+                char hex[3] = {in[i + 1], in[i + 2], 0};
+                out += (char)strtol(hex, nullptr, 16);
+                i += 2;
+            }
+            else
+                out += c;
+        }
+        return out;
+    }
+
+    const char *reasonPhrase(int code)
+    {
+        switch (code)
+        {
+        case 200:
+            return "OK";
+        case 202:
+            return "Accepted";
+        case 204:
+            return "No Content";
+        case 304:
+            return "Not Modified";
+        case 400:
+            return "Bad Request";
+        case 404:
+            return "Not Found";
+        case 405:
+            return "Method Not Allowed";
+        case 409:
+            return "Conflict";
+        case 413:
+            return "Payload Too Large";
+        case 500:
+            return "Internal Server Error";
+        case 503:
+            return "Service Unavailable";
+        default:
+            return "";
+        }
+    }
+
+    WebRequestMethodComposite parseMethod(const String &m)
+    {
+        if (m == "GET")
+            return HTTP_GET;
+        if (m == "POST")
+            return HTTP_POST;
+        if (m == "DELETE")
+            return HTTP_DELETE;
+        if (m == "PUT")
+            return HTTP_PUT;
+        if (m == "PATCH")
+            return HTTP_PATCH;
+        if (m == "HEAD")
+            return HTTP_HEAD;
+        if (m == "OPTIONS")
+            return HTTP_OPTIONS;
+        return 0;
+    }
+}
+
+// =========================================================
+// Responses
+// =========================================================
+
+bool AsyncWebServerResponse::addHeader(const char *name, const char *value, bool replaceExisting)
+{
+    for (AsyncWebHeader &h : _headers)
+    {
+        if (h.name().equalsIgnoreCase(name))
+        {
+            if (!replaceExisting)
+                return false;
+            h = AsyncWebHeader(name, value);
+            return true;
+        }
+    }
+    _headers.emplace_back(name, value);
+    return true;
+}
+
+std::string AsyncWebServerResponse::assemble(bool headOnly)
+{
+    std::string content;
+    body(content);
+
+    std::string out = "HTTP/1.1 " + std::to_string(_code) + " " + reasonPhrase(_code) + "\r\n";
+    if (_contentType.length())
+        out += std::string("Content-Type: ") + _contentType.c_str() + "\r\n";
+    if (_chunked)
+        out += "Transfer-Encoding: chunked\r\n";
+    else if (!_keepOpen)
+        out += "Content-Length: " + std::to_string(content.size()) + "\r\n";
+    for (const AsyncWebHeader &h : DefaultHeaders::Instance().headers())
+        out += std::string(h.name().c_str()) + ": " + h.value().c_str() + "\r\n";
+    for (const AsyncWebHeader &h : _headers)
+        out += std::string(h.name().c_str()) + ": " + h.value().c_str() + "\r\n";
+    out += _keepOpen ? "Connection: keep-alive\r\n\r\n" : "Connection: close\r\n\r\n";
+
+    if (!headOnly)
+    {
+        if (_chunked)
+        {
+            char len[sizeof(size_t) * 2 + 3]; // Hex digits, CRLF, NUL
+            if (!content.empty())
+            {
+                snprintf(len, sizeof(len), "%zx\r\n", content.size());
+                out += len + content + "\r\n";
+            }
+            out += "0\r\n\r\n";
+        }
+        else
+        {
+            out += content;
+        }
+    }
+    return out;
+}
+
+AsyncBasicResponse::AsyncBasicResponse(int code, const String &contentType, const String &content)
+    : _content(content)
+{
+    _code = code;
+    _contentType = contentType;
+}
+
+void AsyncBasicResponse::body(std::string &out)
+{
+    out.assign(_content.c_str(), _content.length());
+}
+
+AsyncProgmemResponse::AsyncProgmemResponse(int code, const String &contentType, const uint8_t *content, size_t len)
+    : _content(content), _len(len)
+{
+    _code = code;
+    _contentType = contentType;
+}
+
+void AsyncProgmemResponse::body(std::string &out)
+{
+    out.assign((const char *)_content, _len);
+}
+
+AsyncFileResponse::AsyncFileResponse(File content, const String &path, const String &contentType, bool download)
+    : _content(content)
+{
+    (void)path;
+    _code = 200;
+    _contentType = contentType.length() ? contentType : String("application/octet-stream");
+    if (download)
+        addHeader("Content-Disposition", "attachment");
+}
+
+void AsyncFileResponse::body(std::string &out)
+{
+    uint8_t buf[1460];
+    size_t n;
+    while ((n = _content.read(buf, sizeof(buf))) > 0)
+        out.append((const char *)buf, n);
+    _content.close();
+}
+
+AsyncChunkedResponse::AsyncChunkedResponse(const String &contentType, AwsResponseFiller callback)
+    : _filler(callback)
+{
+    _code = 200;
+    _contentType = contentType;
+    _chunked = true;
+}
+
+void AsyncChunkedResponse::body(std::string &out)
+{
+    uint8_t buf[1460];
+    size_t index = 0;
+    size_t n;
+    while ((n = _filler(buf, sizeof(buf), index)) > 0)
+    {
+        out.append((const char *)buf, n);
+        index += n;
+    }
+}
+
+AsyncCallbackResponse::AsyncCallbackResponse(const String &contentType, size_t len, AwsResponseFiller callback)
+    : _len(len), _filler(callback)
+{
+    _code = 200;
+    _contentType = contentType;
+}
+
+void AsyncCallbackResponse::body(std::string &out)
+{
+    uint8_t buf[1460];
+    size_t n;
+    while (out.size() < _len)
+    {
+        n = _filler(buf, std::min(sizeof(buf), _len - out.size()), out.size());
+        if (n == 0)
+            break;
+        out.append((const char *)buf, n);
+    }
+}
+
+AsyncResponseStream::AsyncResponseStream(const String &contentType, size_t bufferSize)
+{
+    _code = 200;
+    _contentType = contentType;
+    _buffer.reserve(bufferSize);
+}
+
+size_t AsyncResponseStream::write(uint8_t data)
+{
+    _buffer.push_back((char)data);
+    return 1;
+}
+
+size_t AsyncResponseStream::write(const uint8_t *data, size_t len)
+{
+    _buffer.append((const char *)data, len);
+    return len;
+}
+
+void AsyncResponseStream::body(std::string &out)
+{
+    out = _buffer;
+}
+
+// =========================================================
+// Server-Sent Events
+// =========================================================
+
+namespace
+{
+    // A client that stops reading is dropped from instead of growing without bound
+    const size_t MAX_SSE_PENDING_BYTES = 64 * 1024;
+}
+
+AsyncEventSourceResponse::AsyncEventSourceResponse(AsyncEventSource *server) : _server(server)
+{
+    _code = 200;
+    _contentType = "text/event-stream";
+    _keepOpen = true;
+    addHeader("Cache-Control", "no-cache");
+}
+
+std::string AsyncEventSource::formatFrame(const char *message, const char *event, uint32_t id, uint32_t reconnect)
+{
+    std::string frame;
+    if (reconnect)
+        frame += "retry: " + std::to_string(reconnect) + "\r\n";
+    if (id)
+        frame += "id: " + std::to_string(id) + "\r\n";
+    if (event && *event)
+        frame += std::string("event: ") + event + "\r\n";
+    if (message)
+    {
+        const char *line = message;
+        while (true)
+        {
+            const char *eol = strchr(line, '\n');
+            frame += "data: ";
+            frame.append(line, eol ? (size_t)(eol - line) : strlen(line));
+            frame += "\r\n";
+            if (!eol)
+                break;
+            line = eol + 1;
+        }
+    }
+    frame += "\r\n";
+    return frame;
+}
+
+bool AsyncEventSourceClient::write(const std::string &frame)
+{
+    std::lock_guard<std::mutex> guard(_stream->lock);
+    if (_stream->closed || _stream->pending.size() + frame.size() > MAX_SSE_PENDING_BYTES)
+        return false;
+    _stream->pending += frame;
+    return true;
+}
+
+bool AsyncEventSourceClient::send(const char *message, const char *event, uint32_t id, uint32_t reconnect)
+{
+    if (id)
+        _lastId = id;
+    return write(AsyncEventSource::formatFrame(message, event, id, reconnect));
+}
+
+void AsyncEventSourceClient::close()
+{
+    // The event thread still owns the socket; it closes it once the queue is flushed
+    std::lock_guard<std::mutex> guard(_stream->lock);
+    _stream->closed = true;
+}
+
+bool AsyncEventSourceClient::connected() const
+{
+    std::lock_guard<std::mutex> guard(_stream->lock);
+    return !_stream->closed;
+}
+
+AsyncEventSource::~AsyncEventSource()
+{
+    close();
+}
+
+void AsyncEventSource::close()
+{
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    for (AsyncEventSourceClient *client : _clients)
+        client->close();
+}
+
+void AsyncEventSource::send(const char *message, const char *event, uint32_t id, uint32_t reconnect)
+{
+    std::string frame = formatFrame(message, event, id, reconnect);
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    for (AsyncEventSourceClient *client : _clients)
+        client->write(frame);
+}
+
+size_t AsyncEventSource::count() const
+{
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    size_t n = 0;
+    for (AsyncEventSourceClient *client : _clients)
+        if (client->connected())
+            n++;
+    return n;
+}
+
+bool AsyncEventSource::canHandle(AsyncWebServerRequest *request) const
+{
+    return request->method() == HTTP_GET && request->url() == _url;
+}
+
+void AsyncEventSource::handleRequest(AsyncWebServerRequest *request)
+{
+    request->send(new AsyncEventSourceResponse(this));
+}
+
+void AsyncEventSource::_addClient(AsyncEventSourceClient *client)
+{
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    _clients.push_back(client);
+    if (_connectcb)
+        _connectcb(client);
+}
+
+void AsyncEventSource::_handleDisconnect(AsyncEventSourceClient *client)
+{
+    std::lock_guard<std::recursive_mutex> guard(_lock);
+    if (_disconnectcb)
+        _disconnectcb(client);
+    _clients.erase(std::remove(_clients.begin(), _clients.end(), client), _clients.end());
+    delete client;
+}
+
+DefaultHeaders &DefaultHeaders::Instance()
+{
+    static DefaultHeaders instance;
+    return instance;
+}
+
+// =========================================================
+// Request
+// =========================================================
+
+AsyncWebServerRequest::AsyncWebServerRequest(AsyncWebServer *server, int fd) : _server(server), _fd(fd) {}
+
+AsyncWebServerRequest::~AsyncWebServerRequest()
+{
+    delete _response;
+    if (_tempObject)
+        free(_tempObject);
+}
+
+const char *AsyncWebServerRequest::methodToString() const
+{
+    switch (_method)
+    {
+    case HTTP_GET:
+        return "GET";
+    case HTTP_POST:
+        return "POST";
+    case HTTP_DELETE:
+        return "DELETE";
+    case HTTP_PUT:
+        return "PUT";
+    case HTTP_PATCH:
+        return "PATCH";
+    case HTTP_HEAD:
+        return "HEAD";
+    case HTTP_OPTIONS:
+        return "OPTIONS";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+void AsyncWebServerRequest::addQueryParams(const String &query, bool form)
+{
+    unsigned int start = 0;
+    while (start < query.length())
+    {
+        int amp = query.indexOf('&', start);
+        unsigned int end = amp < 0 ? query.length() : (unsigned int)amp;
+        String pair = query.substring(start, end);
+        int eq = pair.indexOf('=');
+        if (eq >= 0)
+            _params.emplace_back(urlDecode(pair.substring(0, eq)), urlDecode(pair.substring(eq + 1)), form);
+        else if (pair.length())
+            _params.emplace_back(urlDecode(pair), String(), form);
+        start = end + 1;
+    }
+}
+
+bool AsyncWebServerRequest::hasParam(const char *name, bool post, bool file) const
+{
+    return getParam(name, post, file) != nullptr;
+}
+
+const AsyncWebParameter *AsyncWebServerRequest::getParam(const char *name, bool post, bool file) const
+{
+    (void)file;
+    for (const AsyncWebParameter &p : _params)
+        if (p.name() == name && p.isPost() == post)
+            return &p;
+    return nullptr;
+}
+
+bool AsyncWebServerRequest::hasArg(const char *name) const
+{
+    for (const AsyncWebParameter &p : _params)
+        if (p.name() == name)
+            return true;
+    return false;
+}
+
+const String &AsyncWebServerRequest::arg(const char *name) const
+{
+    for (const AsyncWebParameter &p : _params)
+        if (p.name() == name)
+            return p.value();
+    return EMPTY_STRING;
+}
+
+bool AsyncWebServerRequest::hasHeader(const char *name) const
+{
+    return getHeader(name) != nullptr;
+}
+
+const AsyncWebHeader *AsyncWebServerRequest::getHeader(const char *name) const
+{
+    for (const AsyncWebHeader &h : _headers)
+        if (h.name().equalsIgnoreCase(name))
+            return &h;
+    return nullptr;
+}
+
+const String &AsyncWebServerRequest::header(const char *name) const
+{
+    const AsyncWebHeader *h = getHeader(name);
+    return h ? h->value() : EMPTY_STRING;
+}
+
+void AsyncWebServerRequest::send(AsyncWebServerResponse *response)
+{
+    if (_responseSent)
+    {
+        log_w("AsyncWebServer: response already sent for %s", _url.c_str());
+        delete response;
+        return;
+    }
+    _responseSent = true;
+    _response = response;
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const String &contentType, const String &content)
+{
+    return new AsyncBasicResponse(code, contentType, content);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(int code, const char *contentType, const uint8_t *content, size_t len)
+{
+    return new AsyncProgmemResponse(code, contentType, content, len);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(File content, const String &path, const String &contentType, bool download)
+{
+    return new AsyncFileResponse(content, path, contentType, download);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginResponse(const String &contentType, size_t len, AwsResponseFiller callback)
+{
+    return new AsyncCallbackResponse(contentType, len, callback);
+}
+
+AsyncWebServerResponse *AsyncWebServerRequest::beginChunkedResponse(const String &contentType, AwsResponseFiller callback)
+{
+    return new AsyncChunkedResponse(contentType, callback);
+}
+
+AsyncResponseStream *AsyncWebServerRequest::beginResponseStream(const String &contentType, size_t bufferSize)
+{
+    return new AsyncResponseStream(contentType, bufferSize);
+}
+
+// =========================================================
+// Handlers
+// =========================================================
+
+bool AsyncCallbackWebHandler::canHandle(AsyncWebServerRequest *request) const
+{
+    if (!(_method & request->method()))
+        return false;
+    if (_uri.length() && _uri.endsWith("*"))
+        return request->url().startsWith(_uri.substring(0, _uri.length() - 1));
+    return _uri == request->url();
+}
+
+void AsyncCallbackWebHandler::handleRequest(AsyncWebServerRequest *request)
+{
+    if (_onRequest)
+        _onRequest(request);
+    else
+        request->send(404, "text/plain", "Not found");
+}
+
+void AsyncCallbackWebHandler::handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+    if (_onBody)
+        _onBody(request, data, len, index, total);
+}
+
+// =========================================================
+// Server: poll() event loop standing in for the async_tcp task
+// =========================================================
+
+struct AsyncWebServer::Impl
+{
+    struct Connection
+    {
+        AsyncWebServerRequest *request = nullptr;
+        std::string in;
+        std::string out;
+        size_t outPos = 0;
+        bool headersParsed = false;
+        bool dispatched = false;
+        bool responded = false;
+        // Event-stream connections stay open after the response headers
+        std::shared_ptr<AsyncEventSourceStream> stream;
+        AsyncEventSourceClient *client = nullptr;
+        AsyncEventSource *source = nullptr;
+    };
+
+    int listenFd = -1;
+    std::atomic<bool> running{false};
+    std::thread thread;
+    std::map<int, Connection> connections;
+};
+
+AsyncWebServer::AsyncWebServer(uint16_t port)
+    : _port(port), _catchAllHandler(new AsyncCallbackWebHandler()), _impl(new Impl())
+{
+}
+
+AsyncWebServer::~AsyncWebServer()
+{
+    end();
+    for (AsyncWebHandler *h : _handlers)
+        delete h;
+    delete _catchAllHandler;
+}
+
+AsyncWebHandler &AsyncWebServer::addHandler(AsyncWebHandler *handler)
+{
+    _handlers.push_back(handler);
+    return *handler;
+}
+
+bool AsyncWebServer::removeHandler(AsyncWebHandler *handler)
+{
+    for (auto it = _handlers.begin(); it != _handlers.end(); ++it)
+    {
+        if (*it == handler)
+        {
+            _handlers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+AsyncCallbackWebHandler &AsyncWebServer::on(const char *uri, WebRequestMethodComposite method, ArRequestHandlerFunction onRequest,
+                                            ArUploadHandlerFunction onUpload, ArBodyHandlerFunction onBody)
+{
+    AsyncCallbackWebHandler *handler = new AsyncCallbackWebHandler();
+    handler->setUri(uri);
+    handler->setMethod(method);
+    handler->onRequest(onRequest);
+    handler->onUpload(onUpload);
+    handler->onBody(onBody);
+    addHandler(handler);
+    return *handler;
+}
+
+void AsyncWebServer::onNotFound(ArRequestHandlerFunction fn)
+{
+    _catchAllHandler->onRequest(fn);
+}
+
+void AsyncWebServer::onRequestBody(ArBodyHandlerFunction fn)
+{
+    _catchAllHandler->onBody(fn);
+}
+
+void AsyncWebServer::_attachHandler(AsyncWebServerRequest *request)
+{
+    for (AsyncWebHandler *h : _handlers)
+    {
+        if (h->canHandle(request))
+        {
+            request->_handler = h;
+            return;
+        }
+    }
+    request->_handler = _catchAllHandler;
+}
+
+void AsyncWebServer::begin()
+{
+    Impl &impl = *_impl;
+    impl.listenFd = socket(AF_INET, SOCK_STREAM, 0);
+    int yes = 1;
+    setsockopt(impl.listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    addr.sin_port = htons((uint16_t)SimRuntime::mapPort(_port));
+    if (bind(impl.listenFd, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(impl.listenFd, 64) != 0)
+    {
+        log_e("AsyncWebServer: cannot listen on port %d", SimRuntime::mapPort(_port));
+        ::close(impl.listenFd);
+        impl.listenFd = -1;
+        return;
+    }
+    fcntl(impl.listenFd, F_SETFL, fcntl(impl.listenFd, F_GETFL) | O_NONBLOCK);
+
+    impl.running = true;
+    impl.thread = std::thread([this]()
+                              {
+        simAdoptThread("async_tcp", CONFIG_ASYNC_TCP_STACK_SIZE, CONFIG_ASYNC_TCP_PRIORITY, CONFIG_ASYNC_TCP_RUNNING_CORE);
+        Impl &impl = *_impl;
+        std::vector<pollfd> fds;
+        std::vector<int> closing;
+
+        while (impl.running)
+        {
+            fds.clear();
+            fds.push_back({impl.listenFd, POLLIN, 0});
+            for (auto &entry : impl.connections)
+            {
+                short events = POLLIN;
+                if (entry.second.outPos < entry.second.out.size())
+                    events |= POLLOUT;
+                fds.push_back({entry.first, events, 0});
+            }
+
+            if (poll(fds.data(), fds.size(), 20) < 0)
+                continue;
+
+            // Accept every pending connection
+            if (fds[0].revents & POLLIN)
+            {
+                int fd;
+                while ((fd = accept(impl.listenFd, nullptr, nullptr)) >= 0)
+                {
+                    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+                    int one = 1;
+                    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+                    impl.connections[fd].request = new AsyncWebServerRequest(this, fd);
+                }
+            }
+
+            closing.clear();
+            for (size_t i = 1; i < fds.size(); i++)
+            {
+                int fd = fds[i].fd;
+                auto it = impl.connections.find(fd);
+                if (it == impl.connections.end())
+                    continue;
+                Impl::Connection &conn = it->second;
+                AsyncWebServerRequest *req = conn.request;
+
+                if (fds[i].revents & (POLLERR | POLLHUP))
+                {
+                    closing.push_back(fd);
+                    continue;
+                }
+
+                if (fds[i].revents & POLLIN)
+                {
+                    char buf[2048];
+                    ssize_t n = recv(fd, buf, sizeof(buf), 0);
+                    if (n <= 0)
+                    {
+                        closing.push_back(fd);
+                        continue;
+                    }
+                    if (conn.dispatched)
+                        continue; // pipelining is not supported, like the board
+                    conn.in.append(buf, (size_t)n);
+
+                    if (!conn.headersParsed)
+                    {
+                        size_t headerEnd = conn.in.find("\r\n\r\n");
+                        if (headerEnd == std::string::npos)
+                        {
+                            if (conn.in.size() > MAX_HEADER_BYTES)
+                                closing.push_back(fd);
+                            continue;
+                        }
+                        conn.headersParsed = true;
+
+                        size_t lineEnd = conn.in.find("\r\n");
+                        String requestLine(conn.in.substr(0, lineEnd));
+                        int sp1 = requestLine.indexOf(' ');
+                        int sp2 = requestLine.indexOf(' ', sp1 + 1);
+                        if (sp1 < 0 || sp2 < 0)
+                        {
+                            closing.push_back(fd);
+                            continue;
+                        }
+                        req->_method = parseMethod(requestLine.substring(0, sp1));
+                        String target = requestLine.substring(sp1 + 1, sp2);
+                        int q = target.indexOf('?');
+                        req->_url = urlDecode(q >= 0 ? target.substring(0, q) : target);
+                        if (q >= 0)
+                            req->addQueryParams(target.substring(q + 1), false);
+
+                        size_t pos = lineEnd + 2;
+                        while (pos < headerEnd)
+                        {
+                            size_t eol = conn.in.find("\r\n", pos);
+                            String line(conn.in.substr(pos, eol - pos));
+                            int colon = line.indexOf(':');
+                            if (colon > 0)
+                            {
+                                String value = line.substring(colon + 1);
+                                value.trim();
+                                req->_headers.emplace_back(line.substring(0, colon), value);
+                            }
+                            pos = eol + 2;
+                        }
+                        req->_contentType = req->header("Content-Type");
+                        req->_contentLength = (size_t)req->header("Content-Length").toInt();
+                        req->_isForm = req->_contentType.startsWith("application/x-www-form-urlencoded");
+                        _attachHandler(req);
+                        conn.in.erase(0, headerEnd + 4);
+                    }
+
+                    // Body bytes go to the handler as they arrive
+                    if (!conn.in.empty() && req->_bodyReceived < req->_contentLength)
+                    {
+                        size_t take = std::min(conn.in.size(), req->_contentLength - req->_bodyReceived);
+                        if (req->_isForm)
+                            req->_formBody.append(conn.in, 0, take);
+                        else
+                            req->_handler->handleBody(req, (uint8_t *)&conn.in[0], take, req->_bodyReceived, req->_contentLength);
+                        req->_bodyReceived += take;
+                        conn.in.erase(0, take);
+                    }
+
+                    if (req->_bodyReceived >= req->_contentLength)
+                    {
+                        if (req->_isForm)
+                            req->addQueryParams(String(req->_formBody), true);
+                        conn.dispatched = true;
+                        req->_handler->handleRequest(req);
+                    }
+                }
+
+                if ((fds[i].revents & POLLOUT) && conn.outPos < conn.out.size())
+                {
+                    ssize_t n = ::send(fd, conn.out.data() + conn.outPos, conn.out.size() - conn.outPos, MSG_NOSIGNAL);
+                    if (n < 0)
+                    {
+                        closing.push_back(fd);
+                        continue;
+                    }
+                    conn.outPos += (size_t)n;
+                }
+            }
+
+            // Assemble responses and close finished connections
+            for (auto &entry : impl.connections)
+            {
+                Impl::Connection &conn = entry.second;
+                AsyncWebServerRequest *req = conn.request;
+                if (req->_response && !conn.responded)
+                {
+                    conn.responded = true;
+                    conn.out = req->_response->assemble(req->_method == HTTP_HEAD);
+                    ssize_t n = ::send(entry.first, conn.out.data(), conn.out.size(), MSG_NOSIGNAL);
+                    if (n > 0)
+                        conn.outPos = (size_t)n;
+
+                    AsyncEventSource *source = req->_response->eventSource();
+                    if (source)
+                    {
+                        conn.stream = std::make_shared<AsyncEventSourceStream>();
+                        conn.source = source;
+                        conn.client = new AsyncEventSourceClient(source, conn.stream);
+                        source->_addClient(conn.client);
+                    }
+                }
+
+                if (conn.stream)
+                {
+                    // Frames queued by other threads since the last pass
+                    std::lock_guard<std::mutex> guard(conn.stream->lock);
+                    if (!conn.stream->pending.empty())
+                    {
+                        if (conn.outPos >= conn.out.size())
+                        {
+                            conn.out.clear();
+                            conn.outPos = 0;
+                        }
+                        conn.out += conn.stream->pending;
+                        conn.stream->pending.clear();
+                        ssize_t n = ::send(entry.first, conn.out.data() + conn.outPos, conn.out.size() - conn.outPos, MSG_NOSIGNAL);
+                        if (n > 0)
+                            conn.outPos += (size_t)n;
+                    }
+                    if (conn.stream->closed && conn.outPos >= conn.out.size())
+                        closing.push_back(entry.first);
+                    continue;
+                }
+
+                if (conn.responded && conn.outPos >= conn.out.size())
+                    closing.push_back(entry.first);
+            }
+
+            for (int fd : closing)
+            {
+                auto it = impl.connections.find(fd);
+                if (it == impl.connections.end())
+                    continue;
+                AsyncWebServerRequest *req = it->second.request;
+                if (it->second.stream)
+                {
+                    {
+                        std::lock_guard<std::mutex> guard(it->second.stream->lock);
+                        it->second.stream->closed = true;
+                    }
+                    it->second.source->_handleDisconnect(it->second.client);
+                }
+                ::close(fd);
+                impl.connections.erase(it);
+                if (req->_onDisconnect)
+                    req->_onDisconnect();
+                delete req;
+            }
+        } });
+}
+
+void AsyncWebServer::end()
+{
+    Impl &impl = *_impl;
+    if (!impl.running)
+        return;
+    impl.running = false;
+    if (impl.thread.joinable())
+        impl.thread.join();
+    for (auto &entry : impl.connections)
+    {
+        ::close(entry.first);
+        delete entry.second.request;
+    }
+    impl.connections.clear();
+    ::close(impl.listenFd);
+    impl.listenFd = -1;
+}
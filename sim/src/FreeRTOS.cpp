@@ -0,0 +1,364 @@
+#include <Arduino.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/queue.h>
+#include <freertos/semphr.h>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// =========================================================
+// FreeRTOS stand-in (tasks, queues, semaphores, notifications)
+// =========================================================
+
+struct SimTask
+{
+    std::string name;
+    uint32_t stackDepth = 0;
+    UBaseType_t priority = 1;
+    BaseType_t core = tskNO_AFFINITY;
+    std::mutex lock;
+    std::condition_variable cv;
+    uint32_t notifyCount = 0;
+};
+
+struct SimQueue
+{
+    std::mutex lock;
+    std::condition_variable cv;
+    std::deque<std::vector<uint8_t>> items;
+    UBaseType_t length;
+    UBaseType_t itemSize;
+};
+
+struct SimSemaphore
+{
+    std::recursive_timed_mutex mutex;
+    bool isMutex;
+    // binary semaphore state
+    std::mutex lock;
+    std::condition_variable cv;
+    bool given = false;
+};
+
+struct SimMux
+{
+    std::recursive_mutex mutex;
+};
+
+namespace
+{
+    std::mutex g_muxInit;
+
+    // The thread that runs setup()/loop() plays the Arduino loopTask (core 1)
+    SimTask *loopTask()
+    {
+        static SimTask *task = []
+        {
+            SimTask *t = new SimTask();
+            t->name = "loopTask";
+            t->stackDepth = 8192;
+            t->priority = 1;
+            t->core = 1;
+            return t;
+        }();
+        return task;
+    }
+
+    thread_local SimTask *t_current = nullptr;
+
+    std::mutex g_registryLock;
+    std::vector<SimTask *> g_registry;
+
+    SimTask *newTask(const char *name, uint32_t stackDepth, UBaseType_t priority, BaseType_t core)
+    {
+        SimTask *task = new SimTask();
+        task->name = name ? name : "";
+        task->stackDepth = stackDepth;
+        task->priority = priority;
+        task->core = core;
+        std::lock_guard<std::mutex> guard(g_registryLock);
+        g_registry.push_back(task);
+        return task;
+    }
+
+    std::chrono::steady_clock::time_point deadline(TickType_t ticks)
+    {
+        return std::chrono::steady_clock::now() + std::chrono::milliseconds(ticks);
+    }
+
+    // Waits on cv until pred() holds or the tick timeout expires
+    template <typename Lock, typename Pred>
+    bool waitFor(std::condition_variable &cv, Lock &lock, TickType_t ticks, Pred pred)
+    {
+        if (ticks == portMAX_DELAY)
+        {
+            cv.wait(lock, pred);
+            return true;
+        }
+        return cv.wait_until(lock, deadline(ticks), pred);
+    }
+}
+
+// =========================================================
+// Critical sections
+// =========================================================
+
+void simEnterCritical(portMUX_TYPE *mux)
+{
+    {
+        std::lock_guard<std::mutex> guard(g_muxInit);
+        if (!mux->impl)
+            mux->impl = new SimMux();
+    }
+    mux->impl->mutex.lock();
+}
+
+void simExitCritical(portMUX_TYPE *mux)
+{
+    mux->impl->mutex.unlock();
+}
+
+BaseType_t xPortGetCoreID()
+{
+    SimTask *task = xTaskGetCurrentTaskHandle();
+    return task->core == tskNO_AFFINITY ? 0 : task->core;
+}
+
+int64_t esp_timer_get_time()
+{
+    return (int64_t)micros();
+}
+
+// =========================================================
+// Tasks
+// =========================================================
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stackDepth, void *param,
+                                   UBaseType_t priority, TaskHandle_t *createdTask, BaseType_t coreId)
+{
+    SimTask *task = newTask(name, stackDepth, priority, coreId);
+    if (createdTask)
+        *createdTask = task;
+
+    std::thread([fn, param, task]()
+                {
+                    t_current = task;
+                    fn(param);
+                })
+        .detach();
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    // Only self-deletion is supported: park the thread forever
+    if (task == nullptr || task == xTaskGetCurrentTaskHandle())
+    {
+        for (;;)
+            std::this_thread::sleep_for(std::chrono::hours(1));
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount()
+{
+    return (TickType_t)millis();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle()
+{
+    return t_current ? t_current : loopTask();
+}
+
+TaskHandle_t xTaskGetHandle(const char *name)
+{
+    if (strcmp(name, "loopTask") == 0)
+        return loopTask();
+    std::lock_guard<std::mutex> guard(g_registryLock);
+    for (SimTask *task : g_registry)
+    {
+        if (task->name == name)
+            return task;
+    }
+    return nullptr;
+}
+
+TaskHandle_t simAdoptThread(const char *name, uint32_t stackDepth, UBaseType_t priority, BaseType_t coreId)
+{
+    t_current = newTask(name, stackDepth, priority, coreId);
+    return t_current;
+}
+
+const char *pcTaskGetName(TaskHandle_t task)
+{
+    if (!task)
+        task = xTaskGetCurrentTaskHandle();
+    return task->name.c_str();
+}
+
+UBaseType_t uxTaskGetStackHighWaterMark(TaskHandle_t task)
+{
+    // Stack usage can't be observed on the host: report half the stack as free
+    if (!task)
+        task = xTaskGetCurrentTaskHandle();
+    return task->stackDepth / 2;
+}
+
+UBaseType_t uxTaskPriorityGet(TaskHandle_t task)
+{
+    if (!task)
+        task = xTaskGetCurrentTaskHandle();
+    return task->priority;
+}
+
+BaseType_t xTaskGetAffinity(TaskHandle_t task)
+{
+    if (!task)
+        task = xTaskGetCurrentTaskHandle();
+    return task->core;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    {
+        std::lock_guard<std::mutex> guard(task->lock);
+        task->notifyCount++;
+    }
+    task->cv.notify_all();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearCountOnExit, TickType_t ticksToWait)
+{
+    SimTask *task = xTaskGetCurrentTaskHandle();
+    std::unique_lock<std::mutex> lock(task->lock);
+    waitFor(task->cv, lock, ticksToWait, [task]
+            { return task->notifyCount > 0; });
+    uint32_t value = task->notifyCount;
+    if (value > 0)
+        task->notifyCount = clearCountOnExit ? 0 : value - 1;
+    return value;
+}
+
+// =========================================================
+// Queues
+// =========================================================
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize)
+{
+    SimQueue *queue = new SimQueue();
+    queue->length = length;
+    queue->itemSize = itemSize;
+    return queue;
+}
+
+void vQueueDelete(QueueHandle_t queue)
+{
+    delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue->cv, lock, ticksToWait, [queue]
+                 { return queue->items.size() < queue->length; }))
+        return pdFAIL;
+    const uint8_t *bytes = (const uint8_t *)item;
+    queue->items.emplace_back(bytes, bytes + queue->itemSize);
+    lock.unlock();
+    queue->cv.notify_all();
+    return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *buffer, TickType_t ticksToWait)
+{
+    std::unique_lock<std::mutex> lock(queue->lock);
+    if (!waitFor(queue->cv, lock, ticksToWait, [queue]
+                 { return !queue->items.empty(); }))
+        return pdFAIL;
+    memcpy(buffer, queue->items.front().data(), queue->itemSize);
+    queue->items.pop_front();
+    lock.unlock();
+    queue->cv.notify_all();
+    return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue)
+{
+    std::lock_guard<std::mutex> guard(queue->lock);
+    return (UBaseType_t)queue->items.size();
+}
+
+// =========================================================
+// Semaphores
+// =========================================================
+
+SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    SimSemaphore *sem = new SimSemaphore();
+    sem->isMutex = true;
+    return sem;
+}
+
+SemaphoreHandle_t xSemaphoreCreateRecursiveMutex()
+{
+    return xSemaphoreCreateMutex();
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    SimSemaphore *sem = new SimSemaphore();
+    sem->isMutex = false;
+    return sem;
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticksToWait)
+{
+    if (sem->isMutex)
+    {
+        if (ticksToWait == portMAX_DELAY)
+        {
+            sem->mutex.lock();
+            return pdTRUE;
+        }
+        return sem->mutex.try_lock_for(std::chrono::milliseconds(ticksToWait)) ? pdTRUE : pdFALSE;
+    }
+
+    std::unique_lock<std::mutex> lock(sem->lock);
+    if (!waitFor(sem->cv, lock, ticksToWait, [sem]
+                 { return sem->given; }))
+        return pdFALSE;
+    sem->given = false;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->isMutex)
+    {
+        sem->mutex.unlock();
+        return pdTRUE;
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(sem->lock);
+        sem->given = true;
+    }
+    sem->cv.notify_one();
+    return pdTRUE;
+}
@@ -0,0 +1,110 @@
+#include <Preferences.h>
+#include "SimRuntime.h"
+#include <sys/stat.h>
+
+// =========================================================
+// Preferences stand-in (one "key=value" line per key)
+// =========================================================
+
+bool Preferences::begin(const char *name, bool readOnly)
+{
+    ::mkdir(SimRuntime::nvsDir().c_str(), 0755);
+    _path = SimRuntime::nvsDir() + "/" + name;
+    _readOnly = readOnly;
+    _values.clear();
+
+    FILE *fp = fopen(_path.c_str(), "r");
+    if (fp)
+    {
+        char line[512];
+        while (fgets(line, sizeof(line), fp))
+        {
+            char *eq = strchr(line, '=');
+            if (!eq)
+                continue;
+            line[strcspn(line, "\n")] = '\0';
+            *eq = '\0';
+            _values[line] = eq + 1;
+        }
+        fclose(fp);
+    }
+    _open = true;
+    return true;
+}
+
+void Preferences::end()
+{
+    _open = false;
+}
+
+bool Preferences::save()
+{
+    FILE *fp = fopen(_path.c_str(), "w");
+    if (!fp)
+        return false;
+    for (const auto &kv : _values)
+        fprintf(fp, "%s=%s\n", kv.first.c_str(), kv.second.c_str());
+    fclose(fp);
+    return true;
+}
+
+size_t Preferences::put(const char *key, const std::string &value, size_t size)
+{
+    if (!_open || _readOnly || strlen(key) > 15)
+        return 0;
+    _values[key] = value;
+    return save() ? size : 0;
+}
+
+bool Preferences::isKey(const char *key)
+{
+    return _open && _values.count(key) > 0;
+}
+
+bool Preferences::remove(const char *key)
+{
+    if (!_open || _readOnly || _values.erase(key) == 0)
+        return false;
+    return save();
+}
+
+bool Preferences::clear()
+{
+    if (!_open || _readOnly)
+        return false;
+    _values.clear();
+    return save();
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value)
+{
+    return put(key, std::to_string(value), sizeof(value));
+}
+
+size_t Preferences::putUShort(const char *key, uint16_t value)
+{
+    return put(key, std::to_string(value), sizeof(value));
+}
+
+size_t Preferences::putString(const char *key, const char *value)
+{
+    return put(key, value, strlen(value));
+}
+
+uint8_t Preferences::getUChar(const char *key, uint8_t defaultValue)
+{
+    auto it = _values.find(key);
+    return it == _values.end() ? defaultValue : (uint8_t)atoi(it->second.c_str());
+}
+
+uint16_t Preferences::getUShort(const char *key, uint16_t defaultValue)
+{
+    auto it = _values.find(key);
+    return it == _values.end() ? defaultValue : (uint16_t)atoi(it->second.c_str());
+}
+
+String Preferences::getString(const char *key, const String &defaultValue)
+{
+    auto it = _values.find(key);
+    return it == _values.end() ? defaultValue : String(it->second);
+}
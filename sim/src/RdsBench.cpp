@@ -0,0 +1,104 @@
+#include <Arduino.h>
+#include <chrono>
+#include "RdsDecoder.h"
+#include "SimTuner.h"
+
+// =========================================================
+// --bench-rds N: decode N groups of a station's RDS stream
+// =========================================================
+// The groups come from the capture in FAMIO_SIM_RDS (redsea hex format) or
+// the stream generated for the strongest simulated station; set
+// FAMIO_SIM_RDS_BLER to inject block errors. Every group goes through the
+// decoder's ring and process(), as in the control task, with the per-block
+// error levels of the capture (the chip itself reports A and B only).
+// Prints the decode cost, how long the PS name, RadioText and clock take to
+// appear on air (11.4 groups/s) and the error counters.
+
+namespace
+{
+    const float GROUPS_PER_SECOND = 1187.5f / 104;
+
+    void reportFirst(const char *what, int32_t group)
+    {
+        if (group < 0)
+            printf("%-6s not decoded\n", what);
+        else
+            printf("%-6s after %d groups (%.1f s on air)\n", what, (int)group + 1, (group + 1) / GROUPS_PER_SECOND);
+    }
+}
+
+int runRdsBench(int groups)
+{
+    uint16_t freq10k[64];
+    uint8_t peak[64];
+    size_t count = SimTuner::stations(freq10k, peak, 64);
+    uint16_t station = count ? freq10k[0] : 9950;
+    for (size_t i = 1; i < count; i++)
+    {
+        if (peak[i] > peak[0])
+        {
+            peak[0] = peak[i];
+            station = freq10k[i];
+        }
+    }
+
+    const char *capture = getenv("FAMIO_SIM_RDS");
+    const char *bler = getenv("FAMIO_SIM_RDS_BLER");
+    printf("groups: %d, source: %s, injected errors: %s%%\n", groups,
+           (capture && *capture) ? capture : "generated", (bler && *bler) ? bler : "0");
+    if (!(capture && *capture))
+        printf("station: %.1f MHz\n", station / 100.0f);
+
+    RdsDecoder decoder;
+    int32_t firstPs = -1;
+    int32_t firstRt = -1;
+    int32_t firstClock = -1;
+    uint32_t version = decoder.getVersion();
+    double decodeNs = 0;
+
+    for (int n = 0; n < groups; n++)
+    {
+        SimRdsGroup on = SimTuner::rdsGroup(station, n);
+        RdsGroup group;
+        memcpy(group.block, on.block, sizeof(group.block));
+        memcpy(group.bler, on.bler, sizeof(group.bler));
+
+        auto start = std::chrono::steady_clock::now();
+        decoder.push(group);
+        decoder.process();
+        decodeNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+        if (decoder.getVersion() == version)
+            continue;
+        version = decoder.getVersion();
+        RdsInfo info;
+        decoder.getInfo(info);
+        if (firstPs < 0 && info.hasPs)
+            firstPs = n;
+        if (firstRt < 0 && info.hasRt)
+            firstRt = n;
+        if (firstClock < 0 && info.hasClock)
+            firstClock = n;
+    }
+
+    printf("decode: %.0f ns/group\n", groups ? decodeNs / groups : 0.0);
+    reportFirst("ps", firstPs);
+    reportFirst("rt", firstRt);
+    reportFirst("clock", firstClock);
+
+    RdsInfo info;
+    decoder.getInfo(info);
+    printf("pi %04X pty %u tp %d ta %d music %d\n", info.pi, info.pty, info.tp, info.ta, info.music);
+    printf("ps \"%s\"\nrt \"%s\"\n", info.ps, info.rt);
+    if (info.hasClock)
+        printf("clock %04u-%02u-%02u %02u:%02u UTC%+d min\n", info.clock.year, info.clock.month, info.clock.day,
+               info.clock.hour, info.clock.minute, info.clock.offsetHalfHours * 30);
+
+    const RdsStats &stats = decoder.getStats();
+    printf("decoded %u, rejected %u, overflows %u\n", (unsigned)stats.decoded, (unsigned)stats.rejected,
+           (unsigned)stats.overflows);
+    printf("corrected A %u B %u C %u D %u, lost A %u B %u C %u D %u\n",
+           (unsigned)stats.corrected[0], (unsigned)stats.corrected[1], (unsigned)stats.corrected[2], (unsigned)stats.corrected[3],
+           (unsigned)stats.lost[0], (unsigned)stats.lost[1], (unsigned)stats.lost[2], (unsigned)stats.lost[3]);
+    return 0;
+}
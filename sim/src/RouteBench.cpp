@@ -0,0 +1,103 @@
+#include <Arduino.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "RouteTable.h"
+
+// =========================================================
+// --bench-routes N: per-route handlers vs. the sorted route table
+// =========================================================
+// Builds synthetic APIs of growing size and resolves every path N times
+// both ways: the linear scan that server.on() handlers get (String compare
+// per registered route, like AsyncCallbackWebHandler::canHandle) and
+// RouteTable::find over a sorted array. One lookup in every round misses.
+// Host times are only meaningful relative to each other.
+
+namespace
+{
+    struct BenchRoute
+    {
+        const char *path;
+        WebRequestMethod method;
+    };
+
+    struct CallbackRoute
+    {
+        String uri;
+        WebRequestMethodComposite method;
+    };
+
+    const size_t SIZES[] = {24, 96, 384};
+
+    double nsPerLookup(std::chrono::steady_clock::duration elapsed, size_t lookups)
+    {
+        return std::chrono::duration<double, std::nano>(elapsed).count() / lookups;
+    }
+}
+
+int runRouteBench(int rounds)
+{
+    printf("rounds: %d\n", rounds);
+    printf("%8s %14s %14s\n", "routes", "linear_ns", "table_ns");
+
+    for (size_t size : SIZES)
+    {
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < size; i++)
+            paths.push_back("/api/group" + std::to_string(i / 8) + "/action" + std::to_string(i % 8));
+        std::sort(paths.begin(), paths.end(), [](const std::string &a, const std::string &b)
+                  { return RouteTable::compare(a.c_str(), b.c_str()) < 0; });
+
+        std::vector<BenchRoute> table;
+        std::vector<CallbackRoute> handlers;
+        for (const std::string &path : paths)
+        {
+            table.push_back({path.c_str(), HTTP_GET});
+            handlers.push_back({String(path.c_str()), HTTP_GET});
+        }
+
+        // Requests arrive as Strings (request->url())
+        std::vector<String> urls;
+        for (const std::string &path : paths)
+            urls.push_back(String(path.c_str()));
+        urls.push_back(String("/api/missing"));
+
+        size_t found = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (const String &url : urls)
+            {
+                for (const CallbackRoute &handler : handlers)
+                {
+                    if ((handler.method & HTTP_GET) && handler.uri == url)
+                    {
+                        found++;
+                        break;
+                    }
+                }
+            }
+        }
+        double linear = nsPerLookup(std::chrono::steady_clock::now() - start, (size_t)rounds * urls.size());
+
+        WebRequestMethodComposite allowed;
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < rounds; r++)
+        {
+            for (const String &url : urls)
+            {
+                if (RouteTable::find(table.data(), table.size(), url.c_str(), HTTP_GET, allowed) >= 0)
+                    found++;
+            }
+        }
+        double sorted = nsPerLookup(std::chrono::steady_clock::now() - start, (size_t)rounds * urls.size());
+
+        if (found != (size_t)rounds * size * 2)
+        {
+            printf("lookup mismatch at %u routes\n", (unsigned)size);
+            return 1;
+        }
+        printf("%8u %14.1f %14.1f\n", (unsigned)size, linear, sorted);
+    }
+    return 0;
+}
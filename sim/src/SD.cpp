@@ -0,0 +1,276 @@
+#include <SD.h>
+#include "SimRuntime.h"
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+SPIClass SPI;
+fs::SDFS SD;
+
+namespace
+{
+    // Cost of resolving a path on FAT over SPI (directory scans per component)
+    unsigned long openCostUs()
+    {
+        static long cost = -1;
+        if (cost < 0)
+        {
+            const char *value = getenv("FAMIO_SIM_SD_OPEN_US");
+            cost = (value && *value) ? strtol(value, nullptr, 10) : 0;
+        }
+        return (unsigned long)cost;
+    }
+}
+
+namespace fs
+{
+    struct FileHandle
+    {
+        FILE *fp = nullptr;
+        DIR *dir = nullptr;
+        std::string path;     // path as seen by the firmware
+        std::string hostPath; // path on the host
+        std::string name;
+
+        ~FileHandle()
+        {
+            if (fp)
+                fclose(fp);
+            if (dir)
+                closedir(dir);
+        }
+    };
+
+    // =========================================================
+    // File
+    // =========================================================
+
+    size_t File::write(uint8_t c)
+    {
+        return write(&c, 1);
+    }
+
+    size_t File::write(const uint8_t *buf, size_t size)
+    {
+        if (!_h || !_h->fp)
+            return 0;
+        return fwrite(buf, 1, size, _h->fp);
+    }
+
+    int File::available()
+    {
+        if (!_h || !_h->fp)
+            return 0;
+        return (int)(size() - position());
+    }
+
+    int File::read()
+    {
+        if (!_h || !_h->fp)
+            return -1;
+        return fgetc(_h->fp);
+    }
+
+    int File::peek()
+    {
+        if (!_h || !_h->fp)
+            return -1;
+        int c = fgetc(_h->fp);
+        if (c != EOF)
+            ungetc(c, _h->fp);
+        return c;
+    }
+
+    size_t File::read(uint8_t *buf, size_t size)
+    {
+        if (!_h || !_h->fp)
+            return 0;
+        return fread(buf, 1, size, _h->fp);
+    }
+
+    void File::flush()
+    {
+        if (_h && _h->fp)
+            fflush(_h->fp);
+    }
+
+    bool File::seek(uint32_t pos, SeekMode mode)
+    {
+        if (!_h || !_h->fp)
+            return false;
+        int whence = mode == SeekSet ? SEEK_SET : (mode == SeekCur ? SEEK_CUR : SEEK_END);
+        return fseek(_h->fp, (long)pos, whence) == 0;
+    }
+
+    size_t File::position() const
+    {
+        if (!_h || !_h->fp)
+            return 0;
+        return (size_t)ftell(_h->fp);
+    }
+
+    size_t File::size() const
+    {
+        if (!_h)
+            return 0;
+        struct stat st;
+        if (_h->fp)
+            fflush(_h->fp);
+        if (stat(_h->hostPath.c_str(), &st) != 0)
+            return 0;
+        return (size_t)st.st_size;
+    }
+
+    void File::close()
+    {
+        _h.reset();
+    }
+
+    File::operator bool() const
+    {
+        return _h && (_h->fp || _h->dir);
+    }
+
+    const char *File::path() const
+    {
+        return _h ? _h->path.c_str() : nullptr;
+    }
+
+    const char *File::name() const
+    {
+        return _h ? _h->name.c_str() : nullptr;
+    }
+
+    bool File::isDirectory() const
+    {
+        return _h && _h->dir;
+    }
+
+    File File::openNextFile(const char *mode)
+    {
+        if (!_h || !_h->dir)
+            return File();
+
+        struct dirent *entry;
+        while ((entry = readdir(_h->dir)) != nullptr)
+        {
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+                continue;
+
+            auto handle = std::make_shared<FileHandle>();
+            handle->path = _h->path + (_h->path.back() == '/' ? "" : "/") + entry->d_name;
+            handle->hostPath = _h->hostPath + "/" + entry->d_name;
+            handle->name = entry->d_name;
+
+            struct stat st;
+            if (stat(handle->hostPath.c_str(), &st) == 0 && S_ISDIR(st.st_mode))
+                handle->dir = opendir(handle->hostPath.c_str());
+            else
+                handle->fp = fopen(handle->hostPath.c_str(), strcmp(mode, FILE_READ) == 0 ? "rb" : mode);
+            return File(handle);
+        }
+        return File();
+    }
+
+    // =========================================================
+    // FS
+    // =========================================================
+
+    std::string FS::hostPath(const char *path) const
+    {
+        std::string p = SimRuntime::sdRoot();
+        if (path[0] != '/')
+            p += "/";
+        return p + path;
+    }
+
+    File FS::open(const char *path, const char *mode, const bool create)
+    {
+        (void)create;
+        if (!_mounted || !path)
+            return File();
+        if (openCostUs())
+            usleep(openCostUs());
+
+        auto handle = std::make_shared<FileHandle>();
+        handle->path = path;
+        handle->hostPath = hostPath(path);
+        const char *slash = strrchr(path, '/');
+        handle->name = slash ? slash + 1 : path;
+
+        struct stat st;
+        bool exists = stat(handle->hostPath.c_str(), &st) == 0;
+        if (exists && S_ISDIR(st.st_mode))
+        {
+            handle->dir = opendir(handle->hostPath.c_str());
+            return handle->dir ? File(handle) : File();
+        }
+
+        const char *hostMode = "rb";
+        if (strcmp(mode, FILE_WRITE) == 0)
+            hostMode = "wb";
+        else if (strcmp(mode, FILE_APPEND) == 0)
+            hostMode = "ab";
+        else if (strcmp(mode, "r+") == 0)
+            hostMode = "r+b";
+
+        handle->fp = fopen(handle->hostPath.c_str(), hostMode);
+        return handle->fp ? File(handle) : File();
+    }
+
+    bool FS::exists(const char *path)
+    {
+        struct stat st;
+        return _mounted && stat(hostPath(path).c_str(), &st) == 0;
+    }
+
+    bool FS::remove(const char *path)
+    {
+        return _mounted && ::unlink(hostPath(path).c_str()) == 0;
+    }
+
+    bool FS::rename(const char *pathFrom, const char *pathTo)
+    {
+        return _mounted && ::rename(hostPath(pathFrom).c_str(), hostPath(pathTo).c_str()) == 0;
+    }
+
+    bool FS::mkdir(const char *path)
+    {
+        return _mounted && ::mkdir(hostPath(path).c_str(), 0755) == 0;
+    }
+
+    bool FS::rmdir(const char *path)
+    {
+        return _mounted && ::rmdir(hostPath(path).c_str()) == 0;
+    }
+
+    // =========================================================
+    // SDFS
+    // =========================================================
+
+    bool SDFS::begin(uint8_t ssPin, SPIClass &spi, uint32_t frequency, const char *mountpoint,
+                     uint8_t max_files, bool format_if_empty)
+    {
+        (void)ssPin;
+        (void)spi;
+        (void)frequency;
+        (void)max_files;
+        (void)format_if_empty;
+        _mountpoint = mountpoint;
+
+        struct stat st;
+        _mounted = SimRuntime::sdPresent() &&
+                   stat(SimRuntime::sdRoot().c_str(), &st) == 0 && S_ISDIR(st.st_mode);
+        return _mounted;
+    }
+
+    uint64_t SDFS::cardSize()
+    {
+        return _mounted ? 8ULL * 1024 * 1024 * 1024 : 0;
+    }
+
+    uint64_t SDFS::usedBytes()
+    {
+        return 0;
+    }
+}
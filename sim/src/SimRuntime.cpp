@@ -0,0 +1,87 @@
+#include "SimRuntime.h"
+#include <Arduino.h>
+#include <sys/stat.h>
+
+namespace
+{
+    std::string g_sdRoot = "sim_sd";
+    std::string g_nvsDir = "sim_nvs";
+    bool g_noSd = false;
+    int g_httpPort = 8080;
+    int g_benchStorageSaves = 0;
+    int g_benchRouteRounds = 0;
+    int g_benchAutostoreRounds = 0;
+    int g_benchRdsGroups = 0;
+
+    const char *envOr(const char *name, const char *fallback)
+    {
+        const char *value = getenv(name);
+        return (value && *value) ? value : fallback;
+    }
+}
+
+namespace SimRuntime
+{
+    void init(int argc, char **argv)
+    {
+        g_sdRoot = envOr("FAMIO_SD_ROOT", g_sdRoot.c_str());
+        g_httpPort = atoi(envOr("FAMIO_HTTP_PORT", "8080"));
+        g_noSd = strcmp(envOr("FAMIO_NO_SD", "0"), "1") == 0;
+        g_nvsDir = envOr("FAMIO_NVS_DIR", g_nvsDir.c_str());
+
+        for (int i = 1; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            if (arg == "--sd-root" && i + 1 < argc)
+                g_sdRoot = argv[++i];
+            else if (arg == "--port" && i + 1 < argc)
+                g_httpPort = atoi(argv[++i]);
+            else if (arg == "--no-sd")
+                g_noSd = true;
+            else if (arg == "--nvs-dir" && i + 1 < argc)
+                g_nvsDir = argv[++i];
+            else if (arg == "--bench-storage" && i + 1 < argc)
+                g_benchStorageSaves = atoi(argv[++i]);
+            else if (arg == "--bench-routes" && i + 1 < argc)
+                g_benchRouteRounds = atoi(argv[++i]);
+            else if (arg == "--bench-autostore" && i + 1 < argc)
+                g_benchAutostoreRounds = atoi(argv[++i]);
+            else if (arg == "--bench-rds" && i + 1 < argc)
+                g_benchRdsGroups = atoi(argv[++i]);
+        }
+
+        // A fresh checkout has no card image: create the project skeleton so
+        // the firmware can save its config files on first boot.
+        if (!g_noSd)
+        {
+            std::string dir = g_sdRoot;
+            ::mkdir(dir.c_str(), 0755);
+            dir += "/famio";
+            ::mkdir(dir.c_str(), 0755);
+            ::mkdir((dir + "/config").c_str(), 0755);
+            ::mkdir((dir + "/ui").c_str(), 0755);
+        }
+
+        fprintf(stderr, "[sim] SD root: %s%s | HTTP port 80 -> %d\n",
+                g_sdRoot.c_str(), g_noSd ? " (card removed)" : "", g_httpPort);
+    }
+
+    const std::string &sdRoot() { return g_sdRoot; }
+
+    bool sdPresent() { return !g_noSd; }
+
+    const std::string &nvsDir() { return g_nvsDir; }
+
+    int mapPort(int firmwarePort)
+    {
+        return firmwarePort == 80 ? g_httpPort : firmwarePort;
+    }
+
+    int benchStorageSaves() { return g_benchStorageSaves; }
+
+    int benchRouteRounds() { return g_benchRouteRounds; }
+
+    int benchAutostoreRounds() { return g_benchAutostoreRounds; }
+
+    int benchRdsGroups() { return g_benchRdsGroups; }
+}
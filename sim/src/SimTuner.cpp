@@ -0,0 +1,572 @@
+#include "SimTuner.h"
+#include <RDA5807.h>
+#include <Wire.h>
+#include <atomic>
+#include <ctime>
+#include <mutex>
+#include <vector>
+
+// =========================================================
+// Chip model
+// =========================================================
+
+namespace
+{
+    struct Station
+    {
+        uint16_t freq10k;
+        uint8_t peakRssi;
+    };
+
+    const uint16_t BAND_BOTTOM = 8700; // 87.0 MHz
+    const uint16_t BAND_TOP = 10800;   // 108.0 MHz
+    const uint16_t BAND_STEP = 10;     // 100 kHz
+    const uint8_t NOISE_FLOOR = 9;
+    const uint8_t STEREO_RSSI = 30;
+    // Time the chip needs to settle on a channel during tune/seek
+    const uint32_t TUNE_SETTLE_MS = 12;
+
+    std::recursive_mutex g_lock;
+    std::atomic<uint32_t> g_i2cCount{0};
+    uint32_t g_i2cCostUs = 250;
+    std::vector<Station> g_stations;
+    bool g_powered = false;
+    bool g_mono = false;
+    bool g_mute = false;
+    bool g_seekFailed = false;
+    uint8_t g_volume = 0;
+    uint8_t g_seekThreshold = 25;
+    uint16_t g_freq = 8700;
+    uint32_t g_tunedAtUs = 0;
+
+    // RDS: 104 bits at 1187.5 bit/s
+    const uint32_t RDS_GROUP_US = 87600;
+    const uint8_t RDS_MIN_RSSI = 20;
+    const uint8_t RDS_CLOCK_EVERY = 40;     // One 4A group per 40 groups (~3.5 s)
+    const int8_t RDS_OFFSET_HALF_HOURS = 14; // UTC+7
+    // Share (percent) of corrected blocks (BLER 1-2) whose correction was wrong:
+    // the chip reports them as fixed but the data is not what was sent
+    const uint8_t RDS_MISCORRECT_PERCENT[3] = {0, 5, 20};
+    bool g_rds = false;
+    bool g_rdsLoaded = false;
+    uint32_t g_rdsNextGroup = 0; // First group not yet read since the tune
+    int g_rdsBlerPercent = 0;
+    std::vector<SimRdsGroup> g_rdsCapture;
+
+    void loadStations()
+    {
+        if (!g_stations.empty())
+            return;
+
+        const char *spec = getenv("FAMIO_SIM_STATIONS");
+        if (!spec || !*spec)
+            spec = "88.1:48,89.6:35,91.0:52,94.3:22,96.5:44,97.7:58,99.5:40,"
+                   "100.6:30,102.7:55,104.0:18,105.5:47,107.2:33";
+
+        std::string list = spec;
+        size_t start = 0;
+        while (start < list.size())
+        {
+            size_t end = list.find(',', start);
+            if (end == std::string::npos)
+                end = list.size();
+            std::string item = list.substr(start, end - start);
+            float mhz = 0;
+            int peak = 0;
+            if (sscanf(item.c_str(), "%f:%d", &mhz, &peak) == 2)
+                g_stations.push_back({(uint16_t)lroundf(mhz * 100), (uint8_t)peak});
+            start = end + 1;
+        }
+
+        const char *cost = getenv("FAMIO_SIM_I2C_US");
+        if (cost && *cost)
+            g_i2cCostUs = (uint32_t)atoi(cost);
+    }
+
+    int stationIndex(uint16_t freq10k)
+    {
+        for (size_t i = 0; i < g_stations.size(); i++)
+        {
+            if (g_stations[i].freq10k == freq10k)
+                return (int)i;
+        }
+        return -1;
+    }
+
+    void loadRds()
+    {
+        if (g_rdsLoaded)
+            return;
+        g_rdsLoaded = true;
+        const char *path = getenv("FAMIO_SIM_RDS");
+        if (path && *path && SimTuner::loadRdsCapture(path, g_rdsCapture))
+            printf("[sim] RDS capture %s: %u groups\n", path, (unsigned)g_rdsCapture.size());
+        const char *bler = getenv("FAMIO_SIM_RDS_BLER");
+        if (bler && *bler)
+            g_rdsBlerPercent = atoi(bler);
+    }
+
+    void corruptRds(SimRdsGroup &group)
+    {
+        for (int i = 0; i < 4; i++)
+        {
+            if (rand() % 100 >= g_rdsBlerPercent)
+                continue;
+            uint8_t level = 1 + rand() % 3;
+            if (level > group.bler[i])
+                group.bler[i] = level;
+            if (level == 3 || rand() % 100 < RDS_MISCORRECT_PERCENT[level])
+                group.block[i] ^= (uint16_t)(1 + rand() % 0xFFFF);
+        }
+    }
+
+    SimRdsGroup generateRdsGroup(uint16_t freq10k, uint32_t n)
+    {
+        int index = stationIndex(freq10k);
+        if (index < 0)
+            index = 0;
+        uint16_t pi = (uint16_t)(0x3200 + index);
+        uint16_t base = (uint16_t)((1u << 10) | (((index * 5 + 1) % 32) << 5)); // TP, PTY
+
+        char ps[16];
+        snprintf(ps, sizeof(ps), "FM %-5.1f", freq10k / 100.0f);
+        char rt[80];
+        int length = snprintf(rt, sizeof(rt), "Famio sim - now playing on %.1f MHz\r", freq10k / 100.0f);
+        int rtSegments = (length + 3) / 4;
+        memset(rt + length, ' ', sizeof(rt) - length);
+
+        SimRdsGroup group = {};
+        group.block[0] = pi;
+        if (n % RDS_CLOCK_EVERY == RDS_CLOCK_EVERY - 1)
+        {
+            // 4A: MJD, UTC hour/minute and the local offset
+            time_t now = time(nullptr);
+            struct tm utc;
+            gmtime_r(&now, &utc);
+            uint32_t mjd = 40587 + (uint32_t)(now / 86400);
+            group.block[1] = (uint16_t)(0x4000 | base | ((mjd >> 15) & 0x03));
+            group.block[2] = (uint16_t)(((mjd & 0x7FFF) << 1) | (utc.tm_hour >> 4));
+            group.block[3] = (uint16_t)(((utc.tm_hour & 0x0F) << 12) | (utc.tm_min << 6) | RDS_OFFSET_HALF_HOURS);
+        }
+        else if (n % 2 == 0)
+        {
+            // 0A: PS segment, music
+            uint16_t segment = (n / 2) % 4;
+            group.block[1] = (uint16_t)(base | (1u << 3) | segment);
+            group.block[2] = 0xE0CD; // AF: none listed
+            group.block[3] = (uint16_t)(((uint8_t)ps[segment * 2] << 8) | (uint8_t)ps[segment * 2 + 1]);
+        }
+        else
+        {
+            // 2A: RadioText segment
+            uint16_t segment = (n / 2) % rtSegments;
+            group.block[1] = (uint16_t)(0x2000 | base | segment);
+            group.block[2] = (uint16_t)(((uint8_t)rt[segment * 4] << 8) | (uint8_t)rt[segment * 4 + 1]);
+            group.block[3] = (uint16_t)(((uint8_t)rt[segment * 4 + 2] << 8) | (uint8_t)rt[segment * 4 + 3]);
+        }
+        return group;
+    }
+}
+
+namespace SimTuner
+{
+    uint32_t i2cCostUs() { return g_i2cCostUs; }
+
+    void i2cTransaction()
+    {
+        g_i2cCount++;
+        if (g_i2cCostUs)
+            delayMicroseconds(g_i2cCostUs);
+    }
+
+    uint32_t i2cTransactionCount() { return g_i2cCount.load(); }
+
+    void powerUp()
+    {
+        std::lock_guard<std::recursive_mutex> guard(g_lock);
+        loadStations();
+        g_powered = true;
+        // The library rewrites REG02/REG05 with its defaults: forced mono, RDS off, volume 0
+        g_mono = true;
+        g_rds = false;
+        g_volume = 0;
+    }
+
+    void powerDown()
+    {
+        std::lock_guard<std::recursive_mutex> guard(g_lock);
+        g_powered = false;
+    }
+
+    bool isPowered() { return g_powered; }
+
+    void tune(uint16_t freq10k)
+    {
+        std::lock_guard<std::recursive_mutex> guard(g_lock);
+        if (freq10k < BAND_BOTTOM)
+            freq10k = BAND_BOTTOM;
+        if (freq10k > BAND_TOP)
+            freq10k = BAND_TOP;
+        g_freq = (uint16_t)(BAND_BOTTOM + (freq10k - BAND_BOTTOM) / BAND_STEP * BAND_STEP);
+        g_seekFailed = false;
+        g_tunedAtUs = micros();
+        g_rdsNextGroup = 0;
+    }
+
+    uint16_t frequency() { return g_freq; }
+
+    void seek(bool up, bool wrap)
+    {
+        uint16_t freq = g_freq;
+        const int channels = (BAND_TOP - BAND_BOTTOM) / BAND_STEP + 1;
+        for (int i = 0; i < channels; i++)
+        {
+            if (up)
+                freq = (freq >= BAND_TOP) ? (wrap ? BAND_BOTTOM : BAND_TOP) : freq + BAND_STEP;
+            else
+                freq = (freq <= BAND_BOTTOM) ? (wrap ? BAND_TOP : BAND_BOTTOM) : freq - BAND_STEP;
+            delay(TUNE_SETTLE_MS);
+            if (rssiAt(freq) >= g_seekThreshold)
+            {
+                std::lock_guard<std::recursive_mutex> guard(g_lock);
+                g_freq = freq;
+                g_seekFailed = false;
+                g_tunedAtUs = micros() - TUNE_SETTLE_MS * 1000;
+                g_rdsNextGroup = 0;
+                return;
+            }
+        }
+        g_seekFailed = true;
+    }
+
+    void setSeekThreshold(uint8_t value) { g_seekThreshold = value; }
+
+    uint8_t rssiAt(uint16_t freq10k)
+    {
+        std::lock_guard<std::recursive_mutex> guard(g_lock);
+        loadStations();
+        int best = NOISE_FLOOR + (int)(freq10k / BAND_STEP % 3);
+        for (const Station &s : g_stations)
+        {
+            int distance = abs((int)freq10k - (int)s.freq10k) / BAND_STEP;
+            int level = (int)s.peakRssi - 20 * distance;
+            if (level > best)
+                best = level;
+        }
+        return (uint8_t)std::min(best, 63);
+    }
+
+    uint8_t rssi()
+    {
+        if (!g_powered)
+            return 0;
+        uint8_t level = rssiAt(g_freq);
+        uint32_t settled = micros() - g_tunedAtUs;
+        if (settled < TUNE_SETTLE_MS * 1000)
+            level = (uint8_t)(level * settled / (TUNE_SETTLE_MS * 1000));
+        return level;
+    }
+
+    size_t stations(uint16_t *freq10k, uint8_t *peakRssi, size_t max)
+    {
+        std::lock_guard<std::recursive_mutex> guard(g_lock);
+        loadStations();
+        size_t count = 0;
+        for (const Station &s : g_stations)
+        {
+            if (count == max)
+                break;
+            freq10k[count] = s.freq10k;
+            peakRssi[count] = s.peakRssi;
+            count++;
+        }
+        return count;
+    }
+
+    bool isStereo() { return g_powered && !g_mono && rssi() >= STEREO_RSSI; }
+
+    void setMono(bool mono) { g_mono = mono; }
+
+    void setVolume(uint8_t volume) { g_volume = volume > 15 ? 15 : volume; }
+
+    uint8_t volume() { return g_volume; }
+
+    void setMute(bool mute) { g_mute = mute; }
+
+    void setRds(bool enabled) { g_rds = enabled; }
+
+    bool loadRdsCapture(const char *path, std::vector<SimRdsGroup> &groups)
+    {
+        FILE *f = fopen(path, "r");
+        if (!f)
+        {
+            printf("[sim] Cannot open RDS capture %s\n", path);
+            return false;
+        }
+        char line[256];
+        while (fgets(line, sizeof(line), f))
+        {
+            char text[4][8];
+            if (sscanf(line, "%7s %7s %7s %7s", text[0], text[1], text[2], text[3]) != 4)
+                continue;
+            SimRdsGroup group = {};
+            bool valid = true;
+            for (int i = 0; i < 4 && valid; i++)
+            {
+                char *end = nullptr;
+                if (strcmp(text[i], "----") == 0)
+                    group.bler[i] = 3;
+                else if (strlen(text[i]) == 4 && (group.block[i] = (uint16_t)strtoul(text[i], &end, 16), *end == '\0'))
+                    group.bler[i] = 0;
+                else
+                    valid = false;
+            }
+            if (valid)
+                groups.push_back(group);
+        }
+        fclose(f);
+        return !groups.empty();
+    }
+
+    SimRdsGroup rdsGroup(uint16_t freq10k, uint32_t n)
+    {
+        std::lock_guard<std::recursive_mutex> guard(g_lock);
+        loadStations();
+        loadRds();
+        SimRdsGroup group = g_rdsCapture.empty() ? generateRdsGroup(freq10k, n) : g_rdsCapture[n % g_rdsCapture.size()];
+        if (g_rdsBlerPercent > 0)
+            corruptRds(group);
+        return group;
+    }
+
+    void readStatusRegisters(uint16_t regs[6])
+    {
+        std::lock_guard<std::recursive_mutex> guard(g_lock);
+        uint16_t channel = (uint16_t)((g_freq - BAND_BOTTOM) / BAND_STEP);
+        uint8_t level = rssi();
+        // STC: the tune (or seek) has completed
+        bool tuned = g_powered && micros() - g_tunedAtUs >= TUNE_SETTLE_MS * 1000;
+        regs[0] = (uint16_t)((tuned ? (1u << 14) : 0) | (g_seekFailed ? (1u << 13) : 0) |
+                             (isStereo() ? (1u << 10) : 0) | (channel & 0x03FF));
+        regs[1] = (uint16_t)((level & 0x7F) << 9 | (level >= g_seekThreshold ? (1u << 8) : 0) |
+                             (g_powered ? (1u << 7) : 0));
+        regs[2] = regs[3] = regs[4] = regs[5] = 0;
+
+        // RDS: the chip keeps the last complete group; RDSR tells it is new
+        loadRds();
+        uint32_t settled = micros() - g_tunedAtUs;
+        if (!g_rds || !g_powered || stationIndex(g_freq) < 0 || level < RDS_MIN_RSSI || settled < TUNE_SETTLE_MS * 1000)
+            return;
+        uint32_t complete = (settled - TUNE_SETTLE_MS * 1000) / RDS_GROUP_US;
+        regs[0] |= 1u << 12; // RDSS
+        if (complete == 0 || complete <= g_rdsNextGroup)
+            return;
+        g_rdsNextGroup = complete;
+        SimRdsGroup group = rdsGroup(g_freq, complete - 1);
+
+        // Only A and B have error fields; C and D errors show up in BLERB
+        uint8_t blerB = std::max(group.bler[1], std::max(group.bler[2], group.bler[3]));
+        regs[0] |= 1u << 15; // RDSR
+        regs[1] |= (uint16_t)((group.bler[0] << 2) | blerB);
+        for (int i = 0; i < 4; i++)
+            regs[2 + i] = group.block[i];
+    }
+}
+
+// =========================================================
+// PU2CLR RDA5807 library stand-in
+// =========================================================
+// Each call costs the same number of bus transactions as the real
+// library (one register write or one status read).
+
+void RDA5807::setup(uint8_t clock_frequency, uint8_t oscillator_type)
+{
+    (void)clock_frequency;
+    (void)oscillator_type;
+    SimTuner::i2cTransaction();
+    SimTuner::powerUp();
+}
+
+void RDA5807::powerUp()
+{
+    SimTuner::i2cTransaction(); // REG02
+    SimTuner::i2cTransaction(); // REG05
+    SimTuner::powerUp();
+}
+
+void RDA5807::powerDown()
+{
+    SimTuner::i2cTransaction();
+    SimTuner::powerDown();
+}
+
+void RDA5807::softReset()
+{
+    SimTuner::i2cTransaction();
+}
+
+void RDA5807::setBand(uint8_t band)
+{
+    (void)band;
+    SimTuner::i2cTransaction();
+}
+
+void RDA5807::setSpace(uint8_t space)
+{
+    (void)space;
+    SimTuner::i2cTransaction();
+}
+
+void RDA5807::setGpio(uint8_t gpioPin, uint8_t gpioSetup)
+{
+    (void)gpioPin;
+    (void)gpioSetup;
+    SimTuner::i2cTransaction();
+}
+
+void RDA5807::setFrequency(uint16_t frequency)
+{
+    SimTuner::i2cTransaction();
+    SimTuner::tune(frequency);
+}
+
+uint16_t RDA5807::getFrequency()
+{
+    return SimTuner::frequency();
+}
+
+uint16_t RDA5807::getRealFrequency()
+{
+    SimTuner::i2cTransaction();
+    return SimTuner::frequency();
+}
+
+void RDA5807::seek(uint8_t seek_mode, uint8_t direction)
+{
+    SimTuner::i2cTransaction();
+    SimTuner::seek(direction == RDA_SEEK_UP, seek_mode == RDA_SEEK_WRAP);
+    SimTuner::i2cTransaction();
+}
+
+void RDA5807::setSeekThreshold(uint8_t value)
+{
+    SimTuner::i2cTransaction();
+    SimTuner::setSeekThreshold(value);
+}
+
+void RDA5807::setVolume(uint8_t value)
+{
+    SimTuner::i2cTransaction();
+    SimTuner::setVolume(value);
+}
+
+uint8_t RDA5807::getVolume()
+{
+    return SimTuner::volume();
+}
+
+void RDA5807::setMute(bool value)
+{
+    SimTuner::i2cTransaction();
+    SimTuner::setMute(value);
+}
+
+void RDA5807::setMono(bool value)
+{
+    SimTuner::i2cTransaction();
+    SimTuner::setMono(value);
+}
+
+void RDA5807::setRDS(bool value)
+{
+    SimTuner::i2cTransaction();
+    SimTuner::setRds(value);
+}
+
+int RDA5807::getRssi()
+{
+    SimTuner::i2cTransaction();
+    return SimTuner::rssi();
+}
+
+bool RDA5807::isStereo()
+{
+    SimTuner::i2cTransaction();
+    return SimTuner::isStereo();
+}
+
+// =========================================================
+// Wire stand-in
+// =========================================================
+
+TwoWire Wire;
+
+bool TwoWire::begin(int sda, int scl, uint32_t frequency)
+{
+    (void)sda;
+    (void)scl;
+    (void)frequency;
+    return true;
+}
+
+void TwoWire::beginTransmission(uint8_t address)
+{
+    _txAddress = address;
+}
+
+uint8_t TwoWire::endTransmission(bool sendStop)
+{
+    (void)sendStop;
+    SimTuner::i2cTransaction();
+    // 0 = ACK, 2 = address NACK
+    return (_txAddress == 0x10 || _txAddress == 0x11) ? 0 : 2;
+}
+
+uint8_t TwoWire::requestFrom(uint8_t address, uint8_t quantity, bool sendStop)
+{
+    (void)sendStop;
+    SimTuner::i2cTransaction();
+    _rxIndex = 0;
+    _rxLength = 0;
+    if (address != 0x10)
+        return 0;
+
+    uint16_t regs[6];
+    SimTuner::readStatusRegisters(regs);
+    if (quantity > sizeof(_rxBuffer))
+        quantity = sizeof(_rxBuffer);
+    for (uint8_t i = 0; i < quantity; i++)
+    {
+        uint16_t reg = regs[(i / 2) % 6];
+        _rxBuffer[i] = (i % 2 == 0) ? (uint8_t)(reg >> 8) : (uint8_t)(reg & 0xFF);
+    }
+    _rxLength = quantity;
+    return quantity;
+}
+
+size_t TwoWire::write(uint8_t data)
+{
+    (void)data;
+    return 1;
+}
+
+size_t TwoWire::write(const uint8_t *data, size_t quantity)
+{
+    (void)data;
+    return quantity;
+}
+
+int TwoWire::available()
+{
+    return _rxLength - _rxIndex;
+}
+
+int TwoWire::read()
+{
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex++] : -1;
+}
+
+int TwoWire::peek()
+{
+    return _rxIndex < _rxLength ? _rxBuffer[_rxIndex] : -1;
+}
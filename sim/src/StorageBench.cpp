@@ -0,0 +1,147 @@
+#include <Arduino.h>
+#include <SD.h>
+#include <unistd.h>
+#include "RecordLog.h"
+#include "SimRuntime.h"
+
+// =========================================================
+// --bench-storage N: full-file rewrite vs. RecordLog append
+// =========================================================
+// Replays N tune/volume changes on an fm.json-shaped document and persists
+// each one both ways, then cuts the last log record in half to check that a
+// torn write loses only that record. Bytes are exact; latencies are host
+// filesystem times and only meaningful relative to each other.
+
+namespace
+{
+    const char *BENCH_DIR = "/famio/bench";
+    const char *FULL_PATH = "/famio/bench/fm.json";
+    const char *LOG_PATH = "/famio/bench/fm.log";
+
+    struct Series
+    {
+        uint64_t bytes = 0;
+        uint64_t totalUs = 0;
+        uint32_t maxUs = 0;
+
+        void add(size_t written, uint32_t us)
+        {
+            bytes += written;
+            totalUs += us;
+            if (us > maxUs)
+                maxUs = us;
+        }
+    };
+
+    void makeState(JsonDocument &doc, int step)
+    {
+        doc.clear();
+        doc["volume"] = step % 16;
+        doc["current_freq"] = 87.5f + (step % 205) * 0.1f;
+        JsonArray channels = doc["channels"].to<JsonArray>();
+        for (int i = 0; i < 10; i++)
+        {
+            channels.add<JsonObject>()["freq"] = 88.1f + i * 2.0f;
+        }
+    }
+
+    size_t rewriteFile(const JsonDocument &doc)
+    {
+        String content;
+        serializeJson(doc, content);
+        File f = SD.open(FULL_PATH, FILE_WRITE);
+        size_t written = f.write((const uint8_t *)content.c_str(), content.length());
+        f.close();
+        return written;
+    }
+
+    size_t fileSize(const char *path)
+    {
+        File f = SD.open(path);
+        size_t size = f.size();
+        f.close();
+        return size;
+    }
+
+    void printSeries(const char *name, const Series &s, int saves, size_t logicalBytes)
+    {
+        printf("%-14s %10llu %12.2f %10llu %10u\n", name, (unsigned long long)s.bytes,
+               logicalBytes ? (double)s.bytes / logicalBytes : 0.0,
+               (unsigned long long)(saves ? s.totalUs / saves : 0), s.maxUs);
+    }
+}
+
+int runStorageBench(int saves)
+{
+    if (!SD.begin(5))
+    {
+        fprintf(stderr, "[bench] no SD root\n");
+        return 1;
+    }
+    SD.mkdir(BENCH_DIR);
+    SD.remove(FULL_PATH);
+    SD.remove(LOG_PATH);
+
+    RecordLog log;
+    log.begin(LOG_PATH);
+    JsonDocument doc;
+    Series full;
+    Series append;
+    uint64_t logicalBytes = 0;
+
+    for (int i = 0; i < saves; i++)
+    {
+        makeState(doc, i);
+        logicalBytes += measureJson(doc);
+
+        uint32_t start = micros();
+        size_t written = rewriteFile(doc);
+        full.add(written, micros() - start);
+
+        uint64_t before = log.getStats().bytesWritten;
+        start = micros();
+        log.save(doc);
+        append.add((size_t)(log.getStats().bytesWritten - before), micros() - start);
+    }
+
+    const RecordLogStats &stats = log.getStats();
+    printf("saves: %d, logical bytes: %llu, log appends: %u, compactions: %u\n", saves,
+           (unsigned long long)logicalBytes, stats.appends, stats.compactions);
+    printf("%-14s %10s %12s %10s %10s\n", "method", "bytes", "write_amp", "avg_us", "max_us");
+    printSeries("full_rewrite", full, saves, logicalBytes);
+    printSeries("record_log", append, saves, logicalBytes);
+
+    // Torn write: drop half of the last record, as a power cut mid-append would.
+    // The last save must be an append, not a compaction (right after one, it is).
+    int step = saves;
+    size_t size;
+    uint32_t appends;
+    do
+    {
+        size = fileSize(LOG_PATH);
+        appends = log.getStats().appends;
+        makeState(doc, step++);
+        log.save(doc);
+    } while (log.getStats().appends == appends && step < saves + 2);
+    size_t torn = size + (fileSize(LOG_PATH) - size) / 2;
+    std::string host = SimRuntime::sdRoot() + LOG_PATH;
+    if (truncate(host.c_str(), (off_t)torn) != 0)
+    {
+        perror("[bench] truncate");
+        return 1;
+    }
+
+    RecordLog reopened;
+    reopened.begin(LOG_PATH);
+    JsonDocument recovered;
+    JsonDocument expected;
+    makeState(expected, step - 2);
+    String recoveredJson;
+    String expectedJson;
+    bool ok = reopened.load(recovered);
+    serializeJson(recovered, recoveredJson);
+    serializeJson(expected, expectedJson);
+    ok = ok && recoveredJson == expectedJson && reopened.getStats().corruptLoads == 1;
+    printf("torn write recovery: %s (state of save %d restored)\n", ok ? "ok" : "FAILED", step - 2);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,116 @@
+#include <WiFi.h>
+#include <ESPmDNS.h>
+
+WiFiClass WiFi;
+MDNSResponder MDNS;
+
+namespace
+{
+    const int SIM_NETWORK_COUNT = 4;
+    const char *SIM_SSIDS[SIM_NETWORK_COUNT] = {"HomeNet", "HomeNet_5G", "Cafe Guest", "Neighbour"};
+    const int SIM_RSSI[SIM_NETWORK_COUNT] = {-48, -55, -71, -83};
+    const unsigned long SIM_SCAN_MS = 1500;
+
+    unsigned long connectDelayMs()
+    {
+        const char *value = getenv("FAMIO_SIM_WIFI_CONNECT_MS");
+        return (value && *value) ? strtoul(value, nullptr, 10) : 800;
+    }
+}
+
+bool WiFiClass::mode(wifi_mode_t mode)
+{
+    _mode = mode;
+    return true;
+}
+
+wl_status_t WiFiClass::begin(const char *ssid, const char *passphrase)
+{
+    (void)passphrase;
+    _connecting = ssid && *ssid;
+    _connectStart = millis();
+    return status();
+}
+
+wl_status_t WiFiClass::status()
+{
+    if (!_connecting)
+        return WL_DISCONNECTED;
+    return (millis() - _connectStart >= connectDelayMs()) ? WL_CONNECTED : WL_DISCONNECTED;
+}
+
+bool WiFiClass::disconnect(bool wifioff)
+{
+    _connecting = false;
+    if (wifioff)
+        _mode = WIFI_OFF;
+    return true;
+}
+
+IPAddress WiFiClass::localIP()
+{
+    return status() == WL_CONNECTED ? IPAddress(127, 0, 0, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::softAPIP()
+{
+    return IPAddress(192, 168, 4, 1);
+}
+
+bool WiFiClass::softAP(const String &ssid, const String &passphrase)
+{
+    (void)passphrase;
+    return ssid.length() > 0;
+}
+
+int8_t WiFiClass::RSSI()
+{
+    return status() == WL_CONNECTED ? -52 : 0;
+}
+
+int16_t WiFiClass::scanNetworks(bool async, bool show_hidden)
+{
+    (void)show_hidden;
+    _scanStart = millis();
+    _scanState = WIFI_SCAN_RUNNING;
+    if (!async)
+    {
+        delay(SIM_SCAN_MS);
+        _scanState = SIM_NETWORK_COUNT;
+    }
+    return _scanState;
+}
+
+int16_t WiFiClass::scanComplete()
+{
+    if (_scanState == WIFI_SCAN_RUNNING && millis() - _scanStart >= SIM_SCAN_MS)
+        _scanState = SIM_NETWORK_COUNT;
+    return _scanState;
+}
+
+void WiFiClass::scanDelete()
+{
+    _scanState = WIFI_SCAN_FAILED;
+}
+
+String WiFiClass::SSID(uint8_t i)
+{
+    return i < SIM_NETWORK_COUNT ? String(SIM_SSIDS[i]) : String();
+}
+
+String WiFiClass::BSSIDstr(uint8_t i)
+{
+    char buf[18];
+    snprintf(buf, sizeof(buf), "02:00:00:00:00:%02X", i);
+    return String(buf);
+}
+
+int32_t WiFiClass::RSSI(uint8_t i)
+{
+    return i < SIM_NETWORK_COUNT ? SIM_RSSI[i] : 0;
+}
+
+int32_t WiFiClass::channel(uint8_t i)
+{
+    return 1 + (i * 5) % 13;
+}
@@ -0,0 +1,41 @@
+#include <Arduino.h>
+#include "SimRuntime.h"
+
+// =========================================================
+// Host entry point: the Arduino core's app_main/loopTask
+// =========================================================
+
+void setup();
+void loop();
+int runStorageBench(int saves);
+int runRouteBench(int rounds);
+int runAutostoreBench(int rounds);
+int runRdsBench(int groups);
+
+int main(int argc, char **argv)
+{
+    setvbuf(stdout, nullptr, _IOLBF, 0);
+    SimRuntime::init(argc, argv);
+    if (SimRuntime::benchStorageSaves() > 0)
+    {
+        return runStorageBench(SimRuntime::benchStorageSaves());
+    }
+    if (SimRuntime::benchRouteRounds() > 0)
+    {
+        return runRouteBench(SimRuntime::benchRouteRounds());
+    }
+    if (SimRuntime::benchAutostoreRounds() > 0)
+    {
+        return runAutostoreBench(SimRuntime::benchAutostoreRounds());
+    }
+    if (SimRuntime::benchRdsGroups() > 0)
+    {
+        return runRdsBench(SimRuntime::benchRdsGroups());
+    }
+
+    setup();
+    for (;;)
+    {
+        loop();
+    }
+}
@@ -2,10 +2,17 @@
 #include <ArduinoJson.h>
 #include <ConnectivityManager.h>
 #include <BluetoothManager.h>
+#include <esp_timer.h>
+#include <memory>
+
+// Giới hạn kích thước body JSON của các API POST (lớn hơn thì trả 413, không cấp phát)
+#define BODY_LIMIT_CONTROL 128 // {"power":true}, {"value":64}, {"cmd":"next"}, {"pin":"123456"}
+#define BODY_LIMIT_WIFI 256    // {"ssid":"...","pass":"..."}: 32 + 64 ký tự và phần escape
+#define BODY_NESTING_LIMIT 2
 
 // Constructor: Khởi tạo Web Server ở cổng 80 và lưu trữ con trỏ
-AppWebServer::AppWebServer(FMRadio *radio, PowerManager *power, FileManager *fileMgr, BluetoothManager *bluetooth, ConnectivityManager *connectivity)
-    : server(80), fmRadio(radio), btManager(bluetooth), powerManager(power), fileManager(fileMgr), connectivity(connectivity)
+AppWebServer::AppWebServer(FMRadio *radio, PowerManager *power, FileManager *fileMgr, BluetoothManager *bluetooth, ConnectivityManager *connectivity, SettingsStore *settingsStore, TaskManager *tasks, StatusBroadcaster *broadcaster, BandScanner *scanner, StationSeeker *seeker, SourceManager *sources, BootProfiler *boot)
+    : server(80), apiHandler(this), assetCache(fileMgr), fmRadio(radio), btManager(bluetooth), powerManager(power), fileManager(fileMgr), connectivity(connectivity), settings(settingsStore), taskManager(tasks), statusBroadcaster(broadcaster), bandScanner(scanner), stationSeeker(seeker), sourceManager(sources), bootProfiler(boot)
 {
 
     // Kiểm tra tính hợp lệ của con trỏ (tùy chọn)
@@ -21,8 +28,17 @@ AppWebServer::AppWebServer(FMRadio *radio, PowerManager *power, FileManager *fil
 
 bool AppWebServer::begin()
 {
+    // CORS: thêm vào mọi response (thay cho sendCORSHeaders() ở từng handler)
+    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Origin", "*");
+    DefaultHeaders::Instance().addHeader("Access-Control-Allow-Credentials", "false");
+
+    // Buffer cho response JSON (cấp một lần, không cấp phát theo request)
+    responses.begin();
+
     // Đăng ký tất cả các API endpoints
     registerAPIs();
+    // GET /api/events: trạng thái FM/BT được đẩy khi thay đổi (thay cho polling)
+    statusBroadcaster->begin(server);
 
     // Bắt đầu Web Server
     server.begin();
@@ -30,103 +46,248 @@ bool AppWebServer::begin()
 }
 
 // =========================================================
-// Hàm Đăng ký API (Sử dụng std::bind)
+// Bảng route
 // =========================================================
+// Sắp xếp theo path (so từng byte) rồi theo method; static_assert bên dưới
+// báo lỗi biên dịch nếu thêm route sai chỗ. Nhớ cập nhật API_ROUTE_COUNT.
+
+constexpr AppWebServer::Route AppWebServer::ROUTES[API_ROUTE_COUNT] = {
+    // 1. Root ("/") - Trang chính
+    {"/", HTTP_GET, &AppWebServer::handleRoot, 0},
+
+    // API bluetooth
+    {"/api/bt/confirm", HTTP_POST, &AppWebServer::handleBTConfirmPin, BODY_LIMIT_CONTROL},
+    {"/api/bt/control", HTTP_POST, &AppWebServer::handleBTControl, BODY_LIMIT_CONTROL},
+    {"/api/bt/power", HTTP_POST, &AppWebServer::handleBTPower, BODY_LIMIT_CONTROL},
+    {"/api/bt/status", HTTP_GET, &AppWebServer::handleBTStatus, 0},
+    {"/api/bt/volume", HTTP_POST, &AppWebServer::handleBTVolume, BODY_LIMIT_CONTROL},
+
+    // API FM
+    {"/api/fm/autostore", HTTP_POST, &AppWebServer::handleFmAutostore, 0},
+    {"/api/fm/channels", HTTP_GET, &AppWebServer::handleFmLoadChannels, 0},
+    {"/api/fm/delete", HTTP_DELETE, &AppWebServer::handleFmDeleteChannel, 0},
+    {"/api/fm/history", HTTP_GET, &AppWebServer::handleFmHistory, 0},
+    {"/api/fm/power", HTTP_POST, &AppWebServer::handleFmPower, 0},
+    {"/api/fm/rds", HTTP_GET, &AppWebServer::handleFmRds, 0},
+    {"/api/fm/save", HTTP_POST, &AppWebServer::handleFmSaveChannel, 0},
+    {"/api/fm/scan", HTTP_GET, &AppWebServer::handleFmScanResult, 0},
+    {"/api/fm/scan", HTTP_POST, &AppWebServer::handleFmScanStart, 0},
+    {"/api/fm/scan", HTTP_DELETE, &AppWebServer::handleFmScanCancel, 0},
+    {"/api/fm/seek", HTTP_GET, &AppWebServer::handleFmSeek, 0},
+    {"/api/fm/seek", HTTP_POST, &AppWebServer::handleFmSeekStart, 0},
+    {"/api/fm/seek", HTTP_DELETE, &AppWebServer::handleFmSeekCancel, 0},
+    {"/api/fm/select", HTTP_GET, &AppWebServer::handleFmSelectChannel, 0},
+    {"/api/fm/setfreq", HTTP_POST, &AppWebServer::handleFmSetFreq, 0},
+    {"/api/fm/station", HTTP_POST, &AppWebServer::handleFmEditStation, 0},
+    {"/api/fm/status", HTTP_GET, &AppWebServer::handleFmStatus, 0},
+    {"/api/fm/volume", HTTP_POST, &AppWebServer::handleFmVolume, 0},
+
+    // Metric dạng Prometheus
+    {"/api/metrics", HTTP_GET, &AppWebServer::handleMetrics, 0},
+
+    // API Hệ thống
+    {"/api/system/boot", HTTP_GET, &AppWebServer::handleSystemBoot, 0},
+    {"/api/system/reset", HTTP_POST, &AppWebServer::handleSystemReset, 0},
+    {"/api/system/routes", HTTP_GET, &AppWebServer::handleRoutes, 0},
+    {"/api/system/source", HTTP_GET, &AppWebServer::handleSystemSource, 0},
+    {"/api/system/storage", HTTP_GET, &AppWebServer::handleSystemStorage, 0},
+    {"/api/system/tasks", HTTP_GET, &AppWebServer::handleSystemTasks, 0},
+    {"/api/system/trace", HTTP_GET, &AppWebServer::handleSystemTrace, 0},
+
+    // API Cấu hình Wi-Fi
+    {"/api/wifi/config", HTTP_GET, &AppWebServer::handleGetWifiConfig, 0},
+    {"/api/wifi/config", HTTP_POST, &AppWebServer::handleSubmitWifiConfig, BODY_LIMIT_WIFI},
+    {"/api/wifi/reset", HTTP_POST, &AppWebServer::handleResetWifiConfig, 0},
+    {"/api/wifi/scan", HTTP_GET, &AppWebServer::handleScanNetworks, 0},
+    {"/api/wifi/status", HTTP_GET, &AppWebServer::handleGetWifiStatus, 0},
+};
 
 void AppWebServer::registerAPIs()
 {
+    static_assert(RouteTable::isSorted(ROUTES), "ROUTES phải sắp xếp theo path rồi method");
 
-    // API Lấy trạng thái FM
-    server.on("/api/fm/status", HTTP_GET, std::bind(&AppWebServer::handleFmStatus, this));
-    server.on("/api/fm/power", HTTP_POST, std::bind(&AppWebServer::handleFmPower, this));
-    server.on("/api/fm/setfreq", HTTP_POST, std::bind(&AppWebServer::handleFmSetFreq, this));
-    server.on("/api/fm/seek", HTTP_GET, std::bind(&AppWebServer::handleFmSeek, this));
-    server.on("/api/fm/volume", HTTP_POST, std::bind(&AppWebServer::handleFmVolume, this));
-    server.on("/api/fm/save", HTTP_POST, std::bind(&AppWebServer::handleFmSaveChannel, this));
-    server.on("/api/fm/select", HTTP_GET, std::bind(&AppWebServer::handleFmSelectChannel, this));
-    server.on("/api/fm/channels", HTTP_GET, std::bind(&AppWebServer::handleFmLoadChannels, this));
-    server.on("/api/fm/delete", HTTP_DELETE, std::bind(&AppWebServer::handleFmDeleteChannel, this));
+    // Mọi route trong bảng đi qua một handler
+    server.addHandler(&apiHandler);
 
-    // API Cấu hình Wi-Fi
-    server.on("/api/wifi/status", HTTP_GET, std::bind(&AppWebServer::handleGetWifiStatus, this));
-    server.on("/api/wifi/scan", HTTP_GET, std::bind(&AppWebServer::handleScanNetworks, this));
-    server.on("/api/wifi/config", HTTP_POST, std::bind(&AppWebServer::handleSubmitWifiConfig, this));
-    server.on("/api/wifi/reset", HTTP_POST, std::bind(&AppWebServer::handleResetWifiConfig, this));
+    // Global handler: OPTIONS của path lạ và các request không khớp (file UI)
+    server.onNotFound([this](AsyncWebServerRequest *request)
+                      { handleNotFound(request); });
+}
 
-    // API Hệ thống
-    server.on("/api/system/reset", HTTP_POST, std::bind(&AppWebServer::handleSystemReset, this));
+// =========================================================
+// Dispatch
+// =========================================================
 
-    // API bluetooth
-    server.on("/api/bt/status", HTTP_GET, std::bind(&AppWebServer::handleBTStatus, this));
-    server.on("/api/bt/power", HTTP_POST, std::bind(&AppWebServer::handleBTPower, this));
-    server.on("/api/bt/volume", HTTP_POST, std::bind(&AppWebServer::handleBTVolume, this));
-    server.on("/api/bt/control", HTTP_POST, std::bind(&AppWebServer::handleBTControl, this));
-    server.on("/api/bt/confirm", HTTP_POST, std::bind(&AppWebServer::handleBTConfirmPin, this));
+bool AppWebServer::ApiHandler::canHandle(AsyncWebServerRequest *request) const
+{
+    // Nhận cả method sai để trả 405 (kèm Allow) thay vì rơi xuống tìm file UI
+    return RouteTable::findPath(ROUTES, API_ROUTE_COUNT, request->url().c_str()) >= 0;
+}
 
-    // 1. Root ("/") - Trang chính
-    server.on("/", HTTP_GET, std::bind(&AppWebServer::handleRoot, this));
-    // AppWebServer::handleStaticFile();
-
-    // Global handler: tất cả các OPTIONS (preflight) và các request không khớp
-    server.onNotFound([this]()
-                      {
-        // Trả lời preflight (OPTIONS) hoặc phục vụ file tĩnh từ SD
-        if (server.method() == HTTP_OPTIONS) {
-            sendCORSHeaders();
-            server.sendHeader("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-            server.sendHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
-            server.send(204, "text/plain", "");
-            return;
+void AppWebServer::ApiHandler::handleRequest(AsyncWebServerRequest *request)
+{
+    WebRequestMethodComposite allowed;
+    int index = RouteTable::find(ROUTES, API_ROUTE_COUNT, request->url().c_str(), request->method(), allowed);
+    if (index >= 0 && ROUTES[index].maxBody && request->contentLength() > ROUTES[index].maxBody)
+    {
+        // Body đã bị bỏ qua từng đoạn trong handleBody, không có gì để giải phóng
+        owner->bodiesRejected++;
+        owner->responses.sendStatic(request, 413, "{\"status\":\"error\", \"message\":\"Body too large\"}");
+        return;
+    }
+    if (index >= 0)
+    {
+        TRACE_SCOPE(TRACE_HTTP, ROUTES[index].path);
+        uint32_t start = micros();
+        owner->routeHits[index]++;
+        owner->responses.beginRequest();
+        {
+            // JsonDocument của handler nằm trong arena PSRAM, trả lại hết khi handler xong
+            JsonArena::Scope scope;
+            (owner->*ROUTES[index].handler)(request);
         }
+        owner->routeLatency[index].observe(micros() - start);
+        uint32_t allocs = owner->responses.endRequest();
+        if (allocs > owner->routeMaxAllocs[index])
+            owner->routeMaxAllocs[index] = allocs;
+        return;
+    }
 
-        // Nếu không phải OPTIONS, thử phục vụ file từ /ui
-        String path = server.uri();
-        if (path == "/") path = "/index.html";
-        String fsPath = String(UI_PATH) + path;
-        File f = fileManager->openFile(fsPath.c_str());
-        if (f) {
-            sendCORSHeaders();
-            const char* contentType = getContentType(path);
-            server.streamFile(f, contentType);
-            f.close();
-            return;
-        }
+    char methods[48];
+    RouteTable::methodList(allowed, methods, sizeof(methods));
+    AsyncWebServerResponse *response;
+    if (request->method() == HTTP_OPTIONS)
+    {
+        // Preflight: chỉ liệt kê các method thật sự có cho path này
+        owner->preflights++;
+        response = request->beginResponse(204, "text/plain", "");
+        response->addHeader("Access-Control-Allow-Methods", methods);
+        response->addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
+    }
+    else
+    {
+        owner->methodNotAllowed++;
+        static const char body[] = "{\"status\":\"error\", \"message\":\"Method not allowed\"}";
+        response = request->beginResponse(405, "application/json", (const uint8_t *)body, sizeof(body) - 1);
+        response->addHeader("Allow", methods);
+    }
+    request->send(response);
+}
 
-        // Không tìm thấy
-        sendCORSHeaders();
-        server.send(404, "text/plain", "Not Found"); });
+void AppWebServer::ApiHandler::handleBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
+{
+    WebRequestMethodComposite allowed;
+    int route = RouteTable::find(ROUTES, API_ROUTE_COUNT, request->url().c_str(), request->method(), allowed);
+    if (route >= 0 && total <= ROUTES[route].maxBody)
+    {
+        owner->collectBody(request, data, len, index, total);
+    }
 }
 
 // =========================================================
-// Xử lý Request Cụ thể
+// Body của request POST
 // =========================================================
 
-void AppWebServer::handleRoot()
+// AsyncWebServer giao body theo từng đoạn; gom lại thành chuỗi kết thúc bằng '\0'.
+// Kích thước đã được kiểm tra theo bảng route trước khi tới đây. Buffer nằm trong
+// PSRAM để body không chen vào heap nội; thư viện tự free() _tempObject khi request kết thúc.
+void AppWebServer::collectBody(AsyncWebServerRequest *request, uint8_t *data, size_t len, size_t index, size_t total)
 {
-    // Phục vụ file index.html từ thẻ SD
-    File file = fileManager->openFile(UI_PATH "/index.html");
-    if (file)
+    if (index == 0)
     {
-        sendCORSHeaders();
-        server.streamFile(file, "text/html");
-        file.close();
+        request->_tempObject = ps_malloc(total + 1);
+        if (request->_tempObject == nullptr)
+            request->_tempObject = malloc(total + 1);
+        if (total > largestBody)
+            largestBody = total;
     }
-    else
+    if (request->_tempObject == nullptr)
+    {
+        return;
+    }
+    memcpy((uint8_t *)request->_tempObject + index, data, len);
+    if (index + len == total)
+    {
+        ((char *)request->_tempObject)[total] = '\0';
+    }
+}
+
+const char *AppWebServer::getBody(AsyncWebServerRequest *request)
+{
+    return (const char *)request->_tempObject;
+}
+
+// Parse body vào doc, chỉ giữ các khóa có trong filter (ví dụ "{\"power\":true}"):
+// khóa lạ bị bỏ qua ngay khi đọc, không chiếm bộ nhớ của document
+bool AppWebServer::parseBody(AsyncWebServerRequest *request, JsonDocument &doc, const char *filter)
+{
+    const char *body = getBody(request);
+    if (body == nullptr)
+    {
+        return false;
+    }
+    JsonDocument keep(responses.allocator());
+    deserializeJson(keep, filter);
+    DeserializationError error = deserializeJson(doc, body, DeserializationOption::Filter(keep),
+                                                 DeserializationOption::NestingLimit(BODY_NESTING_LIMIT));
+    return !error && doc.is<JsonObject>();
+}
+
+// =========================================================
+// Lệnh phần cứng (chạy trong task control)
+// =========================================================
+
+bool AppWebServer::postCommand(AsyncWebServerRequest *request, ControlCommand cmd, int32_t value, uint32_t waitMs)
+{
+    if (taskManager->post(cmd, value, waitMs))
     {
-        sendCORSHeaders();
-        server.send(404, "text/plain", "File /index.html not found on SD Card!");
+        return true;
     }
+    responses.sendStatic(request, 503, "{\"status\":\"error\", \"message\":\"Thiết bị đang bận, thử lại sau\"}");
+    return false;
 }
 
-void AppWebServer::handleStaticFile()
+// =========================================================
+// Xử lý Request Cụ thể
+// =========================================================
+
+void AppWebServer::handleRoot(AsyncWebServerRequest *request)
 {
-    server.serveStatic("/", SD, PROJECT_ROOT_DIR "/ui/");
+    // Phục vụ file index.html (từ PSRAM sau lần đọc SD đầu tiên)
+    if (!assetCache.serve(request, "/index.html", "text/html"))
+    {
+        responses.sendStatic(request, 404, "File /index.html not found on SD Card!", "text/plain");
+    }
+}
+
+void AppWebServer::handleNotFound(AsyncWebServerRequest *request)
+{
+    // Trả lời preflight (OPTIONS) hoặc phục vụ file tĩnh từ SD
+    if (request->method() == HTTP_OPTIONS)
+    {
+        AsyncWebServerResponse *response = request->beginResponse(204, "text/plain", "");
+        response->addHeader("Access-Control-Allow-Methods", "GET, POST, DELETE, OPTIONS");
+        response->addHeader("Access-Control-Allow-Headers", "Content-Type, Authorization");
+        request->send(response);
+        return;
+    }
+
+    // Nếu không phải OPTIONS, thử phục vụ file từ /ui ("/" đã nằm trong bảng route)
+    TRACE_SCOPE(TRACE_HTTP, "static");
+    const String &path = request->url();
+    if (assetCache.serve(request, path, getContentType(path)))
+    {
+        return;
+    }
+
+    // Không tìm thấy
+    responses.sendStatic(request, 404, "Not Found", "text/plain");
 }
 
-void AppWebServer::handleFmStatus()
+void AppWebServer::handleFmStatus(AsyncWebServerRequest *request)
 {
     // Cấp phát bộ nhớ cho phản hồi JSON
-    JsonDocument statusDoc;
+    JsonDocument statusDoc(responses.allocator());
 
     // GỌI HÀM CỦA FMRADIO ĐỂ LẤY TRẠNG THÁI THẬT
     if (fmRadio)
@@ -143,41 +304,70 @@ void AppWebServer::handleFmStatus()
         statusDoc["rssi"] = 68;
     }
 
-    String response;
-    serializeJson(statusDoc, response);
-
-    sendCORSHeaders();
-    server.send(200, "application/json", response);
+    responses.sendJson(request, 200, statusDoc);
 }
 
-// =========================================================
-// Hàm xử lý chính (BẮT BUỘC TRONG LOOP)
-// =========================================================
+// Snapshot do task control giải mã, không đọc I2C
+void AppWebServer::handleFmRds(AsyncWebServerRequest *request)
+{
+    JsonDocument doc(responses.allocator());
+    fmRadio->getRds(&doc);
+    responses.sendJson(request, 200, doc);
+}
 
-void AppWebServer::handleClient()
+// level=0: điểm 1 giây (10 phút), level=1: điểm 1 phút (24 giờ); points = số
+// điểm mới nhất (mặc định: tất cả); format=bin trả dạng nhị phân (SignalHistory.h).
+// Ghi thẳng vào buffer của pool, không qua JsonDocument
+void AppWebServer::handleFmHistory(AsyncWebServerRequest *request)
 {
-    // Hàm này phải được gọi liên tục trong main loop() để Web Server hoạt động
-    server.handleClient();
+    long level = request->hasArg("level") ? request->arg("level").toInt() : 0;
+    long points = request->hasArg("points") ? request->arg("points").toInt() : 0;
+    if (level < 0 || level >= HISTORY_LEVELS || points < 0)
+    {
+        responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Tham số level (0/1) hoặc points không hợp lệ\"}");
+        return;
+    }
+    if (points > HISTORY_MINUTES)
+        points = HISTORY_MINUTES;
+    bool binary = request->hasArg("format") && request->arg("format") == "bin";
+
+    int slot;
+    uint8_t *buf = responses.acquireBuffer(slot);
+    if (buf == nullptr)
+    {
+        responses.sendStatic(request, 503, "{\"status\":\"error\", \"message\":\"Thiết bị đang bận, thử lại sau\"}");
+        return;
+    }
+
+    SignalHistory *history = fmRadio->getHistory();
+    if (binary)
+    {
+        size_t len = history->writeBinary(level, points, buf, RESPONSE_BUFFER_SIZE);
+        responses.sendBuffer(request, 200, slot, len, "application/octet-stream");
+        return;
+    }
+    size_t len = history->writeJson(level, points, (char *)buf, RESPONSE_BUFFER_SIZE);
+    responses.sendBuffer(request, 200, slot, len);
 }
 
 // --- XỬ LÝ API WIFI ---
 
-void AppWebServer::handleGetWifiStatus()
+void AppWebServer::handleGetWifiStatus(AsyncWebServerRequest *request)
 {
-    JsonDocument doc;
+    JsonDocument doc(responses.allocator());
     doc["isOperational"] = connectivity->isOperational();
-    doc["ip"] = connectivity->isOperational() ? WiFi.localIP().toString() : WiFi.softAPIP().toString();
+    IPAddress ip = connectivity->isOperational() ? WiFi.localIP() : WiFi.softAPIP();
+    char ipText[16];
+    snprintf(ipText, sizeof(ipText), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+    doc["ip"] = ipText;
 
-    String jsonResponse;
-    serializeJson(doc, jsonResponse);
-    sendCORSHeaders();
-    server.send(200, "application/json", jsonResponse);
+    responses.sendJson(request, 200, doc);
 }
 
-void AppWebServer::handleScanNetworks()
+void AppWebServer::handleScanNetworks(AsyncWebServerRequest *request)
 {
     int state = connectivity->startScanNetworks();
-    JsonDocument doc; // Kích thước lớn hơn để chứa danh sách mạng
+    JsonDocument doc(responses.allocator()); // Kích thước lớn hơn để chứa danh sách mạng
 
     if (state == -1)
     {
@@ -201,77 +391,214 @@ void AppWebServer::handleScanNetworks()
         JsonArray networks = doc["networks"].to<JsonArray>();
         connectivity->getScanResults(networks);
     }
-    String jsonResponse;
-    serializeJson(doc, jsonResponse);
-    sendCORSHeaders();
-    server.send(200, "application/json", jsonResponse);
+    responses.sendJson(request, 200, doc);
 }
 
-void AppWebServer::handleSubmitWifiConfig()
+void AppWebServer::handleSubmitWifiConfig(AsyncWebServerRequest *request)
 {
     // Giả định dữ liệu gửi lên là JSON: {"ssid": "...", "pass": "..."}
-    if (server.method() != HTTP_POST || !server.hasArg("plain"))
+    if (getBody(request) == nullptr)
     {
-        server.send(400, "text/plain", "Bad Request");
+        responses.sendStatic(request, 400, "Bad Request", "text/plain");
         return;
     }
 
-    JsonDocument doc;
-    DeserializationError error = deserializeJson(doc, server.arg("plain"));
-    if (error)
+    JsonDocument doc(responses.allocator());
+    if (!parseBody(request, doc, "{\"ssid\":true,\"pass\":true}"))
     {
-        server.send(400, "text/plain", "Invalid JSON");
+        responses.sendStatic(request, 400, "Invalid JSON", "text/plain");
         return;
     }
 
     String ssid = doc["ssid"].as<String>();
     String pass = doc["pass"].as<String>();
 
-    if (connectivity->checkAndSaveCredentials(ssid, pass))
+    // Việc kết nối thử có thể mất tới CONNECTION_TIMEOUT_S giây: không được chặn task async_tcp.
+    // ConnectivityManager chạy kiểm tra trong loop(), UI hỏi kết quả qua GET /api/wifi/config.
+    if (connectivity->startCredentialCheck(ssid, pass))
     {
-        // Kết nối thành công, đã lưu config. Phản hồi và reset.
-        Serial.printf("Connect sussessfully to Wifi ssid: %s", ssid.c_str());
-        sendCORSHeaders();
-        server.send(200, "application/json", "{\"status\":\"success\", \"message\":\"Config saved. Restarting device to continue.\"}");
-        // Thực hiện reset
+        responses.sendStatic(request, 202, "{\"status\":\"pending\", \"message\":\"Checking credentials. Poll GET /api/wifi/config for the result.\"}");
     }
     else
     {
-        // Kết nối thất bại/timeout
-        sendCORSHeaders();
-        server.send(400, "application/json", "{\"status\":\"failed\", \"message\":\"Connection failed or timeout after 30s. Check credentials.\"}");
+        responses.sendStatic(request, 409, "{\"status\":\"failed\", \"message\":\"A check is already running or the device is not in provisioning mode.\"}");
     }
 }
 
-void AppWebServer::handleResetWifiConfig()
+void AppWebServer::handleGetWifiConfig(AsyncWebServerRequest *request)
+{
+    switch (connectivity->getCredentialCheckState())
+    {
+    case ConnectivityManager::CHECK_PENDING:
+        responses.sendStatic(request, 200, "{\"status\":\"pending\"}");
+        break;
+    case ConnectivityManager::CHECK_SUCCESS:
+        responses.sendStatic(request, 200, "{\"status\":\"success\", \"message\":\"Config saved. Restarting device to continue.\"}");
+        break;
+    case ConnectivityManager::CHECK_FAILED:
+        responses.sendStatic(request, 200, "{\"status\":\"failed\", \"message\":\"Connection failed or timeout after 30s. Check credentials.\"}");
+        break;
+    default:
+        responses.sendStatic(request, 200, "{\"status\":\"idle\"}");
+        break;
+    }
+}
+
+void AppWebServer::handleResetWifiConfig(AsyncWebServerRequest *request)
 {
     // API đưa về Provisioning Mode
-    sendCORSHeaders();
-    server.send(200, "application/json", "{\"status\":\"success\", \"message\":\"Resetting to Provisioning Mode. Device will restart.\"}");
-    delay(500);
-    connectivity->resetToProvisioning(); // Thực hiện reset
+    // Reset sau khi response đã gửi xong và kết nối đóng (thay cho delay(500))
+    request->onDisconnect([this]()
+                          { connectivity->resetToProvisioning(); });
+    responses.sendStatic(request, 200, "{\"status\":\"success\", \"message\":\"Resetting to Provisioning Mode. Device will restart.\"}");
 }
 
-void AppWebServer::handleSystemReset()
+void AppWebServer::handleSystemReset(AsyncWebServerRequest *request)
 {
     // API kích hoạt reset thiết bị thủ công
-    sendCORSHeaders();
-    server.send(200, "application/json", "{\"status\":\"success\", \"message\":\"Device is restarting...\"}");
-    delay(500);
-    connectivity->manualReset(); // Thực hiện reset
+    request->onDisconnect([this]()
+                          { connectivity->manualReset(); });
+    responses.sendStatic(request, 200, "{\"status\":\"success\", \"message\":\"Device is restarting...\"}");
 }
 
-// ---------------------------------------------------------
-// CORS và MIME helpers
-// ---------------------------------------------------------
-void AppWebServer::sendCORSHeaders()
+void AppWebServer::handleSystemTasks(AsyncWebServerRequest *request)
+{
+    // %CPU tính trong cửa sổ từ lần gọi trước
+    JsonDocument doc(responses.allocator());
+    taskManager->getTaskReport(doc);
+    JsonDocument arena(responses.allocator());
+    JsonArena::instance().getStats(arena);
+    doc["json_arena"] = arena;
+
+    responses.sendJson(request, 200, doc);
+}
+
+// Text exposition format của Prometheus: ghi vào buffer PSRAM rồi gửi từng đoạn
+void AppWebServer::handleMetrics(AsyncWebServerRequest *request)
+{
+    std::shared_ptr<MetricsWriter> out = std::make_shared<MetricsWriter>(METRICS_BUFFER_SIZE);
+    if (!out->ok())
+    {
+        responses.sendStatic(request, 503, "Out of memory\n", "text/plain");
+        return;
+    }
+
+    out->family("famio_uptime_seconds", "gauge", "Time since boot.");
+    out->sample("famio_uptime_seconds", nullptr, esp_timer_get_time() / 1e6);
+
+    // Thời gian handler theo route (chỉ route đã được gọi)
+    out->family("famio_http_request_duration_seconds", "histogram", "Time spent in the API handler, by route.");
+    for (size_t i = 0; i < API_ROUTE_COUNT; i++)
+    {
+        if (routeHits[i] == 0)
+            continue;
+        char method[16];
+        RouteTable::methodList(ROUTES[i].method, method, sizeof(method), false);
+        char labels[96];
+        snprintf(labels, sizeof(labels), "route=\"%s\",method=\"%s\"", ROUTES[i].path, method);
+        out->histogram("famio_http_request_duration_seconds", labels, routeLatency[i]);
+    }
+
+    fileManager->writeMetrics(*out);
+    fmRadio->writeMetrics(*out);
+    btManager->writeMetrics(*out);
+
+    // Bộ nhớ: RAM nội (stack BT/Wi-Fi) và PSRAM
+    out->family("famio_memory_free_bytes", "gauge", "Free heap.");
+    out->sample("famio_memory_free_bytes", "region=\"internal\"", ESP.getFreeHeap());
+    out->sample("famio_memory_free_bytes", "region=\"psram\"", ESP.getFreePsram());
+    out->family("famio_memory_min_free_bytes", "gauge", "Lowest free heap since boot.");
+    out->sample("famio_memory_min_free_bytes", "region=\"internal\"", ESP.getMinFreeHeap());
+    out->sample("famio_memory_min_free_bytes", "region=\"psram\"", ESP.getMinFreePsram());
+    out->family("famio_memory_largest_free_block_bytes", "gauge", "Largest block that can be allocated.");
+    out->sample("famio_memory_largest_free_block_bytes", "region=\"internal\"", ESP.getMaxAllocHeap());
+    out->sample("famio_memory_largest_free_block_bytes", "region=\"psram\"", ESP.getMaxAllocPsram());
+
+    if (WiFi.status() == WL_CONNECTED)
+    {
+        out->family("famio_wifi_rssi_dbm", "gauge", "RSSI of the station link.");
+        out->sample("famio_wifi_rssi_dbm", nullptr, WiFi.RSSI());
+    }
+    if (out->isTruncated())
+        Serial.println("AppWebServer: /api/metrics vượt METRICS_BUFFER_SIZE, bỏ các metric cuối.");
+
+    AsyncWebServerResponse *response = request->beginChunkedResponse("text/plain; version=0.0.4", [out](uint8_t *buffer, size_t maxLen, size_t /*index*/) -> size_t
+                                                                     { return out->fill(buffer, maxLen); });
+    request->send(response);
+}
+
+void AppWebServer::handleSystemBoot(AsyncWebServerRequest *request)
 {
-    // Cho phép tất cả origin
-    server.sendHeader("Access-Control-Allow-Origin", "*");
-    // Không cho phép cookie mặc định
-    server.sendHeader("Access-Control-Allow-Credentials", "false");
+    JsonDocument doc(responses.allocator());
+    bootProfiler->getReport(doc);
+    responses.sendJson(request, 200, doc);
 }
 
+// Ring trace dạng Chrome JSON, gửi từng đoạn (có thể vài trăm KB)
+void AppWebServer::handleSystemTrace(AsyncWebServerRequest *request)
+{
+    std::shared_ptr<Trace::Export> trace = std::make_shared<Trace::Export>();
+    if (!trace->ok())
+    {
+        responses.sendStatic(request, 503, "{\"status\":\"error\", \"message\":\"Trace không bật hoặc thiếu bộ nhớ\"}");
+        return;
+    }
+    AsyncWebServerResponse *response = request->beginChunkedResponse("application/json", [trace](uint8_t *buffer, size_t maxLen, size_t /*index*/) -> size_t
+                                                                     { return trace->fill(buffer, maxLen); });
+    response->addHeader("Content-Disposition", "attachment; filename=\"famio-trace.json\"");
+    request->send(response);
+}
+
+void AppWebServer::handleSystemSource(AsyncWebServerRequest *request)
+{
+    JsonDocument doc(responses.allocator());
+    sourceManager->getStatus(doc);
+    responses.sendJson(request, 200, doc);
+}
+
+void AppWebServer::handleSystemStorage(AsyncWebServerRequest *request)
+{
+    JsonDocument doc(responses.allocator());
+    fileManager->getStats(doc);
+    JsonDocument nvs(responses.allocator());
+    settings->getStats(nvs);
+    doc["nvs"] = nvs;
+    JsonDocument assets(responses.allocator());
+    assetCache.getStats(assets);
+    doc["assets"] = assets;
+
+    responses.sendJson(request, 200, doc);
+}
+
+void AppWebServer::handleRoutes(AsyncWebServerRequest *request)
+{
+    JsonDocument doc(responses.allocator());
+    JsonArray routes = doc["routes"].to<JsonArray>();
+    char methods[48];
+    for (size_t i = 0; i < API_ROUTE_COUNT; i++)
+    {
+        JsonObject route = routes.add<JsonObject>();
+        route["path"] = ROUTES[i].path;
+        RouteTable::methodList(ROUTES[i].method, methods, sizeof(methods), false);
+        route["methods"] = methods;
+        route["max_body"] = ROUTES[i].maxBody;
+        route["hits"] = routeHits[i];
+        route["max_allocs"] = routeMaxAllocs[i];
+    }
+    doc["method_not_allowed"] = methodNotAllowed;
+    doc["preflights"] = preflights;
+    doc["bodies_rejected"] = bodiesRejected;
+    doc["largest_body"] = largestBody;
+    JsonDocument writer(responses.allocator());
+    responses.getStats(writer);
+    doc["responses"] = writer;
+
+    responses.sendJson(request, 200, doc);
+}
+
+// ---------------------------------------------------------
+// MIME helper
+// ---------------------------------------------------------
 const char *AppWebServer::getContentType(const String &path)
 {
     if (path.endsWith(".htm") || path.endsWith(".html"))
@@ -297,230 +624,363 @@ const char *AppWebServer::getContentType(const String &path)
     return "application/octet-stream";
 }
 
-void AppWebServer::handleFmPower()
+void AppWebServer::handleFmPower(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("state"))
+    if (request->hasArg("state"))
     {
-        String state = server.arg("state");
+        const String &state = request->arg("state");
         if (state == "on")
         {
-            // Free RAM from bluetooth service
-            btManager->setPower(false);
-            // Initialize and power on FM radio hardware
-            fmRadio->begin();
-            server.send(200, "application/json", "{\"status\":\"success\", \"powered\":true}");
+            // Tắt Bluetooth (giải phóng RAM) rồi khởi tạo chip FM trong task control
+            if (!postCommand(request, CMD_FM_POWER_ON))
+                return;
+            responses.sendStatic(request, 200, "{\"status\":\"success\", \"powered\":true}");
             return;
         }
         else if (state == "off")
         {
-            fmRadio->powerOff();
-            server.send(200, "application/json", "{\"status\":\"success\", \"powered\":false}");
+            if (!postCommand(request, CMD_FM_POWER_OFF))
+                return;
+            responses.sendStatic(request, 200, "{\"status\":\"success\", \"powered\":false}");
             return;
         }
     }
-    server.send(400, "application/json", "{\"status\":\"error\", \"message\":\"Thiếu tham số state (on/off)\"}");
+    responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Thiếu tham số state (on/off)\"}");
 }
 
-void AppWebServer::handleFmSeek()
+// Seek chạy nền trong task control (StationSeeker): trả id của job ngay, tiến
+// độ qua sự kiện SSE "seek" và GET /api/fm/seek
+void AppWebServer::handleFmSeekStart(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("direction"))
+    if (!request->hasArg("direction"))
     {
-        String dir = server.arg("direction");
-        if (dir == "up")
-        {
-            fmRadio->seekUp();
-        }
-        else if (dir == "down")
-        {
-            fmRadio->seekDown();
-        }
-        else if (dir == "next")
-        {
-            fmRadio->autoSeekNext();
-        }
-        else
-        {
-            server.send(400, "application/json", "{\"status\":\"error\", \"message\":\"Tham số direction không hợp lệ (up/down/next)\"}");
-            return;
-        }
-        server.send(200, "application/json", "{\"status\":\"success\", \"freq\":" + String(fmRadio->getCurrentFrequency(), 1) + "}");
+        responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Thiếu tham số direction (up/down/next)\"}");
         return;
     }
-    server.send(400, "application/json", "{\"status\":\"error\", \"message\":\"Thiếu tham số direction (up/down/next)\"}");
+    const String &dir = request->arg("direction");
+    ControlCommand cmd;
+    if (dir == "up" || dir == "next")
+    {
+        cmd = CMD_FM_SEEK_UP;
+    }
+    else if (dir == "down")
+    {
+        cmd = CMD_FM_SEEK_DOWN;
+    }
+    else
+    {
+        responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Tham số direction không hợp lệ (up/down/next)\"}");
+        return;
+    }
+    if (!fmRadio->getPowerState())
+    {
+        responses.sendStatic(request, 409, "{\"status\":\"error\", \"message\":\"FM đang tắt\"}");
+        return;
+    }
+    uint32_t job = stationSeeker->reserveId();
+    if (!postCommand(request, cmd, job))
+        return;
+    responses.sendf(request, 202, "{\"status\":\"started\", \"job\":%u, \"from\":%.1f}", (unsigned)job, fmRadio->getCurrentFrequency());
 }
 
-void AppWebServer::handleFmSaveChannel()
+// ?id=n: 404 nếu job đó đã bị job mới hơn thay (chỉ giữ job cuối).
+// Có direction: bắt đầu seek như POST (UI cũ gọi GET)
+void AppWebServer::handleFmSeek(AsyncWebServerRequest *request)
+{
+    if (request->hasArg("direction"))
+    {
+        handleFmSeekStart(request);
+        return;
+    }
+    if (request->hasArg("id") && (uint32_t)request->arg("id").toInt() != stationSeeker->getJobId())
+    {
+        responses.sendStatic(request, 404, "{\"status\":\"error\", \"message\":\"Không có job seek này\"}");
+        return;
+    }
+    JsonDocument doc(responses.allocator());
+    stationSeeker->getStatus(doc);
+    responses.sendJson(request, 200, doc);
+}
+
+void AppWebServer::handleFmSeekCancel(AsyncWebServerRequest *request)
+{
+    if (!postCommand(request, CMD_FM_SEEK_CANCEL))
+        return;
+    responses.sendStatic(request, 200, "{\"status\":\"success\"}");
+}
+
+void AppWebServer::handleFmSaveChannel(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
     float currentFreq = fmRadio->getCurrentFrequency();
-    fmRadio->saveChannel(currentFreq);
-    server.send(200, "application/json", "{\"status\":\"success\", \"message\":\"Đã lưu kênh\", \"freq\":" + String(currentFreq, 1) + "}");
+    if (!postCommand(request, CMD_FM_SAVE_CHANNEL, lroundf(currentFreq * 100)))
+        return;
+    responses.sendf(request, 200, "{\"status\":\"success\", \"message\":\"Đã lưu kênh\", \"freq\":%.1f}", currentFreq);
 }
 
-void AppWebServer::handleFmSelectChannel()
+void AppWebServer::handleFmSelectChannel(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("index"))
+    if (request->hasArg("index"))
     {
-        int index = server.arg("index").toInt();
-        fmRadio->selectSavedChannel(index);
-        server.send(200, "application/json", "{\"status\":\"success\", \"freq\":" + String(fmRadio->getCurrentFrequency(), 1) + "}");
+        int index = request->arg("index").toInt();
+        float freq = fmRadio->getSavedChannel(index);
+        if (!postCommand(request, CMD_FM_SELECT_CHANNEL, index))
+            return;
+        if (freq == 0)
+            freq = fmRadio->getCurrentFrequency();
+        responses.sendf(request, 200, "{\"status\":\"success\", \"freq\":%.1f}", freq);
         return;
     }
-    server.send(400, "application/json", "{\"status\":\"error\", \"message\":\"Thiếu tham số index\"}");
+    responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Thiếu tham số index\"}");
 }
 
-void AppWebServer::handleFmLoadChannels()
+// Danh sách kênh theo trang: ?offset=&limit=&sort=order|freq&favorites=1
+void AppWebServer::handleFmLoadChannels(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    JsonDocument doc;
-    fmRadio->getSavedChannels(&doc);
+    long offset = request->hasArg("offset") ? request->arg("offset").toInt() : 0;
+    long limit = request->hasArg("limit") ? request->arg("limit").toInt() : STATION_PAGE_SIZE;
+    offset = constrain(offset, 0, STATION_CAPACITY);
+    limit = constrain(limit, 1, STATION_PAGE_MAX);
+    bool byFrequency = request->hasArg("sort") && request->arg("sort") == "freq";
+    bool favoritesOnly = request->hasArg("favorites") && request->arg("favorites") == "1";
 
-    String output;
-    serializeJson(doc, output);
-    server.send(200, "application/json", output);
+    JsonDocument doc(responses.allocator());
+    fmRadio->getSavedChannels(&doc, offset, limit, byFrequency, favoritesOnly);
+
+    responses.sendJson(request, 200, doc);
 }
 
-void AppWebServer::handleFmSetFreq()
+void AppWebServer::handleFmSetFreq(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("freq"))
+    if (request->hasArg("freq"))
     {
-        float freq = server.arg("freq").toFloat();
+        float freq = request->arg("freq").toFloat();
         if (freq >= 87.0 && freq <= 108.0)
         {
-            fmRadio->setFrequency(freq);
-            server.send(200, "application/json", "{\"status\":\"success\", \"freq\":" + String(fmRadio->getCurrentFrequency(), 1) + "}");
+            if (!postCommand(request, CMD_FM_SET_FREQ, lroundf(freq * 100)))
+                return;
+            responses.sendf(request, 200, "{\"status\":\"success\", \"freq\":%.1f}", freq);
+            return;
+        }
+    }
+    responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Tần số không hợp lệ (87.0-108.0)\"}");
+}
+
+void AppWebServer::handleFmVolume(AsyncWebServerRequest *request)
+{
+    if (request->hasArg("level"))
+    {
+        int level = constrain(request->arg("level").toInt(), 0, 15);
+        if (!postCommand(request, CMD_FM_SET_VOLUME, level))
+            return;
+        responses.sendf(request, 200, "{\"status\":\"success\", \"volume\":%d}", level);
+        return;
+    }
+    responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Thiếu tham số level (0-15)\"}");
+}
+
+// Thêm API xóa kênh (theo index trong danh sách hoặc theo tần số: ?freq=99.5)
+void AppWebServer::handleFmDeleteChannel(AsyncWebServerRequest *request)
+{
+    if (request->hasArg("freq"))
+    {
+        float freq = request->arg("freq").toFloat();
+        long freq10k = lroundf(freq * 100);
+        if (freq10k < STATION_FREQ_MIN || freq10k > STATION_FREQ_MAX)
+        {
+            responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Tần số không hợp lệ (87.0-108.0)\"}");
             return;
         }
+        if (!postCommand(request, CMD_FM_DELETE_STATION, freq10k))
+            return;
+        responses.sendf(request, 200, "{\"status\":\"success\", \"message\":\"Đã xóa kênh\", \"freq\":%.1f}", freq);
+        return;
     }
-    server.send(400, "application/json", "{\"status\":\"error\", \"message\":\"Tần số không hợp lệ (87.0-108.0)\"}");
+    if (request->hasArg("index"))
+    {
+        int index = request->arg("index").toInt();
+        if (!postCommand(request, CMD_FM_DELETE_CHANNEL, index))
+            return;
+        responses.sendf(request, 200, "{\"status\":\"success\", \"message\":\"Đã xóa kênh index %d\"}", index);
+        return;
+    }
+    responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Thiếu tham số index\"}");
 }
 
-void AppWebServer::handleFmVolume()
+// ?freq=99.5 [&name=...] [&favorite=0|1] [&position=n]: chỉ sửa danh sách (không chạm chip)
+// nên chạy ngay trong async_tcp; StationStore tự khóa
+void AppWebServer::handleFmEditStation(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("level"))
+    if (!request->hasArg("freq"))
     {
-        int level = server.arg("level").toInt();
-        fmRadio->setVolume(level);
-        server.send(200, "application/json", "{\"status\":\"success\", \"volume\":" + String(fmRadio->getVolume()) + "}");
+        responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Thiếu tham số freq\"}");
         return;
     }
-    server.send(400, "application/json", "{\"status\":\"error\", \"message\":\"Thiếu tham số level (0-15)\"}");
+    long freq = lroundf(request->arg("freq").toFloat() * 100);
+    if (freq < STATION_FREQ_MIN || freq > STATION_FREQ_MAX)
+    {
+        responses.sendStatic(request, 400, "{\"status\":\"error\", \"message\":\"Tần số không hợp lệ (87.0-108.0)\"}");
+        return;
+    }
+    uint16_t freq10k = (uint16_t)freq;
+    const char *name = request->hasArg("name") ? request->arg("name").c_str() : nullptr;
+    int favorite = request->hasArg("favorite") ? (request->arg("favorite") == "1") : -1;
+    int position = -1;
+    if (request->hasArg("position"))
+    {
+        long value = request->arg("position").toInt();
+        position = value < 0 ? 0 : value;
+    }
+
+    if (!fmRadio->editStation(freq10k, name, favorite, position))
+    {
+        responses.sendStatic(request, 404, "{\"status\":\"error\", \"message\":\"Chưa lưu kênh này\"}");
+        return;
+    }
+    responses.sendf(request, 200, "{\"status\":\"success\", \"freq\":%.1f}", freq10k / 100.0f);
 }
 
-// Thêm API xóa kênh
-void AppWebServer::handleFmDeleteChannel()
+// Quét băng tần: task control chạy từng bước, kết quả từng phần đi qua SSE ("scan")
+void AppWebServer::startScan(AsyncWebServerRequest *request, ControlCommand cmd)
 {
-    if (server.hasArg("index"))
+    if (!fmRadio->getPowerState())
     {
-        int index = server.arg("index").toInt();
-        fmRadio->deleteChannel(index);
-        server.send(200, "application/json", "{\"status\":\"success\", \"message\":\"Đã xóa kênh index " + String(index) + "\"}");
+        responses.sendStatic(request, 409, "{\"status\":\"error\", \"message\":\"FM đang tắt\"}");
         return;
     }
-    server.send(400, "application/json", "{\"status\":\"error\", \"message\":\"Thiếu tham số index\"}");
+    if (bandScanner->isRunning())
+    {
+        responses.sendStatic(request, 409, "{\"status\":\"error\", \"message\":\"Đang quét\"}");
+        return;
+    }
+    // dwell: thời gian dừng mỗi kênh (ms), dài hơn thì RSSI chính xác hơn nhưng quét chậm hơn
+    uint32_t dwell = SCAN_DWELL_MS;
+    if (request->hasArg("dwell"))
+    {
+        long value = request->arg("dwell").toInt();
+        dwell = constrain(value, SCAN_DWELL_MIN_MS, SCAN_DWELL_MAX_MS);
+    }
+    if (!postCommand(request, cmd, dwell))
+        return;
+    responses.sendf(request, 202, "{\"status\":\"started\", \"channels\":%u, \"dwell_ms\":%u}", (unsigned)SCAN_CHANNELS, (unsigned)dwell);
+}
+
+void AppWebServer::handleFmScanStart(AsyncWebServerRequest *request)
+{
+    startScan(request, CMD_FM_SCAN_START);
+}
+
+// Kết quả (danh sách kênh mới, "presets") có trong sự kiện "scan" cuối và GET /api/fm/scan
+void AppWebServer::handleFmAutostore(AsyncWebServerRequest *request)
+{
+    startScan(request, CMD_FM_AUTOSTORE);
+}
+
+void AppWebServer::handleFmScanResult(AsyncWebServerRequest *request)
+{
+    JsonDocument doc(responses.allocator());
+    bandScanner->getResult(doc);
+    responses.sendJson(request, 200, doc);
+}
+
+void AppWebServer::handleFmScanCancel(AsyncWebServerRequest *request)
+{
+    if (!postCommand(request, CMD_FM_SCAN_CANCEL))
+        return;
+    responses.sendStatic(request, 200, "{\"status\":\"success\"}");
 }
 
 // Bluetooth
 // Hàm xử lý Status
-void AppWebServer::handleBTStatus()
+void AppWebServer::handleBTStatus(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    JsonDocument doc;
+    JsonDocument doc(responses.allocator());
     btManager->getStatus(doc);
-    String response;
-    serializeJson(doc, response);
-    server.send(200, "application/json", response);
+    responses.sendJson(request, 200, doc);
 }
 
 // Hàm xử lý Bật/Tắt
-void AppWebServer::handleBTPower()
+void AppWebServer::handleBTPower(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("plain"))
+    JsonDocument doc(responses.allocator());
+    if (parseBody(request, doc, "{\"power\":true}"))
     {
-        JsonDocument doc;
-        deserializeJson(doc, server.arg("plain"));
-        bool power = doc["power"] | false;
-        if (power)
+        if (doc["power"].is<bool>())
         {
-            fmRadio->powerOff();
+            bool power = doc["power"];
+            // Bật Bluetooth thì tắt FM trước (xử lý trong task control)
+            if (!postCommand(request, power ? CMD_BT_POWER_ON : CMD_BT_POWER_OFF))
+                return;
+            responses.sendStatic(request, 200, "{\"status\":\"ok\"}");
+            return;
         }
-        btManager->setPower(power);
-        server.send(200, "application/json", "{\"status\":\"ok\"}");
     }
-    server.send(200, "application/json", "{\"status\":\"failed\"}");
+    responses.sendStatic(request, 400, "{\"error\":\"Missing power\"}");
 }
 
 // API Chỉnh Volume
-void AppWebServer::handleBTVolume()
+void AppWebServer::handleBTVolume(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("plain"))
+    JsonDocument doc(responses.allocator()); // ArduinoJson V7
+    if (parseBody(request, doc, "{\"value\":true}"))
     {
-        JsonDocument doc; // ArduinoJson V7
-        deserializeJson(doc, server.arg("plain"));
-
         if (doc["value"].is<uint8_t>())
         {
             uint8_t vol = doc["value"]; // 0-127
-            btManager->setVolume(vol);
-            server.send(200, "application/json", "{\"status\":\"ok\"}");
-        }
-        else
-        {
-            server.send(400, "application/json", "{\"error\":\"Missing value\"}");
+            if (!postCommand(request, CMD_BT_SET_VOLUME, vol))
+                return;
+            responses.sendStatic(request, 200, "{\"status\":\"ok\"}");
+            return;
         }
     }
+    responses.sendStatic(request, 400, "{\"error\":\"Missing value\"}");
 }
 
 // API Điều khiển trình phát (Play/Pause/Next/Prev)
-void AppWebServer::handleBTControl()
+void AppWebServer::handleBTControl(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("plain"))
+    JsonDocument doc(responses.allocator());
+    if (parseBody(request, doc, "{\"cmd\":true}"))
     {
-        JsonDocument doc;
-        deserializeJson(doc, server.arg("plain"));
-
-        String cmd = doc["cmd"] | "";
-
-        if (cmd == "play")
-            btManager->play();
-        else if (cmd == "pause")
-            btManager->pause();
-        else if (cmd == "next")
-            btManager->next();
-        else if (cmd == "prev")
-            btManager->previous();
+        const char *cmd = doc["cmd"] | "";
+
+        bool posted = true;
+        if (strcmp(cmd, "play") == 0)
+            posted = postCommand(request, CMD_BT_PLAY);
+        else if (strcmp(cmd, "pause") == 0)
+            posted = postCommand(request, CMD_BT_PAUSE);
+        else if (strcmp(cmd, "next") == 0)
+            posted = postCommand(request, CMD_BT_NEXT);
+        else if (strcmp(cmd, "prev") == 0)
+            posted = postCommand(request, CMD_BT_PREVIOUS);
+        if (!posted)
+            return;
 
-        server.send(200, "application/json", "{\"status\":\"ok\"}");
+        responses.sendStatic(request, 200, "{\"status\":\"ok\"}");
+        return;
     }
+    responses.sendStatic(request, 400, "{\"status\":\"failed\"}");
 }
-void AppWebServer::handleBTConfirmPin()
+void AppWebServer::handleBTConfirmPin(AsyncWebServerRequest *request)
 {
-    sendCORSHeaders();
-    if (server.hasArg("plain"))
+    JsonDocument doc(responses.allocator());
+    if (parseBody(request, doc, "{\"pin\":true}"))
     {
-        JsonDocument doc;
-        deserializeJson(doc, server.arg("plain"));
-        String pinCodeStr = doc["pin"] | "";
+        const char *pinCodeStr = doc["pin"] | "";
         Serial.printf("Input Pin 1: %s\n", pinCodeStr);
 
-        if (pinCodeStr.isEmpty())
+        if (*pinCodeStr == '\0')
         {
-            server.send(200, "application/json", "{\"status\":\"failed\"}");
+            responses.sendStatic(request, 200, "{\"status\":\"failed\"}");
         }
         else
         {
-            long pinCode = pinCodeStr.toInt();
-            Serial.printf("Input Pin 2: %d\n", pinCode);
-            btManager->confirmPinCode(pinCode);
-            server.send(200, "application/json", "{\"status\":\"ok\"}");
+            long pinCode = atol(pinCodeStr);
+            Serial.printf("Input Pin 2: %ld\n", pinCode);
+            if (!postCommand(request, CMD_BT_CONFIRM_PIN, pinCode))
+                return;
+            responses.sendStatic(request, 200, "{\"status\":\"ok\"}");
         }
+        return;
     }
-}
\ No newline at end of file
+    responses.sendStatic(request, 400, "{\"status\":\"failed\"}");
+}
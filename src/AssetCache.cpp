@@ -0,0 +1,281 @@
+#include "AssetCache.h"
+#include "Constants.h"
+
+// FNV-1a 32 bit: đủ để phân biệt các phiên bản của cùng một file
+static uint32_t fnv1a(const uint8_t *data, size_t len)
+{
+    uint32_t hash = 2166136261UL;
+    for (size_t i = 0; i < len; i++)
+    {
+        hash ^= data[i];
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+AssetCache::AssetCache(FileManager *fileMgr) : fileManager(fileMgr)
+{
+    lock = xSemaphoreCreateMutex();
+}
+
+// =========================================================
+// Nạp file vào PSRAM
+// =========================================================
+
+AssetCache::Asset *AssetCache::find(const String &path)
+{
+    for (uint8_t i = 0; i < assetCount; i++)
+    {
+        if (assets[i].path == path)
+        {
+            return &assets[i];
+        }
+    }
+    return nullptr;
+}
+
+// 1: đã nạp, 0: không có trên thẻ, -1: có nhưng không đưa vào cache được
+int AssetCache::loadVariant(const String &path, Variant &variant)
+{
+    // Ưu tiên gói UI: index trong RAM, đọc bằng seek, hash có sẵn
+    const BundleEntry *entry = fileManager->findBundleEntry(path.c_str());
+    if (entry)
+    {
+        size_t size = entry->length;
+        uint8_t *data = nullptr;
+        if (size > 0 && size <= ASSET_MAX_FILE_SIZE && usedBytes + size <= ASSET_CACHE_BUDGET)
+        {
+            data = (uint8_t *)ps_malloc(size);
+        }
+        if (data != nullptr && fileManager->readBundle(entry, 0, data, size) != size)
+        {
+            free(data);
+            data = nullptr;
+        }
+        if (data == nullptr)
+        {
+            return -1;
+        }
+        variant.data = data;
+        variant.size = size;
+        snprintf(variant.etag, sizeof(variant.etag), "\"%08lx\"", (unsigned long)entry->hash);
+        usedBytes += size;
+        return 1;
+    }
+
+    File file = fileManager->openFile((String(UI_PATH) + path).c_str());
+    if (!file || file.isDirectory())
+    {
+        return 0;
+    }
+
+    size_t size = file.size();
+    uint8_t *data = nullptr;
+    if (size > 0 && size <= ASSET_MAX_FILE_SIZE && usedBytes + size <= ASSET_CACHE_BUDGET)
+    {
+        data = (uint8_t *)ps_malloc(size);
+    }
+    if (data != nullptr && file.read(data, size) != size)
+    {
+        free(data);
+        data = nullptr;
+    }
+    file.close();
+    if (data == nullptr)
+    {
+        return -1;
+    }
+
+    variant.data = data;
+    variant.size = size;
+    snprintf(variant.etag, sizeof(variant.etag), "\"%08lx\"", (unsigned long)fnv1a(data, size));
+    usedBytes += size;
+    return 1;
+}
+
+AssetCache::Asset *AssetCache::load(const String &path)
+{
+    if (assetCount >= MAX_CACHED_ASSETS)
+    {
+        return nullptr;
+    }
+
+    Asset &asset = assets[assetCount];
+    int plain = loadVariant(path, asset.plain);
+    int gzip = loadVariant(path + ".gz", asset.gzip);
+    if (plain < 0 || gzip < 0 || (plain == 0 && gzip == 0))
+    {
+        // Không có file, hoặc một bản không vừa cache: bỏ cả hai, đọc từ SD
+        for (Variant *variant : {&asset.plain, &asset.gzip})
+        {
+            if (variant->data)
+            {
+                free(variant->data);
+                usedBytes -= variant->size;
+                *variant = Variant();
+            }
+        }
+        return nullptr;
+    }
+
+    asset.path = path;
+    asset.immutable = isHashedName(path);
+    assetCount++;
+    loads++;
+    Serial.printf("AssetCache: %s (%u byte%s%s), PSRAM đã dùng %u byte\n", path.c_str(),
+                  (unsigned)asset.plain.size, asset.gzip.data ? ", có .gz" : "",
+                  asset.immutable ? ", immutable" : "", (unsigned)usedBytes);
+    return &asset;
+}
+
+// Tên có hash do bundler sinh ra: app.3f9a2c1b.js, index-a1b2c3d4.css
+// (đoạn 8-32 ký tự chữ/số, có ít nhất một chữ số, ngay trước phần mở rộng)
+bool AssetCache::isHashedName(const String &path)
+{
+    int ext = path.lastIndexOf('.');
+    int slash = path.lastIndexOf('/');
+    if (ext <= slash)
+        return false;
+
+    int end = ext;
+    int start = end - 1;
+    bool digit = false;
+    while (start > slash && isalnum((unsigned char)path[start]))
+    {
+        digit |= isdigit((unsigned char)path[start]) != 0;
+        start--;
+    }
+    int length = end - start - 1;
+    return start > slash && (path[start] == '.' || path[start] == '-') && digit && length >= 8 && length <= 32;
+}
+
+// =========================================================
+// Trả file
+// =========================================================
+
+bool AssetCache::serve(AsyncWebServerRequest *request, const String &path, const char *contentType)
+{
+    if (path.indexOf("..") >= 0)
+    {
+        return false;
+    }
+    bool acceptGzip = request->hasHeader("Accept-Encoding") && request->header("Accept-Encoding").indexOf("gzip") >= 0;
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    Asset *asset = find(path);
+    if (asset)
+        hits++;
+    else
+        asset = load(path);
+    xSemaphoreGive(lock);
+
+    if (asset == nullptr)
+    {
+        return serveFromSd(request, path, contentType, acceptGzip);
+    }
+
+    // Bản đã nạp không đổi nữa: đọc ngoài khóa
+    bool compressed = asset->gzip.data && (acceptGzip || !asset->plain.data);
+    const Variant &variant = compressed ? asset->gzip : asset->plain;
+    const char *cacheControl = asset->immutable ? ASSET_CACHE_IMMUTABLE : ASSET_CACHE_REVALIDATE;
+    bool bothVariants = asset->gzip.data && asset->plain.data;
+
+    AsyncWebServerResponse *response;
+    bool unchanged = request->hasHeader("If-None-Match") && request->header("If-None-Match").indexOf(variant.etag) >= 0;
+    if (unchanged)
+    {
+        response = request->beginResponse(304);
+    }
+    else
+    {
+        response = request->beginResponse(200, contentType, variant.data, variant.size);
+        if (compressed)
+            response->addHeader("Content-Encoding", "gzip");
+    }
+    response->addHeader("ETag", variant.etag);
+    response->addHeader("Cache-Control", cacheControl);
+    if (bothVariants)
+        response->addHeader("Vary", "Accept-Encoding");
+    request->send(response);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    if (unchanged)
+    {
+        notModified++;
+        bytesSaved += variant.size;
+    }
+    else
+    {
+        bytesSent += variant.size;
+        if (compressed && asset->plain.data)
+            bytesSaved += asset->plain.size - variant.size;
+    }
+    xSemaphoreGive(lock);
+    return true;
+}
+
+// Hết ngân sách cache hoặc file quá lớn: đọc từ SD như trước, vẫn ưu tiên bản .gz
+bool AssetCache::serveFromSd(AsyncWebServerRequest *request, const String &path, const char *contentType, bool acceptGzip)
+{
+    AsyncWebServerResponse *response = nullptr;
+    bool compressed = false;
+    size_t size = 0;
+
+    // Trong gói: trả từng đoạn bằng seek trên file gói đang mở
+    const BundleEntry *entry = acceptGzip ? fileManager->findBundleEntry((path + ".gz").c_str()) : nullptr;
+    compressed = entry != nullptr;
+    if (!entry)
+        entry = fileManager->findBundleEntry(path.c_str());
+    if (entry)
+    {
+        FileManager *fm = fileManager;
+        size = entry->length;
+        response = request->beginResponse(contentType, size, [fm, entry](uint8_t *buffer, size_t maxLen, size_t index) -> size_t
+                                          { return fm->readBundle(entry, index, buffer, maxLen); });
+    }
+    else
+    {
+        String fsPath = String(UI_PATH) + path;
+        File file;
+        if (acceptGzip)
+        {
+            file = fileManager->openFile((fsPath + ".gz").c_str());
+            compressed = file && !file.isDirectory();
+        }
+        if (!compressed)
+        {
+            file = fileManager->openFile(fsPath.c_str());
+            if (!file || file.isDirectory())
+            {
+                return false;
+            }
+        }
+        size = file.size();
+        response = request->beginResponse(file, path, contentType);
+    }
+
+    if (compressed)
+        response->addHeader("Content-Encoding", "gzip");
+    request->send(response);
+
+    xSemaphoreTake(lock, portMAX_DELAY);
+    sdFallbacks++;
+    bytesSent += size;
+    xSemaphoreGive(lock);
+    return true;
+}
+
+void AssetCache::getStats(JsonDocument &doc)
+{
+    xSemaphoreTake(lock, portMAX_DELAY);
+    doc["cached_files"] = assetCount;
+    doc["psram_bytes"] = usedBytes;
+    doc["budget_bytes"] = ASSET_CACHE_BUDGET;
+    doc["hits"] = hits;
+    doc["loads"] = loads;
+    doc["sd_fallbacks"] = sdFallbacks;
+    doc["not_modified"] = notModified;
+    doc["bytes_sent"] = bytesSent;
+    doc["bytes_saved"] = bytesSaved;
+    xSemaphoreGive(lock);
+}
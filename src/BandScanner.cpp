@@ -0,0 +1,259 @@
+#include "BandScanner.h"
+
+static const char *stateName(ScanState state)
+{
+    switch (state)
+    {
+    case SCAN_RUNNING:
+        return "running";
+    case SCAN_DONE:
+        return "done";
+    case SCAN_CANCELLED:
+        return "cancelled";
+    default:
+        return "idle";
+    }
+}
+
+BandScanner::BandScanner(FMRadio *radio, StatusBroadcaster *broadcaster)
+    : fmRadio(radio), statusBroadcaster(broadcaster)
+{
+    memset(points, 0, sizeof(points));
+}
+
+// =========================================================
+// Job control (control task)
+// =========================================================
+void BandScanner::start(uint32_t dwell, bool store)
+{
+    if (state == SCAN_RUNNING)
+        return;
+    if (!fmRadio->getPowerState())
+    {
+        // FM went off after the handler answered 202: end this job too instead of
+        // leaving the previous scan's state and points in place
+        portENTER_CRITICAL(&lock);
+        done = 0;
+        elapsedMs = 0;
+        presetCount = 0;
+        state = SCAN_CANCELLED;
+        portEXIT_CRITICAL(&lock);
+        pushed = 0;
+        scans++;
+        push();
+        Serial.println("BandScanner: Scan cancelled, FM is off");
+        return;
+    }
+
+    if (dwell < SCAN_DWELL_MIN_MS)
+        dwell = SCAN_DWELL_MIN_MS;
+    if (dwell > SCAN_DWELL_MAX_MS)
+        dwell = SCAN_DWELL_MAX_MS;
+
+    portENTER_CRITICAL(&lock);
+    memset(points, 0, sizeof(points));
+    done = 0;
+    elapsedMs = 0;
+    dwellMs = dwell;
+    presetCount = 0;
+    state = SCAN_RUNNING;
+    portEXIT_CRITICAL(&lock);
+    autostore = store;
+
+    pushed = 0;
+    scans++;
+    fmRadio->beginScan();
+    startedAt = millis();
+    fmRadio->tuneScan(channelFrequency(0));
+    tunedAt = millis();
+    Serial.printf("BandScanner: Scanning %u channels, dwell %u ms%s\n", (unsigned)SCAN_CHANNELS, (unsigned)dwellMs,
+                  autostore ? ", auto-store" : "");
+}
+
+void BandScanner::cancel()
+{
+    if (state == SCAN_RUNNING)
+        finish(SCAN_CANCELLED);
+}
+
+uint32_t BandScanner::msUntilStep() const
+{
+    uint32_t waited = millis() - tunedAt;
+    return waited >= dwellMs ? 0 : dwellMs - waited;
+}
+
+void BandScanner::step()
+{
+    if (state != SCAN_RUNNING || msUntilStep() > 0)
+        return;
+
+    uint8_t rssi;
+    bool stereo;
+    bool station;
+    fmRadio->readSignal(rssi, stereo, station);
+
+    uint16_t index = done;
+    portENTER_CRITICAL(&lock);
+    points[index] = (rssi & SCAN_POINT_RSSI) | (stereo ? SCAN_POINT_STEREO : 0);
+    done = index + 1;
+    elapsedMs = millis() - startedAt;
+    portEXIT_CRITICAL(&lock);
+
+    if (done >= SCAN_CHANNELS)
+    {
+        finish(SCAN_DONE);
+        return;
+    }
+    fmRadio->tuneScan(channelFrequency(done));
+    tunedAt = millis();
+    if (done - pushed >= SCAN_PUSH_POINTS)
+        push();
+}
+
+void BandScanner::finish(ScanState result)
+{
+    fmRadio->endScan();
+    if (result == SCAN_DONE && autostore)
+        storePresets();
+    portENTER_CRITICAL(&lock);
+    elapsedMs = millis() - startedAt;
+    state = result;
+    portEXIT_CRITICAL(&lock);
+    push();
+    Serial.printf("BandScanner: Scan %s, %u channels in %u ms (%.1f steps/s)\n", stateName(result),
+                  (unsigned)done, (unsigned)elapsedMs, stepsPerSecond());
+}
+
+float BandScanner::stepsPerSecond() const
+{
+    uint32_t elapsed = elapsedMs;
+    return elapsed ? done * 1000.0f / elapsed : 0.0f;
+}
+
+// =========================================================
+// Auto-store
+// =========================================================
+static uint8_t stationScore(uint8_t point)
+{
+    return (point & SCAN_POINT_RSSI) + ((point & SCAN_POINT_STEREO) ? AUTOSTORE_STEREO_BONUS : 0);
+}
+
+uint8_t BandScanner::pickStations(const uint8_t *points, uint16_t count, uint16_t *channels, uint8_t max)
+{
+    if (count == 0)
+        return 0;
+
+    // Noise floor: median RSSI of the band (most channels carry no station)
+    uint16_t histogram[SCAN_POINT_RSSI + 1] = {};
+    for (uint16_t i = 0; i < count; i++)
+        histogram[points[i] & SCAN_POINT_RSSI]++;
+    uint16_t seen = 0;
+    uint8_t median = 0;
+    while (median < SCAN_POINT_RSSI && (seen += histogram[median]) < (count + 1) / 2)
+        median++;
+    uint8_t threshold = median + AUTOSTORE_MARGIN;
+    if (threshold < AUTOSTORE_MIN_RSSI)
+        threshold = AUTOSTORE_MIN_RSSI;
+
+    // Best remaining peak first; a peak too close to one already taken is the
+    // same station seen on a neighbouring channel
+    const uint16_t spacing = (AUTOSTORE_SPACING_10K + SCAN_STEP_10K - 1) / SCAN_STEP_10K;
+    uint8_t found = 0;
+    while (found < max)
+    {
+        int best = -1;
+        for (uint16_t i = 0; i < count; i++)
+        {
+            uint8_t rssi = points[i] & SCAN_POINT_RSSI;
+            if (rssi < threshold)
+                continue;
+            // Local maximum (the first channel of a plateau)
+            if (i > 0 && (points[i - 1] & SCAN_POINT_RSSI) >= rssi)
+                continue;
+            if (i + 1 < count && (points[i + 1] & SCAN_POINT_RSSI) > rssi)
+                continue;
+            bool taken = false;
+            for (uint8_t k = 0; k < found && !taken; k++)
+                taken = abs((int)channels[k] - (int)i) < spacing;
+            if (taken)
+                continue;
+            if (best < 0 || stationScore(points[i]) > stationScore(points[best]))
+                best = i;
+        }
+        if (best < 0)
+            break;
+        channels[found++] = best;
+    }
+    return found;
+}
+
+void BandScanner::storePresets()
+{
+    uint16_t channels[AUTOSTORE_PRESETS];
+    uint8_t count = pickStations(points, done, channels, AUTOSTORE_PRESETS);
+
+    uint8_t levels[AUTOSTORE_PRESETS];
+    portENTER_CRITICAL(&lock);
+    for (uint8_t i = 0; i < count; i++)
+    {
+        presets[i] = channelFrequency(channels[i]);
+        levels[i] = points[channels[i]] & SCAN_POINT_RSSI;
+    }
+    presetCount = count;
+    portEXIT_CRITICAL(&lock);
+
+    fmRadio->autostoreChannels(presets, levels, count);
+    Serial.printf("BandScanner: Auto-store saved %u stations\n", (unsigned)count);
+}
+
+// =========================================================
+// Results
+// =========================================================
+void BandScanner::addHeader(JsonDocument &doc, ScanState current, uint16_t count)
+{
+    doc["state"] = stateName(current);
+    doc["start"] = SCAN_BAND_BOTTOM;
+    doc["step"] = SCAN_STEP_10K;
+    doc["total"] = SCAN_CHANNELS;
+    doc["done"] = count;
+    doc["dwell_ms"] = dwellMs;
+    doc["elapsed_ms"] = elapsedMs;
+    doc["steps_per_sec"] = roundf(stepsPerSecond() * 10) / 10;
+    if (autostore)
+    {
+        JsonArray list = doc["presets"].to<JsonArray>();
+        for (uint8_t i = 0; i < presetCount; i++)
+            list.add(presets[i] / 100.0f);
+    }
+}
+
+// Sends the points recorded since the last event (called from the control task)
+void BandScanner::push()
+{
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
+    uint16_t count = done;
+    addHeader(doc, state, count);
+    doc["first"] = pushed;
+    JsonArray list = doc["points"].to<JsonArray>();
+    for (uint16_t i = pushed; i < count; i++)
+        list.add(points[i]);
+    pushed = count;
+    statusBroadcaster->sendEvent("scan", doc);
+}
+
+void BandScanner::getResult(JsonDocument &doc)
+{
+    uint8_t snapshot[SCAN_CHANNELS];
+    portENTER_CRITICAL(&lock);
+    ScanState current = state;
+    uint16_t count = done;
+    memcpy(snapshot, points, count);
+    portEXIT_CRITICAL(&lock);
+
+    addHeader(doc, current, count);
+    doc["scans"] = scans;
+    JsonArray list = doc["points"].to<JsonArray>();
+    for (uint16_t i = 0; i < count; i++)
+        list.add(snapshot[i]);
+}
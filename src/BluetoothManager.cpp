@@ -1,14 +1,29 @@
 #include "BluetoothManager.h"
 #include <esp_gap_bt_api.h>
 #include "esp_bt.h"
+#include "Trace.h"
 
 // Khởi tạo static member
 MusicMetadata BluetoothManager::_meta;
+SemaphoreHandle_t BluetoothManager::_metaLock = nullptr;
+volatile uint32_t BluetoothManager::_metaVersion = 0;
+Histogram BluetoothManager::_connectTime(HISTOGRAM_CONNECT_US, HISTOGRAM_CONNECT_COUNT);
+volatile uint32_t BluetoothManager::_connectStartMs = 0;
+volatile uint32_t BluetoothManager::_connections = 0;
 
-BluetoothManager::BluetoothManager(FileManager *fileMgr) : fileManager(fileMgr) {}
+BluetoothManager::BluetoothManager(FileManager *fileMgr, SettingsStore *settingsStore)
+    : fileManager(fileMgr), settings(settingsStore)
+{
+    // _meta được ghi từ task Bluetooth (callback AVRC) và đọc từ task async_tcp
+    if (_metaLock == nullptr)
+        _metaLock = xSemaphoreCreateMutex();
+    // bluetooth.json (dạng log) chỉ còn được đọc để chuyển âm lượng cũ sang NVS
+    fileManager->useRecordLog(CONFIG_FILE_PATH BT_CONFIG_FILE);
+}
 
 void BluetoothManager::begin()
 {
+    TRACE_SCOPE(TRACE_BT, "a2dp.start");
     i2s_pin_config_t my_pin_config = {
         .bck_io_num = I2S_BCK_PIN,    // 26
         .ws_io_num = I2S_WS_PIN,      // 25
@@ -18,10 +33,12 @@ void BluetoothManager::begin()
     esp_bt_io_cap_t iocap = ESP_BT_IO_CAP_NONE;
     esp_bt_gap_set_security_param(ESP_BT_SP_IOCAP_MODE, &iocap, sizeof(esp_bt_io_cap_t));
     a2dp_sink.set_avrc_metadata_callback(metadataCallback);
+    a2dp_sink.set_on_connection_state_changed(connectionCallback);
     
     loadConfig();
     a2dp_sink.activate_pin_code(false);
     esp_bt_controller_mem_release(ESP_BT_MODE_BLE);
+    _connectStartMs = millis() | 1; // Khác 0 kể cả lúc millis() = 0
     a2dp_sink.start("ESP32_Famio_Audio");
     a2dp_sink.set_volume(_currentVolume);
 }
@@ -30,17 +47,46 @@ void BluetoothManager::setPower(bool enable)
 {
     if (enable && !_isPowered)
     {
-        begin();
+        if (_standby)
+        {
+            a2dp_sink.play();
+            _standby = false;
+        }
+        else
+        {
+            begin();
+        }
         _isPowered = true;
     }
-    else if (!enable && _isPowered)
+    else if (!enable && (_isPowered || _standby))
     {
+        TRACE_SCOPE(TRACE_BT, "a2dp.end");
         a2dp_sink.end();
         _isPowered = false;
+        _standby = false;
+        xSemaphoreTake(_metaLock, portMAX_DELAY);
         _meta.reset();
+        _metaVersion++;
+        xSemaphoreGive(_metaLock);
     }
 }
 
+void BluetoothManager::standby()
+{
+    if (!_isPowered)
+        return;
+    TRACE_INSTANT(TRACE_BT, "a2dp.standby", 0);
+    a2dp_sink.pause();
+    _isPowered = false;
+    _standby = true;
+}
+
+void BluetoothManager::setOutputLevel(uint8_t level)
+{
+    if (_isPowered || _standby)
+        a2dp_sink.set_volume(level);
+}
+
 void BluetoothManager::setVolume(uint8_t volume)
 {
     _currentVolume = volume;
@@ -83,6 +129,8 @@ void BluetoothManager::previous()
 
 void BluetoothManager::metadataCallback(uint8_t id, const uint8_t *text)
 {
+    TRACE_SCOPE_NAMED(trace, TRACE_BT, "avrc.metadata");
+    TRACE_SET_ARG(trace, id);
     String rawText = (char *)text;
 
     // Giới hạn độ dài chuỗi để bảo vệ Heap
@@ -91,12 +139,43 @@ void BluetoothManager::metadataCallback(uint8_t id, const uint8_t *text)
         rawText = rawText.substring(0, 61) + "...";
     }
 
+    xSemaphoreTake(_metaLock, portMAX_DELAY);
     if (id == 0x1)
         _meta.title = rawText;
     if (id == 0x2)
         _meta.artist = rawText;
     if (id == 0x4)
         _meta.album = rawText;
+    _metaVersion++;
+    xSemaphoreGive(_metaLock);
+}
+
+void BluetoothManager::connectionCallback(esp_a2d_connection_state_t state, void *obj)
+{
+    TRACE_INSTANT(TRACE_BT, "a2dp.connection", state);
+    if (state == ESP_A2D_CONNECTION_STATE_CONNECTED)
+    {
+        uint32_t start = _connectStartMs;
+        if (start)
+            _connectTime.observe((millis() - start) * 1000);
+        _connectStartMs = 0;
+        _connections++;
+    }
+    else if (state == ESP_A2D_CONNECTION_STATE_DISCONNECTED && _connectStartMs == 0)
+    {
+        // Stack vẫn chạy: đo thời gian tự kết nối lại
+        _connectStartMs = millis() | 1;
+    }
+}
+
+void BluetoothManager::writeMetrics(MetricsWriter &out)
+{
+    out.family("famio_a2dp_connect_duration_seconds", "histogram", "Time from A2DP start or link loss until a phone connects.");
+    out.histogram("famio_a2dp_connect_duration_seconds", nullptr, _connectTime);
+    out.family("famio_a2dp_connections_total", "counter", "A2DP connections established.");
+    out.sample("famio_a2dp_connections_total", nullptr, _connections);
+    out.family("famio_a2dp_connected", "gauge", "1 while a phone is connected over A2DP.");
+    out.sample("famio_a2dp_connected", nullptr, (_isPowered || _standby) && a2dp_sink.is_connected() ? 1 : 0);
 }
 
 void BluetoothManager::getStatus(JsonDocument &doc)
@@ -109,9 +188,11 @@ void BluetoothManager::getStatus(JsonDocument &doc)
     // Nếu đang kết nối thì mới gửi tên bài hát, không thì gửi "Chưa kết nối"
     if (a2dp_sink.is_connected())
     {
+        xSemaphoreTake(_metaLock, portMAX_DELAY);
         doc["title"] = _meta.title.length() > 0 ? _meta.title : "Unknown Title";
         doc["artist"] = _meta.artist.length() > 0 ? _meta.artist : "Unknown Artist";
         doc["album"] = _meta.album.length() > 0 ? _meta.album : "";
+        xSemaphoreGive(_metaLock);
     }
     else
     {
@@ -122,16 +203,24 @@ void BluetoothManager::getStatus(JsonDocument &doc)
 
 void BluetoothManager::loadConfig()
 {
-    JsonDocument doc;
+    if (settings->hasBtVolume())
+    {
+        _currentVolume = settings->getBtVolume();
+        return;
+    }
+
+    // Chưa có trong NVS: lấy từ file cũ trên SD (nếu có) rồi chuyển sang NVS
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
     if (fileManager->loadJsonFile(CONFIG_FILE_PATH BT_CONFIG_FILE, &doc))
     {
         _currentVolume = doc["volume"] | 64;
     }
+    saveConfig();
 }
 
 void BluetoothManager::saveConfig()
 {
-    JsonDocument doc;
-    doc["volume"] = _currentVolume;
-    fileManager->saveJsonFile(CONFIG_FILE_PATH BT_CONFIG_FILE, doc);
+    // Chỉ đổi giá trị trong RAM, task storage ghi xuống NVS sau
+    settings->setBtVolume(_currentVolume);
 }
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include "BootProfiler.h"
+
+// =========================================================
+// Ghi mốc
+// =========================================================
+
+uint8_t BootProfiler::start(const char *name)
+{
+    uint32_t now = millis();
+    portENTER_CRITICAL(&lock);
+    uint8_t id = count;
+    if (id < BOOT_MAX_PHASES)
+    {
+        Phase &phase = phases[id];
+        phase.name = name;
+        phase.startMs = now;
+        phase.core = -1;
+        count = id + 1;
+    }
+    portEXIT_CRITICAL(&lock);
+    return id;
+}
+
+void BootProfiler::finish(uint8_t id, bool ok)
+{
+    uint32_t now = millis();
+    int8_t core = (int8_t)xPortGetCoreID();
+    portENTER_CRITICAL(&lock);
+    if (id < count)
+    {
+        Phase &phase = phases[id];
+        phase.endMs = now;
+        phase.core = core;
+        phase.ok = ok;
+        phase.done = true;
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+bool BootProfiler::isDone(uint8_t id)
+{
+    portENTER_CRITICAL(&lock);
+    bool done = id >= count || phases[id].done;
+    portEXIT_CRITICAL(&lock);
+    return done;
+}
+
+uint32_t BootProfiler::waitFor(uint8_t id)
+{
+    uint32_t start = millis();
+    while (!isDone(id))
+        delay(BOOT_WAIT_POLL_MS);
+    return millis() - start;
+}
+
+// =========================================================
+// Báo cáo
+// =========================================================
+
+void BootProfiler::complete()
+{
+    completedMs = millis();
+
+    Phase snapshot[BOOT_MAX_PHASES];
+    portENTER_CRITICAL(&lock);
+    uint8_t total = count;
+    memcpy(snapshot, phases, sizeof(snapshot));
+    portEXIT_CRITICAL(&lock);
+
+    Serial.printf("Boot: Hoàn tất sau %u ms.\n", (unsigned)completedMs);
+    for (uint8_t i = 0; i < total; i++)
+    {
+        const Phase &phase = snapshot[i];
+        Serial.printf("  %-9s %5u -> %5u ms (%5u ms, core %d)%s\n", phase.name, (unsigned)phase.startMs,
+                      (unsigned)phase.endMs, (unsigned)(phase.endMs - phase.startMs), phase.core,
+                      phase.ok ? "" : " LỖI");
+    }
+}
+
+void BootProfiler::getReport(JsonDocument &doc)
+{
+    Phase snapshot[BOOT_MAX_PHASES];
+    portENTER_CRITICAL(&lock);
+    uint8_t total = count;
+    memcpy(snapshot, phases, sizeof(snapshot));
+    portEXIT_CRITICAL(&lock);
+
+    doc["setup_ms"] = completedMs;
+    JsonArray list = doc["phases"].to<JsonArray>();
+    for (uint8_t i = 0; i < total; i++)
+    {
+        const Phase &phase = snapshot[i];
+        JsonObject item = list.add<JsonObject>();
+        item["name"] = phase.name;
+        item["start_ms"] = phase.startMs;
+        if (!phase.done)
+            continue; // Pha còn đang chạy
+        item["end_ms"] = phase.endMs;
+        item["ms"] = phase.endMs - phase.startMs;
+        item["core"] = phase.core;
+        item["ok"] = phase.ok;
+    }
+}
@@ -1,34 +1,54 @@
 #include "ConnectivityManager.h"
 #include <ESPmDNS.h>
 
-ConnectivityManager::ConnectivityManager(FileManager *fileManager) : fm(fileManager)
+ConnectivityManager::ConnectivityManager(FileManager *fileManager, SettingsStore *settingsStore)
+    : fm(fileManager), settings(settingsStore)
 {
     // Khởi tạo
 }
 
-// Hàm nội bộ: Tải Credentials từ SD Card
-bool ConnectivityManager::loadCredentials(String &ssid, String &pass, String &ap_ssid, String &ap_pass)
+// Hàm nội bộ: Tải Credentials từ NVS
+bool ConnectivityManager::loadCredentials(String &ssid, String &pass)
 {
-    JsonDocument doc;
+    if (settings->getWifiCredentials(ssid, pass))
+    {
+        return ssid.length() > 0;
+    }
+
+    // NVS chưa có: chuyển thông tin từ wifi.json cũ (nếu có) sang NVS
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
     if (fm->loadJsonFile(CONFIG_FILE_PATH WIFI_CONFIG_FILE, &doc))
     {
         ssid = doc[STA_SSID_CONFIG_KEY] | "";
         pass = doc[STA_PWD_CONFIG_KEY] | "";
-        ap_ssid = doc[AP_SSID_CONFIG_KEY] | "Famio_Setup_AP";
-        ap_pass = doc[AP_PWD_CONFIG_KEY] | "12345678";
-        return ssid.length() > 0;
+        if (ssid.length() > 0)
+        {
+            saveCredentials(ssid, pass);
+            return true;
+        }
     }
     return false;
 }
 
-// Hàm nội bộ: Lưu Credentials vào SD Card
+// Hàm nội bộ: Tải cấu hình AP, mặc định nếu không có wifi.json hoặc không có thẻ SD
+void ConnectivityManager::loadApConfig(String &ap_ssid, String &ap_pass)
+{
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
+    ap_ssid = DEFAULT_AP_SSID;
+    ap_pass = DEFAULT_AP_PASS;
+    if (fm->loadJsonFile(CONFIG_FILE_PATH WIFI_CONFIG_FILE, &doc))
+    {
+        ap_ssid = doc[AP_SSID_CONFIG_KEY] | DEFAULT_AP_SSID;
+        ap_pass = doc[AP_PWD_CONFIG_KEY] | DEFAULT_AP_PASS;
+    }
+}
+
+// Hàm nội bộ: Lưu Credentials vào NVS (ghi ngay, thường đi kèm khởi động lại)
 bool ConnectivityManager::saveCredentials(const String &ssid, const String &pass)
 {
-    JsonDocument doc;
-    fm->loadJsonFile(CONFIG_FILE_PATH WIFI_CONFIG_FILE, &doc);
-    doc[STA_SSID_CONFIG_KEY] = ssid;
-    doc[STA_PWD_CONFIG_KEY] = pass;
-    return fm->saveJsonFile(CONFIG_FILE_PATH WIFI_CONFIG_FILE, doc);
+    return settings->setWifiCredentials(ssid, pass);
 }
 
 // Hàm nội bộ: Xóa Credentials
@@ -40,9 +60,9 @@ void ConnectivityManager::clearCredentials()
 // Hàm chính khởi tạo
 bool ConnectivityManager::begin()
 {
-    String saved_ssid, saved_pass, ap_ssid, ap_pass;
+    String saved_ssid, saved_pass;
 
-    if (loadCredentials(saved_ssid, saved_pass, ap_ssid, ap_pass))
+    if (loadCredentials(saved_ssid, saved_pass))
     {
         // --- PHA HOẠT ĐỘNG (OPERATIONAL PHASE) ---
         WiFi.mode(WIFI_STA);
@@ -53,21 +73,22 @@ bool ConnectivityManager::begin()
         long start_time = millis();
         while (WiFi.status() != WL_CONNECTED && (millis() - start_time < CONNECTION_TIMEOUT_S * 1000))
         {
-            delay(500);
-            Serial.print(".");
+            delay(CONNECTION_POLL_MS);
         }
 
         if (WiFi.status() == WL_CONNECTED)
         {
-            Serial.printf("\nSTA Connected. IP: %s\n", WiFi.localIP().toString().c_str());
+            Serial.printf("STA Connected sau %lu ms. IP: %s\n", millis() - start_time, WiFi.localIP().toString().c_str());
             operational_mode = true;
         }
         else
         {
             // Thất bại: Chuyển về chế độ cấu hình
-            Serial.println("\nSTA Connect FAILED/TIMEOUT. Entering Provisioning Mode.");
+            Serial.println("STA Connect FAILED/TIMEOUT. Entering Provisioning Mode.");
             clearCredentials(); // Xóa cấu hình sai để bắt đầu lại
             operational_mode = false;
+            settings->flush();
+            fm->flush();
             ESP.restart();
             // FALL-THROUGH để chạy Provisioning Mode
         }
@@ -77,6 +98,8 @@ bool ConnectivityManager::begin()
     {
         // --- PHA CẤU HÌNH (PROVISIONING PHASE) ---
         Serial.println("Starting Provisioning Mode (AP+STA)...");
+        String ap_ssid, ap_pass;
+        loadApConfig(ap_ssid, ap_pass);
         WiFi.mode(WIFI_AP_STA);
         if (!WiFi.softAP(ap_ssid, ap_pass))
         {
@@ -144,38 +167,55 @@ void ConnectivityManager::getScanResults(JsonArray &array)
     }
 }
 
-// API: Kiểm tra Credentials và lưu nếu thành công
-bool ConnectivityManager::checkAndSaveCredentials(const String &ssid, const String &pass)
+// API: Bắt đầu kiểm tra Credentials (Non-blocking)
+bool ConnectivityManager::startCredentialCheck(const String &ssid, const String &pass)
 {
     if (operational_mode)
         return false; // Chỉ thực hiện khi đang ở Provisioning
+    if (check_requested || check_state == CHECK_PENDING)
+        return false;
 
-    // 1. Cố gắng kết nối với Timeout 30s
-    WiFi.begin(ssid.c_str(), pass.c_str());
-
-    long start_time = millis();
-    bool connected = false;
+    check_ssid = ssid;
+    check_pass = pass;
+    check_state = CHECK_PENDING;
+    check_requested = true;
+    return true;
+}
 
-    while (millis() - start_time < CONNECTION_TIMEOUT_S * 1000)
+// Tiến hành kiểm tra Credentials, gọi từ loop()
+void ConnectivityManager::loop()
+{
+    if (check_requested)
     {
-        if (WiFi.status() == WL_CONNECTED)
-        {
-            connected = true;
-            break;
-        }
-        delay(500);
+        // 1. Cố gắng kết nối với Timeout 30s
+        check_requested = false;
+        WiFi.begin(check_ssid.c_str(), check_pass.c_str());
+        check_start = millis();
+        return;
     }
 
+    if (check_state != CHECK_PENDING)
+        return;
+
     // 2. Đánh giá kết quả
-    if (connected)
+    if (WiFi.status() == WL_CONNECTED)
     {
-        // Thành công: Lưu config và reset
-        saveCredentials(ssid, pass);
+        // Thành công: Lưu config
+        saveCredentials(check_ssid, check_pass);
         operational_mode = true;
-        // Lưu ý: Chúng ta không gọi ESP.restart() trong hàm này mà để AppWebServer xử lý phản hồi API và reset
+        check_state = CHECK_SUCCESS;
+        Serial.printf("Connect sussessfully to Wifi ssid: %s\n", check_ssid.c_str());
+        // Lưu ý: không gọi ESP.restart() ở đây, UI sẽ gọi /api/system/reset sau khi nhận kết quả
+    }
+    else if (millis() - check_start >= CONNECTION_TIMEOUT_S * 1000)
+    {
+        check_state = CHECK_FAILED;
+    }
+    else
+    {
+        return;
     }
     WiFi.mode(WIFI_AP_STA); // Đảm bảo AP+STA vẫn chạy
-    return connected;
 }
 
 // API: Buộc đưa thiết bị về chế độ cấu hình
@@ -183,6 +223,8 @@ void ConnectivityManager::resetToProvisioning()
 {
     Serial.println("Manual reset to Provisioning from API. Restarting device...");
     clearCredentials();
+    settings->flush();
+    fm->flush();   // Ghi cấu hình đang chờ trước khi khởi động lại
     ESP.restart(); // Reset sẽ tự động đưa về Provisioning Mode
 }
 
@@ -190,5 +232,7 @@ void ConnectivityManager::resetToProvisioning()
 void ConnectivityManager::manualReset()
 {
     Serial.println("Manual reset triggered from API. Restarting device...");
+    settings->flush();
+    fm->flush(); // Ghi cấu hình đang chờ trước khi khởi động lại
     ESP.restart();
 }
\ No newline at end of file
@@ -1,44 +1,117 @@
 #include "FMRadio.h"
+#include "Trace.h"
 
 // =========================================================
 // Constructor
 // =========================================================
-FMRadio::FMRadio(FileManager *fm)
-    : fileManager(fm), currentFreq(99.5f), isPowered(false), rssi(0), currentVolume(10), numSavedChannels(0)
+FMRadio::FMRadio(FileManager *fm, SettingsStore *settingsStore)
+    : fileManager(fm), settings(settingsStore), currentFreq(99.5f), isPowered(false), lastSample(0), i2cTransactions(0), currentVolume(10)
 {
-    // Constructor body (rx object initialized by default)
+    // Channel edits are small and frequent: keep fm.json as an append-only log
+    fileManager->useRecordLog(FM_CONFIG_FILE);
 }
 
 // =========================================================
 // Initialization
 // =========================================================
-void FMRadio::begin()
+void FMRadio::begin(bool silent)
 {
-    // 1. Load configuration from SD Card
-    loadConfig();
+    if (isPowered)
+        return;
+    uint32_t start = millis();
+
+    // Warm: the chip kept its configuration through powerDown(), only wake it
+    // up and retune. Cold (first start, or the chip did not answer): full setup
+    bool warm = chipConfigured && resume(silent);
+    if (!warm)
+        coldStart(silent);
+    isPowered = true;
+    sample(true);
+
+    uint32_t elapsed = millis() - start;
+    lastStartWarm = warm;
+    if (warm)
+    {
+        warmStarts++;
+        lastWarmMs = elapsed;
+    }
+    else
+    {
+        coldStarts++;
+        lastColdMs = elapsed;
+    }
+    Serial.printf("FMRadio: %s start, audio after %u ms.\n", warm ? "Warm" : "Cold", (unsigned)elapsed);
+}
+
+void FMRadio::coldStart(bool silent)
+{
+    TRACE_SCOPE(TRACE_I2C, "fm.coldStart");
+    // 1. Load configuration (NVS + SD Card), once: afterwards RAM is newer than the card
+    if (!configLoaded)
+    {
+        loadConfig();
+        configLoaded = true;
+    }
 
     // 2. Initialize RDA5807 chip using library
     // Note: Wire.begin() is already called in setup(), so I2C bus is ready
     rx.setup();
-    delay(100);
 
-    // 4. Configure band and spacing
+    // 3. Configure band and spacing
     rx.setBand(RDA5807_BAND);
     rx.setSpace(RDA5807_SPACE);
 
-    // 5. Set volume
-    rx.setVolume(currentVolume);
+    // 4. Set volume
+    rx.setVolume(silent ? 0 : currentVolume);
     rx.setMono(false);
     rx.setGpio(3,1);
+    rx.setRDS(true);
+    i2cTransactions += 7; // setup() to setRDS(); not timed, the library delays inside setup()
 
+    // 5. Set loaded frequency and wait until the chip reports it tuned
+    // (instead of fixed delays for the chip to stabilize)
+    setFrequency(currentFreq);
+    if (!waitTuned())
+        Serial.println("FMRadio: Chip did not report the tune complete.");
+    chipConfigured = true;
+}
 
-    // 6. Wait for chip to stabilize
-    delay(500);
+bool FMRadio::resume(bool silent)
+{
+    TRACE_SCOPE(TRACE_I2C, "fm.resume");
+    // Band and spacing stay in the chip's registers while it is powered down,
+    // but powerUp() rewrites REG02/REG05 with the library defaults (mono, RDS
+    // off, volume 0): set those again, then retune (enabling drops the tune)
+    // and wait for STC. The volume left by a fade-out is restored here unless
+    // the caller fades in
+    uint32_t i2cStart = micros();
+    rx.powerUp();
+    rx.setVolume(silent ? 0 : currentVolume);
+    rx.setMono(false);
+    rx.setRDS(true);
+    rx.setFrequency((uint16_t)lroundf(currentFreq * 100));
+    countI2c(i2cStart, 6); // powerUp() writes two registers
+    rds.reset();
+    if (waitTuned())
+        return true;
+    warmFallbacks++;
+    Serial.println("FMRadio: Warm start failed, doing a full setup.");
+    return false;
+}
 
-    // 7. Set loaded frequency
-    setFrequency(currentFreq);
-    isPowered = true;
-    Serial.println("FMRadio: RDA5807 chip initialized successfully.");
+// Polls STC (0x0A bit 14) instead of sleeping; false after FM_READY_TIMEOUT_MS
+bool FMRadio::waitTuned()
+{
+    uint32_t start = millis();
+    for (;;)
+    {
+        uint16_t regs[RDA5807_STATUS_REGS];
+        if (readStatusRegisters(regs) && (regs[0] & 0x4000))
+            return true;
+        if (millis() - start >= FM_READY_TIMEOUT_MS)
+            return false;
+        delay(FM_READY_POLL_MS);
+    }
 }
 
 // =========================================================
@@ -46,54 +119,29 @@ void FMRadio::begin()
 // =========================================================
 void FMRadio::setFrequency(float freq_mhz)
 {
+    TRACE_SCOPE(TRACE_I2C, "fm.setFrequency");
     // Convert MHz to library format (frequency in 10 kHz units)
     // Example: 99.5 MHz = 9950 in library format (99.5 * 100)
     uint16_t freq_code = (uint16_t)(freq_mhz * 100);
 
+    uint32_t i2cStart = micros();
     rx.setFrequency(freq_code);
+    countI2c(i2cStart, 1);
+    rds.reset();
     currentFreq = freq_mhz;
-    saveConfig();
+    settings->setFmFrequency(freq_mhz);
     Serial.printf("FMRadio: Frequency set to %.1f MHz\n", freq_mhz);
 }
 
-// =========================================================
-// Seek/Tuning
-// =========================================================
-void FMRadio::seekUp()
-{
-    Serial.println("FMRadio: Seeking up...");
-    // RDA5807 library seek function
-    // RDA_SEEK_WRAP: wrap around at band edges
-    // RDA_SEEK_UP: seek upward
-    rx.seek(RDA_SEEK_WRAP, RDA_SEEK_UP);
-    // Get the new frequency from chip (in 10 kHz units)
-    uint16_t freq_code = rx.getRealFrequency();
-    currentFreq = freq_code / 100.0f;
-    Serial.printf("FMRadio: Seek up complete. New frequency: %.1f MHz\n", currentFreq);
-}
-
-void FMRadio::seekDown()
-{
-    Serial.println("FMRadio: Seeking down...");
-    rx.seek(RDA_SEEK_WRAP, RDA_SEEK_DOWN);
-    uint16_t freq_code = rx.getRealFrequency();
-    currentFreq = freq_code / 100.0f;
-    Serial.printf("FMRadio: Seek down complete. New frequency: %.1f MHz\n", currentFreq);
-}
-
-float FMRadio::autoSeekNext()
-{
-    seekUp();
-    Serial.printf("FMRadio: Auto seek completed. New frequency: %.1f MHz\n", currentFreq);
-    return currentFreq;
-}
-
 // =========================================================
 // Stereo/Mono Control
 // =========================================================
 void FMRadio::setStereo(bool enable)
 {
+    TRACE_SCOPE(TRACE_I2C, "fm.setStereo");
+    uint32_t i2cStart = micros();
     rx.setMono(!enable); // setMono(true) = mono, setMono(false) = stereo
+    countI2c(i2cStart, 1);
     Serial.printf("FMRadio: Stereo mode set to %s\n", enable ? "ON" : "OFF");
 }
 
@@ -110,10 +158,15 @@ void FMRadio::powerOn()
 
 void FMRadio::powerOff()
 {
+    TRACE_SCOPE(TRACE_I2C, "fm.powerOff");
     // Disable receiver or put into low power mode
+    uint32_t i2cStart = micros();
     rx.powerDown();
+    countI2c(i2cStart, 1);
+    rds.reset();
     Serial.println("FMRadio: Power OFF");
     isPowered = false;
+    publishTuner(TunerStatus());
 }
 
 // =========================================================
@@ -121,98 +174,273 @@ void FMRadio::powerOff()
 // =========================================================
 void FMRadio::setVolume(uint8_t volume)
 {
+    TRACE_SCOPE(TRACE_I2C, "fm.setVolume");
     if (volume > 15)
         volume = 15;
     if (volume == currentVolume)
         return;
 
     currentVolume = volume;
+    uint32_t i2cStart = micros();
     rx.setVolume(volume);
-    saveConfig(); // Save volume to SD card
+    countI2c(i2cStart, 1);
+    settings->setFmVolume(volume); // Written to NVS by the storage task
     Serial.printf("FMRadio: Volume set to %d\n", currentVolume);
 }
 
+void FMRadio::setOutputLevel(uint8_t level)
+{
+    TRACE_SCOPE(TRACE_I2C, "fm.setOutputLevel");
+    if (!isPowered)
+        return;
+    uint32_t i2cStart = micros();
+    rx.setVolume(level > 15 ? 15 : level);
+    countI2c(i2cStart, 1);
+}
+
 // =========================================================
 // Configuration Management
 // =========================================================
 void FMRadio::loadConfig()
 {
-    JsonDocument doc;
+    // 1. Volume and last frequency come from NVS: available without the SD card
+    bool fromNvs = settings->hasFmState();
+    if (fromNvs)
+    {
+        currentVolume = settings->getFmVolume();
+        currentFreq = settings->getFmFrequency();
+    }
 
-    // Try to load fm.json from SD Card
+    // 2. Saved stations stay on the SD card
+    stations.begin();
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
     if (fileManager->loadJsonFile(FM_CONFIG_FILE, &doc))
     {
-        // 1. Load volume
-        currentVolume = doc["volume"] | 10;
-        if (currentVolume > 15)
-            currentVolume = 15;
-
-        // 2. Load current frequency
-        currentFreq = doc["current_freq"] | 99.5f;
-
-        // 3. Load saved channels
-        JsonArray channels = doc["channels"].as<JsonArray>();
-        numSavedChannels = 0;
-
-        for (JsonObject channel : channels)
+        if (!fromNvs)
         {
-            if (numSavedChannels < MAX_CHANNELS)
-            {
-                float freq = channel["freq"] | 0.0f;
-                if (freq >= 87.0f && freq <= 108.0f)
-                {
-                    savedChannels[numSavedChannels] = freq;
-                    numSavedChannels++;
-                }
-            }
+            // Older fm.json still holds volume/frequency: move them to NVS
+            currentVolume = doc["volume"] | 10;
+            currentFreq = doc["current_freq"] | 99.5f;
         }
-        Serial.printf("FMRadio: Config loaded. Vol: %d, Channels: %d\n", currentVolume, numSavedChannels);
     }
     else
     {
-        // Initialize defaults if load fails
-        Serial.println("FMRadio: Config not found. Using defaults.");
-        currentVolume = 10;
+        Serial.println("FMRadio: Channel list not found.");
+        doc.clear();
+    }
+    stations.fromJson(doc);
+
+    if (currentVolume > 15)
+        currentVolume = 15;
+    if (currentFreq < 87.0f || currentFreq > 108.0f)
         currentFreq = 99.5f;
-        numSavedChannels = 0;
-        saveConfig();
+    if (!fromNvs)
+    {
+        settings->setFmVolume(currentVolume);
+        settings->setFmFrequency(currentFreq);
     }
+    Serial.printf("FMRadio: Config loaded. Vol: %d, Freq: %.1f MHz, Channels: %d\n", currentVolume, currentFreq, stations.count());
 }
 
 void FMRadio::saveConfig()
 {
-    JsonDocument doc;
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
 
-    doc["volume"] = currentVolume;
-    doc["current_freq"] = currentFreq;
+    // One key per station: the record log only appends the stations that changed.
+    // The lock keeps snapshots from the control task and the web server in order
+    stations.lock();
+    stations.toJson(doc);
+    bool saved = fileManager->saveJsonFile(FM_CONFIG_FILE, doc);
+    stations.unlock();
 
-    JsonArray channels = doc["channels"].as<JsonArray>();
-    for (int i = 0; i < numSavedChannels; i++)
+    if (saved)
     {
-        JsonObject channel = channels.add<JsonObject>();
-        channel["freq"] = savedChannels[i];
-    }
-
-    if (fileManager->saveJsonFile(FM_CONFIG_FILE, doc))
-    {
-        Serial.println("FMRadio: Config saved successfully.");
+        Serial.println("FMRadio: Channels saved successfully.");
     }
     else
     {
-        Serial.println("FMRadio: Failed to save config.");
+        Serial.println("FMRadio: Failed to save channels.");
     }
 }
 
 // =========================================================
-// Status & Information
+// Band Scan
 // =========================================================
-void FMRadio::updateStatus()
+void FMRadio::beginScan()
+{
+    TRACE_SCOPE(TRACE_I2C, "fm.beginScan");
+    uint32_t i2cStart = micros();
+    rx.setMute(true);
+    countI2c(i2cStart, 1);
+}
+
+void FMRadio::tuneScan(uint16_t freq10k)
+{
+    TRACE_SCOPE(TRACE_I2C, "fm.tuneScan");
+    // currentFreq and the NVS copy keep pointing at the station being listened to
+    uint32_t i2cStart = micros();
+    rx.setFrequency(freq10k);
+    countI2c(i2cStart, 1);
+}
+
+void FMRadio::readSignal(uint8_t &rssiOut, bool &stereoOut, bool &stationOut)
+{
+    // One burst instead of getRssi() + isStereo()
+    uint16_t regs[RDA5807_STATUS_REGS];
+    if (!readStatusRegisters(regs))
+    {
+        rssiOut = 0;
+        stereoOut = false;
+        stationOut = false;
+        return;
+    }
+    rssiOut = (regs[1] >> 9) & 0x7F;
+    stereoOut = (regs[0] >> 10) & 0x01;
+    stationOut = (regs[1] >> 8) & 0x01;
+}
+
+void FMRadio::endScan()
 {
+    TRACE_SCOPE(TRACE_I2C, "fm.endScan");
     if (!isPowered)
         return;
+    uint32_t i2cStart = micros();
+    rx.setFrequency((uint16_t)lroundf(currentFreq * 100));
+    rx.setMute(false);
+    countI2c(i2cStart, 2);
+    rds.reset();
+    sample(true);
+}
 
-    // Get RSSI (signal strength) from chip
-    rssi = rx.getRssi(); // 0-63 scale
+void FMRadio::endSeek(uint16_t freq10k)
+{
+    TRACE_SCOPE(TRACE_I2C, "fm.endSeek");
+    if (!isPowered)
+        return;
+    // The chip is already on the station: no retune
+    currentFreq = freq10k / 100.0f;
+    settings->setFmFrequency(currentFreq);
+    rds.reset();
+    uint32_t i2cStart = micros();
+    rx.setMute(false);
+    countI2c(i2cStart, 1);
+    sample(true);
+    Serial.printf("FMRadio: Seek complete. New frequency: %.1f MHz\n", currentFreq);
+}
+
+// =========================================================
+// Telemetry sampler
+// =========================================================
+// One sequential read of 0x0A-0x0F instead of a library call per register
+bool FMRadio::readStatusRegisters(uint16_t regs[RDA5807_STATUS_REGS])
+{
+    TRACE_SCOPE(TRACE_I2C, "fm.readStatusRegisters");
+    uint8_t length = RDA5807_STATUS_REGS * 2;
+    uint32_t i2cStart = micros();
+    bool received = Wire.requestFrom((uint8_t)RDA5807_I2C_SEQUENTIAL, length) == length;
+    countI2c(i2cStart, 1);
+    if (!received)
+        return false;
+    for (uint8_t i = 0; i < RDA5807_STATUS_REGS; i++)
+    {
+        uint8_t high = Wire.read();
+        regs[i] = (high << 8) | (uint8_t)Wire.read();
+    }
+    return true;
+}
+
+// Latency is per transaction: a batch of calls is split evenly
+void FMRadio::countI2c(uint32_t startUs, uint8_t transactions)
+{
+    i2cTransactions += transactions;
+    uint32_t each = (micros() - startUs) / transactions;
+    for (uint8_t i = 0; i < transactions; i++)
+        i2cLatency.observe(each);
+}
+
+void FMRadio::writeMetrics(MetricsWriter &out)
+{
+    out.family("famio_i2c_transactions_total", "counter", "I2C transactions issued to the RDA5807.");
+    out.sample("famio_i2c_transactions_total", nullptr, i2cTransactions);
+    out.family("famio_i2c_transaction_duration_seconds", "histogram", "Time of one RDA5807 I2C transaction.");
+    out.histogram("famio_i2c_transaction_duration_seconds", nullptr, i2cLatency);
+    out.family("famio_fm_rssi", "gauge", "RSSI of the tuned station (0 when the radio is off).");
+    out.sample("famio_fm_rssi", nullptr, isPowered ? getRssi() : 0);
+}
+
+uint32_t FMRadio::msUntilSample() const
+{
+    uint32_t waited = millis() - lastSample;
+    return waited >= FM_SAMPLE_MS ? 0 : FM_SAMPLE_MS - waited;
+}
+
+void FMRadio::publishTuner(const TunerStatus &status)
+{
+    portENTER_CRITICAL(&tunerLock);
+    tuner = status;
+    portEXIT_CRITICAL(&tunerLock);
+}
+
+void FMRadio::getTunerStatus(TunerStatus &out)
+{
+    portENTER_CRITICAL(&tunerLock);
+    out = tuner;
+    portEXIT_CRITICAL(&tunerLock);
+}
+
+int FMRadio::getRssi()
+{
+    TunerStatus status;
+    getTunerStatus(status);
+    return status.rssi;
+}
+
+bool FMRadio::getStereo()
+{
+    TunerStatus status;
+    getTunerStatus(status);
+    return status.stereo;
+}
+
+void FMRadio::sample(bool force)
+{
+    history.advance(millis());
+    if (!isPowered || (!force && msUntilSample() > 0))
+        return;
+    lastSample = millis();
+
+    uint16_t regs[RDA5807_STATUS_REGS];
+    if (!readStatusRegisters(regs))
+        return;
+
+    // 0x0A: bit 10 ST, bits 9:0 READCHAN. 0x0B: bits 15:9 RSSI, bit 8 FM_TRUE
+    TunerStatus status;
+    status.freq10k = RDA5807_BAND_BOTTOM + (regs[0] & 0x03FF) * RDA5807_STEP_10K;
+    status.rssi = (regs[1] >> 9) & 0x7F;
+    status.stereo = (regs[0] >> 10) & 0x01;
+    status.station = (regs[1] >> 8) & 0x01;
+    status.sampledAt = lastSample;
+    publishTuner(status);
+    history.add(lastSample, status.rssi, status.stereo);
+
+    // 0x0A bit 15 RDSR: a new group is ready, bit 12 RDSS: decoder synchronized
+    if ((regs[0] & 0x8000) && (regs[0] & 0x1000))
+    {
+        // 0x0B bits 3:2 BLERA, 1:0 BLERB. The chip has no levels for C and D:
+        // they get B's, which is the best indication of how the group went
+        RdsGroup group;
+        uint8_t blerA = (regs[1] >> 2) & 0x03;
+        uint8_t blerB = regs[1] & 0x03;
+        for (uint8_t i = 0; i < 4; i++)
+        {
+            group.block[i] = regs[2 + i];
+            group.bler[i] = i == 0 ? blerA : blerB;
+        }
+        rds.push(group);
+    }
+    rds.process();
 }
 
 void FMRadio::getStatus(JsonDocument *doc)
@@ -223,12 +451,35 @@ void FMRadio::getStatus(JsonDocument *doc)
         return;
     }
 
-    updateStatus();
     (*doc)["freq"] = currentFreq;
-    (*doc)["rssi"] = rssi;
-    (*doc)["stereo"] = rx.isStereo(); // Use isStereo() instead of getStereoIndicator()
+    TunerStatus status;
+    getTunerStatus(status);
+    (*doc)["rssi"] = status.rssi;
+    (*doc)["stereo"] = status.stereo;
+    (*doc)["station"] = status.station;
+    (*doc)["sample_age_ms"] = millis() - status.sampledAt;
     (*doc)["isPowered"] = isPowered;
     (*doc)["volume"] = currentVolume;
+    // Time from power-on to audio
+    JsonObject startup = (*doc)["startup"].to<JsonObject>();
+    startup["last"] = lastStartWarm ? "warm" : "cold";
+    startup["cold_ms"] = lastColdMs;
+    startup["warm_ms"] = lastWarmMs;
+    startup["cold"] = coldStarts;
+    startup["warm"] = warmStarts;
+    startup["warm_failed"] = warmFallbacks;
+
+    RdsInfo info;
+    rds.getInfo(info);
+    if (info.pi != 0)
+    {
+        JsonObject summary = (*doc)["rds"].to<JsonObject>();
+        summary["pty"] = info.pty;
+        if (info.hasPs)
+            summary["ps"] = info.ps;
+        if (info.hasRt)
+            summary["rt"] = info.rt;
+    }
 }
 
 // =========================================================
@@ -236,60 +487,85 @@ void FMRadio::getStatus(JsonDocument *doc)
 // =========================================================
 void FMRadio::saveChannel(float freq_mhz)
 {
-    if (numSavedChannels >= MAX_CHANNELS)
+    uint16_t freq10k = (uint16_t)lroundf(freq_mhz * 100);
+    uint8_t level = (freq10k == (uint16_t)lroundf(currentFreq * 100)) ? getRssi() : 0;
+    bool created = false;
+    if (!stations.add(freq10k, level, &created))
     {
         Serial.println("FMRadio: Channel limit reached.");
         return;
     }
+    if (!created)
+    {
+        Serial.printf("FMRadio: %.1f MHz is already saved.\n", freq_mhz);
+        return;
+    }
 
-    savedChannels[numSavedChannels] = freq_mhz;
-    numSavedChannels++;
-
-    Serial.printf("FMRadio: Channel saved - %.1f MHz at index %d\n", freq_mhz, numSavedChannels - 1);
+    Serial.printf("FMRadio: Channel saved - %.1f MHz, %d channels\n", freq_mhz, stations.count());
     saveConfig();
 }
 
-void FMRadio::selectSavedChannel(uint8_t index)
+void FMRadio::selectSavedChannel(uint16_t index)
 {
-    if (index >= numSavedChannels)
+    float savedFreq = getSavedChannel(index);
+    if (savedFreq == 0)
     {
         Serial.println("FMRadio: Invalid channel index.");
         return;
     }
 
-    float savedFreq = savedChannels[index];
     Serial.printf("FMRadio: Selecting channel at index %d: %.1f MHz\n", index, savedFreq);
-    setFrequency(savedFreq);
-    saveConfig();
+    setFrequency(savedFreq); // setFrequency() already stores the frequency
 }
 
-void FMRadio::getSavedChannels(JsonDocument *doc)
+void FMRadio::getSavedChannels(JsonDocument *doc, uint16_t offset, uint16_t limit, bool byFrequency, bool favoritesOnly)
 {
-    JsonArray channels = (*doc)["channels"].as<JsonArray>();
+    JsonArray channels = (*doc)["channels"].to<JsonArray>();
+    uint16_t total = stations.page(channels, offset, limit, byFrequency, favoritesOnly);
+    (*doc)["total"] = total;
+    (*doc)["offset"] = offset;
+    (*doc)["limit"] = limit;
+}
 
-    for (int i = 0; i < numSavedChannels; i++)
-    {
-        JsonObject channel = channels.add<JsonObject>();
-        channel["index"] = i;
-        channel["freq"] = savedChannels[i];
-    }
+float FMRadio::getSavedChannel(uint16_t index)
+{
+    return stations.frequencyAt(index) / 100.0f;
 }
 
-void FMRadio::deleteChannel(uint8_t index)
+void FMRadio::deleteChannel(uint16_t index)
 {
-    if (index >= numSavedChannels)
+    uint16_t freq10k = stations.frequencyAt(index);
+    if (freq10k == 0)
     {
         Serial.println("FMRadio: Invalid channel index to delete.");
         return;
     }
+    deleteStation(freq10k);
+}
 
-    // Shift remaining channels
-    for (int i = index; i < numSavedChannels - 1; i++)
+void FMRadio::deleteStation(uint16_t freq10k)
+{
+    if (!stations.remove(freq10k))
     {
-        savedChannels[i] = savedChannels[i + 1];
+        Serial.println("FMRadio: No saved channel at that frequency.");
+        return;
     }
 
-    numSavedChannels--;
-    Serial.printf("FMRadio: Channel deleted. Remaining: %d\n", numSavedChannels);
+    Serial.printf("FMRadio: Channel deleted. Remaining: %d\n", stations.count());
+    saveConfig();
+}
+
+bool FMRadio::editStation(uint16_t freq10k, const char *name, int favorite, int position)
+{
+    if (!stations.edit(freq10k, name, favorite, position))
+        return false;
+    saveConfig();
+    return true;
+}
+
+void FMRadio::autostoreChannels(const uint16_t *freq10k, const uint8_t *rssiLevels, uint8_t count)
+{
+    stations.replaceUnfavorites(freq10k, rssiLevels, count);
+    Serial.printf("FMRadio: Auto-store found %d stations, %d channels saved\n", count, stations.count());
     saveConfig();
 }
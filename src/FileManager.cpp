@@ -1,5 +1,6 @@
 #include "FileManager.h"
 #include "Constants.h"
+#include "Trace.h"
 
 // =========================================================
 // Hàm Helper: Nối đường dẫn thư mục gốc
@@ -15,12 +16,38 @@ String getFullPath(const char *path)
     return String(PROJECT_ROOT_DIR) + "/" + String(path);
 }
 
+FileManager::FileManager()
+{
+    cacheLock = xSemaphoreCreateMutex();
+    logLock = xSemaphoreCreateMutex();
+    bundleLock = xSemaphoreCreateMutex();
+}
+
+void FileManager::useRecordLog(const char *path)
+{
+    if (logCount >= MAX_RECORD_LOGS || findLog(path) >= 0)
+    {
+        return;
+    }
+
+    // /config/fm.json -> /famio/config/fm.log
+    String logPath = getFullPath(path);
+    if (logPath.endsWith(".json"))
+    {
+        logPath = logPath.substring(0, logPath.length() - 5);
+    }
+    logs[logCount].path = path;
+    logs[logCount].log.begin(logPath + ".log");
+    logCount++;
+}
+
 // =========================================================
 // Khởi tạo SD Card
 // =========================================================
 
 bool FileManager::begin()
 {
+    TRACE_SCOPE(TRACE_SD, "sd.mount");
     Serial.print("Đang khởi tạo SD Card...");
     // Khởi tạo với Pin CS được định nghĩa (SD_CS_PIN)
     if (!SD.begin(SD_CS_PIN))
@@ -42,6 +69,7 @@ bool FileManager::begin()
     Serial.printf("Thành công! Loại thẻ: %d\n", cardType);
     Serial.printf("Kích thước thẻ: %.2f GB\n", SD.cardSize() / (1024.0 * 1024.0 * 1024.0));
     sd_initialized = true;
+    openBundle();
     return true;
 }
 
@@ -57,9 +85,36 @@ bool FileManager::loadJsonFile(const char *path, JsonDocument *doc)
         return false;
     }
 
+    // Bản trong cache mới hơn (hoặc bằng) bản trên SD
+    xSemaphoreTake(cacheLock, portMAX_DELAY);
+    int index = findEntry(path);
+    if (index >= 0)
+    {
+        DeserializationError error = deserializeJson(*doc, cache[index].content);
+        xSemaphoreGive(cacheLock);
+        if (!error)
+        {
+            return true;
+        }
+        doc->clear();
+        return false;
+    }
+    xSemaphoreGive(cacheLock);
+
+    int logIndex = findLog(path);
+    if (logIndex >= 0)
+    {
+        return loadFromLog(logIndex, path, doc);
+    }
+
     // SỬ DỤNG HÀM HELPER ĐỂ CÓ ĐƯỜNG DẪN ĐẦY ĐỦ: /famio/config.json
-    String fullPath = getFullPath(path);
+    return readJsonFile(getFullPath(path), doc);
+}
 
+bool FileManager::readJsonFile(const String &fullPath, JsonDocument *doc)
+{
+    TRACE_SCOPE(TRACE_SD, "sd.readJson");
+    uint32_t start = micros();
     File file = SD.open(fullPath.c_str());
     if (!file)
     {
@@ -68,8 +123,11 @@ bool FileManager::loadJsonFile(const char *path, JsonDocument *doc)
     }
 
     // ... (Phần deserializeJson và xử lý lỗi giữ nguyên) ...
+    size_t size = file.size();
     DeserializationError error = deserializeJson(*doc, file);
     file.close();
+    sdReadLatency.observe(micros() - start);
+    sdBytesRead.fetch_add(size, std::memory_order_relaxed);
 
     if (error)
     {
@@ -82,9 +140,21 @@ bool FileManager::loadJsonFile(const char *path, JsonDocument *doc)
 }
 
 // =========================================================
-// Lưu file JSON
+// Lưu file JSON (write-behind)
 // =========================================================
 
+int FileManager::findEntry(const char *path)
+{
+    for (int i = 0; i < MAX_CACHED_FILES; i++)
+    {
+        if (cache[i].used && cache[i].path == path)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
 bool FileManager::saveJsonFile(const char *path, const JsonDocument &doc)
 {
     if (!sd_initialized)
@@ -93,27 +163,294 @@ bool FileManager::saveJsonFile(const char *path, const JsonDocument &doc)
         return false;
     }
 
-    // SỬ DỤNG HÀM HELPER ĐỂ CÓ ĐƯỜNG DẪN ĐẦY ĐỦ: /famio/ui/config
-    String fullPath = getFullPath(path);
+    String content;
+    serializeJson(doc, content);
+    uint32_t now = millis();
+
+    xSemaphoreTake(cacheLock, portMAX_DELAY);
+    saveCount++;
+    int index = findEntry(path);
+    if (index < 0)
+    {
+        // Lấy ô trống, nếu không có thì thay một file đã ghi xong
+        for (int i = 0; i < MAX_CACHED_FILES && index < 0; i++)
+        {
+            if (!cache[i].used)
+                index = i;
+        }
+        for (int i = 0; i < MAX_CACHED_FILES && index < 0; i++)
+        {
+            if (!cache[i].dirty)
+                index = i;
+        }
+        if (index < 0)
+        {
+            // Cache đầy file chưa ghi: ghi thẳng xuống SD
+            xSemaphoreGive(cacheLock);
+            return persist(path, content);
+        }
+        cache[index].used = true;
+        cache[index].dirty = false;
+        cache[index].path = path;
+    }
+    else if (cache[index].content == content)
+    {
+        // Nội dung không đổi: không cần ghi
+        writesAvoided++;
+        xSemaphoreGive(cacheLock);
+        return true;
+    }
+
+    CacheEntry &entry = cache[index];
+    if (entry.dirty)
+    {
+        // Gộp với lần lưu trước còn chưa ghi
+        writesAvoided++;
+    }
+    else
+    {
+        entry.dirty = true;
+        entry.firstDirtyMs = now;
+    }
+    entry.content = content;
+    entry.version++;
+    entry.lastSaveMs = now;
+    xSemaphoreGive(cacheLock);
+    return true;
+}
+
+bool FileManager::writeFile(const String &fullPath, const String &content)
+{
+    TRACE_SCOPE_NAMED(trace, TRACE_SD, "sd.write");
+    TRACE_SET_ARG(trace, content.length());
+    uint32_t start = micros();
+    bool ok = false;
 
     File file = SD.open(fullPath.c_str(), FILE_WRITE);
     if (!file)
     {
         Serial.printf("Lỗi: Không thể mở file để ghi: %s\n", fullPath.c_str());
-        return false;
+    }
+    else
+    {
+        ok = file.write((const uint8_t *)content.c_str(), content.length()) == content.length();
+        file.close();
+        if (!ok)
+        {
+            Serial.printf("Lỗi: Ghi file JSON thất bại: %s\n", fullPath.c_str());
+        }
     }
 
-    // ... (Phần serializeJson và xử lý lỗi giữ nguyên) ...
+    uint32_t elapsed = micros() - start;
+    sdWriteLatency.observe(elapsed);
+    if (ok)
+        sdBytesWritten.fetch_add(content.length(), std::memory_order_relaxed);
+    recordFlush(elapsed, ok);
+    return ok;
+}
 
-    if (serializeJson(doc, file) == 0)
+void FileManager::recordFlush(uint32_t elapsedUs, bool ok)
+{
+    xSemaphoreTake(cacheLock, portMAX_DELAY);
+    sdWrites++;
+    if (!ok)
+        sdWriteErrors++;
+    lastFlushUs = elapsedUs;
+    totalFlushUs += elapsedUs;
+    if (elapsedUs > maxFlushUs)
+        maxFlushUs = elapsedUs;
+    xSemaphoreGive(cacheLock);
+}
+
+bool FileManager::persist(const String &path, const String &content)
+{
+    int logIndex = findLog(path.c_str());
+    if (logIndex >= 0)
+    {
+        return saveToLog(logIndex, content);
+    }
+    return writeFile(getFullPath(path.c_str()), content);
+}
+
+bool FileManager::flushEntry(int index)
+{
+    // Chép nội dung ra rồi mới ghi SD, để không giữ khóa trong lúc ghi
+    xSemaphoreTake(cacheLock, portMAX_DELAY);
+    if (!cache[index].dirty)
+    {
+        xSemaphoreGive(cacheLock);
+        return true;
+    }
+    String path = cache[index].path;
+    String content = cache[index].content;
+    uint32_t version = cache[index].version;
+    xSemaphoreGive(cacheLock);
+
+    bool ok = persist(path, content);
+
+    xSemaphoreTake(cacheLock, portMAX_DELAY);
+    // Nếu trong lúc ghi có bản mới hơn thì giữ trạng thái chưa ghi
+    if (ok && cache[index].version == version)
+    {
+        cache[index].dirty = false;
+    }
+    xSemaphoreGive(cacheLock);
+    return ok;
+}
+
+void FileManager::flushDue()
+{
+    uint32_t now = millis();
+    for (int i = 0; i < MAX_CACHED_FILES; i++)
+    {
+        xSemaphoreTake(cacheLock, portMAX_DELAY);
+        bool due = cache[i].dirty &&
+                   (now - cache[i].lastSaveMs >= WRITE_BEHIND_DELAY_MS ||
+                    now - cache[i].firstDirtyMs >= WRITE_BEHIND_MAX_AGE_MS);
+        xSemaphoreGive(cacheLock);
+        if (due)
+        {
+            flushEntry(i);
+        }
+    }
+}
+
+void FileManager::flush()
+{
+    for (int i = 0; i < MAX_CACHED_FILES; i++)
+    {
+        flushEntry(i);
+    }
+}
+
+void FileManager::getStats(JsonDocument &doc)
+{
+    xSemaphoreTake(cacheLock, portMAX_DELAY);
+    uint8_t cached = 0;
+    uint8_t dirty = 0;
+    for (int i = 0; i < MAX_CACHED_FILES; i++)
+    {
+        if (cache[i].used)
+            cached++;
+        if (cache[i].dirty)
+            dirty++;
+    }
+    doc["saves"] = saveCount;
+    doc["writes_avoided"] = writesAvoided;
+    doc["sd_writes"] = sdWrites;
+    doc["sd_write_errors"] = sdWriteErrors;
+    doc["cached_files"] = cached;
+    doc["dirty_files"] = dirty;
+    doc["last_flush_us"] = lastFlushUs;
+    doc["max_flush_us"] = maxFlushUs;
+    doc["avg_flush_us"] = sdWrites ? (uint32_t)(totalFlushUs / sdWrites) : 0;
+    xSemaphoreGive(cacheLock);
+
+    xSemaphoreTake(bundleLock, portMAX_DELAY);
+    doc["bundle_files"] = bundleCount;
+    doc["bundle_reads"] = bundleReads;
+    xSemaphoreGive(bundleLock);
+
+    // write_amplification = byte ghi thật / byte nếu ghi lại cả file mỗi lần (< 1 là tiết kiệm)
+    JsonArray logArray = doc["logs"].to<JsonArray>();
+    xSemaphoreTake(logLock, portMAX_DELAY);
+    for (uint8_t i = 0; i < logCount; i++)
+    {
+        const RecordLogStats &stats = logs[i].log.getStats();
+        JsonObject entry = logArray.add<JsonObject>();
+        entry["path"] = logs[i].log.getPath();
+        entry["appends"] = stats.appends;
+        entry["compactions"] = stats.compactions;
+        entry["corrupt_loads"] = stats.corruptLoads;
+        entry["bytes_written"] = stats.bytesWritten;
+        entry["logical_bytes"] = stats.logicalBytes;
+        entry["write_amplification"] = stats.logicalBytes ? roundf(100.0f * stats.bytesWritten / stats.logicalBytes) / 100 : 0;
+        entry["avg_write_us"] = stats.writes ? (uint32_t)(stats.totalWriteUs / stats.writes) : 0;
+        entry["max_write_us"] = stats.maxWriteUs;
+    }
+    xSemaphoreGive(logLock);
+}
+
+void FileManager::writeMetrics(MetricsWriter &out)
+{
+    out.family("famio_sd_read_duration_seconds", "histogram", "Time to read a file or bundle block from the SD card.");
+    out.histogram("famio_sd_read_duration_seconds", nullptr, sdReadLatency);
+    out.family("famio_sd_write_duration_seconds", "histogram", "Time to write a file or log record to the SD card.");
+    out.histogram("famio_sd_write_duration_seconds", nullptr, sdWriteLatency);
+    out.family("famio_sd_read_bytes_total", "counter", "Bytes read from the SD card.");
+    out.sample("famio_sd_read_bytes_total", nullptr, sdBytesRead.load(std::memory_order_relaxed));
+    out.family("famio_sd_written_bytes_total", "counter", "Bytes written to the SD card.");
+    out.sample("famio_sd_written_bytes_total", nullptr, sdBytesWritten.load(std::memory_order_relaxed));
+    out.family("famio_sd_write_errors_total", "counter", "Failed SD card writes.");
+    out.sample("famio_sd_write_errors_total", nullptr, sdWriteErrors);
+}
+
+// =========================================================
+// File cấu hình dạng log
+// =========================================================
+
+int FileManager::findLog(const char *path)
+{
+    // Danh sách log chỉ được thêm lúc khởi tạo, đọc không cần khóa
+    for (uint8_t i = 0; i < logCount; i++)
+    {
+        if (logs[i].path == path)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+bool FileManager::loadFromLog(int index, const char *path, JsonDocument *doc)
+{
+    TRACE_SCOPE(TRACE_SD, "sd.logLoad");
+    xSemaphoreTake(logLock, portMAX_DELAY);
+    RecordLog &log = logs[index].log;
+    uint32_t start = micros();
+    bool ok = log.load(*doc);
+    sdReadLatency.observe(micros() - start);
+    if (!ok)
+    {
+        // Chưa có log: chuyển file JSON cũ (nếu có) sang log rồi xóa nó
+        String legacyPath = getFullPath(path);
+        ok = readJsonFile(legacyPath, doc);
+        if (ok && log.compact(*doc))
+        {
+            SD.remove(legacyPath.c_str());
+            Serial.printf("FileManager: Đã chuyển %s sang %s\n", legacyPath.c_str(), log.getPath().c_str());
+        }
+    }
+    xSemaphoreGive(logLock);
+    return ok;
+}
+
+bool FileManager::saveToLog(int index, const String &content)
+{
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
+    if (deserializeJson(doc, content))
     {
-        Serial.printf("Lỗi: Ghi file JSON thất bại: %s\n", fullPath.c_str());
-        file.close();
         return false;
     }
 
-    file.close();
-    return true;
+    TRACE_SCOPE_NAMED(trace, TRACE_SD, "sd.logSave");
+    TRACE_SET_ARG(trace, content.length());
+    uint32_t start = micros();
+    xSemaphoreTake(logLock, portMAX_DELAY);
+    uint64_t before = logs[index].log.getStats().bytesWritten;
+    bool ok = logs[index].log.save(doc);
+    uint32_t written = (uint32_t)(logs[index].log.getStats().bytesWritten - before);
+    xSemaphoreGive(logLock);
+    if (!ok)
+    {
+        Serial.printf("Lỗi: Ghi log thất bại: %s\n", logs[index].log.getPath().c_str());
+    }
+    uint32_t elapsed = micros() - start;
+    sdWriteLatency.observe(elapsed);
+    sdBytesWritten.fetch_add(written, std::memory_order_relaxed);
+    recordFlush(elapsed, ok);
+    return ok;
 }
 
 // =========================================================
@@ -128,7 +465,123 @@ File FileManager::openFile(const char *path)
     }
 
     // SỬ DỤNG HÀM HELPER ĐỂ CÓ ĐƯỜNG DẪN ĐẦY ĐỦ: /famio/index.html
+    TRACE_SCOPE(TRACE_SD, "sd.open");
     String fullPath = getFullPath(path);
 
     return SD.open(fullPath.c_str());
-}
\ No newline at end of file
+}
+// =========================================================
+// Gói UI (ui.pack)
+// =========================================================
+
+static uint32_t readLE32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+bool FileManager::openBundle()
+{
+    String fullPath = getFullPath(UI_BUNDLE_FILE);
+    if (!SD.exists(fullPath.c_str()))
+    {
+        return false;
+    }
+
+    File file = SD.open(fullPath.c_str());
+    if (!file)
+    {
+        return false;
+    }
+
+    // Header: magic(4) version(2) count(2) index size(4) data offset(4)
+    uint8_t header[16];
+    size_t fileSize = file.size();
+    uint16_t version = 0;
+    uint16_t count = 0;
+    if (file.read(header, sizeof(header)) == sizeof(header))
+    {
+        version = header[4] | (header[5] << 8);
+        count = header[6] | (header[7] << 8);
+    }
+    if (memcmp(header, UI_BUNDLE_MAGIC, 4) != 0 || version != UI_BUNDLE_VERSION ||
+        count == 0 || count > UI_BUNDLE_MAX_ENTRIES || readLE32(header + 8) != count * sizeof(BundleEntry))
+    {
+        Serial.printf("Lỗi: %s không phải gói UI hợp lệ.\n", fullPath.c_str());
+        file.close();
+        return false;
+    }
+
+    size_t indexSize = count * sizeof(BundleEntry);
+    BundleEntry *index = (BundleEntry *)ps_malloc(indexSize);
+    if (index == nullptr)
+        index = (BundleEntry *)malloc(indexSize);
+    if (index == nullptr || file.read((uint8_t *)index, indexSize) != indexSize)
+    {
+        Serial.println("Lỗi: Không đọc được index của gói UI.");
+        free(index);
+        file.close();
+        return false;
+    }
+
+    for (uint16_t i = 0; i < count; i++)
+    {
+        index[i].path[sizeof(index[i].path) - 1] = '\0';
+        index[i].mime[sizeof(index[i].mime) - 1] = '\0';
+        if (index[i].offset > fileSize || index[i].length > fileSize - index[i].offset ||
+            (i > 0 && strcmp(index[i - 1].path, index[i].path) >= 0))
+        {
+            Serial.printf("Lỗi: Index gói UI hỏng tại mục %u.\n", i);
+            free(index);
+            file.close();
+            return false;
+        }
+    }
+
+    bundleFile = file;
+    bundleIndex = index;
+    bundleCount = count;
+    Serial.printf("FileManager: Gói UI %s, %u file.\n", fullPath.c_str(), count);
+    return true;
+}
+
+const BundleEntry *FileManager::findBundleEntry(const char *path)
+{
+    // Index đã sắp xếp theo đường dẫn và không đổi sau khi mở: không cần khóa
+    int low = 0;
+    int high = (int)bundleCount - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        int cmp = strcmp(bundleIndex[mid].path, path);
+        if (cmp == 0)
+            return &bundleIndex[mid];
+        if (cmp < 0)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return nullptr;
+}
+
+size_t FileManager::readBundle(const BundleEntry *entry, size_t offset, uint8_t *buf, size_t len)
+{
+    if (offset >= entry->length)
+        return 0;
+    if (len > entry->length - offset)
+        len = entry->length - offset;
+
+    TRACE_SCOPE_NAMED(trace, TRACE_SD, "sd.bundleRead");
+    TRACE_SET_ARG(trace, len);
+    uint32_t start = micros();
+    xSemaphoreTake(bundleLock, portMAX_DELAY);
+    size_t n = 0;
+    if (bundleFile.seek(entry->offset + offset))
+    {
+        n = bundleFile.read(buf, len);
+    }
+    bundleReads++;
+    xSemaphoreGive(bundleLock);
+    sdReadLatency.observe(micros() - start);
+    sdBytesRead.fetch_add(n, std::memory_order_relaxed);
+    return n;
+}
@@ -0,0 +1,263 @@
+#include "JsonArena.h"
+
+// Mỗi block có 8 byte đầu giữ kích thước (cần khi reallocate phải copy)
+static const size_t BLOCK_HEADER = 8;
+
+static size_t alignBlock(size_t size)
+{
+    return (size + 7) & ~(size_t)7;
+}
+
+JsonArena &JsonArena::instance()
+{
+    static JsonArena arena;
+    return arena;
+}
+
+bool JsonArena::begin()
+{
+    if (memory)
+        return true;
+    memory = (uint8_t *)ps_malloc(JSON_ARENA_REGIONS * JSON_ARENA_REGION_SIZE);
+    if (memory == nullptr)
+    {
+        Serial.println("JsonArena: Không có PSRAM, JsonDocument dùng heap nội như cũ.");
+        return false;
+    }
+    Serial.printf("JsonArena: %u region x %u byte trong PSRAM\n", (unsigned)JSON_ARENA_REGIONS, (unsigned)JSON_ARENA_REGION_SIZE);
+    return true;
+}
+
+// =========================================================
+// Region của từng task
+// =========================================================
+
+int JsonArena::currentRegion(bool claim)
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    int found = -1;
+    int empty = -1;
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < JSON_ARENA_REGIONS; i++)
+    {
+        if (regions[i].owner == self)
+        {
+            found = i;
+            break;
+        }
+        if (empty < 0 && regions[i].owner == nullptr)
+            empty = i;
+    }
+    if (found < 0 && claim && empty >= 0 && memory)
+    {
+        regions[empty].owner = self;
+        found = empty;
+    }
+    portEXIT_CRITICAL(&mux);
+    return found;
+}
+
+void JsonArena::releaseTask()
+{
+    TaskHandle_t self = xTaskGetCurrentTaskHandle();
+    portENTER_CRITICAL(&mux);
+    for (int i = 0; i < JSON_ARENA_REGIONS; i++)
+    {
+        Region &r = regions[i];
+        if (r.owner == self && r.depth == 0)
+        {
+            r.owner = nullptr;
+            r.top = 0;
+            r.lastBlock = SIZE_MAX;
+        }
+    }
+    portEXIT_CRITICAL(&mux);
+}
+
+int JsonArena::regionOf(const void *ptr)
+{
+    const uint8_t *p = (const uint8_t *)ptr;
+    if (memory == nullptr || p < memory || p >= memory + JSON_ARENA_REGIONS * JSON_ARENA_REGION_SIZE)
+        return -1;
+    return (p - memory) / JSON_ARENA_REGION_SIZE;
+}
+
+JsonArena::Scope::Scope() : region(-1), mark(0)
+{
+    JsonArena &arena = instance();
+    region = arena.currentRegion(true);
+    if (region >= 0)
+    {
+        Region &r = arena.regions[region];
+        mark = r.top;
+        r.depth++;
+        r.scopes++;
+    }
+}
+
+JsonArena::Scope::~Scope()
+{
+    if (region >= 0)
+    {
+        Region &r = instance().regions[region];
+        r.top = mark;
+        r.lastBlock = SIZE_MAX;
+        r.depth--;
+    }
+}
+
+// =========================================================
+// Allocator
+// =========================================================
+
+void *JsonArena::heapAllocate(size_t size, Region *region)
+{
+    void *ptr = ps_malloc(size);
+    if (region)
+        region->overflows++;
+    if (ptr == nullptr)
+    {
+        ptr = malloc(size);
+        if (region)
+            region->internal++;
+        else
+            unownedInternal++;
+    }
+    return ptr;
+}
+
+void *JsonArena::allocate(size_t size)
+{
+    int index = currentRegion(false);
+    if (index < 0)
+        return heapAllocate(size, nullptr);
+
+    Region &r = regions[index];
+    size_t need = BLOCK_HEADER + alignBlock(size);
+    if (r.depth == 0 || r.top + need > JSON_ARENA_REGION_SIZE)
+        return heapAllocate(size, &r);
+
+    uint8_t *block = memory + index * JSON_ARENA_REGION_SIZE + r.top;
+    *(size_t *)block = size;
+    r.lastBlock = r.top;
+    r.top += need;
+    if (r.top > r.peak)
+        r.peak = r.top;
+    r.allocations++;
+    return block + BLOCK_HEADER;
+}
+
+void JsonArena::deallocate(void *ptr)
+{
+    if (ptr == nullptr)
+        return;
+    int index = regionOf(ptr);
+    if (index < 0)
+    {
+        free(ptr);
+        return;
+    }
+
+    // Trong arena: chỉ thu hồi được block cuối, phần còn lại chờ Scope đóng
+    Region &r = regions[index];
+    size_t offset = (uint8_t *)ptr - BLOCK_HEADER - (memory + index * JSON_ARENA_REGION_SIZE);
+    if (offset == r.lastBlock && r.owner == xTaskGetCurrentTaskHandle())
+    {
+        r.top = offset;
+        r.lastBlock = SIZE_MAX;
+    }
+}
+
+void *JsonArena::reallocate(void *ptr, size_t newSize)
+{
+    if (ptr == nullptr)
+        return allocate(newSize);
+
+    int index = regionOf(ptr);
+    if (index < 0)
+    {
+        void *moved = ps_realloc(ptr, newSize);
+        return moved ? moved : realloc(ptr, newSize);
+    }
+
+    Region &r = regions[index];
+    uint8_t *block = (uint8_t *)ptr - BLOCK_HEADER;
+    size_t oldSize = *(size_t *)block;
+    size_t offset = block - (memory + index * JSON_ARENA_REGION_SIZE);
+
+    // Block cuối: nới rộng/thu hẹp tại chỗ (trường hợp thường gặp khi deserialize)
+    if (offset == r.lastBlock && r.owner == xTaskGetCurrentTaskHandle() &&
+        offset + BLOCK_HEADER + alignBlock(newSize) <= JSON_ARENA_REGION_SIZE)
+    {
+        *(size_t *)block = newSize;
+        r.top = offset + BLOCK_HEADER + alignBlock(newSize);
+        if (r.top > r.peak)
+            r.peak = r.top;
+        return ptr;
+    }
+    if (newSize <= oldSize)
+        return ptr;
+
+    void *copy = allocate(newSize);
+    if (copy)
+        memcpy(copy, ptr, oldSize);
+    return copy;
+}
+
+uint32_t JsonArena::internalAllocations()
+{
+    int index = currentRegion(false);
+    return index >= 0 ? regions[index].internal : unownedInternal;
+}
+
+void JsonArena::getStats(JsonDocument &doc)
+{
+    doc["psram"] = memory != nullptr;
+    doc["region_size"] = JSON_ARENA_REGION_SIZE;
+    JsonArray list = doc["regions"].to<JsonArray>();
+    for (int i = 0; i < JSON_ARENA_REGIONS; i++)
+    {
+        const Region &r = regions[i];
+        if (r.owner == nullptr)
+            continue;
+        JsonObject region = list.add<JsonObject>();
+        region["task"] = pcTaskGetName(r.owner);
+        region["peak"] = r.peak;
+        region["in_use"] = r.top;
+        region["scopes"] = r.scopes;
+        region["allocs"] = r.allocations;
+        region["overflows"] = r.overflows;
+        region["internal"] = r.internal;
+    }
+    doc["unscoped_internal"] = unownedInternal;
+    doc["internal_free"] = ESP.getFreeHeap();
+    doc["internal_min_free"] = ESP.getMinFreeHeap();
+    doc["internal_max_block"] = ESP.getMaxAllocHeap();
+}
+
+// =========================================================
+// PsramAllocator
+// =========================================================
+
+PsramAllocator &PsramAllocator::instance()
+{
+    static PsramAllocator allocator;
+    return allocator;
+}
+
+void *PsramAllocator::allocate(size_t size)
+{
+    void *ptr = ps_malloc(size);
+    return ptr ? ptr : malloc(size);
+}
+
+void PsramAllocator::deallocate(void *ptr)
+{
+    free(ptr);
+}
+
+void *PsramAllocator::reallocate(void *ptr, size_t newSize)
+{
+    void *moved = ps_realloc(ptr, newSize);
+    return moved ? moved : realloc(ptr, newSize);
+}
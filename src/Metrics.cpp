@@ -0,0 +1,133 @@
+#include "Metrics.h"
+#include <stdarg.h>
+
+const uint32_t HISTOGRAM_LATENCY_US[] = {50, 100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 1000000};
+const uint8_t HISTOGRAM_LATENCY_COUNT = sizeof(HISTOGRAM_LATENCY_US) / sizeof(HISTOGRAM_LATENCY_US[0]);
+const uint32_t HISTOGRAM_CONNECT_US[] = {500000, 1000000, 2000000, 5000000, 10000000, 20000000, 30000000, 60000000};
+const uint8_t HISTOGRAM_CONNECT_COUNT = sizeof(HISTOGRAM_CONNECT_US) / sizeof(HISTOGRAM_CONNECT_US[0]);
+
+// =========================================================
+// Histogram
+// =========================================================
+
+Histogram::Histogram(const uint32_t *bounds, uint8_t count)
+    : bounds(bounds), boundCount(count > HISTOGRAM_MAX_BOUNDS ? HISTOGRAM_MAX_BOUNDS : count), sumUs(0), sumWraps(0)
+{
+    for (uint8_t i = 0; i <= HISTOGRAM_MAX_BOUNDS; i++)
+        buckets[i].store(0, std::memory_order_relaxed);
+}
+
+void Histogram::observe(uint32_t us)
+{
+    uint8_t bucket = 0;
+    while (bucket < boundCount && us > bounds[bucket])
+        bucket++;
+    buckets[bucket].fetch_add(1, std::memory_order_relaxed);
+    uint32_t before = sumUs.fetch_add(us, std::memory_order_relaxed);
+    if ((uint32_t)(before + us) < before)
+        sumWraps.fetch_add(1, std::memory_order_relaxed);
+}
+
+void Histogram::snapshot(Snapshot &out) const
+{
+    // Đọc lại nếu tổng vừa tràn trong lúc đọc
+    uint32_t wraps;
+    uint32_t low;
+    do
+    {
+        wraps = sumWraps.load(std::memory_order_acquire);
+        low = sumUs.load(std::memory_order_acquire);
+    } while (wraps != sumWraps.load(std::memory_order_acquire));
+    out.sumUs = ((uint64_t)wraps << 32) | low;
+
+    out.count = 0;
+    for (uint8_t i = 0; i <= boundCount; i++)
+    {
+        out.buckets[i] = buckets[i].load(std::memory_order_relaxed);
+        out.count += out.buckets[i];
+    }
+}
+
+// =========================================================
+// Text exposition format
+// =========================================================
+
+MetricsWriter::MetricsWriter(size_t size)
+{
+    text = (char *)ps_malloc(size);
+    if (text)
+        capacity = size;
+}
+
+MetricsWriter::~MetricsWriter()
+{
+    free(text);
+}
+
+void MetricsWriter::append(const char *format, ...)
+{
+    if (text == nullptr || truncated)
+        return;
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(text + length, capacity - length, format, args);
+    va_end(args);
+    if (written < 0 || (size_t)written >= capacity - length)
+    {
+        // Bỏ dòng dở: client chỉ thiếu các metric cuối
+        text[length] = '\0';
+        truncated = true;
+        return;
+    }
+    length += written;
+}
+
+void MetricsWriter::family(const char *name, const char *type, const char *help)
+{
+    append("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void MetricsWriter::sample(const char *name, const char *labels, double value)
+{
+    if (labels)
+        append("%s{%s} %.10g\n", name, labels, value);
+    else
+        append("%s %.10g\n", name, value);
+}
+
+void MetricsWriter::histogram(const char *name, const char *labels, const Histogram &histogram)
+{
+    Histogram::Snapshot snap;
+    histogram.snapshot(snap);
+    const char *sep = labels ? "," : "";
+    if (labels == nullptr)
+        labels = "";
+
+    uint32_t cumulative = 0;
+    for (uint8_t i = 0; i < histogram.getBoundCount(); i++)
+    {
+        cumulative += snap.buckets[i];
+        append("%s_bucket{%s%sle=\"%g\"} %u\n", name, labels, sep, histogram.getBounds()[i] / 1e6, (unsigned)cumulative);
+    }
+    append("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, labels, sep, (unsigned)snap.count);
+    if (*labels)
+    {
+        append("%s_sum{%s} %.6f\n", name, labels, snap.sumUs / 1e6);
+        append("%s_count{%s} %u\n", name, labels, (unsigned)snap.count);
+    }
+    else
+    {
+        append("%s_sum %.6f\n", name, snap.sumUs / 1e6);
+        append("%s_count %u\n", name, (unsigned)snap.count);
+    }
+}
+
+size_t MetricsWriter::fill(uint8_t *buffer, size_t maxLen)
+{
+    size_t chunk = length - sent;
+    if (chunk > maxLen)
+        chunk = maxLen;
+    memcpy(buffer, text + sent, chunk);
+    sent += chunk;
+    return chunk;
+}
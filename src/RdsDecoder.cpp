@@ -0,0 +1,380 @@
+#include "RdsDecoder.h"
+
+#define RDS_BLOCK_A 0
+#define RDS_BLOCK_B 1
+#define RDS_BLOCK_C 2
+#define RDS_BLOCK_D 3
+
+RdsDecoder::RdsDecoder()
+{
+    clearStation();
+}
+
+// =========================================================
+// Ring buffer
+// =========================================================
+bool RdsDecoder::push(const RdsGroup &group)
+{
+    uint16_t next = (head + 1) % RDS_RING_SIZE;
+    if (next == tail)
+    {
+        stats.overflows++;
+        return false;
+    }
+    ring[head] = group;
+    head = next;
+    stats.groups++;
+    return true;
+}
+
+uint16_t RdsDecoder::process(uint16_t maxGroups)
+{
+    uint16_t count = 0;
+    while (tail != head && count < maxGroups)
+    {
+        decode(ring[tail]);
+        tail = (tail + 1) % RDS_RING_SIZE;
+        count++;
+    }
+    publish();
+
+    uint32_t now = millis();
+    windowGroups += count;
+    if (windowStart == 0)
+        windowStart = now;
+    else if (now - windowStart >= 1000)
+    {
+        stats.groupsPerSecond = windowGroups * 1000.0f / (now - windowStart);
+        windowGroups = 0;
+        windowStart = now;
+    }
+    return count;
+}
+
+void RdsDecoder::reset()
+{
+    tail = head;
+    clearStation();
+    publish();
+}
+
+void RdsDecoder::clearStation()
+{
+    RdsInfo empty;
+    working = empty;
+    memset(psCandidate, 0, sizeof(psCandidate));
+    memset(rtText, ' ', sizeof(rtText));
+    memset(rtCandidate, 0, sizeof(rtCandidate));
+    psReceived = 0;
+    rtReceived = 0;
+    rtAbFlag = -1;
+    rtLength = RDS_RT_SIZE;
+    dirty = true;
+}
+
+// =========================================================
+// Group decoding
+// =========================================================
+void RdsDecoder::decode(const RdsGroup &group)
+{
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        if (group.bler[i] >= RDS_BLER_LOST)
+            stats.lost[i]++;
+        else if (group.bler[i] > 0)
+            stats.corrected[i]++;
+    }
+
+    // Block B tells what the group is: nothing can be used without it
+    if (group.bler[RDS_BLOCK_B] > RDS_MAX_BLER)
+    {
+        stats.rejected++;
+        return;
+    }
+
+    uint16_t b = group.block[RDS_BLOCK_B];
+    uint8_t type = b >> 12;
+    bool versionB = (b >> 11) & 1;
+
+    // PI only from clean blocks (A, or C' in version B groups): a wrong PI
+    // would throw away everything decoded so far
+    uint16_t pi = 0;
+    if (group.bler[RDS_BLOCK_A] == 0)
+        pi = group.block[RDS_BLOCK_A];
+    else if (versionB && group.bler[RDS_BLOCK_C] == 0)
+        pi = group.block[RDS_BLOCK_C];
+    if (pi != 0 && pi != working.pi)
+    {
+        if (working.pi != 0)
+            clearStation(); // Another station on the same channel
+        working.pi = pi;
+        dirty = true;
+    }
+    if (working.pi == 0)
+        return; // Nothing to attach the data to yet
+
+    uint8_t pty = (b >> 5) & 0x1F;
+    bool tp = (b >> 10) & 1;
+    if (pty != working.pty || tp != working.tp)
+    {
+        working.pty = pty;
+        working.tp = tp;
+        dirty = true;
+    }
+
+    switch (type)
+    {
+    case 0:
+        decodePs(group);
+        break;
+    case 2:
+        decodeRt(group, versionB);
+        break;
+    case 4:
+        if (!versionB)
+            decodeClock(group);
+        break;
+    default:
+        break;
+    }
+    stats.decoded++;
+}
+
+void RdsDecoder::decodePs(const RdsGroup &group)
+{
+    uint16_t b = group.block[RDS_BLOCK_B];
+    bool ta = (b >> 4) & 1;
+    bool music = (b >> 3) & 1;
+    if (ta != working.ta || music != working.music)
+    {
+        working.ta = ta;
+        working.music = music;
+        dirty = true;
+    }
+
+    if (group.bler[RDS_BLOCK_D] > RDS_MAX_BLER)
+        return;
+    uint8_t segment = b & 0x03;
+    uint8_t chars[2] = {(uint8_t)(group.block[RDS_BLOCK_D] >> 8), (uint8_t)group.block[RDS_BLOCK_D]};
+    bool changed = false;
+    bool accepted = acceptChars(working.ps, psCandidate, segment * 2, chars, 2, group.bler[RDS_BLOCK_D], changed);
+    if (changed && working.hasPs)
+        dirty = true; // Dynamic PS: the name is rewritten segment by segment
+    if (!accepted)
+        return;
+
+    psReceived |= 1 << segment;
+    if (psReceived == 0x0F && !working.hasPs)
+    {
+        working.hasPs = true;
+        dirty = true;
+    }
+}
+
+void RdsDecoder::decodeRt(const RdsGroup &group, bool versionB)
+{
+    uint16_t b = group.block[RDS_BLOCK_B];
+    int8_t ab = (b >> 4) & 1;
+    if (rtAbFlag >= 0 && ab != rtAbFlag)
+    {
+        // Text A/B flag toggled: the station started a new message
+        memset(rtText, ' ', sizeof(rtText));
+        memset(rtCandidate, 0, sizeof(rtCandidate));
+        rtReceived = 0;
+        rtLength = RDS_RT_SIZE;
+    }
+    rtAbFlag = ab;
+
+    uint8_t segment = b & 0x0F;
+    uint8_t segmentSize = versionB ? 2 : 4;
+    uint8_t maxLength = versionB ? RDS_RT_SIZE / 2 : RDS_RT_SIZE;
+    uint8_t pos = segment * segmentSize;
+    uint8_t chars[4];
+    uint8_t count = 0;
+    bool complete = true;
+    bool changed = false;
+
+    if (!versionB)
+    {
+        if (group.bler[RDS_BLOCK_C] > RDS_MAX_BLER || group.bler[RDS_BLOCK_D] > RDS_MAX_BLER)
+            return;
+        chars[0] = group.block[RDS_BLOCK_C] >> 8;
+        chars[1] = group.block[RDS_BLOCK_C];
+        complete = acceptChars(rtText, rtCandidate, pos, chars, 2, group.bler[RDS_BLOCK_C], changed);
+        count = 2;
+    }
+    else if (group.bler[RDS_BLOCK_D] > RDS_MAX_BLER)
+        return;
+    chars[count] = group.block[RDS_BLOCK_D] >> 8;
+    chars[count + 1] = group.block[RDS_BLOCK_D];
+    complete = acceptChars(rtText, rtCandidate, pos + count, &chars[count], 2, group.bler[RDS_BLOCK_D], changed) && complete;
+    count += 2;
+    if (!complete)
+        return;
+
+    // 0x0D ends a message shorter than 64 (32) characters
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (chars[i] == 0x0D && pos + i < rtLength)
+            rtLength = pos + i;
+    }
+    if (rtLength > maxLength)
+        rtLength = maxLength;
+    rtReceived |= 1 << segment;
+
+    uint8_t segments = (rtLength + segmentSize - 1) / segmentSize;
+    uint16_t needed = segments >= 16 ? 0xFFFF : (1 << segments) - 1;
+    if ((rtReceived & needed) != needed)
+        return;
+
+    char text[RDS_RT_SIZE + 1];
+    uint8_t length = rtLength;
+    memcpy(text, rtText, length);
+    while (length > 0 && text[length - 1] == ' ')
+        length--;
+    text[length] = '\0';
+    if (!working.hasRt || strcmp(text, working.rt) != 0)
+    {
+        strcpy(working.rt, text);
+        working.hasRt = true;
+        dirty = true;
+    }
+}
+
+void RdsDecoder::decodeClock(const RdsGroup &group)
+{
+    // A wrong time is worse than none: clean blocks only
+    if (group.bler[RDS_BLOCK_C] != 0 || group.bler[RDS_BLOCK_D] != 0)
+        return;
+
+    uint16_t b = group.block[RDS_BLOCK_B];
+    uint16_t c = group.block[RDS_BLOCK_C];
+    uint16_t d = group.block[RDS_BLOCK_D];
+    uint32_t mjd = ((uint32_t)(b & 0x03) << 15) | (c >> 1);
+    uint8_t hour = ((c & 0x01) << 4) | (d >> 12);
+    uint8_t minute = (d >> 6) & 0x3F;
+    int8_t offset = d & 0x1F;
+    if ((d >> 5) & 1)
+        offset = -offset;
+    if (mjd == 0 || hour > 23 || minute > 59)
+        return;
+
+    // Modified Julian Date to calendar date (EN 50067 annex G)
+    int yp = (int)((mjd - 15078.2) / 365.25);
+    int mp = (int)((mjd - 14956.1 - (int)(yp * 365.25)) / 30.6001);
+    int day = mjd - 14956 - (int)(yp * 365.25) - (int)(mp * 30.6001);
+    int k = (mp == 14 || mp == 15) ? 1 : 0;
+
+    RdsClock clock;
+    clock.year = 1900 + yp + k;
+    clock.month = mp - 1 - k * 12;
+    clock.day = day;
+    clock.hour = hour;
+    clock.minute = minute;
+    clock.offsetHalfHours = offset;
+    working.clock = clock;
+    working.hasClock = true;
+    dirty = true;
+}
+
+// Takes characters from clean blocks at once; from corrected blocks only when
+// they repeat what was received last time at that position
+bool RdsDecoder::acceptChars(char *text, char *candidate, uint8_t pos, const uint8_t *chars, uint8_t count, uint8_t bler, bool &changed)
+{
+    bool accepted = true;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        char c = toAscii(chars[i]);
+        if (bler == 0 || candidate[pos + i] == c)
+        {
+            if (text[pos + i] != c)
+            {
+                text[pos + i] = c;
+                changed = true;
+            }
+        }
+        else
+            accepted = false;
+        candidate[pos + i] = c;
+    }
+    return accepted;
+}
+
+// RDS uses its own character table: keep the ASCII range, the rest would not
+// be valid UTF-8 in the JSON APIs
+char RdsDecoder::toAscii(uint8_t c)
+{
+    if (c == 0x0D)
+        return ' ';
+    if (c < 0x20 || c > 0x7E)
+        return '?';
+    return (char)c;
+}
+
+// =========================================================
+// Snapshot
+// =========================================================
+void RdsDecoder::publish()
+{
+    if (!dirty)
+        return;
+    dirty = false;
+    RdsInfo info = working;
+    if (!info.hasPs)
+        memset(info.ps, 0, sizeof(info.ps)); // Segments received so far are not a name yet
+
+    portENTER_CRITICAL(&lock);
+    published = info;
+    version = version + 1;
+    portEXIT_CRITICAL(&lock);
+}
+
+void RdsDecoder::getInfo(RdsInfo &out)
+{
+    portENTER_CRITICAL(&lock);
+    out = published;
+    portEXIT_CRITICAL(&lock);
+}
+
+void RdsDecoder::toJson(JsonDocument &doc)
+{
+    RdsInfo info;
+    getInfo(info);
+
+    if (info.pi != 0)
+    {
+        char pi[5];
+        snprintf(pi, sizeof(pi), "%04X", info.pi);
+        doc["pi"] = pi;
+        doc["pty"] = info.pty;
+        doc["tp"] = info.tp;
+        doc["ta"] = info.ta;
+        doc["music"] = info.music;
+        if (info.hasPs)
+            doc["ps"] = info.ps;
+        if (info.hasRt)
+            doc["rt"] = info.rt;
+        if (info.hasClock)
+        {
+            char utc[24];
+            snprintf(utc, sizeof(utc), "%04u-%02u-%02uT%02u:%02uZ", info.clock.year, info.clock.month,
+                     info.clock.day, info.clock.hour, info.clock.minute);
+            doc["clock"] = utc;
+            doc["clock_offset_min"] = info.clock.offsetHalfHours * 30;
+        }
+    }
+
+    JsonObject counters = doc["stats"].to<JsonObject>();
+    counters["groups"] = stats.groups;
+    counters["decoded"] = stats.decoded;
+    counters["rejected"] = stats.rejected;
+    counters["overflows"] = stats.overflows;
+    counters["groups_per_sec"] = roundf(stats.groupsPerSecond * 10) / 10;
+    JsonArray corrected = counters["corrected"].to<JsonArray>();
+    JsonArray lost = counters["lost"].to<JsonArray>();
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        corrected.add(stats.corrected[i]);
+        lost.add(stats.lost[i]);
+    }
+}
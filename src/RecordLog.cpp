@@ -0,0 +1,293 @@
+#include "RecordLog.h"
+
+#define RECORD_HEADER_SIZE 6
+
+// CRC-32 (IEEE 802.3), không dùng bảng để tiết kiệm RAM: record chỉ vài chục byte
+static uint32_t crc32(const uint8_t *data, size_t len)
+{
+    uint32_t crc = 0xFFFFFFFFUL;
+    for (size_t i = 0; i < len; i++)
+    {
+        crc ^= data[i];
+        for (int bit = 0; bit < 8; bit++)
+        {
+            crc = (crc >> 1) ^ (0xEDB88320UL & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+static uint32_t readLE32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void writeLE32(uint8_t *p, uint32_t value)
+{
+    p[0] = value & 0xFF;
+    p[1] = (value >> 8) & 0xFF;
+    p[2] = (value >> 16) & 0xFF;
+    p[3] = (value >> 24) & 0xFF;
+}
+
+void RecordLog::begin(const String &logPath)
+{
+    path = logPath;
+    tmpPath = logPath + ".tmp";
+    loaded = false;
+}
+
+// =========================================================
+// Đọc lại log
+// =========================================================
+
+void RecordLog::applyRecord(JsonDocument &doc, JsonObjectConst record)
+{
+    for (JsonPairConst kv : record)
+    {
+        if (kv.value().isNull())
+            doc.remove(kv.key());
+        else
+            doc[kv.key()] = kv.value();
+    }
+}
+
+bool RecordLog::replay(const char *file, JsonDocument &doc, size_t &validSize, bool &corrupt)
+{
+    validSize = 0;
+    File f = SD.open(file);
+    if (!f)
+    {
+        return false;
+    }
+
+    uint8_t head[RECORD_HEADER_SIZE];
+    size_t total = f.size();
+    if (f.read(head, 4) != 4 || readLE32(head) != RECORD_LOG_MAGIC)
+    {
+        corrupt = true;
+        f.close();
+        return false;
+    }
+    validSize = 4;
+
+    bool any = false;
+    while (validSize < total)
+    {
+        if (f.read(head, RECORD_HEADER_SIZE) != RECORD_HEADER_SIZE)
+        {
+            corrupt = true;
+            break;
+        }
+        size_t len = (size_t)head[0] | ((size_t)head[1] << 8);
+        uint32_t crc = readLE32(head + 2);
+        if (len == 0 || validSize + RECORD_HEADER_SIZE + len > total)
+        {
+            corrupt = true;
+            break;
+        }
+
+        uint8_t *payload = (uint8_t *)malloc(len);
+        if (payload == nullptr)
+        {
+            break;
+        }
+        bool valid = f.read(payload, len) == len && crc32(payload, len) == crc;
+        JsonDocument record(&JsonArena::instance());
+        if (valid)
+        {
+            valid = !deserializeJson(record, (const char *)payload, len) && record.is<JsonObject>();
+        }
+        free(payload);
+        if (!valid)
+        {
+            corrupt = true;
+            break;
+        }
+
+        applyRecord(doc, record.as<JsonObjectConst>());
+        any = true;
+        validSize += RECORD_HEADER_SIZE + len;
+    }
+
+    f.close();
+    return any;
+}
+
+bool RecordLog::load(JsonDocument &doc)
+{
+    // Compact bị ngắt sau khi đã xóa log cũ: bản .tmp là bản mới nhất.
+    // Nếu log cũ còn thì .tmp có thể ghi dở, bỏ đi.
+    if (SD.exists(tmpPath.c_str()))
+    {
+        if (SD.exists(path.c_str()))
+            SD.remove(tmpPath.c_str());
+        else
+            SD.rename(tmpPath.c_str(), path.c_str());
+    }
+
+    doc.clear();
+    size_t validSize = 0;
+    bool corrupt = false;
+    bool ok = replay(path.c_str(), doc, validSize, corrupt);
+
+    current = doc;
+    loaded = true;
+    logSize = ok ? validSize : 0;
+    stateBytes = measureJson(current);
+
+    if (corrupt && SD.exists(path.c_str()))
+    {
+        // Record cuối bị ghi dở: ghi lại log chỉ với phần hợp lệ, để các record
+        // nối thêm sau này không nằm sau vùng hỏng
+        Serial.printf("RecordLog: %s hỏng sau %u byte, ghi gọn lại.\n", path.c_str(), (unsigned)validSize);
+        stats.corruptLoads++;
+        if (ok)
+            writeCompacted(current, 0);
+        else
+            SD.remove(path.c_str());
+    }
+    return ok;
+}
+
+// =========================================================
+// Ghi
+// =========================================================
+
+bool RecordLog::writeRecord(File &file, const uint8_t *payload, size_t len)
+{
+    uint8_t head[RECORD_HEADER_SIZE];
+    head[0] = len & 0xFF;
+    head[1] = (len >> 8) & 0xFF;
+    writeLE32(head + 2, crc32(payload, len));
+    return file.write(head, RECORD_HEADER_SIZE) == RECORD_HEADER_SIZE && file.write(payload, len) == len;
+}
+
+void RecordLog::recordWrite(uint32_t startUs, size_t bytes, size_t logicalBytes)
+{
+    uint32_t elapsed = micros() - startUs;
+    stats.writes++;
+    stats.bytesWritten += bytes;
+    stats.logicalBytes += logicalBytes;
+    stats.lastWriteUs = elapsed;
+    stats.totalWriteUs += elapsed;
+    if (elapsed > stats.maxWriteUs)
+        stats.maxWriteUs = elapsed;
+}
+
+bool RecordLog::save(const JsonDocument &state)
+{
+    if (!loaded)
+    {
+        JsonDocument previous(&JsonArena::instance());
+        load(previous);
+    }
+
+    // Các khóa cấp 1 đã đổi (khóa bị xóa ghi thành null)
+    JsonDocument delta(&JsonArena::instance());
+    JsonObjectConst next = state.as<JsonObjectConst>();
+    JsonObjectConst prev = current.as<JsonObjectConst>();
+    for (JsonPairConst kv : next)
+    {
+        if (prev[kv.key()] != kv.value())
+            delta[kv.key()] = kv.value();
+    }
+    for (JsonPairConst kv : prev)
+    {
+        if (next[kv.key()].isNull())
+            delta[kv.key()] = nullptr;
+    }
+    if (delta.size() == 0)
+    {
+        return true;
+    }
+
+    size_t logical = measureJson(state);
+    size_t len = measureJson(delta);
+    if (logSize == 0 || len > RECORD_MAX_PAYLOAD || logSize + RECORD_HEADER_SIZE + len > compactLimit())
+    {
+        return writeCompacted(state, logical);
+    }
+
+    String payload;
+    serializeJson(delta, payload);
+
+    uint32_t start = micros();
+    File f = SD.open(path.c_str(), FILE_APPEND);
+    if (!f)
+    {
+        Serial.printf("RecordLog: Không thể mở %s để ghi.\n", path.c_str());
+        return false;
+    }
+    bool ok = writeRecord(f, (const uint8_t *)payload.c_str(), payload.length());
+    f.close();
+    if (!ok)
+    {
+        // Có thể đã để lại một record ghi dở: đọc lại (và sửa) trước lần ghi sau
+        loaded = false;
+        return false;
+    }
+
+    applyRecord(current, delta.as<JsonObjectConst>());
+    logSize += RECORD_HEADER_SIZE + payload.length();
+    stats.appends++;
+    recordWrite(start, RECORD_HEADER_SIZE + payload.length(), logical);
+    return true;
+}
+
+// Trạng thái lớn (ví dụ danh sách vài trăm kênh trong fm.json) đã vượt ngưỡng cố
+// định ngay sau khi compact; để nó nhân đôi trước khi ghi lại, nếu không mỗi lần
+// lưu lại thành một lần ghi cả file
+size_t RecordLog::compactLimit() const
+{
+    size_t relative = 2 * (4 + RECORD_HEADER_SIZE + stateBytes);
+    return relative > RECORD_LOG_COMPACT_BYTES ? relative : RECORD_LOG_COMPACT_BYTES;
+}
+
+bool RecordLog::compact(const JsonDocument &state)
+{
+    return writeCompacted(state, measureJson(state));
+}
+
+bool RecordLog::writeCompacted(const JsonDocument &state, size_t logicalBytes)
+{
+    String payload;
+    serializeJson(state, payload);
+    if (payload.length() == 0 || payload.length() > 0xFFFF)
+    {
+        return false;
+    }
+
+    uint32_t start = micros();
+    File f = SD.open(tmpPath.c_str(), FILE_WRITE);
+    if (!f)
+    {
+        Serial.printf("RecordLog: Không thể mở %s để ghi.\n", tmpPath.c_str());
+        return false;
+    }
+    uint8_t magic[4];
+    writeLE32(magic, RECORD_LOG_MAGIC);
+    bool ok = f.write(magic, 4) == 4 && writeRecord(f, (const uint8_t *)payload.c_str(), payload.length());
+    f.close();
+    if (!ok)
+    {
+        SD.remove(tmpPath.c_str());
+        return false;
+    }
+
+    // FAT không đổi tên đè được: xóa log cũ rồi đổi tên (load() xử lý nếu bị ngắt ở giữa)
+    SD.remove(path.c_str());
+    if (!SD.rename(tmpPath.c_str(), path.c_str()))
+    {
+        loaded = false;
+        return false;
+    }
+
+    current = state;
+    loaded = true;
+    logSize = 4 + RECORD_HEADER_SIZE + payload.length();
+    stateBytes = payload.length();
+    stats.compactions++;
+    recordWrite(start, logSize, logicalBytes);
+    return true;
+}
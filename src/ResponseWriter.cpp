@@ -0,0 +1,161 @@
+#include "ResponseWriter.h"
+#include <stdarg.h>
+
+static_assert(RESPONSE_POOL_SLOTS <= 32, "freeSlots là bitmask 32 bit");
+
+bool ResponseWriter::begin()
+{
+    size_t size = RESPONSE_POOL_SLOTS * RESPONSE_BUFFER_SIZE;
+    pool = (char *)ps_malloc(size);
+    if (pool == nullptr)
+        pool = (char *)malloc(size);
+    if (pool == nullptr)
+    {
+        Serial.println("ResponseWriter: Không cấp phát được pool, mọi response sẽ dùng heap.");
+        return false;
+    }
+    freeSlots = (RESPONSE_POOL_SLOTS == 32) ? 0xFFFFFFFFUL : ((1UL << RESPONSE_POOL_SLOTS) - 1);
+    return true;
+}
+
+// =========================================================
+// Pool buffer
+// =========================================================
+
+int ResponseWriter::acquire()
+{
+    int slot = -1;
+    portENTER_CRITICAL(&poolMux);
+    if (freeSlots)
+    {
+        slot = __builtin_ctz(freeSlots);
+        freeSlots &= ~(1UL << slot);
+    }
+    portEXIT_CRITICAL(&poolMux);
+    return slot;
+}
+
+void ResponseWriter::release(int slot)
+{
+    portENTER_CRITICAL(&poolMux);
+    freeSlots |= 1UL << slot;
+    portEXIT_CRITICAL(&poolMux);
+}
+
+void ResponseWriter::sendSlot(AsyncWebServerRequest *request, int code, int slot, size_t len, const char *contentType)
+{
+    // Lambda chỉ giữ this và slot: std::function lưu tại chỗ, không cấp phát
+    request->onDisconnect([this, slot]()
+                          { release(slot); });
+    request->send(request->beginResponse(code, contentType, (const uint8_t *)(pool + slot * RESPONSE_BUFFER_SIZE), len));
+    pooledSends++;
+    if (len > largestResponse)
+        largestResponse = len;
+}
+
+// =========================================================
+// Gửi response
+// =========================================================
+
+void ResponseWriter::sendJson(AsyncWebServerRequest *request, int code, const JsonDocument &doc)
+{
+    size_t len = measureJson(doc);
+    int slot = len < RESPONSE_BUFFER_SIZE ? acquire() : -1;
+    if (slot < 0)
+    {
+        // Pool hết hoặc response quá lớn: stream như trước
+        fallbacks++;
+        AsyncResponseStream *stream = request->beginResponseStream("application/json");
+        stream->setCode(code);
+        serializeJson(doc, *stream);
+        request->send(stream);
+        return;
+    }
+    len = serializeJson(doc, pool + slot * RESPONSE_BUFFER_SIZE, RESPONSE_BUFFER_SIZE);
+    sendSlot(request, code, slot, len);
+}
+
+void ResponseWriter::sendf(AsyncWebServerRequest *request, int code, const char *format, ...)
+{
+    char line[RESPONSE_LINE_SIZE];
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(line, sizeof(line), format, args);
+    va_end(args);
+    if (len < 0)
+        len = 0;
+    if (len >= (int)sizeof(line))
+        len = sizeof(line) - 1; // Bị cắt: format sai kích thước, sửa ở handler
+
+    int slot = acquire();
+    if (slot < 0)
+    {
+        fallbacks++;
+        request->send(code, "application/json", String(line));
+        return;
+    }
+    memcpy(pool + slot * RESPONSE_BUFFER_SIZE, line, len);
+    sendSlot(request, code, slot, len);
+}
+
+void ResponseWriter::sendStatic(AsyncWebServerRequest *request, int code, const char *content, const char *contentType)
+{
+    request->send(request->beginResponse(code, contentType, (const uint8_t *)content, strlen(content)));
+    staticSends++;
+}
+
+uint8_t *ResponseWriter::acquireBuffer(int &slot)
+{
+    slot = acquire();
+    if (slot < 0)
+    {
+        fallbacks++;
+        return nullptr;
+    }
+    return (uint8_t *)(pool + slot * RESPONSE_BUFFER_SIZE);
+}
+
+void ResponseWriter::sendBuffer(AsyncWebServerRequest *request, int code, int slot, size_t len, const char *contentType)
+{
+    sendSlot(request, code, slot, len, contentType);
+}
+
+// =========================================================
+// Thống kê theo request
+// =========================================================
+
+void ResponseWriter::beginRequest()
+{
+    requestStart = JsonArena::instance().internalAllocations() + fallbacks;
+}
+
+uint32_t ResponseWriter::endRequest()
+{
+    uint32_t allocs = JsonArena::instance().internalAllocations() + fallbacks - requestStart;
+    requests++;
+    requestAllocs += allocs;
+    if (allocs == 0)
+        zeroAllocRequests++;
+    if (allocs > maxAllocs)
+        maxAllocs = allocs;
+    return allocs;
+}
+
+void ResponseWriter::getStats(JsonDocument &doc)
+{
+    portENTER_CRITICAL(&poolMux);
+    uint32_t slots = freeSlots;
+    portEXIT_CRITICAL(&poolMux);
+
+    doc["pool_slots"] = RESPONSE_POOL_SLOTS;
+    doc["pool_free"] = __builtin_popcount(slots);
+    doc["buffer_size"] = RESPONSE_BUFFER_SIZE;
+    doc["pooled_sends"] = pooledSends;
+    doc["static_sends"] = staticSends;
+    doc["fallbacks"] = fallbacks;
+    doc["largest_response"] = largestResponse;
+    doc["requests"] = requests;
+    doc["zero_alloc_requests"] = zeroAllocRequests;
+    doc["allocs_per_request"] = requests ? (float)requestAllocs / requests : 0.0f;
+    doc["max_allocs"] = maxAllocs;
+}
@@ -0,0 +1,252 @@
+#include "SettingsStore.h"
+
+bool SettingsStore::begin()
+{
+    uint32_t start = micros();
+    prefsLock = xSemaphoreCreateMutex();
+    if (!prefs.begin(SETTINGS_NAMESPACE, false))
+    {
+        Serial.println("SettingsStore: Không mở được NVS, dùng giá trị mặc định.");
+        return false;
+    }
+    ready = true;
+
+    uint8_t found = 0;
+    if (prefs.isKey(NVS_KEY_FM_VOLUME))
+    {
+        fmVolume = prefs.getUChar(NVS_KEY_FM_VOLUME, fmVolume);
+        found |= KEY_FM_VOLUME;
+    }
+    if (prefs.isKey(NVS_KEY_FM_FREQ))
+    {
+        fmFreq = prefs.getUShort(NVS_KEY_FM_FREQ, fmFreq);
+        found |= KEY_FM_FREQ;
+    }
+    if (prefs.isKey(NVS_KEY_BT_VOLUME))
+    {
+        btVolume = prefs.getUChar(NVS_KEY_BT_VOLUME, btVolume);
+        found |= KEY_BT_VOLUME;
+    }
+    if (prefs.isKey(NVS_KEY_MODE))
+    {
+        mode = prefs.getUChar(NVS_KEY_MODE, mode);
+        found |= KEY_MODE;
+    }
+    present = found;
+
+    bootLoadUs = micros() - start;
+    Serial.printf("SettingsStore: Đọc NVS trong %lu us (FM %.1f MHz, vol %d, chế độ %d).\n",
+                  (unsigned long)bootLoadUs, fmFreq / 100.0f, fmVolume, mode);
+    return true;
+}
+
+// =========================================================
+// Getter / setter (chỉ RAM)
+// =========================================================
+
+void SettingsStore::markDirty(uint8_t key)
+{
+    // Gọi trong vùng khóa
+    uint32_t now = millis();
+    if (dirty == 0)
+        firstDirtyMs = now;
+    dirty |= key;
+    present |= key;
+    lastChangeMs = now;
+    changes++;
+}
+
+bool SettingsStore::hasFmState()
+{
+    portENTER_CRITICAL(&lock);
+    bool has = (present & (KEY_FM_VOLUME | KEY_FM_FREQ)) == (KEY_FM_VOLUME | KEY_FM_FREQ);
+    portEXIT_CRITICAL(&lock);
+    return has;
+}
+
+uint8_t SettingsStore::getFmVolume()
+{
+    return fmVolume;
+}
+
+float SettingsStore::getFmFrequency()
+{
+    return fmFreq / 100.0f;
+}
+
+void SettingsStore::setFmVolume(uint8_t volume)
+{
+    portENTER_CRITICAL(&lock);
+    if (volume != fmVolume || !(present & KEY_FM_VOLUME))
+    {
+        fmVolume = volume;
+        markDirty(KEY_FM_VOLUME);
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+void SettingsStore::setFmFrequency(float freqMhz)
+{
+    uint16_t freq = (uint16_t)lroundf(freqMhz * 100);
+    portENTER_CRITICAL(&lock);
+    if (freq != fmFreq || !(present & KEY_FM_FREQ))
+    {
+        fmFreq = freq;
+        markDirty(KEY_FM_FREQ);
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+bool SettingsStore::hasBtVolume()
+{
+    portENTER_CRITICAL(&lock);
+    bool has = present & KEY_BT_VOLUME;
+    portEXIT_CRITICAL(&lock);
+    return has;
+}
+
+uint8_t SettingsStore::getBtVolume()
+{
+    return btVolume;
+}
+
+void SettingsStore::setBtVolume(uint8_t volume)
+{
+    portENTER_CRITICAL(&lock);
+    if (volume != btVolume || !(present & KEY_BT_VOLUME))
+    {
+        btVolume = volume;
+        markDirty(KEY_BT_VOLUME);
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+AudioMode SettingsStore::getMode()
+{
+    return (AudioMode)mode;
+}
+
+void SettingsStore::setMode(AudioMode newMode)
+{
+    portENTER_CRITICAL(&lock);
+    if (newMode != mode || !(present & KEY_MODE))
+    {
+        mode = newMode;
+        markDirty(KEY_MODE);
+    }
+    portEXIT_CRITICAL(&lock);
+}
+
+// =========================================================
+// Wi-Fi (đọc/ghi thẳng NVS)
+// =========================================================
+
+bool SettingsStore::getWifiCredentials(String &ssid, String &pass)
+{
+    if (!ready)
+        return false;
+
+    xSemaphoreTake(prefsLock, portMAX_DELAY);
+    bool has = prefs.isKey(NVS_KEY_STA_SSID);
+    if (has)
+    {
+        ssid = prefs.getString(NVS_KEY_STA_SSID, "");
+        pass = prefs.getString(NVS_KEY_STA_PASS, "");
+    }
+    xSemaphoreGive(prefsLock);
+    return has;
+}
+
+bool SettingsStore::setWifiCredentials(const String &ssid, const String &pass)
+{
+    if (!ready)
+        return false;
+
+    xSemaphoreTake(prefsLock, portMAX_DELAY);
+    bool ok = prefs.putString(NVS_KEY_STA_SSID, ssid) == ssid.length() &&
+              prefs.putString(NVS_KEY_STA_PASS, pass) == pass.length();
+    xSemaphoreGive(prefsLock);
+    return ok;
+}
+
+// =========================================================
+// Ghi xuống NVS
+// =========================================================
+
+bool SettingsStore::commit()
+{
+    if (!ready)
+        return false;
+
+    // Chép ra rồi mới ghi: không giữ portMUX trong lúc ghi flash
+    portENTER_CRITICAL(&lock);
+    uint8_t keys = dirty;
+    uint8_t fmVol = fmVolume;
+    uint16_t freq = fmFreq;
+    uint8_t btVol = btVolume;
+    uint8_t lastMode = mode;
+    dirty = 0;
+    portEXIT_CRITICAL(&lock);
+    if (keys == 0)
+        return true;
+
+    uint32_t start = micros();
+    xSemaphoreTake(prefsLock, portMAX_DELAY);
+    bool ok = true;
+    if (keys & KEY_FM_VOLUME)
+        ok &= prefs.putUChar(NVS_KEY_FM_VOLUME, fmVol) > 0;
+    if (keys & KEY_FM_FREQ)
+        ok &= prefs.putUShort(NVS_KEY_FM_FREQ, freq) > 0;
+    if (keys & KEY_BT_VOLUME)
+        ok &= prefs.putUChar(NVS_KEY_BT_VOLUME, btVol) > 0;
+    if (keys & KEY_MODE)
+        ok &= prefs.putUChar(NVS_KEY_MODE, lastMode) > 0;
+    xSemaphoreGive(prefsLock);
+    uint32_t elapsed = micros() - start;
+
+    portENTER_CRITICAL(&lock);
+    if (!ok)
+        dirty |= keys; // Thử lại lần sau
+    commits++;
+    lastCommitUs = elapsed;
+    if (elapsed > maxCommitUs)
+        maxCommitUs = elapsed;
+    portEXIT_CRITICAL(&lock);
+    return ok;
+}
+
+void SettingsStore::flushDue()
+{
+    uint32_t now = millis();
+    portENTER_CRITICAL(&lock);
+    bool due = dirty != 0 &&
+               (now - lastChangeMs >= SETTINGS_COMMIT_DELAY_MS ||
+                now - firstDirtyMs >= SETTINGS_MAX_AGE_MS);
+    portEXIT_CRITICAL(&lock);
+    if (due)
+        commit();
+}
+
+void SettingsStore::flush()
+{
+    commit();
+}
+
+void SettingsStore::getStats(JsonDocument &doc)
+{
+    portENTER_CRITICAL(&lock);
+    uint32_t changeCount = changes;
+    uint32_t commitCount = commits;
+    uint32_t lastUs = lastCommitUs;
+    uint32_t maxUs = maxCommitUs;
+    bool pending = dirty != 0;
+    portEXIT_CRITICAL(&lock);
+
+    doc["ready"] = ready;
+    doc["changes"] = changeCount;
+    doc["commits"] = commitCount;
+    doc["pending"] = pending;
+    doc["last_commit_us"] = lastUs;
+    doc["max_commit_us"] = maxUs;
+    doc["boot_load_us"] = bootLoadUs;
+}
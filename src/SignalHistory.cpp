@@ -0,0 +1,208 @@
+#include "SignalHistory.h"
+#include <stdarg.h>
+
+static const uint16_t LEVEL_STEP_S[HISTORY_LEVELS] = {1, 60};
+
+// =========================================================
+// Recording (control task)
+// =========================================================
+void SignalHistory::add(uint32_t nowMs, uint8_t rssi, bool stereo)
+{
+    advance(nowMs);
+    sampleCount++;
+    rssiSum += rssi;
+    if (stereo)
+        stereoCount++;
+}
+
+void SignalHistory::advance(uint32_t nowMs)
+{
+    if (!started)
+    {
+        started = true;
+        clockMs = nowMs;
+        uptimeMs = nowMs;
+        second = nowMs / 1000;
+        return;
+    }
+
+    // millis() wraps after ~49.7 days: count uptime from wrap-safe deltas
+    int32_t elapsed = (int32_t)(nowMs - clockMs);
+    if (elapsed > 0)
+    {
+        clockMs = nowMs;
+        uptimeMs += (uint32_t)elapsed;
+    }
+    uint32_t now = (uint32_t)(uptimeMs / 1000);
+
+    // After a long stall every point would be a gap anyway
+    int32_t span = (int32_t)HISTORY_MINUTES * 60;
+    if ((int32_t)(now - second) > span)
+        second = now - span;
+    while ((int32_t)(now - second) > 0)
+    {
+        closeSecond();
+        second++;
+    }
+}
+
+uint8_t SignalHistory::makePoint(uint16_t valid, uint16_t stereo, uint32_t sum)
+{
+    if (valid == 0)
+        return HISTORY_POINT_GAP;
+    uint32_t rssi = (sum + valid / 2) / valid;
+    if (rssi >= HISTORY_POINT_RSSI)
+        rssi = HISTORY_POINT_RSSI - 1;
+    return (stereo * 2 > valid ? HISTORY_POINT_STEREO : 0) | rssi;
+}
+
+void SignalHistory::closeSecond()
+{
+    uint8_t point = makePoint(sampleCount, stereoCount, rssiSum);
+    push(0, point);
+    sampleCount = 0;
+    stereoCount = 0;
+    rssiSum = 0;
+
+    minuteSeconds++;
+    if (point != HISTORY_POINT_GAP)
+    {
+        minuteValid++;
+        minuteRssiSum += point & HISTORY_POINT_RSSI;
+        if (point & HISTORY_POINT_STEREO)
+            minuteStereo++;
+    }
+    if (minuteSeconds == 60)
+    {
+        push(1, makePoint(minuteValid, minuteStereo, minuteRssiSum));
+        minuteSeconds = 0;
+        minuteValid = 0;
+        minuteStereo = 0;
+        minuteRssiSum = 0;
+    }
+}
+
+void SignalHistory::push(uint8_t level, uint8_t point)
+{
+    Ring &ring = rings[level];
+    portENTER_CRITICAL(&lock);
+    ring.points[ring.head] = point;
+    ring.head = (ring.head + 1) % ring.capacity;
+    if (ring.count < ring.capacity)
+        ring.count++;
+    endSecond[level] = second + 1;
+    portEXIT_CRITICAL(&lock);
+}
+
+// =========================================================
+// Export (any task)
+// =========================================================
+uint16_t SignalHistory::snapshot(uint8_t level, uint16_t points, uint8_t *out, uint32_t &end)
+{
+    const Ring &ring = rings[level];
+    portENTER_CRITICAL(&lock);
+    uint16_t count = ring.count;
+    if (points > 0 && points < count)
+        count = points;
+    uint16_t start = (ring.head + ring.capacity - count) % ring.capacity;
+    uint16_t first = ring.capacity - start;
+    if (first > count)
+        first = count;
+    memcpy(out, ring.points + start, first);
+    memcpy(out + first, ring.points, count - first);
+    end = endSecond[level];
+    portEXIT_CRITICAL(&lock);
+    return count;
+}
+
+size_t SignalHistory::writeBinary(uint8_t level, uint16_t points, uint8_t *buf, size_t size)
+{
+    if (level >= HISTORY_LEVELS || size < HISTORY_HEADER_SIZE)
+        return 0;
+    size_t room = size - HISTORY_HEADER_SIZE;
+    if (points == 0 || points > room)
+        points = room < rings[level].capacity ? room : rings[level].capacity;
+
+    uint32_t end = 0;
+    uint16_t count = snapshot(level, points, buf + HISTORY_HEADER_SIZE, end);
+    buf[0] = 'F';
+    buf[1] = 'H';
+    buf[2] = HISTORY_BINARY_VERSION;
+    buf[3] = level;
+    buf[4] = LEVEL_STEP_S[level] & 0xFF;
+    buf[5] = LEVEL_STEP_S[level] >> 8;
+    buf[6] = count & 0xFF;
+    buf[7] = count >> 8;
+    for (uint8_t i = 0; i < 4; i++)
+        buf[8 + i] = (end >> (8 * i)) & 0xFF;
+    return HISTORY_HEADER_SIZE + count;
+}
+
+static bool appendf(char *buf, size_t size, size_t &pos, const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(buf + pos, size - pos, format, args);
+    va_end(args);
+    if (len < 0 || pos + len >= size)
+        return false;
+    pos += len;
+    return true;
+}
+
+size_t SignalHistory::writeJson(uint8_t level, uint16_t points, char *buf, size_t size)
+{
+    if (level >= HISTORY_LEVELS)
+        return 0;
+    uint8_t data[HISTORY_MINUTES];
+    uint32_t end = 0;
+    uint16_t total = snapshot(level, points, data, end);
+
+    // Too long for the buffer: keep the newest half until it fits
+    for (uint16_t count = total;; count /= 2)
+    {
+        const uint8_t *p = data + (total - count);
+        size_t pos = 0;
+        bool ok = appendf(buf, size, pos, "{\"level\":%u,\"step_s\":%u,\"end_s\":%lu,\"count\":%u,\"rssi\":[",
+                          level, LEVEL_STEP_S[level], (unsigned long)end, count);
+
+        int previous = -1;
+        for (uint16_t i = 0; i < count && ok; i++)
+        {
+            const char *comma = i ? "," : "";
+            if (p[i] == HISTORY_POINT_GAP)
+            {
+                ok = appendf(buf, size, pos, "%snull", comma);
+                previous = -1;
+                continue;
+            }
+            int rssi = p[i] & HISTORY_POINT_RSSI;
+            ok = appendf(buf, size, pos, "%s%d", comma, previous < 0 ? rssi : rssi - previous);
+            previous = rssi;
+        }
+
+        ok = ok && appendf(buf, size, pos, "],\"stereo\":[");
+        bool stereo = false;
+        uint16_t run = 0;
+        bool first = true;
+        for (uint16_t i = 0; i <= count && count > 0 && ok; i++)
+        {
+            bool current = i < count && p[i] != HISTORY_POINT_GAP && (p[i] & HISTORY_POINT_STEREO);
+            if (i < count && current == stereo)
+            {
+                run++;
+                continue;
+            }
+            ok = appendf(buf, size, pos, "%s%u", first ? "" : ",", run);
+            first = false;
+            stereo = current;
+            run = 1;
+        }
+        ok = ok && appendf(buf, size, pos, "]}");
+
+        if (ok)
+            return pos;
+        if (count == 0)
+            return 0;
+    }
+}
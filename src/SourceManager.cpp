@@ -0,0 +1,196 @@
+#include "SourceManager.h"
+
+static const char *modeName(AudioMode mode)
+{
+    switch (mode)
+    {
+    case MODE_FM:
+        return "fm";
+    case MODE_BT:
+        return "bt";
+    default:
+        return "off";
+    }
+}
+
+SourceManager::SourceManager(FMRadio *radio, BluetoothManager *bluetooth, SettingsStore *settingsStore)
+    : fmRadio(radio), btManager(bluetooth), settings(settingsStore)
+{
+}
+
+// =========================================================
+// Chuyển nguồn (task control)
+// =========================================================
+
+void SourceManager::select(AudioMode target, uint32_t requestedAt)
+{
+    AudioMode from = active;
+    if (target == from)
+        return;
+    uint32_t start = millis();
+
+    // 1. Bật nguồn mới ở mức 0 (từ standby nếu được)
+    bool warm = false;
+    bool fadeIn = false;
+    if (target == MODE_FM)
+    {
+        fmRadio->begin(true);
+        warm = fmRadio->lastStartWasWarm();
+        fadeIn = true;
+    }
+    else if (target == MODE_BT)
+    {
+        warm = btManager->isStandby();
+        if (warm)
+            btManager->setOutputLevel(0);
+        btManager->setPower(true);
+        fadeIn = warm; // Stack mới: chưa có âm thanh để fade
+    }
+
+    // 2. Crossfade
+    fade(from, target, fadeIn);
+
+    // 3. Nguồn cũ về standby; tắt hết thì Bluetooth cũng tắt hẳn
+    if (from == MODE_FM)
+        fmRadio->powerOff();
+    else if (from == MODE_BT && target != MODE_OFF)
+        parkBluetooth();
+    if (target == MODE_OFF)
+        btManager->setPower(false);
+
+    portENTER_CRITICAL(&lock);
+    active = target;
+    portEXIT_CRITICAL(&lock);
+    settings->setMode(target);
+
+    uint32_t now = millis();
+    record(target, warm, now - requestedAt, start - requestedAt);
+    Serial.printf("SourceManager: %s -> %s (%s) sau %u ms, chờ hàng đợi %u ms.\n", modeName(from), modeName(target),
+                  warm ? "nóng" : "nguội", (unsigned)(now - requestedAt), (unsigned)(start - requestedAt));
+}
+
+void SourceManager::stop(AudioMode source, uint32_t requestedAt)
+{
+    if (active == source)
+        select(MODE_OFF, requestedAt);
+    else if (source == MODE_BT && btManager->isStandby())
+        btManager->setPower(false);
+}
+
+void SourceManager::tick()
+{
+    if (!btManager->isStandby())
+        return;
+    if (millis() - standbySince >= SOURCE_STANDBY_MS || ESP.getFreeHeap() < SOURCE_STANDBY_MIN_HEAP)
+    {
+        btManager->setPower(false);
+        btTeardowns++;
+        Serial.println("SourceManager: Tắt hẳn Bluetooth standby (hết hạn hoặc thiếu heap).");
+    }
+}
+
+void SourceManager::parkBluetooth()
+{
+    if (ESP.getFreeHeap() >= SOURCE_STANDBY_MIN_HEAP)
+    {
+        btManager->standby();
+        standbySince = millis();
+        return;
+    }
+    // Không đủ heap cho FM và Web Server: giải phóng stack như trước
+    btManager->setPower(false);
+    btTeardowns++;
+}
+
+// =========================================================
+// Fade
+// =========================================================
+
+uint8_t SourceManager::fullLevel(AudioMode source)
+{
+    if (source == MODE_FM)
+        return fmRadio->getVolume();
+    if (source == MODE_BT)
+        return btManager->getVolume();
+    return 0;
+}
+
+void SourceManager::setLevel(AudioMode source, uint8_t level)
+{
+    if (source == MODE_FM)
+        fmRadio->setOutputLevel(level);
+    else if (source == MODE_BT)
+        btManager->setOutputLevel(level);
+}
+
+// Nguồn cũ giảm dần về 0 trong khi nguồn mới tăng dần lên âm lượng đã lưu
+void SourceManager::fade(AudioMode from, AudioMode to, bool fadeIn)
+{
+    bool fadeOut = from != MODE_OFF;
+    if (!fadeOut && !fadeIn)
+        return;
+
+    uint8_t fromFull = fullLevel(from);
+    uint8_t toFull = fullLevel(to);
+    for (uint8_t step = 1; step <= SOURCE_FADE_STEPS; step++)
+    {
+        if (fadeOut)
+            setLevel(from, fromFull * (SOURCE_FADE_STEPS - step) / SOURCE_FADE_STEPS);
+        if (fadeIn)
+            setLevel(to, toFull * step / SOURCE_FADE_STEPS);
+        if (step < SOURCE_FADE_STEPS)
+            delay(SOURCE_FADE_MS / SOURCE_FADE_STEPS);
+    }
+}
+
+// =========================================================
+// Thống kê
+// =========================================================
+
+void SourceManager::record(AudioMode target, bool warm, uint32_t elapsedMs, uint32_t queueMs)
+{
+    portENTER_CRITICAL(&lock);
+    SwitchStats &entry = stats[target][warm ? 1 : 0];
+    entry.count++;
+    entry.lastMs = elapsedMs;
+    entry.totalMs += elapsedMs;
+    if (elapsedMs > entry.maxMs)
+        entry.maxMs = elapsedMs;
+    lastQueueMs = queueMs;
+    portEXIT_CRITICAL(&lock);
+}
+
+void SourceManager::getStatus(JsonDocument &doc)
+{
+    SwitchStats snapshot[3][2];
+    portENTER_CRITICAL(&lock);
+    AudioMode current = active;
+    memcpy(snapshot, stats, sizeof(snapshot));
+    uint32_t queueMs = lastQueueMs;
+    portEXIT_CRITICAL(&lock);
+
+    doc["active"] = modeName(current);
+    doc["bt_standby"] = btManager->isStandby();
+    doc["fade_ms"] = SOURCE_FADE_MS;
+    doc["last_queue_ms"] = queueMs;
+    doc["bt_teardowns"] = btTeardowns;
+
+    // Độ trễ đầu-cuối (từ lúc gửi lệnh tới khi nguồn mới phát đủ âm lượng)
+    JsonArray list = doc["switches"].to<JsonArray>();
+    for (uint8_t target = 0; target < 3; target++)
+    {
+        for (uint8_t warm = 0; warm < 2; warm++)
+        {
+            const SwitchStats &entry = snapshot[target][warm];
+            if (entry.count == 0)
+                continue;
+            JsonObject item = list.add<JsonObject>();
+            item["to"] = modeName((AudioMode)target);
+            item["warm"] = warm == 1;
+            item["count"] = entry.count;
+            item["last_ms"] = entry.lastMs;
+            item["mean_ms"] = entry.totalMs / entry.count;
+            item["max_ms"] = entry.maxMs;
+        }
+    }
+}
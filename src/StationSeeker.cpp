@@ -0,0 +1,215 @@
+#include "StationSeeker.h"
+#include "JsonArena.h"
+
+static const char *stateName(SeekState state)
+{
+    switch (state)
+    {
+    case SEEK_RUNNING:
+        return "running";
+    case SEEK_FOUND:
+        return "found";
+    case SEEK_FAILED:
+        return "failed";
+    case SEEK_CANCELLED:
+        return "cancelled";
+    default:
+        return "idle";
+    }
+}
+
+StationSeeker::StationSeeker(FMRadio *radio, StatusBroadcaster *broadcaster)
+    : fmRadio(radio), statusBroadcaster(broadcaster)
+{
+}
+
+uint32_t StationSeeker::reserveId()
+{
+    portENTER_CRITICAL(&lock);
+    uint32_t id = ++lastId;
+    portEXIT_CRITICAL(&lock);
+    return id;
+}
+
+// =========================================================
+// Job control (control task)
+// =========================================================
+void StationSeeker::start(uint32_t id, bool upward)
+{
+    if (state == SEEK_RUNNING)
+        finish(SEEK_CANCELLED);
+
+    uint16_t from = (uint16_t)lroundf(fmRadio->getCurrentFrequency() * 100);
+    if (!fmRadio->getPowerState())
+    {
+        // FM went off after the handler answered 202: the id still gets a final state
+        portENTER_CRITICAL(&lock);
+        jobId = id;
+        up = upward;
+        fromFreq10k = from;
+        freq10k = from;
+        channels = 0;
+        elapsedMs = 0;
+        state = SEEK_CANCELLED;
+        seeks++;
+        cancelled++;
+        portEXIT_CRITICAL(&lock);
+        push();
+        Serial.printf("StationSeeker: Job %u cancelled, FM is off\n", (unsigned)id);
+        return;
+    }
+
+    uint16_t first;
+    portENTER_CRITICAL(&lock);
+    jobId = id;
+    up = upward;
+    fromFreq10k = from;
+    first = nextChannel(from);
+    freq10k = first;
+    channels = 0;
+    elapsedMs = 0;
+    state = SEEK_RUNNING;
+    portEXIT_CRITICAL(&lock);
+
+    fmRadio->beginScan();
+    startedAt = millis();
+    fmRadio->tuneScan(first);
+    tunedAt = millis();
+    pushedAt = startedAt;
+    push();
+    Serial.printf("StationSeeker: Job %u seeking %s from %.1f MHz\n", (unsigned)id, up ? "up" : "down", from / 100.0f);
+}
+
+void StationSeeker::cancel()
+{
+    if (state == SEEK_RUNNING)
+        finish(SEEK_CANCELLED);
+}
+
+uint32_t StationSeeker::msUntilStep() const
+{
+    uint32_t waited = millis() - tunedAt;
+    return waited >= SEEK_DWELL_MS ? 0 : SEEK_DWELL_MS - waited;
+}
+
+uint16_t StationSeeker::nextChannel(uint16_t freq) const
+{
+    if (up)
+        return freq + RDA5807_STEP_10K > RDA5807_BAND_TOP ? RDA5807_BAND_BOTTOM : freq + RDA5807_STEP_10K;
+    return freq < RDA5807_BAND_BOTTOM + RDA5807_STEP_10K ? RDA5807_BAND_TOP : freq - RDA5807_STEP_10K;
+}
+
+void StationSeeker::step()
+{
+    if (state != SEEK_RUNNING || msUntilStep() > 0)
+        return;
+
+    uint8_t rssi;
+    bool stereo;
+    bool station;
+    fmRadio->readSignal(rssi, stereo, station);
+    portENTER_CRITICAL(&lock);
+    channels = channels + 1;
+    elapsedMs = millis() - startedAt;
+    portEXIT_CRITICAL(&lock);
+
+    if (station)
+    {
+        finish(SEEK_FOUND);
+        return;
+    }
+    // Back at the start (or a whole band further, if the start was off the channel grid)
+    uint16_t next = nextChannel(freq10k);
+    if (next == fromFreq10k || channels >= (RDA5807_BAND_TOP - RDA5807_BAND_BOTTOM) / RDA5807_STEP_10K + 1)
+    {
+        finish(SEEK_FAILED);
+        return;
+    }
+    freq10k = next;
+    fmRadio->tuneScan(next);
+    tunedAt = millis();
+    if (millis() - pushedAt >= SEEK_PUSH_MS)
+        push();
+}
+
+void StationSeeker::finish(SeekState result)
+{
+    if (result == SEEK_FOUND)
+        fmRadio->endSeek(freq10k);
+    else
+        fmRadio->endScan();
+
+    portENTER_CRITICAL(&lock);
+    uint32_t elapsed = millis() - startedAt;
+    elapsedMs = elapsed;
+    state = result;
+    seeks++;
+    if (result == SEEK_FOUND)
+    {
+        found++;
+        foundMsTotal += elapsed;
+        if (elapsed > maxMs)
+            maxMs = elapsed;
+    }
+    else if (result == SEEK_FAILED)
+        failed++;
+    else
+        cancelled++;
+    portEXIT_CRITICAL(&lock);
+
+    push();
+    Serial.printf("StationSeeker: Job %u %s at %.1f MHz, %u channels in %u ms\n", (unsigned)jobId, stateName(result),
+                  (result == SEEK_FOUND ? freq10k : fromFreq10k) / 100.0f, (unsigned)channels, (unsigned)elapsed);
+}
+
+// =========================================================
+// Progress
+// =========================================================
+void StationSeeker::getStatus(JsonDocument &doc)
+{
+    portENTER_CRITICAL(&lock);
+    uint32_t id = jobId;
+    SeekState current = state;
+    bool upward = up;
+    uint16_t from = fromFreq10k;
+    uint16_t freq = freq10k;
+    uint16_t measured = channels;
+    uint32_t elapsed = elapsedMs;
+    uint32_t total = seeks;
+    uint32_t foundCount = found;
+    uint32_t failedCount = failed;
+    uint32_t cancelledCount = cancelled;
+    uint32_t foundMs = foundMsTotal;
+    uint32_t longest = maxMs;
+    portEXIT_CRITICAL(&lock);
+
+    doc["job"] = id;
+    doc["state"] = stateName(current);
+    if (current != SEEK_IDLE)
+    {
+        doc["direction"] = upward ? "up" : "down";
+        doc["from"] = from / 100.0f;
+        // Running: channel being measured. Found: the station. Otherwise back on "from"
+        doc["freq"] = (current == SEEK_RUNNING || current == SEEK_FOUND ? freq : from) / 100.0f;
+        doc["channels"] = measured;
+        doc["elapsed_ms"] = elapsed;
+    }
+
+    JsonObject stats = doc["stats"].to<JsonObject>();
+    stats["seeks"] = total;
+    stats["found"] = foundCount;
+    stats["failed"] = failedCount;
+    stats["cancelled"] = cancelledCount;
+    stats["mean_found_ms"] = foundCount ? foundMs / foundCount : 0;
+    stats["max_found_ms"] = longest;
+}
+
+// Called from the control task
+void StationSeeker::push()
+{
+    pushedAt = millis();
+    JsonArena::Scope scope;
+    JsonDocument doc(&JsonArena::instance());
+    getStatus(doc);
+    statusBroadcaster->sendEvent("seek", doc);
+}
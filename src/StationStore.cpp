@@ -0,0 +1,316 @@
+#include "StationStore.h"
+#include <algorithm>
+
+StationStore::StationStore()
+{
+    mutex = xSemaphoreCreateRecursiveMutex();
+}
+
+bool StationStore::begin()
+{
+    if (stations)
+        return true;
+
+    stations = (Station *)ps_malloc(STATION_CAPACITY * sizeof(Station));
+    if (stations == nullptr)
+        stations = (Station *)malloc(STATION_CAPACITY * sizeof(Station));
+    byOrder = (uint16_t *)ps_malloc(STATION_CAPACITY * sizeof(uint16_t));
+    if (byOrder == nullptr)
+        byOrder = (uint16_t *)malloc(STATION_CAPACITY * sizeof(uint16_t));
+    if (stations == nullptr || byOrder == nullptr)
+    {
+        free(stations);
+        free(byOrder);
+        stations = nullptr;
+        byOrder = nullptr;
+        Serial.println("StationStore: Out of memory for the station list.");
+        return false;
+    }
+    return true;
+}
+
+uint16_t StationStore::count()
+{
+    lock();
+    uint16_t n = used;
+    unlock();
+    return n;
+}
+
+// =========================================================
+// Lookup
+// =========================================================
+int StationStore::indexOf(uint16_t freq10k) const
+{
+    int low = 0;
+    int high = (int)used - 1;
+    while (low <= high)
+    {
+        int mid = (low + high) / 2;
+        if (stations[mid].freq10k == freq10k)
+            return mid;
+        if (stations[mid].freq10k < freq10k)
+            low = mid + 1;
+        else
+            high = mid - 1;
+    }
+    return -(low + 1);
+}
+
+int StationStore::positionOf(uint16_t freq10k) const
+{
+    for (uint16_t i = 0; i < used; i++)
+    {
+        if (byOrder[i] == freq10k)
+            return i;
+    }
+    return -1;
+}
+
+bool StationStore::find(uint16_t freq10k, Station &out)
+{
+    lock();
+    int index = stations ? indexOf(freq10k) : -1;
+    if (index >= 0)
+        out = stations[index];
+    unlock();
+    return index >= 0;
+}
+
+uint16_t StationStore::frequencyAt(uint16_t position)
+{
+    lock();
+    uint16_t freq = position < used ? byOrder[position] : 0;
+    unlock();
+    return freq;
+}
+
+// =========================================================
+// Edits
+// =========================================================
+void StationStore::copyName(char *dest, const char *name)
+{
+    size_t len = strlen(name);
+    if (len >= STATION_NAME_SIZE)
+    {
+        // Cut on a UTF-8 character boundary
+        len = STATION_NAME_SIZE - 1;
+        while (len > 0 && ((uint8_t)name[len] & 0xC0) == 0x80)
+            len--;
+    }
+    memcpy(dest, name, len);
+    dest[len] = '\0';
+}
+
+bool StationStore::insert(uint16_t freq10k, uint16_t order, uint8_t rssi, uint8_t flags, const char *name)
+{
+    if (stations == nullptr || used >= STATION_CAPACITY || freq10k < STATION_FREQ_MIN || freq10k > STATION_FREQ_MAX)
+        return false;
+    int index = indexOf(freq10k);
+    if (index >= 0)
+        return false;
+    index = -index - 1;
+
+    memmove(&stations[index + 1], &stations[index], (used - index) * sizeof(Station));
+    Station &station = stations[index];
+    station.freq10k = freq10k;
+    station.order = order;
+    station.rssi = rssi;
+    station.flags = flags;
+    copyName(station.name, name ? name : "");
+    used++;
+    if (order >= nextOrder)
+        nextOrder = order + 1;
+    return true;
+}
+
+void StationStore::erase(int index)
+{
+    memmove(&stations[index], &stations[index + 1], (used - index - 1) * sizeof(Station));
+    used--;
+}
+
+bool StationStore::add(uint16_t freq10k, uint8_t rssi, bool *created)
+{
+    lock();
+    int index = stations ? indexOf(freq10k) : -1;
+    bool ok;
+    bool added = false;
+    if (index >= 0)
+    {
+        stations[index].rssi = rssi;
+        ok = true;
+    }
+    else
+    {
+        ok = added = insert(freq10k, nextOrder, rssi, 0, nullptr);
+        if (added)
+            byOrder[used - 1] = freq10k;
+    }
+    unlock();
+    if (created)
+        *created = added;
+    return ok;
+}
+
+bool StationStore::remove(uint16_t freq10k)
+{
+    lock();
+    int index = stations ? indexOf(freq10k) : -1;
+    if (index >= 0)
+    {
+        int position = positionOf(freq10k);
+        memmove(&byOrder[position], &byOrder[position + 1], (used - position - 1) * sizeof(uint16_t));
+        erase(index);
+    }
+    unlock();
+    return index >= 0;
+}
+
+bool StationStore::edit(uint16_t freq10k, const char *name, int favorite, int position)
+{
+    lock();
+    int index = stations ? indexOf(freq10k) : -1;
+    if (index >= 0)
+    {
+        Station &station = stations[index];
+        if (name)
+            copyName(station.name, name);
+        if (favorite >= 0)
+            station.flags = favorite ? (station.flags | STATION_FAVORITE) : (station.flags & ~STATION_FAVORITE);
+        if (position >= 0)
+        {
+            if (position >= used)
+                position = used - 1;
+            int from = positionOf(freq10k);
+            if (from < position)
+                memmove(&byOrder[from], &byOrder[from + 1], (position - from) * sizeof(uint16_t));
+            else if (from > position)
+                memmove(&byOrder[position + 1], &byOrder[position], (from - position) * sizeof(uint16_t));
+            byOrder[position] = freq10k;
+            renumber();
+        }
+    }
+    unlock();
+    return index >= 0;
+}
+
+// Order values follow the preset order again (after a move)
+void StationStore::renumber()
+{
+    for (uint16_t i = 0; i < used; i++)
+        stations[indexOf(byOrder[i])].order = i;
+    nextOrder = used;
+}
+
+void StationStore::rebuildOrder()
+{
+    for (uint16_t i = 0; i < used; i++)
+        byOrder[i] = stations[i].freq10k;
+    std::sort(byOrder, byOrder + used, [this](uint16_t a, uint16_t b)
+              {
+                  uint16_t orderA = stations[indexOf(a)].order;
+                  uint16_t orderB = stations[indexOf(b)].order;
+                  return orderA != orderB ? orderA < orderB : a < b; });
+}
+
+void StationStore::replaceUnfavorites(const uint16_t *freq10k, const uint8_t *rssi, uint8_t count)
+{
+    lock();
+    if (stations)
+    {
+        for (int i = (int)used - 1; i >= 0; i--)
+        {
+            bool found = false;
+            for (uint8_t k = 0; k < count && !found; k++)
+                found = stations[i].freq10k == freq10k[k];
+            if (!(stations[i].flags & STATION_FAVORITE) && !found)
+                erase(i);
+        }
+        rebuildOrder();
+        for (uint8_t k = 0; k < count; k++)
+            add(freq10k[k], rssi[k]);
+    }
+    unlock();
+}
+
+// =========================================================
+// Listing
+// =========================================================
+void StationStore::addEntry(JsonArray out, const Station &station, uint16_t position)
+{
+    JsonObject entry = out.add<JsonObject>();
+    entry["index"] = position;
+    entry["freq"] = station.freq10k / 100.0f;
+    entry["name"] = station.name;
+    entry["rssi"] = station.rssi;
+    entry["favorite"] = (station.flags & STATION_FAVORITE) != 0;
+}
+
+uint16_t StationStore::page(JsonArray out, uint16_t offset, uint16_t limit, bool byFrequency, bool favoritesOnly)
+{
+    lock();
+    uint16_t matched = 0;
+    for (uint16_t i = 0; i < used; i++)
+    {
+        int index = byFrequency ? i : indexOf(byOrder[i]);
+        const Station &station = stations[index];
+        if (favoritesOnly && !(station.flags & STATION_FAVORITE))
+            continue;
+        if (matched >= offset && matched - offset < limit)
+            addEntry(out, station, byFrequency ? positionOf(station.freq10k) : i);
+        matched++;
+    }
+    unlock();
+    return matched;
+}
+
+// =========================================================
+// Persistence
+// =========================================================
+void StationStore::fromJson(const JsonDocument &doc)
+{
+    lock();
+    used = 0;
+    nextOrder = 0;
+    if (stations)
+    {
+        JsonObjectConst root = doc.as<JsonObjectConst>();
+        for (JsonPairConst kv : root)
+        {
+            const char *key = kv.key().c_str();
+            if (!isdigit((unsigned char)key[0]))
+                continue;
+            JsonObjectConst value = kv.value().as<JsonObjectConst>();
+            insert((uint16_t)atoi(key), value["o"] | 0, value["r"] | 0, (value["f"] | false) ? STATION_FAVORITE : 0, value["n"] | "");
+        }
+
+        // fm.json before the station store: {"channels":[{"freq":99.5}, ...]}
+        for (JsonObjectConst channel : root["channels"].as<JsonArrayConst>())
+        {
+            float freq = channel["freq"] | 0.0f;
+            insert((uint16_t)lroundf(freq * 100), nextOrder, 0, 0, nullptr);
+        }
+        rebuildOrder();
+    }
+    unlock();
+}
+
+void StationStore::toJson(JsonDocument &doc)
+{
+    lock();
+    char key[8];
+    for (uint16_t i = 0; i < used; i++)
+    {
+        const Station &station = stations[i];
+        snprintf(key, sizeof(key), "%u", station.freq10k);
+        JsonObject value = doc[key].to<JsonObject>();
+        value["o"] = station.order;
+        value["r"] = station.rssi;
+        if (station.name[0])
+            value["n"] = station.name;
+        if (station.flags & STATION_FAVORITE)
+            value["f"] = true;
+    }
+    unlock();
+}
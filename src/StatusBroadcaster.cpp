@@ -0,0 +1,110 @@
+#include "StatusBroadcaster.h"
+
+StatusBroadcaster::StatusBroadcaster(FMRadio *radio, BluetoothManager *bluetooth)
+    : events(EVENTS_PATH), fmRadio(radio), btManager(bluetooth)
+{
+    frameLock = xSemaphoreCreateMutex();
+}
+
+void StatusBroadcaster::begin(AsyncWebServer &server)
+{
+    events.onConnect(std::bind(&StatusBroadcaster::handleConnect, this, std::placeholders::_1));
+    server.addHandler(&events);
+}
+
+// =========================================================
+// Phát hiện thay đổi
+// =========================================================
+
+void StatusBroadcaster::readFmState(FmState &state)
+{
+    state.powered = fmRadio->getPowerState();
+    state.freq10k = (uint16_t)lroundf(fmRadio->getCurrentFrequency() * 100);
+    state.rssiBucket = fmRadio->getRssi() / RSSI_BUCKET_SIZE;
+    state.stereo = fmRadio->getStereo();
+    state.volume = fmRadio->getVolume();
+    state.rdsVersion = fmRadio->getRdsVersion();
+}
+
+void StatusBroadcaster::readBtState(BtState &state)
+{
+    state.powered = btManager->isPowered();
+    state.connected = btManager->isConnected();
+    state.volume = btManager->getVolume();
+    state.metaVersion = BluetoothManager::getMetadataVersion();
+}
+
+void StatusBroadcaster::update()
+{
+    FmState fm;
+    BtState bt;
+    readFmState(fm);
+    readBtState(bt);
+
+    bool fmChanged = !hasState || fm.powered != lastFm.powered || fm.freq10k != lastFm.freq10k ||
+                     fm.rssiBucket != lastFm.rssiBucket || fm.stereo != lastFm.stereo || fm.volume != lastFm.volume ||
+                     fm.rdsVersion != lastFm.rdsVersion;
+    bool btChanged = !hasState || bt.powered != lastBt.powered || bt.connected != lastBt.connected ||
+                     bt.volume != lastBt.volume || bt.metaVersion != lastBt.metaVersion;
+    hasState = true;
+    lastFm = fm;
+    lastBt = bt;
+
+    if (fmChanged)
+    {
+        JsonArena::Scope scope;
+        JsonDocument doc(&JsonArena::instance());
+        fmRadio->getStatus(&doc);
+        publish("fm", fmFrame, doc);
+    }
+    if (btChanged)
+    {
+        JsonArena::Scope scope;
+        JsonDocument doc(&JsonArena::instance());
+        btManager->getStatus(doc);
+        publish("bt", btFrame, doc);
+    }
+}
+
+void StatusBroadcaster::publish(const char *event, String &frame, JsonDocument &doc)
+{
+    String message;
+    serializeJson(doc, message);
+
+    // Không giữ frameLock khi gửi: onConnect giữ khóa của AsyncEventSource rồi mới lấy frameLock
+    xSemaphoreTake(frameLock, portMAX_DELAY);
+    frame = message;
+    xSemaphoreGive(frameLock);
+
+    if (events.count() > 0)
+    {
+        events.send(message.c_str(), event, ++eventId);
+    }
+}
+
+void StatusBroadcaster::sendEvent(const char *event, JsonDocument &doc)
+{
+    if (events.count() == 0)
+        return;
+    String message;
+    serializeJson(doc, message);
+    events.send(message.c_str(), event, ++eventId);
+}
+
+// =========================================================
+// Client mới: gửi ngay trạng thái hiện tại
+// =========================================================
+
+void StatusBroadcaster::handleConnect(AsyncEventSourceClient *client)
+{
+    xSemaphoreTake(frameLock, portMAX_DELAY);
+    String fm = fmFrame;
+    String bt = btFrame;
+    xSemaphoreGive(frameLock);
+
+    client->send("hello", nullptr, eventId, EVENTS_RECONNECT_MS);
+    if (fm.length())
+        client->send(fm.c_str(), "fm", eventId);
+    if (bt.length())
+        client->send(bt.c_str(), "bt", eventId);
+}
@@ -0,0 +1,379 @@
+#include "TaskManager.h"
+#include <esp_timer.h>
+#include "Trace.h"
+
+TaskManager::TaskManager(FMRadio *radio, BluetoothManager *bluetooth, FileManager *fileMgr, SettingsStore *settingsStore, StatusBroadcaster *broadcaster, BandScanner *scanner, StationSeeker *seeker, SourceManager *sources)
+    : fmRadio(radio), btManager(bluetooth), fileManager(fileMgr), settings(settingsStore), statusBroadcaster(broadcaster), bandScanner(scanner), stationSeeker(seeker), sourceManager(sources)
+{
+}
+
+bool TaskManager::begin()
+{
+    controlQueue = xQueueCreate(CONTROL_QUEUE_LENGTH, sizeof(ControlMessage));
+    if (controlQueue == nullptr)
+    {
+        Serial.println("TaskManager: Không tạo được hàng đợi lệnh.");
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(controlTaskEntry, CONTROL_TASK_NAME, CONTROL_TASK_STACK, this,
+                                CONTROL_TASK_PRIORITY, &controlTask, CONTROL_TASK_CORE) != pdPASS)
+    {
+        Serial.println("TaskManager: Không tạo được task control.");
+        return false;
+    }
+
+    if (xTaskCreatePinnedToCore(storageTaskEntry, STORAGE_TASK_NAME, STORAGE_TASK_STACK, this,
+                                STORAGE_TASK_PRIORITY, &storageTask, STORAGE_TASK_CORE) != pdPASS)
+    {
+        Serial.println("TaskManager: Không tạo được task storage.");
+        return false;
+    }
+
+    lastReportUs = esp_timer_get_time();
+    Serial.printf("TaskManager: Task control chạy trên core %d (priority %d).\n", CONTROL_TASK_CORE, CONTROL_TASK_PRIORITY);
+    return true;
+}
+
+// =========================================================
+// Hàng đợi lệnh
+// =========================================================
+
+bool TaskManager::post(ControlCommand cmd, int32_t value, uint32_t waitMs)
+{
+    if (controlQueue == nullptr)
+        return false;
+
+    ControlMessage msg;
+    msg.cmd = cmd;
+    msg.value = value;
+    msg.seq = ++nextSeq;
+    msg.waiter = waitMs > 0 ? xTaskGetCurrentTaskHandle() : nullptr;
+    msg.postedAt = millis();
+
+    // Không chặn Web Server nếu hàng đợi đầy: bỏ lệnh và báo lỗi cho client
+    if (xQueueSend(controlQueue, &msg, 0) != pdPASS)
+    {
+        droppedCount++;
+        return false;
+    }
+    if (waitMs == 0)
+        return true;
+
+    // Chờ task control chạy tới lệnh này (bỏ qua thông báo cũ của lệnh đã hết hạn chờ).
+    // Hết thời gian chờ thì lệnh vẫn nằm trong hàng đợi và sẽ chạy sau.
+    uint32_t start = millis();
+    while ((int32_t)(completedSeq - msg.seq) < 0)
+    {
+        uint32_t elapsed = millis() - start;
+        if (elapsed >= waitMs)
+            break;
+        ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(waitMs - elapsed));
+    }
+    return true;
+}
+
+void TaskManager::controlTaskEntry(void *arg)
+{
+    static_cast<TaskManager *>(arg)->controlLoop();
+}
+
+void TaskManager::controlLoop()
+{
+    ControlMessage msg;
+
+    for (;;)
+    {
+        // Đang quét băng tần/seek: chỉ chờ lệnh tới lúc đọc kênh kế tiếp.
+        // Đang nghe FM: tới lần lấy mẫu thanh ghi trạng thái kế tiếp
+        uint32_t waitMs = CONTROL_TICK_MS;
+        if (bandScanner->isRunning())
+        {
+            if (bandScanner->msUntilStep() < waitMs)
+                waitMs = bandScanner->msUntilStep();
+        }
+        else if (stationSeeker->isRunning())
+        {
+            if (stationSeeker->msUntilStep() < waitMs)
+                waitMs = stationSeeker->msUntilStep();
+        }
+        else if (fmRadio->getPowerState() && fmRadio->msUntilSample() < waitMs)
+        {
+            waitMs = fmRadio->msUntilSample();
+        }
+
+        if (xQueueReceive(controlQueue, &msg, pdMS_TO_TICKS(waitMs)) == pdTRUE)
+        {
+            int64_t start = esp_timer_get_time();
+            execute(msg);
+            addBusy(controlBusyUs, esp_timer_get_time() - start);
+            commandCount++;
+
+            if (msg.waiter)
+            {
+                completedSeq = msg.seq;
+                xTaskNotifyGive(msg.waiter);
+            }
+        }
+
+        int64_t start = esp_timer_get_time();
+        // RSSI/stereo/RDS được đọc ở đây (một lần đọc burst mỗi FM_SAMPLE_MS),
+        // API trạng thái chỉ đọc snapshot. Khi quét/seek, chip đang ở kênh khác:
+        // bỏ qua để trạng thái FM không nhảy theo
+        if (bandScanner->isRunning())
+        {
+            bandScanner->step();
+        }
+        else if (stationSeeker->isRunning())
+        {
+            stationSeeker->step();
+        }
+        else
+        {
+            fmRadio->sample();
+        }
+        sourceManager->tick();
+        // Trạng thái vừa đổi (do lệnh, RSSI hay metadata) được đẩy tới các client SSE
+        statusBroadcaster->update();
+        addBusy(controlBusyUs, esp_timer_get_time() - start);
+    }
+}
+
+// Lệnh đổi kênh hoặc bật/tắt chip thì dừng lần quét đang chạy
+static bool interruptsScan(ControlCommand cmd)
+{
+    switch (cmd)
+    {
+    case CMD_FM_POWER_ON:
+    case CMD_FM_POWER_OFF:
+    case CMD_FM_SET_FREQ:
+    case CMD_FM_SEEK_UP:
+    case CMD_FM_SEEK_DOWN:
+    case CMD_FM_SELECT_CHANNEL:
+    case CMD_BT_POWER_ON:
+    case CMD_FM_SCAN_CANCEL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+// Seek dừng (quay về kênh cũ) khi có lệnh đổi kênh, bật/tắt chip hoặc quét
+static bool interruptsSeek(ControlCommand cmd)
+{
+    switch (cmd)
+    {
+    case CMD_FM_POWER_ON:
+    case CMD_FM_POWER_OFF:
+    case CMD_FM_SET_FREQ:
+    case CMD_FM_SELECT_CHANNEL:
+    case CMD_BT_POWER_ON:
+    case CMD_FM_SCAN_START:
+    case CMD_FM_AUTOSTORE:
+    case CMD_FM_SEEK_CANCEL:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void TaskManager::execute(const ControlMessage &msg)
+{
+    TRACE_SCOPE_NAMED(trace, TRACE_CONTROL, "control.command");
+    TRACE_SET_ARG(trace, msg.cmd);
+    if (interruptsScan(msg.cmd))
+        bandScanner->cancel();
+    if (interruptsSeek(msg.cmd))
+        stationSeeker->cancel();
+
+    switch (msg.cmd)
+    {
+    case CMD_FM_POWER_ON:
+        // Bluetooth (nếu đang phát) chuyển sang standby hoặc tắt hẳn nếu thiếu heap
+        sourceManager->select(MODE_FM, msg.postedAt);
+        break;
+    case CMD_FM_POWER_OFF:
+        sourceManager->stop(MODE_FM, msg.postedAt);
+        requestFlush();
+        break;
+    case CMD_FM_SET_FREQ:
+        fmRadio->setFrequency(msg.value / 100.0f);
+        break;
+    case CMD_FM_SET_VOLUME:
+        fmRadio->setVolume(msg.value);
+        break;
+    case CMD_FM_SEEK_UP:
+        stationSeeker->start(msg.value, true); // Thay seek đang chạy (nếu có)
+        break;
+    case CMD_FM_SEEK_DOWN:
+        stationSeeker->start(msg.value, false);
+        break;
+    case CMD_FM_SAVE_CHANNEL:
+        fmRadio->saveChannel(msg.value / 100.0f);
+        break;
+    case CMD_FM_SELECT_CHANNEL:
+        fmRadio->selectSavedChannel(msg.value);
+        break;
+    case CMD_FM_DELETE_CHANNEL:
+        fmRadio->deleteChannel(msg.value);
+        break;
+    case CMD_FM_DELETE_STATION:
+        fmRadio->deleteStation(msg.value);
+        break;
+    case CMD_BT_POWER_ON:
+        sourceManager->select(MODE_BT, msg.postedAt);
+        break;
+    case CMD_BT_POWER_OFF:
+        sourceManager->stop(MODE_BT, msg.postedAt);
+        requestFlush();
+        break;
+    case CMD_BT_SET_VOLUME:
+        btManager->setVolume(msg.value);
+        break;
+    case CMD_BT_PLAY:
+        btManager->play();
+        break;
+    case CMD_BT_PAUSE:
+        btManager->pause();
+        break;
+    case CMD_BT_NEXT:
+        btManager->next();
+        break;
+    case CMD_BT_PREVIOUS:
+        btManager->previous();
+        break;
+    case CMD_BT_CONFIRM_PIN:
+        btManager->confirmPinCode(msg.value);
+        break;
+    case CMD_FM_SCAN_START:
+        bandScanner->start(msg.value);
+        break;
+    case CMD_FM_AUTOSTORE:
+        bandScanner->start(msg.value, true);
+        break;
+    case CMD_FM_SCAN_CANCEL:
+    case CMD_FM_SEEK_CANCEL:
+        break; // Đã dừng ở trên
+
+    }
+}
+
+// =========================================================
+// Task storage: ghi trễ cài đặt xuống NVS và cấu hình xuống SD
+// =========================================================
+
+void TaskManager::requestFlush()
+{
+    if (storageTask)
+        xTaskNotifyGive(storageTask);
+}
+
+void TaskManager::storageTaskEntry(void *arg)
+{
+    static_cast<TaskManager *>(arg)->storageLoop();
+}
+
+void TaskManager::storageLoop()
+{
+    for (;;)
+    {
+        bool flushAll = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(STORAGE_CHECK_MS)) > 0;
+        int64_t start = esp_timer_get_time();
+        if (flushAll)
+        {
+            settings->flush();
+            fileManager->flush();
+        }
+        else
+        {
+            settings->flushDue();
+            fileManager->flushDue();
+        }
+        addBusy(storageBusyUs, esp_timer_get_time() - start);
+    }
+}
+
+// =========================================================
+// Báo cáo CPU / stack
+// =========================================================
+
+void TaskManager::addTaskEntry(JsonArray &tasks, const char *name, TaskHandle_t handle, float cpu)
+{
+    if (handle == nullptr)
+        return;
+
+    JsonObject task = tasks.add<JsonObject>();
+    task["name"] = name;
+    task["core"] = xTaskGetAffinity(handle);
+    task["priority"] = uxTaskPriorityGet(handle);
+    task["stack_free"] = uxTaskGetStackHighWaterMark(handle);
+    if (cpu >= 0)
+        task["cpu"] = roundf(cpu * 10) / 10;
+}
+
+void TaskManager::getTaskReport(JsonDocument &doc)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t windowUs = (uint32_t)(now - lastReportUs);
+    lastReportUs = now;
+
+    doc["uptime_ms"] = millis();
+    doc["window_ms"] = windowUs / 1000;
+    doc["commands"] = commandCount;
+    doc["dropped"] = droppedCount;
+    doc["queued"] = controlQueue ? uxQueueMessagesWaiting(controlQueue) : 0;
+
+    // Giao dịch I2C tới RDA5807 (tổng và mỗi giây trong cửa sổ)
+    uint32_t i2c = fmRadio->getI2cTransactions();
+    doc["i2c_transactions"] = i2c;
+    doc["i2c_per_sec"] = windowUs ? roundf((i2c - lastI2cTransactions) * 1e7f / windowUs) / 10 : 0;
+    doc["fm_sample_ms"] = FM_SAMPLE_MS;
+    lastI2cTransactions = i2c;
+    JsonArray tasks = doc["tasks"].to<JsonArray>();
+
+#if (configGENERATE_RUN_TIME_STATS == 1) && (configUSE_TRACE_FACILITY == 1)
+    // Có run-time stats: %CPU của mọi task (tính trên một core) trong cửa sổ từ lần gọi trước
+    doc["source"] = "runtime_stats";
+    TaskStatus_t status[MAX_REPORTED_TASKS];
+    uint32_t totalRuntime = 0;
+    UBaseType_t count = uxTaskGetSystemState(status, MAX_REPORTED_TASKS, &totalRuntime);
+    uint32_t totalDelta = totalRuntime - lastTotalRuntime;
+
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        uint32_t previous = 0;
+        for (uint8_t j = 0; j < lastRuntimeCount; j++)
+        {
+            if (lastRuntime[j].handle == status[i].xHandle)
+            {
+                previous = lastRuntime[j].runtime;
+                break;
+            }
+        }
+        float cpu = totalDelta ? 100.0f * (status[i].ulRunTimeCounter - previous) / totalDelta : 0;
+        addTaskEntry(tasks, status[i].pcTaskName, status[i].xHandle, cpu);
+    }
+    for (UBaseType_t i = 0; i < count; i++)
+    {
+        lastRuntime[i].handle = status[i].xHandle;
+        lastRuntime[i].runtime = status[i].ulRunTimeCounter;
+    }
+    lastRuntimeCount = count;
+    lastTotalRuntime = totalRuntime;
+#else
+    // Không có run-time stats: chỉ có thời gian bận đo được trong code của mình
+    doc["source"] = "busy_time";
+    portENTER_CRITICAL(&busyLock);
+    uint64_t control = controlBusyUs;
+    uint64_t storage = storageBusyUs;
+    uint64_t loop = loopBusyUs;
+    portEXIT_CRITICAL(&busyLock);
+    addTaskEntry(tasks, CONTROL_TASK_NAME, controlTask, windowUs ? 100.0f * (control - lastControlBusyUs) / windowUs : 0);
+    addTaskEntry(tasks, STORAGE_TASK_NAME, storageTask, windowUs ? 100.0f * (storage - lastStorageBusyUs) / windowUs : 0);
+    addTaskEntry(tasks, "loopTask", xTaskGetHandle("loopTask"), windowUs ? 100.0f * (loop - lastLoopBusyUs) / windowUs : 0);
+    addTaskEntry(tasks, "async_tcp", xTaskGetHandle("async_tcp"), -1);
+    lastControlBusyUs = control;
+    lastStorageBusyUs = storage;
+    lastLoopBusyUs = loop;
+#endif
+}
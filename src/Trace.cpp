@@ -0,0 +1,228 @@
+#include "Trace.h"
+#include <stdarg.h>
+#include <esp_timer.h>
+#include <freertos/task.h>
+
+TraceEvent *Trace::rings = nullptr;
+std::atomic<uint32_t> Trace::heads[TRACE_CORES];
+
+static const char *const CATEGORY_NAMES[TRACE_CATEGORY_COUNT] = {"http", "sd", "i2c", "bt", "control"};
+
+static_assert((TRACE_RING_EVENTS & (TRACE_RING_EVENTS - 1)) == 0, "TRACE_RING_EVENTS phải là lũy thừa của 2");
+
+bool Trace::begin()
+{
+#if TRACE_ENABLED
+    if (rings)
+        return true;
+    size_t size = TRACE_CORES * TRACE_RING_EVENTS * sizeof(TraceEvent);
+    TraceEvent *memory = (TraceEvent *)ps_malloc(size);
+    if (memory == nullptr)
+    {
+        Serial.println("Trace: Không cấp được ring buffer, tắt trace.");
+        return false;
+    }
+    memset(memory, 0, size); // Slot trống có seq = 0
+    rings = memory;
+    Serial.printf("Trace: %u core x %u sự kiện (%u byte) trong PSRAM\n", (unsigned)TRACE_CORES,
+                  (unsigned)TRACE_RING_EVENTS, (unsigned)(TRACE_CORES * TRACE_RING_EVENTS * sizeof(TraceEvent)));
+    return true;
+#else
+    return false;
+#endif
+}
+
+// =========================================================
+// Ghi sự kiện (mọi task)
+// =========================================================
+// Ring và slot nằm trong PSRAM: chỉ đọc/ghi thường trên đó, thao tác nguyên tử
+// đọc-sửa-ghi (fetch_add) chỉ dùng trên đầu ring trong RAM nội.
+
+void Trace::record(TraceCategory category, const char *name, char phase, int32_t arg)
+{
+    TraceEvent *ring = rings;
+    if (ring == nullptr)
+        return;
+
+    uint32_t core = (uint32_t)xPortGetCoreID() % TRACE_CORES;
+    uint32_t index = heads[core].fetch_add(1, std::memory_order_relaxed);
+    TraceEvent &event = ring[core * TRACE_RING_EVENTS + (index & (TRACE_RING_EVENTS - 1))];
+
+    // seq = 0 trong lúc ghi: Export bỏ qua slot đang ghi dở
+    __atomic_store_n(&event.seq, 0, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    event.tsUs = (uint32_t)esp_timer_get_time();
+    event.name = name;
+    event.arg = arg;
+    event.phase = phase;
+    event.category = category;
+    strncpy(event.task, pcTaskGetName(nullptr), TRACE_TASK_NAME_LEN - 1);
+    event.task[TRACE_TASK_NAME_LEN - 1] = '\0';
+    __atomic_store_n(&event.seq, index + 1, __ATOMIC_RELEASE);
+}
+
+// =========================================================
+// Xuất JSON
+// =========================================================
+
+Trace::Export::Export()
+{
+    if (rings == nullptr)
+        return;
+    events = (TraceEvent *)ps_malloc(TRACE_CORES * TRACE_RING_EVENTS * sizeof(TraceEvent));
+    if (events == nullptr)
+        return;
+
+    nowUs = esp_timer_get_time();
+    for (uint8_t core = 0; core < TRACE_CORES; core++)
+    {
+        uint32_t head = heads[core].load(std::memory_order_acquire);
+        recorded += head;
+        uint32_t oldest = head > TRACE_RING_EVENTS ? head - TRACE_RING_EVENTS : 0;
+        // Từ cũ tới mới; slot đang ghi dở hoặc bị ghi đè trong lúc chép thì bỏ
+        for (uint32_t index = oldest; index < head; index++)
+        {
+            const TraceEvent &slot = rings[core * TRACE_RING_EVENTS + (index & (TRACE_RING_EVENTS - 1))];
+            if (__atomic_load_n(&slot.seq, __ATOMIC_ACQUIRE) != index + 1)
+                continue;
+            TraceEvent &copy = events[count];
+            memcpy(&copy, &slot, sizeof(TraceEvent));
+            __atomic_thread_fence(__ATOMIC_ACQUIRE);
+            if (__atomic_load_n(&slot.seq, __ATOMIC_RELAXED) != index + 1)
+                continue;
+            uint8_t id = taskId(copy.task);
+            if (id > 0)
+                taskCores[id - 1] |= 1 << core;
+            count++;
+        }
+        coreEnd[core] = count;
+    }
+}
+
+Trace::Export::~Export()
+{
+    free(events);
+}
+
+uint8_t Trace::Export::taskId(const char *name)
+{
+    for (uint8_t i = 0; i < taskCount; i++)
+    {
+        if (strcmp(tasks[i], name) == 0)
+            return i + 1;
+    }
+    if (taskCount >= MAX_TASKS)
+        return 0;
+    tasks[taskCount] = name;
+    return ++taskCount;
+}
+
+void Trace::Export::append(const char *format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    int written = vsnprintf(line + lineLen, sizeof(line) - lineLen, format, args);
+    va_end(args);
+    if (written > 0)
+    {
+        lineLen += written;
+        if (lineLen >= sizeof(line))
+            lineLen = sizeof(line) - 1;
+    }
+}
+
+// Sinh dòng JSON kế tiếp vào line; false khi đã hết
+bool Trace::Export::nextLine()
+{
+    lineLen = 0;
+    lineOffset = 0;
+    while (lineLen == 0)
+    {
+        switch (stage)
+        {
+        case STAGE_HEADER:
+            append("{\"displayTimeUnit\":\"ms\",\"otherData\":{\"recorded\":%u,\"kept\":%u,\"ring_events\":%u},\"traceEvents\":[\n",
+                   (unsigned)recorded, (unsigned)count, (unsigned)TRACE_RING_EVENTS);
+            stage = STAGE_CORES;
+            break;
+
+        // Mỗi core là một "process", mỗi task một "thread"
+        case STAGE_CORES:
+            if (cursor >= TRACE_CORES)
+            {
+                stage = STAGE_TASKS;
+                cursor = 0;
+                break;
+            }
+            append("%s{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"core %u\"}}\n",
+                   cursor == 0 ? "" : ",", (unsigned)cursor, (unsigned)cursor);
+            cursor++;
+            break;
+
+        case STAGE_TASKS:
+            if (cursor >= (size_t)taskCount * TRACE_CORES)
+            {
+                stage = STAGE_EVENTS;
+                cursor = 0;
+                break;
+            }
+            // Chỉ các cặp (core, task) có sự kiện
+            if (taskCores[cursor % taskCount] & (1 << (cursor / taskCount)))
+                append(",{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"%s\"}}\n",
+                       (unsigned)(cursor / taskCount), (unsigned)(cursor % taskCount + 1), tasks[cursor % taskCount]);
+            cursor++;
+            break;
+
+        case STAGE_EVENTS:
+        {
+            if (cursor >= count)
+            {
+                stage = STAGE_FOOTER;
+                break;
+            }
+            const TraceEvent &event = events[cursor];
+            uint8_t core = 0;
+            while (core < TRACE_CORES - 1 && cursor >= coreEnd[core])
+                core++;
+            // Khôi phục 64 bit từ 32 bit thấp (đúng với sự kiện trong vòng 71 phút)
+            int64_t ts = nowUs - (uint32_t)((uint32_t)nowUs - event.tsUs);
+            const char *category = event.category < TRACE_CATEGORY_COUNT ? CATEGORY_NAMES[event.category] : "";
+            append(",{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"%c\",\"ts\":%lld,\"pid\":%u,\"tid\":%u", event.name,
+                   category, event.phase, (long long)ts, (unsigned)core, (unsigned)taskId(event.task));
+            if (event.phase == 'i')
+                append(",\"s\":\"t\"");
+            if (event.arg != 0 || event.phase == 'i')
+                append(",\"args\":{\"value\":%d}", (int)event.arg);
+            append("}\n");
+            cursor++;
+            break;
+        }
+
+        case STAGE_FOOTER:
+            append("]}\n");
+            stage = STAGE_DONE;
+            break;
+
+        case STAGE_DONE:
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t Trace::Export::fill(uint8_t *buffer, size_t maxLen)
+{
+    size_t written = 0;
+    while (written < maxLen)
+    {
+        if (lineOffset >= lineLen && !nextLine())
+            break;
+        size_t chunk = lineLen - lineOffset;
+        if (chunk > maxLen - written)
+            chunk = maxLen - written;
+        memcpy(buffer + written, line + lineOffset, chunk);
+        lineOffset += chunk;
+        written += chunk;
+    }
+    return written;
+}
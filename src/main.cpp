@@ -7,91 +7,150 @@
 // Bao gồm các file Header của các lớp đã tạo
 #include "Constants.h"
 #include "FileManager.h"
+#include "SettingsStore.h"
 #include "PowerManager.h"
 #include "FMRadio.h"
 #include "AppWebServer.h"
 #include "BluetoothManager.h"
 #include "ConnectivityManager.h"
+#include "TaskManager.h"
+#include "StatusBroadcaster.h"
+#include "BandScanner.h"
+#include "StationSeeker.h"
+#include "SourceManager.h"
+#include "BootProfiler.h"
+#include "Trace.h"
 
 // =========================================================
 // Khai báo các Đối tượng Toàn cục (Global Managers)
 // =========================================================
 
 FileManager fileManager;
-BluetoothManager bluetooth(&fileManager);
+SettingsStore settingsStore;
+BluetoothManager bluetooth(&fileManager, &settingsStore);
 PowerManager powerManager;
-FMRadio fmRadio(&fileManager);
-ConnectivityManager connectivityManager(&fileManager);
-AppWebServer appWebServer(&fmRadio, &powerManager, &fileManager, &bluetooth, &connectivityManager);
+FMRadio fmRadio(&fileManager, &settingsStore);
+ConnectivityManager connectivityManager(&fileManager, &settingsStore);
+StatusBroadcaster statusBroadcaster(&fmRadio, &bluetooth);
+BandScanner bandScanner(&fmRadio, &statusBroadcaster);
+StationSeeker stationSeeker(&fmRadio, &statusBroadcaster);
+SourceManager sourceManager(&fmRadio, &bluetooth, &settingsStore);
+BootProfiler bootProfiler;
+TaskManager taskManager(&fmRadio, &bluetooth, &fileManager, &settingsStore, &statusBroadcaster, &bandScanner, &stationSeeker, &sourceManager);
+AppWebServer appWebServer(&fmRadio, &powerManager, &fileManager, &bluetooth, &connectivityManager, &settingsStore, &taskManager, &statusBroadcaster, &bandScanner, &stationSeeker, &sourceManager, &bootProfiler);
 
 // =========================================================
 // Setup() - Khởi tạo Hệ thống
 // =========================================================
-
-void setup()
+// Các pha chạy theo thứ tự phụ thuộc:
+//   psram -> nvs -> net (task boot_net, core 0; cần thẻ SD khi NVS chưa có Wi-Fi)
+//                -> sd -> i2c -> control -> audio (phát lại nguồn cuối)
+//   net + audio -> web
+// Radio phát lại trong lúc Wi-Fi còn đang kết nối (tới CONNECTION_TIMEOUT_S).
+
+static uint8_t netPhase;
+static uint8_t sdPhase;
+static bool netNeedsCard = false;
+
+// Kết nối Wi-Fi (hoặc mở AP cấu hình)
+static void connectNetwork()
 {
-    Serial.begin(115200);
-    delay(500);
-    Serial.println("\n--- Bắt đầu Hệ thống Famio FM Radio ESP32 ---");
-
+    // Chưa có Wi-Fi trong NVS: thông tin cũ (wifi.json) và cấu hình AP nằm trên thẻ
+    if (netNeedsCard)
+        bootProfiler.waitFor(sdPhase);
 
-    // 1. Kiểm tra sự tồn tại vật lý của PSRAM
-    if (psramInit()) {
-        Serial.println("PSRAM: Đã tìm thấy chip vật lý và khởi tạo thành công.");
-    } else {
-        Serial.println("PSRAM: Không tìm thấy chip hoặc khởi tạo thất bại!");
+    if (!connectivityManager.begin())
+    {
+        // Nếu kết nối/cấu hình thất bại, khởi động lại để thử lại
+        Serial.println("Hệ thống không thể kết nối");
+        while (1)
+            ;
     }
+    bootProfiler.finish(netPhase);
+}
 
-    // 2. Kiểm tra dung lượng PSRAM khả dụng
-    size_t psramSize = ESP.getPsramSize();
-    size_t freePsram = ESP.getFreePsram();
-
-    if (psramSize > 0) {
-        Serial.printf("Tổng dung lượng PSRAM: %d bytes (%.2f MB)\n", psramSize, psramSize / (1024.0 * 1024.0));
-        Serial.printf("Dung lượng PSRAM trống: %d bytes\n", freePsram);
-    } else {
-        Serial.println("CẢNH BÁO: Hệ thống không nhận được dung lượng PSRAM nào.");
-    }
+// Task boot_net: tự xóa khi kết nối xong
+static void connectTask(void *arg)
+{
+    connectNetwork();
+    JsonArena::instance().releaseTask();
+    vTaskDelete(nullptr);
+}
 
-    // 3. Kiểm tra Heap nội bộ (RAM mặc định của ESP32) để đối chiếu
-    Serial.printf("DRAM trống (Internal RAM): %d bytes\n", ESP.getFreeHeap());
-    Serial.println("--------------------------------\n");
+void setup()
+{
+    Serial.begin(115200);
+    Serial.println("\n--- Bắt đầu Hệ thống Famio FM Radio ESP32 ---");
 
-    // Khởi tạo PowerManager và SD Card trước
+    // 1. PSRAM (JsonArena và cache UI cần nó)
+    uint8_t phase = bootProfiler.start("psram");
+    bool psramOk = psramInit() && ESP.getPsramSize() > 0;
+    if (psramOk)
+        Serial.printf("PSRAM: %u bytes, trống %u bytes.\n", (unsigned)ESP.getPsramSize(), (unsigned)ESP.getFreePsram());
+    else
+        Serial.println("CẢNH BÁO: Không tìm thấy PSRAM.");
+    Serial.printf("DRAM trống (Internal RAM): %u bytes\n", (unsigned)ESP.getFreeHeap());
+    // JsonDocument tạm dùng PSRAM thay cho DRAM nội (cần cho stack BT/Wi-Fi)
+    JsonArena::instance().begin();
+    // Ring trace (GET /api/system/trace)
+    Trace::begin();
+    bootProfiler.finish(phase, psramOk);
+
+    // 2. Cài đặt (âm lượng, tần số, chế độ cuối, Wi-Fi) nằm trong NVS: đọc trước, không cần thẻ SD
+    phase = bootProfiler.start("nvs");
+    settingsStore.begin();
+    String ssid, pass;
+    netNeedsCard = !settingsStore.getWifiCredentials(ssid, pass) || ssid.length() == 0;
+    bootProfiler.finish(phase);
+
+    // 3. Wi-Fi chạy song song với phần còn lại
+    sdPhase = bootProfiler.start("sd");
+    netPhase = bootProfiler.start("net");
+    bool netTask = xTaskCreatePinnedToCore(connectTask, BOOT_NET_TASK_NAME, BOOT_NET_TASK_STACK, nullptr,
+                                           BOOT_NET_TASK_PRIORITY, nullptr, BOOT_NET_TASK_CORE) == pdPASS;
+    if (!netTask)
+        Serial.println("SETUP: Không tạo được task boot_net, kết nối Wi-Fi sau khi phát lại.");
+
+    // 4. PowerManager và SD Card
     powerManager.begin();
     SPI.begin(SPI_SCK_PIN, SPI_MISO_PIN, SPI_MOSI_PIN, SD_CS_PIN);
-    if (!fileManager.begin())
-    {
-        Serial.println("Lỗi nghiêm trọng: Không thể khởi tạo SD Card.");
-        return;
-    }
-
-    // 1. TẢI CẤU HÌNH (Sử dụng JsonDocument, phù hợp với v7)
-    JsonDocument commonConfig;
-
-    // Đường dẫn được lấy từ Constants.h (PROJECT_ROOT_DIR)
-    if (!fileManager.loadJsonFile(CONFIG_FILE_PATH COMMON_CONFIG_FILE, &commonConfig))
-    {
-        Serial.println("Không tải được /config/common.json. Sử dụng cấu hình mặc định.");
-    }
-
-    int initialVolume = commonConfig["volume"] | 50;
-    float initialFreq = commonConfig["freq"] | 99.5f;
-
-    // QUẢN LÝ KẾT NỐI WI-FI
-    if (!connectivityManager.begin())
+    bool cardOk = fileManager.begin();
+    if (!cardOk)
     {
-        // Nếu kết nối/cấu hình thất bại, khởi động lại để thử lại
-        Serial.println("Hệ thống không thể kết nối");
-        while (1)
-            ;
+        // Vẫn chạy tiếp: radio và API dùng cài đặt trong NVS, chỉ thiếu UI và danh sách kênh
+        Serial.println("Lỗi: Không thể khởi tạo SD Card. Tiếp tục không có thẻ.");
     }
+    bootProfiler.finish(sdPhase, cardOk);
 
-    // KHỞI TẠO WEB SERVER
-    appWebServer.begin();
+    // 5. I2C
+    phase = bootProfiler.start("i2c");
     Wire.begin();
     // HOẶC: Wire.begin(SDA_PIN, SCL_PIN); nếu bạn dùng chân tùy chỉnh
-    Serial.println("SETUP: Khởi tạo I2C Bus thành công.");
+    bootProfiler.finish(phase);
+
+    // 6. Task control (core 1) phải chạy trước khi Web Server nhận lệnh
+    phase = bootProfiler.start("control");
+    bool tasksOk = taskManager.begin();
+    bootProfiler.finish(phase, tasksOk);
+
+    // 7. Khôi phục chế độ đang dùng trước khi tắt máy (chờ tới khi phát được)
+    phase = bootProfiler.start("audio");
+    AudioMode lastMode = settingsStore.getMode();
+    if (lastMode == MODE_FM)
+        taskManager.post(CMD_FM_POWER_ON, 0, CONTROL_WAIT_MS);
+    else if (lastMode == MODE_BT)
+        taskManager.post(CMD_BT_POWER_ON, 0, CONTROL_WAIT_MS);
+    bootProfiler.finish(phase);
+
+    // 8. KHỞI TẠO WEB SERVER (sau khi Wi-Fi/AP đã lên)
+    if (!netTask)
+        connectNetwork();
+    bootProfiler.waitFor(netPhase);
+    phase = bootProfiler.start("web");
+    appWebServer.begin();
+    bootProfiler.finish(phase);
+
+    bootProfiler.complete();
 }
 
 // =========================================================
@@ -100,6 +159,10 @@ void setup()
 
 void loop()
 {
-    appWebServer.handleClient();
+    // Web Server chạy trong task async_tcp, phần cứng trong task control;
+    // loop() chỉ xử lý các việc chạy nền
+    uint32_t start = micros();
+    connectivityManager.loop();
+    taskManager.addLoopTime(micros() - start);
     delay(10);
 }
\ No newline at end of file
@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+"""Load generator for the Famio web API (host build or a real board).
+
+Each client thread replays the given requests round-robin for --duration
+seconds and the script prints throughput and latency percentiles per route.
+
+    python3 tools/loadtest.py --port 8080 --clients 4 GET:/api/fm/status GET:/api/bt/status
+    python3 tools/loadtest.py --port 8080 --clients 2 "POST:/api/fm/volume?level={i16}"
+
+Placeholders in a path: {i} is the running request number of the client,
+{i16} the same modulo 16 (handy for volume storms).
+"""
+
+import argparse
+import http.client
+import json
+import threading
+import time
+from collections import defaultdict
+
+
+def percentile(sorted_values, p):
+    if not sorted_values:
+        return 0.0
+    k = min(len(sorted_values) - 1, int(round(p / 100.0 * (len(sorted_values) - 1))))
+    return sorted_values[k]
+
+
+def parse_spec(spec):
+    method, _, path = spec.partition(":")
+    if not path:
+        method, path = "GET", spec
+    body = None
+    if "#" in path:
+        path, body = path.split("#", 1)
+    return method.upper(), path, body
+
+
+class Client(threading.Thread):
+    def __init__(self, args, specs, deadline, results, errors):
+        super().__init__(daemon=True)
+        self.args = args
+        self.specs = specs
+        self.deadline = deadline
+        self.results = results
+        self.errors = errors
+        self.conn = None
+
+    def connection(self):
+        if self.conn is None or not self.args.keepalive:
+            if self.conn is not None:
+                self.conn.close()
+            self.conn = http.client.HTTPConnection(self.args.host, self.args.port, timeout=self.args.timeout)
+        return self.conn
+
+    def run(self):
+        i = 0
+        while time.monotonic() < self.deadline:
+            method, path, body = self.specs[i % len(self.specs)]
+            url = path.format(i=i, i16=i % 16)
+            headers = {"Connection": "keep-alive" if self.args.keepalive else "close"}
+            if body is not None:
+                headers["Content-Type"] = "application/json"
+            start = time.perf_counter()
+            try:
+                conn = self.connection()
+                conn.request(method, url, body=body, headers=headers)
+                resp = conn.getresponse()
+                resp.read()
+                if resp.will_close:
+                    conn.close()
+                    self.conn = None
+                elapsed = (time.perf_counter() - start) * 1000.0
+                self.results[(method, path)].append(elapsed)
+            except (OSError, http.client.HTTPException):
+                self.errors[(method, path)] += 1
+                if self.conn is not None:
+                    self.conn.close()
+                self.conn = None
+            i += 1
+            if self.args.interval:
+                time.sleep(self.args.interval / 1000.0)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("requests", nargs="+", help="METHOD:/path[#json-body]")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=8080)
+    parser.add_argument("--clients", type=int, default=2)
+    parser.add_argument("--duration", type=float, default=10.0, help="seconds")
+    parser.add_argument("--interval", type=float, default=0.0, help="pause between requests of one client (ms)")
+    parser.add_argument("--timeout", type=float, default=10.0)
+    parser.add_argument("--keepalive", action="store_true", help="reuse one connection per client")
+    parser.add_argument("--json", action="store_true", help="print the summary as JSON")
+    args = parser.parse_args()
+
+    specs = [parse_spec(s) for s in args.requests]
+    per_client = [(defaultdict(list), defaultdict(int)) for _ in range(args.clients)]
+    deadline = time.monotonic() + args.duration
+    started = time.monotonic()
+    threads = [Client(args, specs, deadline, r, e) for r, e in per_client]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    wall = time.monotonic() - started
+
+    summary = {}
+    for method, path, _ in specs:
+        key = (method, path)
+        samples = sorted(x for r, _ in per_client for x in r[key])
+        errors = sum(e[key] for _, e in per_client)
+        summary["%s %s" % key] = {
+            "requests": len(samples),
+            "errors": errors,
+            "rps": round(len(samples) / wall, 1),
+            "p50_ms": round(percentile(samples, 50), 2),
+            "p90_ms": round(percentile(samples, 90), 2),
+            "p99_ms": round(percentile(samples, 99), 2),
+            "max_ms": round(samples[-1], 2) if samples else 0.0,
+        }
+
+    if args.json:
+        print(json.dumps(summary, indent=2))
+        return
+    print("%-40s %8s %6s %8s %8s %8s %8s %8s" % ("route", "req", "err", "req/s", "p50", "p90", "p99", "max"))
+    for route, s in summary.items():
+        print("%-40s %8d %6d %8.1f %8.2f %8.2f %8.2f %8.2f" % (
+            route, s["requests"], s["errors"], s["rps"], s["p50_ms"], s["p90_ms"], s["p99_ms"], s["max_ms"]))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Pack the web UI directory into a single bundle (ui.pack) for the SD card.
+
+The firmware opens the bundle once at boot, keeps its index in RAM and serves
+every file by seeking inside the open file instead of a FAT lookup per request.
+
+    python3 tools/pack_ui.py ui/ sd/famio/ui.pack --gzip
+
+Layout (little endian):
+    header  16 bytes   magic "FUIP", version u16, count u16, index size u32, data offset u32
+    index   count x 128 bytes, sorted by path (the firmware binary-searches it)
+            path[80]  URL path, e.g. "/index.html", NUL padded
+            mime[32]  Content-Type, NUL padded
+            offset u32, length u32   position of the data from the start of the file
+            hash u32                 FNV-1a of the data (used as the ETag)
+            flags u32                bit 0: data is gzip-compressed
+    data    file contents back to back
+
+--gzip adds a "<path>.gz" entry for text assets when compression saves space;
+.gz files already present in the directory are packed as they are.
+"""
+
+import argparse
+import gzip
+import os
+import struct
+import sys
+
+MAGIC = b"FUIP"
+VERSION = 1
+HEADER = struct.Struct("<4sHHII")
+ENTRY = struct.Struct("<80s32sIIII")
+FLAG_GZIP = 1
+MAX_ENTRIES = 512
+
+# Same mapping as AppWebServer::getContentType
+MIME_TYPES = {
+    ".htm": "text/html",
+    ".html": "text/html",
+    ".css": "text/css",
+    ".js": "application/javascript",
+    ".png": "image/png",
+    ".jpg": "image/jpeg",
+    ".jpeg": "image/jpeg",
+    ".gif": "image/gif",
+    ".svg": "image/svg+xml",
+    ".ico": "image/x-icon",
+    ".json": "application/json",
+    ".txt": "text/plain",
+}
+COMPRESSIBLE = {".htm", ".html", ".css", ".js", ".svg", ".json", ".txt"}
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & 0xFFFFFFFF
+    return h
+
+
+def mime_for(path):
+    if path.endswith(".gz"):
+        path = path[:-3]
+    return MIME_TYPES.get(os.path.splitext(path)[1].lower(), "application/octet-stream")
+
+
+def collect(root, add_gzip):
+    files = {}
+    for dirpath, _, names in os.walk(root):
+        for name in names:
+            full = os.path.join(dirpath, name)
+            url = "/" + os.path.relpath(full, root).replace(os.sep, "/")
+            with open(full, "rb") as f:
+                files[url] = f.read()
+
+    if add_gzip:
+        for url, data in list(files.items()):
+            if url.endswith(".gz") or url + ".gz" in files:
+                continue
+            if os.path.splitext(url)[1].lower() not in COMPRESSIBLE:
+                continue
+            packed = gzip.compress(data, compresslevel=9, mtime=0)
+            if len(packed) < len(data):
+                files[url + ".gz"] = packed
+    return files
+
+
+def build(files):
+    paths = sorted(files, key=lambda p: p.encode())
+    if len(paths) > MAX_ENTRIES:
+        sys.exit("too many files: %d (max %d)" % (len(paths), MAX_ENTRIES))
+
+    index_size = len(paths) * ENTRY.size
+    offset = HEADER.size + index_size
+    index = bytearray()
+    data = bytearray()
+    for path in paths:
+        encoded = path.encode()
+        if len(encoded) >= 80:
+            sys.exit("path too long for the index: " + path)
+        content = files[path]
+        flags = FLAG_GZIP if path.endswith(".gz") else 0
+        index += ENTRY.pack(encoded, mime_for(path).encode(), offset + len(data), len(content), fnv1a(content), flags)
+        data += content
+
+    header = HEADER.pack(MAGIC, VERSION, len(paths), index_size, HEADER.size + index_size)
+    return bytes(header) + bytes(index) + bytes(data)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("ui_dir", help="directory with the built UI (becomes the URL root)")
+    parser.add_argument("output", help="bundle to write, normally <sd>/famio/ui.pack")
+    parser.add_argument("--gzip", action="store_true", help="add .gz variants of text assets")
+    args = parser.parse_args()
+
+    files = collect(args.ui_dir, args.gzip)
+    if not files:
+        sys.exit("no files in " + args.ui_dir)
+    bundle = build(files)
+    with open(args.output, "wb") as f:
+        f.write(bundle)
+
+    raw = sum(len(v) for k, v in files.items() if not k.endswith(".gz"))
+    print("%s: %d entries, %d bytes (%d bytes of uncompressed assets)" % (args.output, len(files), len(bundle), raw))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+"""Time-to-first-byte of the web UI files (host build or a real board).
+
+For every URL the first request is reported separately (cold: the firmware
+still has to find the file on the card) from the median of the following
+--repeat requests (warm). Run it once against loose files in /famio/ui and
+once with /famio/ui.pack present to compare the two layouts.
+
+    python3 tools/ttfb.py --port 8080 / /assets/app.js /assets/style.css
+    python3 tools/ttfb.py --port 8080 --gzip --repeat 50 /
+
+Each request uses a fresh connection, like a browser opening the page.
+"""
+
+import argparse
+import socket
+import statistics
+import time
+
+
+def ttfb(host, port, path, gzip, timeout):
+    request = "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: close\r\n" % (path, host)
+    if gzip:
+        request += "Accept-Encoding: gzip\r\n"
+    request += "\r\n"
+
+    start = time.perf_counter()
+    sock = socket.create_connection((host, port), timeout=timeout)
+    try:
+        sock.sendall(request.encode())
+        first = sock.recv(4096)
+        first_byte = time.perf_counter() - start
+        data = first
+        while True:
+            chunk = sock.recv(65536)
+            if not chunk:
+                break
+            data += chunk
+        total = time.perf_counter() - start
+    finally:
+        sock.close()
+
+    status = int(data.split(b" ", 2)[1]) if first else 0
+    head, _, body = data.partition(b"\r\n\r\n")
+    return status, first_byte * 1000.0, total * 1000.0, len(body)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("paths", nargs="+", help="URL paths, e.g. / /assets/app.js")
+    parser.add_argument("--host", default="127.0.0.1")
+    parser.add_argument("--port", type=int, default=80)
+    parser.add_argument("--repeat", type=int, default=20, help="warm requests per URL")
+    parser.add_argument("--gzip", action="store_true", help="send Accept-Encoding: gzip")
+    parser.add_argument("--timeout", type=float, default=10.0)
+    args = parser.parse_args()
+
+    print("%-32s %6s %8s %10s %10s %10s" % ("path", "status", "bytes", "cold ms", "warm p50", "warm max"))
+    for path in args.paths:
+        status, cold, _, size = ttfb(args.host, args.port, path, args.gzip, args.timeout)
+        warm = [ttfb(args.host, args.port, path, args.gzip, args.timeout)[1] for _ in range(args.repeat)]
+        print("%-32s %6d %8d %10.2f %10.2f %10.2f"
+              % (path, status, size, cold, statistics.median(warm) if warm else 0.0, max(warm) if warm else 0.0))
+
+
+if __name__ == "__main__":
+    main()